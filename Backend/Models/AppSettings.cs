@@ -4,6 +4,14 @@ public class AppSettings
 {
     public MqttSettings Mqtt { get; set; } = new();
     public SpotifySettings Spotify { get; set; } = new();
+    public TraceSettings Trace { get; set; } = new();
+    public CommandQueueSettings CommandQueue { get; set; } = new();
+    public MetricsSettings Metrics { get; set; } = new();
+    public LibrarySettings Library { get; set; } = new();
+    public ImageCacheSettings ImageCache { get; set; } = new();
+    public OtaSettings Ota { get; set; } = new();
+    public ClusterSettings Cluster { get; set; } = new();
+    public DiagnosticsSettings Diagnostics { get; set; } = new();
 }
 
 public class MqttSettings
@@ -18,6 +26,28 @@ public class MqttSettings
     public string ImageTopic { get; set; } = "spotidial/image";
     public string PlaylistTopic { get; set; } = "spotidial/playlists";
     public string AlbumTopic { get; set; } = "spotidial/albums";
+    public string PlaylistTableTopic { get; set; } = "spotidial/playlists/table";
+    public string AlbumTableTopic { get; set; } = "spotidial/albums/table";
+    public string TraceTopic { get; set; } = "spotidial/trace";
+    public string MetricsTopic { get; set; } = "spotidial/metrics";
+    public string OtaRequestTopic { get; set; } = "spotidial/ota/request";
+    public string OtaTopicPrefix { get; set; } = "spotidial/ota/";   // + client id + /offer or /data
+    public string EncodingTopicPrefix { get; set; } = "spotidial/encoding/";  // + client id + /request or /accept
+    public string StallTopic { get; set; } = "spotidial/diag/stall";
+    public string CoreDumpTopicPrefix { get; set; } = "spotidial/diag/coredump/";  // + client id
+
+    // Accept dials' requests for the compact status and list encoding, published on <topic>/compact
+    public bool CompactEncoding { get; set; } = true;
+
+    // Keep the session (and subscriptions) on the broker across reconnects; needs a stable ClientId
+    public bool CleanSession { get; set; } = false;
+
+    // Reconnect backoff: doubled after every failed attempt up to the max, each wait jittered
+    public int ReconnectMinDelayMs { get; set; } = 1000;
+    public int ReconnectMaxDelayMs { get; set; } = 30000;
+
+    // Name tables are sent in chunks of this size; the dial's MQTT buffer is 2048 bytes
+    public int TableChunkBytes { get; set; } = 1536;
 }
 
 public class SpotifySettings
@@ -28,6 +58,17 @@ public class SpotifySettings
     public int PollingIntervalMs { get; set; } = 1000;
     public int OAuthCallbackPort { get; set; } = 8888;
 
+    // Adaptive polling: PollingIntervalMs is the dense interval used near a predicted track
+    // boundary and right after a command; otherwise polls are spread out
+    public bool AdaptivePolling { get; set; } = true;
+    public int PausedPollingIntervalMs { get; set; } = 5000;    // First poll while paused or idle, doubles while nothing changes
+    public int MaxPollingIntervalMs { get; set; } = 30000;     // Ceiling for the paused/idle backoff
+    public int PlayingCheckIntervalMs { get; set; } = 15000;   // Longest gap while playing, catches skips from other apps
+    public int CommandPollWindowMs { get; set; } = 5000;       // Poll densely this long after a command
+
+    // Alternative Web API endpoint (e.g. a local stub server); uses a static token instead of OAuth
+    public string ApiBaseUrl { get; set; } = string.Empty;
+
     private string? _oauthRedirectUri;
     public string OAuthRedirectUri
     {
@@ -35,3 +76,126 @@ public class SpotifySettings
         set => _oauthRedirectUri = value;
     }
 }
+
+public class TraceSettings
+{
+    public bool Enabled { get; set; } = true;
+    public int ReportIntervalSeconds { get; set; } = 60;
+}
+
+public class CommandQueueSettings
+{
+    // Commands buffered per device before the MQTT receive loop is held back
+    public int Capacity { get; set; } = 64;
+
+    // How long a full queue may hold back the receive loop before the command is dropped
+    public int EnqueueTimeoutMs { get; set; } = 1000;
+}
+
+public class LibrarySettings
+{
+    // Serve playlists/albums from the cache without any API call while younger than this
+    public int CacheTtlSeconds { get; set; } = 300;
+
+    // Walk the whole library at this interval instead of stopping at the first unchanged page
+    public int FullSyncIntervalMinutes { get; set; } = 60;
+
+    // Items per Spotify request (the API allows up to 50)
+    public int PageSize { get; set; } = 50;
+
+    // Where library_<user>.json files go; defaults to the application directory
+    public string CacheDirectory { get; set; } = string.Empty;
+
+    // Also send complete lists as a sorted, front-coded name table with a letter index
+    public bool NameTable { get; set; } = true;
+
+    // Every Nth entry is stored in full; the dial decodes at most N - 1 entries to reach a row
+    public int NameTableRestartInterval { get; set; } = 16;
+}
+
+public class ImageCacheSettings
+{
+    // Processed covers kept in memory (least recently used dropped first)
+    public int MemoryCacheMb { get; set; } = 8;
+
+    // Processed covers kept on disk; 0 disables the disk tier
+    public int DiskCacheMb { get; set; } = 64;
+
+    // Defaults to image-cache/ in the application directory
+    public string CacheDirectory { get; set; } = string.Empty;
+
+    // Cells per side of the colour preview sent with the status (at most 8); 0 disables it
+    public int PreviewGrid { get; set; } = 4;
+}
+
+public class OtaSettings
+{
+    public bool Enabled { get; set; } = false;
+
+    // Firmware images (.bin as built by PlatformIO); dials are known by the SHA-256 appended to them
+    public string FirmwareDirectory { get; set; } = "firmware";
+
+    // File in FirmwareDirectory to roll out; defaults to the newest
+    public string TargetImage { get; set; } = string.Empty;
+
+    // Unit of resuming on the dial; a multiple of the 4 KB flash sector
+    public int BlockSize { get; set; } = 65536;
+
+    // Patch bytes per MQTT message; the dial's MQTT buffer is 2048 bytes
+    public int ChunkBytes { get; set; } = 1536;
+
+    // Send the full image even when the dial's image is known, to compare against a delta
+    public bool ForceFullImage { get; set; } = false;
+}
+
+public class ClusterSettings
+{
+    // Run as one of several instances sharing the command topics (needs an MQTT 5 broker)
+    public bool Enabled { get; set; } = false;
+
+    // Unique per instance; defaults to the host name and process id
+    public string InstanceId { get; set; } = string.Empty;
+
+    // Instances in the same group split the commands between them ($share/<group>/...)
+    public string SharedGroup { get; set; } = "spotidial-backend";
+
+    // Heartbeats, forwarded messages: <prefix>members/<instance>, <prefix>forward/<instance>/...
+    public string TopicPrefix { get; set; } = "spotidial/cluster/";
+
+    // An instance without a heartbeat for this long loses its devices to the others
+    public int LeaseMs { get; set; } = 3000;
+
+    // Points per instance on the hash ring; more spread the devices more evenly
+    public int VirtualNodes { get; set; } = 64;
+}
+
+public class MetricsSettings
+{
+    // How often metrics are logged and published to the metrics topic
+    public int IntervalSeconds { get; set; } = 30;
+}
+
+public class DiagnosticsSettings
+{
+    // Collect the stall and panic reports and core dumps dials upload
+    public bool Enabled { get; set; } = true;
+
+    // ELF files of firmware builds (.pio/build/<env>/firmware.elf under any name); dials report
+    // the SHA-256 of theirs
+    public string SymbolDirectory { get; set; } = "symbols";
+
+    // From the ESP32-S3 toolchain; without it stalls are only grouped by step and build
+    public string Addr2LinePath { get; set; } = "xtensa-esp32s3-elf-addr2line";
+
+    // Frames in source files under this path are the firmware's own; stalls are grouped by the first
+    public string AppSourcePath { get; set; } = "Firmware/src/";
+
+    // Reassembled core dumps; defaults to coredumps/ in the application directory
+    public string CoreDumpDirectory { get; set; } = string.Empty;
+
+    // How often the worst stalls are logged
+    public int ReportIntervalSeconds { get; set; } = 300;
+
+    // Stall groups logged and published with the metrics
+    public int TopStalls { get; set; } = 10;
+}
@@ -0,0 +1,116 @@
+using System.Text.Json.Serialization;
+
+namespace SpotiDialBackend.Models;
+
+// Published periodically on the metrics topic
+public class BackendMetrics
+{
+    public CommandQueueMetrics CommandQueue { get; set; } = new();
+    public PlaybackMetrics Playback { get; set; } = new();
+    public LibraryMetrics Library { get; set; } = new();
+    public ImageCacheMetrics Images { get; set; } = new();
+
+    [JsonIgnore(Condition = JsonIgnoreCondition.WhenWritingNull)]
+    public ClusterMetrics? Cluster { get; set; }
+
+    [JsonIgnore(Condition = JsonIgnoreCondition.WhenWritingNull)]
+    public StallMetrics? Stalls { get; set; }
+}
+
+public class PlaybackMetrics
+{
+    // Every request sent to the Spotify Web API, commands included
+    public long ApiCalls { get; set; }
+    public double ApiCallsPerHour { get; set; }
+
+    // Playback state polls made by the monitor
+    public long Polls { get; set; }
+    public double PollsPerHour { get; set; }
+    public int CurrentPollIntervalMs { get; set; }
+
+    public long RateLimited { get; set; }
+
+    // Time between a track starting and the backend noticing it
+    public long TrackChanges { get; set; }
+    public double TrackChangeLagP50Ms { get; set; }
+    public double TrackChangeLagP90Ms { get; set; }
+    public double TrackChangeLagMaxMs { get; set; }
+}
+
+public class LibraryMetrics
+{
+    // get_playlists/get_albums requests, and how many were answered from the cache alone
+    public long Browses { get; set; }
+    public long CacheHits { get; set; }
+
+    // Spotify pages requested vs. pages taken from the cache after an unchanged page
+    public long PagesFetched { get; set; }
+    public long PagesReused { get; set; }
+
+    // Browse request -> first list published
+    public double FirstEntryP50Ms { get; set; }
+    public double FirstEntryP90Ms { get; set; }
+    public double FirstEntryMaxMs { get; set; }
+}
+
+public class ImageCacheMetrics
+{
+    public long Requests { get; set; }
+    public long MemoryHits { get; set; }
+    public long DiskHits { get; set; }
+    public long Misses { get; set; }
+    public double HitRatio { get; set; }
+    public long DownloadedBytes { get; set; }
+
+    // Managed allocations while decoding, cropping and encoding one cover
+    public long AllocatedBytesPerImage { get; set; }
+    public double ProcessP50Ms { get; set; }
+    public double ProcessP99Ms { get; set; }
+
+    public long MemoryCacheBytes { get; set; }
+    public int MemoryCacheEntries { get; set; }
+    public long DiskCacheBytes { get; set; }
+}
+
+public class ClusterMetrics
+{
+    public string InstanceId { get; set; } = string.Empty;
+    public int Members { get; set; }
+
+    // Commands and OTA requests the broker gave this instance, and how many went on to their owner
+    public long Received { get; set; }
+    public long Forwarded { get; set; }
+
+    // Messages other instances forwarded here
+    public long ForwardedIn { get; set; }
+
+    // Ring changes (instances joining or leaving), and how many of them were lapsed leases
+    public long Handovers { get; set; }
+    public long LeasesExpired { get; set; }
+}
+
+public class StallMetrics
+{
+    public long Reports { get; set; }
+    public long Panics { get; set; }
+    public long CoreDumps { get; set; }
+
+    // Worst first, by time the dials spent stalled
+    public List<StallGroupMetrics> Top { get; set; } = new();
+}
+
+// Stalls in the same step and function of the firmware, across all dials
+public class StallGroupMetrics
+{
+    public string Kind { get; set; } = string.Empty;
+    public string Step { get; set; } = string.Empty;
+    public string Function { get; set; } = string.Empty;
+    public string Location { get; set; } = string.Empty;
+    public string WaitingIn { get; set; } = string.Empty;   // Innermost frame, where the time went
+    public long Count { get; set; }
+    public long Unreported { get; set; }                    // Rate-limited on the dials
+    public int Devices { get; set; }
+    public long TotalMs { get; set; }
+    public long MaxMs { get; set; }
+    public long Blocked { get; set; }
+}
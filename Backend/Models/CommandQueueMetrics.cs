@@ -0,0 +1,26 @@
+namespace SpotiDialBackend.Models;
+
+// Published periodically on the metrics topic
+public class CommandQueueMetrics
+{
+    public int Devices { get; set; }
+    public int QueueDepth { get; set; }
+    public int MaxQueueDepth { get; set; }
+    public long Received { get; set; }
+    public long Executed { get; set; }
+    public long Coalesced { get; set; }
+    public long Superseded { get; set; }
+    public long Dropped { get; set; }
+
+    // Replays of commands already received, by commandId
+    public long Duplicates { get; set; }
+
+    // Commands received per command sent to Spotify
+    public double CoalesceRatio { get; set; }
+
+    // Command received -> Spotify call returned
+    public double ApiLatencyP50Ms { get; set; }
+    public double ApiLatencyP90Ms { get; set; }
+    public double ApiLatencyP99Ms { get; set; }
+    public double ApiLatencyMaxMs { get; set; }
+}
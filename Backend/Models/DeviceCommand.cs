@@ -1,9 +1,24 @@
+using System.Text.Json.Serialization;
+
 namespace SpotiDialBackend.Models;
 
 public class DeviceCommand
 {
     public string Command { get; set; } = string.Empty;
     public string? Parameter { get; set; }
+
+    // Sending device (its MQTT client id); commands without one share a queue
+    public string? DeviceId { get; set; }
+
+    // Set by the device so the command can be traced end to end
+    public string? CorrelationId { get; set; }
+
+    // Unique per device boot; a command replayed after a reconnect keeps its id
+    public string? CommandId { get; set; }
+
+    // Stopwatch timestamp taken when the MQTT message arrived
+    [JsonIgnore]
+    public long ReceivedTimestamp { get; set; }
 }
 
 public static class Commands
@@ -15,8 +30,12 @@ public static class Commands
     public const string VolumeUp = "volume_up";
     public const string VolumeDown = "volume_down";
     public const string SetVolume = "set_volume";
+    public const string Seek = "seek";
     public const string ChangePlaylist = "change_playlist";
     public const string ChangeAlbum = "change_album";
     public const string GetPlaylists = "get_playlists";
     public const string GetAlbums = "get_albums";
+
+    // Volume change for volume_up/volume_down without a parameter
+    public const int VolumeStep = 5;
 }
@@ -0,0 +1,20 @@
+namespace SpotiDialBackend.Models;
+
+// Published retained by a dial on <encoding prefix><client id>/request. The backend answers on
+// <encoding prefix><client id>/accept with the topics it publishes in that encoding
+public class EncodingRequest
+{
+    public int Format { get; set; }
+    public int Dictionary { get; set; }
+    public List<string> Topics { get; set; } = new();
+}
+
+// Topics that have a compact variant, as named in encoding requests
+public static class CompactTopics
+{
+    public const string Status = "status";
+    public const string Playlists = "playlists";
+    public const string Albums = "albums";
+
+    public static readonly string[] All = { Status, Playlists, Albums };
+}
@@ -0,0 +1,9 @@
+namespace SpotiDialBackend.Models;
+
+// A library item with the key that changes whenever the item does (snapshot id, save time)
+public record LibraryEntry<T>(string Key, T Info);
+
+public record LibraryPage<T>(List<LibraryEntry<T>> Items, int Total)
+{
+    public static LibraryPage<T> Empty => new(new List<LibraryEntry<T>>(), 0);
+}
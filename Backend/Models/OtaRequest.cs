@@ -0,0 +1,51 @@
+namespace SpotiDialBackend.Models;
+
+// Published by a dial on the OTA request topic
+public class OtaRequest
+{
+    public string Type { get; set; } = string.Empty;
+    public string ClientId { get; set; } = string.Empty;
+
+    // hello: the running firmware, by its appended SHA-256, and an update that was rolled back
+    public string? Version { get; set; }
+    public string? Image { get; set; }
+    public string? RolledBack { get; set; }
+
+    // get: a range of the patch
+    public string? Patch { get; set; }
+    public int Offset { get; set; }
+    public int Length { get; set; }
+
+    // result: measured on the dial, from accepting the offer to switching the boot slot
+    public bool Ok { get; set; }
+    public bool Full { get; set; }
+    public string? Error { get; set; }
+    public long Bytes { get; set; }
+    public long PatchSize { get; set; }
+    public long ImageSize { get; set; }
+    public long FlashMs { get; set; }
+    public long TotalMs { get; set; }
+    public long ActivateMs { get; set; }
+
+    // confirmed: from boot to the broker on the new image
+    public long ConnectMs { get; set; }
+}
+
+public static class OtaRequestTypes
+{
+    public const string Hello = "hello";
+    public const string Get = "get";
+    public const string Result = "result";
+    public const string Confirmed = "confirmed";
+}
+
+// Sent to one dial on <OtaTopicPrefix><client id>/offer
+public class OtaOffer
+{
+    public string Patch { get; set; } = string.Empty;
+    public string Base { get; set; } = string.Empty;
+    public string Target { get; set; } = string.Empty;
+    public bool Full { get; set; }
+    public int Size { get; set; }
+    public int ImageSize { get; set; }
+}
@@ -0,0 +1,4 @@
+namespace SpotiDialBackend.Models;
+
+// Cached result of one GetCurrentPlayback call; FetchedTimestamp is a Stopwatch timestamp
+public record PlaybackState(string? TrackId, SongInfo? Song, long FetchedTimestamp);
@@ -1,3 +1,5 @@
+using System.Text.Json.Serialization;
+
 namespace SpotiDialBackend.Models;
 
 public class SongInfo
@@ -10,4 +12,21 @@ public class SongInfo
     public bool IsPlaying { get; set; }
     public int VolumePercent { get; set; }
     public string? AlbumImageUrl { get; set; }
+
+    // Tiny colour preview of the cover, shown until the full image has arrived
+    [JsonIgnore(Condition = JsonIgnoreCondition.WhenWritingNull)]
+    public string? ArtPreview { get; set; }
+
+    // Echo of the command that caused this status, with the backend's share of the latency
+    [JsonIgnore(Condition = JsonIgnoreCondition.WhenWritingNull)]
+    public string? CorrelationId { get; set; }
+
+    [JsonIgnore(Condition = JsonIgnoreCondition.WhenWritingNull)]
+    public long? BackendUs { get; set; }
+
+    // Backend instance that handled the command, when running as a cluster
+    [JsonIgnore(Condition = JsonIgnoreCondition.WhenWritingNull)]
+    public string? BackendInstance { get; set; }
+
+    public SongInfo Clone() => (SongInfo)MemberwiseClone();
 }
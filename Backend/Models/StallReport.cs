@@ -0,0 +1,25 @@
+namespace SpotiDialBackend.Models;
+
+public static class StallKinds
+{
+    public const string Stall = "stall";   // A loop() step ran past the dial's threshold
+    public const string Panic = "panic";   // The dial reset on a panic or watchdog in this step
+}
+
+// Sent by a dial's stall watchdog, from its flash ring, once it is connected
+public class StallReport
+{
+    public string DeviceId { get; set; } = string.Empty;
+    public string Version { get; set; } = string.Empty;
+    public string Elf { get; set; } = string.Empty;        // SHA-256 of the firmware's ELF file
+    public uint Seq { get; set; }
+    public string Kind { get; set; } = StallKinds.Stall;
+    public string Step { get; set; } = string.Empty;
+    public long DurationMs { get; set; }
+    public long UptimeMs { get; set; }                     // When the step started
+    public bool Blocked { get; set; }                      // Waiting rather than running when sampled
+    public int Suppressed { get; set; }                    // Stalls of the step not reported since the last
+    public string? Reason { get; set; }
+    public string? Task { get; set; }
+    public uint[] Backtrace { get; set; } = Array.Empty<uint>();
+}
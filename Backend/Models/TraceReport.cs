@@ -0,0 +1,12 @@
+namespace SpotiDialBackend.Models;
+
+// Device-side timings for one traced command, measured on the device's monotonic clock
+public class TraceReport
+{
+    public string CorrelationId { get; set; } = string.Empty;
+    public string Command { get; set; } = string.Empty;
+    public long InputToPublishUs { get; set; }
+    public long PublishToStatusUs { get; set; }
+    public long StatusToRenderUs { get; set; }
+    public long BackendUs { get; set; }
+}
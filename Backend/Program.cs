@@ -1,3 +1,4 @@
+using System.Net;
 using Microsoft.Extensions.Configuration;
 using Microsoft.Extensions.DependencyInjection;
 using Microsoft.Extensions.Hosting;
@@ -31,12 +32,64 @@ class Program
                     { "AppSettings:Mqtt:CommandTopic", Environment.GetEnvironmentVariable("MQTT_COMMAND_TOPIC") ?? "spotidial/commands" },
                     { "AppSettings:Mqtt:StatusTopic", Environment.GetEnvironmentVariable("MQTT_STATUS_TOPIC") ?? "spotidial/status" },
                     { "AppSettings:Mqtt:ImageTopic", Environment.GetEnvironmentVariable("MQTT_IMAGE_TOPIC") ?? "spotidial/image" },
+                    { "AppSettings:Mqtt:TraceTopic", Environment.GetEnvironmentVariable("MQTT_TRACE_TOPIC") ?? "spotidial/trace" },
+                    { "AppSettings:Mqtt:MetricsTopic", Environment.GetEnvironmentVariable("MQTT_METRICS_TOPIC") ?? "spotidial/metrics" },
+                    { "AppSettings:Mqtt:CleanSession", Environment.GetEnvironmentVariable("MQTT_CLEAN_SESSION") ?? "false" },
+                    { "AppSettings:Mqtt:ReconnectMinDelayMs", Environment.GetEnvironmentVariable("MQTT_RECONNECT_MIN_DELAY_MS") ?? "1000" },
+                    { "AppSettings:Mqtt:ReconnectMaxDelayMs", Environment.GetEnvironmentVariable("MQTT_RECONNECT_MAX_DELAY_MS") ?? "30000" },
+                    { "AppSettings:Mqtt:TableChunkBytes", Environment.GetEnvironmentVariable("MQTT_TABLE_CHUNK_BYTES") ?? "1536" },
+                    { "AppSettings:Mqtt:OtaRequestTopic", Environment.GetEnvironmentVariable("MQTT_OTA_REQUEST_TOPIC") ?? "spotidial/ota/request" },
+                    { "AppSettings:Mqtt:OtaTopicPrefix", Environment.GetEnvironmentVariable("MQTT_OTA_TOPIC_PREFIX") ?? "spotidial/ota/" },
+                    { "AppSettings:Mqtt:EncodingTopicPrefix", Environment.GetEnvironmentVariable("MQTT_ENCODING_TOPIC_PREFIX") ?? "spotidial/encoding/" },
+                    { "AppSettings:Mqtt:CompactEncoding", Environment.GetEnvironmentVariable("MQTT_COMPACT_ENCODING") ?? "true" },
+                    { "AppSettings:Mqtt:StallTopic", Environment.GetEnvironmentVariable("MQTT_STALL_TOPIC") ?? "spotidial/diag/stall" },
+                    { "AppSettings:Mqtt:CoreDumpTopicPrefix", Environment.GetEnvironmentVariable("MQTT_COREDUMP_TOPIC_PREFIX") ?? "spotidial/diag/coredump/" },
                     { "AppSettings:Spotify:ClientId", Environment.GetEnvironmentVariable("SPOTIFY_CLIENT_ID") ?? "" },
                     { "AppSettings:Spotify:ClientSecret", Environment.GetEnvironmentVariable("SPOTIFY_CLIENT_SECRET") ?? "" },
                     { "AppSettings:Spotify:RefreshToken", Environment.GetEnvironmentVariable("SPOTIFY_REFRESH_TOKEN") ?? "" },
                     { "AppSettings:Spotify:PollingIntervalMs", Environment.GetEnvironmentVariable("SPOTIFY_POLLING_INTERVAL_MS") ?? "1000" },
                     { "AppSettings:Spotify:OAuthCallbackPort", Environment.GetEnvironmentVariable("SPOTIFY_OAUTH_CALLBACK_PORT") ?? "8888" },
-                    { "AppSettings:Spotify:OAuthRedirectUri", Environment.GetEnvironmentVariable("SPOTIFY_OAUTH_REDIRECT_URI") ?? "" }
+                    { "AppSettings:Spotify:AdaptivePolling", Environment.GetEnvironmentVariable("SPOTIFY_ADAPTIVE_POLLING") ?? "true" },
+                    { "AppSettings:Spotify:PausedPollingIntervalMs", Environment.GetEnvironmentVariable("SPOTIFY_PAUSED_POLLING_INTERVAL_MS") ?? "5000" },
+                    { "AppSettings:Spotify:MaxPollingIntervalMs", Environment.GetEnvironmentVariable("SPOTIFY_MAX_POLLING_INTERVAL_MS") ?? "30000" },
+                    { "AppSettings:Spotify:PlayingCheckIntervalMs", Environment.GetEnvironmentVariable("SPOTIFY_PLAYING_CHECK_INTERVAL_MS") ?? "15000" },
+                    { "AppSettings:Spotify:CommandPollWindowMs", Environment.GetEnvironmentVariable("SPOTIFY_COMMAND_POLL_WINDOW_MS") ?? "5000" },
+                    { "AppSettings:Spotify:OAuthRedirectUri", Environment.GetEnvironmentVariable("SPOTIFY_OAUTH_REDIRECT_URI") ?? "" },
+                    { "AppSettings:Spotify:ApiBaseUrl", Environment.GetEnvironmentVariable("SPOTIFY_API_BASE_URL") ?? "" },
+                    { "AppSettings:Trace:Enabled", Environment.GetEnvironmentVariable("TRACE_ENABLED") ?? "true" },
+                    { "AppSettings:Trace:ReportIntervalSeconds", Environment.GetEnvironmentVariable("TRACE_REPORT_INTERVAL_SECONDS") ?? "60" },
+                    { "AppSettings:CommandQueue:Capacity", Environment.GetEnvironmentVariable("COMMAND_QUEUE_CAPACITY") ?? "64" },
+                    { "AppSettings:CommandQueue:EnqueueTimeoutMs", Environment.GetEnvironmentVariable("COMMAND_QUEUE_ENQUEUE_TIMEOUT_MS") ?? "1000" },
+                    { "AppSettings:Library:CacheTtlSeconds", Environment.GetEnvironmentVariable("LIBRARY_CACHE_TTL_SECONDS") ?? "300" },
+                    { "AppSettings:Library:FullSyncIntervalMinutes", Environment.GetEnvironmentVariable("LIBRARY_FULL_SYNC_INTERVAL_MINUTES") ?? "60" },
+                    { "AppSettings:Library:PageSize", Environment.GetEnvironmentVariable("LIBRARY_PAGE_SIZE") ?? "50" },
+                    { "AppSettings:Library:CacheDirectory", Environment.GetEnvironmentVariable("LIBRARY_CACHE_DIR") ?? "" },
+                    { "AppSettings:Library:NameTable", Environment.GetEnvironmentVariable("LIBRARY_NAME_TABLE") ?? "true" },
+                    { "AppSettings:Library:NameTableRestartInterval", Environment.GetEnvironmentVariable("LIBRARY_NAME_TABLE_RESTART_INTERVAL") ?? "16" },
+                    { "AppSettings:ImageCache:MemoryCacheMb", Environment.GetEnvironmentVariable("IMAGE_CACHE_MEMORY_MB") ?? "8" },
+                    { "AppSettings:ImageCache:DiskCacheMb", Environment.GetEnvironmentVariable("IMAGE_CACHE_DISK_MB") ?? "64" },
+                    { "AppSettings:ImageCache:CacheDirectory", Environment.GetEnvironmentVariable("IMAGE_CACHE_DIR") ?? "" },
+                    { "AppSettings:ImageCache:PreviewGrid", Environment.GetEnvironmentVariable("IMAGE_PREVIEW_GRID") ?? "4" },
+                    { "AppSettings:Ota:Enabled", Environment.GetEnvironmentVariable("OTA_ENABLED") ?? "false" },
+                    { "AppSettings:Ota:FirmwareDirectory", Environment.GetEnvironmentVariable("OTA_FIRMWARE_DIR") ?? "firmware" },
+                    { "AppSettings:Ota:TargetImage", Environment.GetEnvironmentVariable("OTA_TARGET_IMAGE") ?? "" },
+                    { "AppSettings:Ota:BlockSize", Environment.GetEnvironmentVariable("OTA_BLOCK_SIZE") ?? "65536" },
+                    { "AppSettings:Ota:ChunkBytes", Environment.GetEnvironmentVariable("OTA_CHUNK_BYTES") ?? "1536" },
+                    { "AppSettings:Ota:ForceFullImage", Environment.GetEnvironmentVariable("OTA_FORCE_FULL_IMAGE") ?? "false" },
+                    { "AppSettings:Cluster:Enabled", Environment.GetEnvironmentVariable("CLUSTER_ENABLED") ?? "false" },
+                    { "AppSettings:Cluster:InstanceId", Environment.GetEnvironmentVariable("CLUSTER_INSTANCE_ID") ?? "" },
+                    { "AppSettings:Cluster:SharedGroup", Environment.GetEnvironmentVariable("CLUSTER_SHARED_GROUP") ?? "spotidial-backend" },
+                    { "AppSettings:Cluster:TopicPrefix", Environment.GetEnvironmentVariable("CLUSTER_TOPIC_PREFIX") ?? "spotidial/cluster/" },
+                    { "AppSettings:Cluster:LeaseMs", Environment.GetEnvironmentVariable("CLUSTER_LEASE_MS") ?? "3000" },
+                    { "AppSettings:Cluster:VirtualNodes", Environment.GetEnvironmentVariable("CLUSTER_VIRTUAL_NODES") ?? "64" },
+                    { "AppSettings:Metrics:IntervalSeconds", Environment.GetEnvironmentVariable("METRICS_INTERVAL_SECONDS") ?? "30" },
+                    { "AppSettings:Diagnostics:Enabled", Environment.GetEnvironmentVariable("DIAG_ENABLED") ?? "true" },
+                    { "AppSettings:Diagnostics:SymbolDirectory", Environment.GetEnvironmentVariable("DIAG_SYMBOL_DIR") ?? "symbols" },
+                    { "AppSettings:Diagnostics:Addr2LinePath", Environment.GetEnvironmentVariable("DIAG_ADDR2LINE") ?? "xtensa-esp32s3-elf-addr2line" },
+                    { "AppSettings:Diagnostics:AppSourcePath", Environment.GetEnvironmentVariable("DIAG_APP_SOURCE_PATH") ?? "Firmware/src/" },
+                    { "AppSettings:Diagnostics:CoreDumpDirectory", Environment.GetEnvironmentVariable("DIAG_COREDUMP_DIR") ?? "" },
+                    { "AppSettings:Diagnostics:ReportIntervalSeconds", Environment.GetEnvironmentVariable("DIAG_REPORT_INTERVAL_SECONDS") ?? "300" },
+                    { "AppSettings:Diagnostics:TopStalls", Environment.GetEnvironmentVariable("DIAG_TOP_STALLS") ?? "10" }
                 };
 
                 config.AddInMemoryCollection(envVarMappings!);
@@ -46,14 +99,39 @@ class Program
                 // Configuration
                 services.Configure<AppSettings>(context.Configuration.GetSection("AppSettings"));
 
+                // One long-lived connection pool for the Spotify API and cover downloads;
+                // connections are recycled so DNS changes are still picked up
+                services.AddHttpClient(HttpClientNames.Spotify)
+                    .ConfigurePrimaryHttpMessageHandler(() => new SocketsHttpHandler
+                    {
+                        PooledConnectionLifetime = TimeSpan.FromMinutes(5),
+                        PooledConnectionIdleTimeout = TimeSpan.FromMinutes(1),
+                        AutomaticDecompression = DecompressionMethods.GZip | DecompressionMethods.Deflate
+                    })
+                    .SetHandlerLifetime(Timeout.InfiniteTimeSpan);
+
                 // Services
                 services.AddSingleton<TokenStorageService>();
+                services.AddSingleton<ClusterMembership>();
                 services.AddSingleton<MqttService>();
+                services.AddSingleton<SpotifyApiMonitor>();
                 services.AddSingleton<SpotifyService>();
+                services.AddSingleton<LibraryCacheService>();
                 services.AddSingleton<ImageProcessingService>();
+                services.AddSingleton<ImageCacheService>();
+                services.AddSingleton<TraceCollectorService>();
+                services.AddSingleton<CommandQueueService>();
+                services.AddSingleton<OtaService>();
+                services.AddSingleton<StallCollectorService>();
 
-                // Background service
+                // Background services
                 services.AddHostedService<CommandProcessorService>();
+                services.AddHostedService(sp => sp.GetRequiredService<TraceCollectorService>());
+                services.AddHostedService(sp => sp.GetRequiredService<StallCollectorService>());
+                services.AddHostedService<MetricsPublisherService>();
+
+                // Registered after the command processor so it stops first and leaves while still connected
+                services.AddHostedService<ClusterService>();
             })
             .ConfigureLogging((context, logging) =>
             {
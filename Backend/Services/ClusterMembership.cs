@@ -0,0 +1,150 @@
+using System.Diagnostics;
+using Microsoft.Extensions.Logging;
+using Microsoft.Extensions.Options;
+using SpotiDialBackend.Models;
+
+namespace SpotiDialBackend.Services;
+
+/// <summary>
+/// Which backend instances are alive and which of them owns a device. Each instance holds a
+/// lease that its heartbeats renew; when a lease runs out or the instance's will clears its
+/// heartbeat, it drops off the hash ring and its devices move to the instances next to it.
+/// With clustering disabled this instance owns everything.
+/// </summary>
+public class ClusterMembership
+{
+    private readonly ILogger<ClusterMembership> _logger;
+    private readonly ClusterSettings _settings;
+
+    private readonly object _lock = new();
+    private readonly Dictionary<string, long> _lastHeartbeat = new();
+    private volatile HashRing _ring;
+
+    private long _received;
+    private long _forwarded;
+    private long _forwardedIn;
+    private long _handovers;
+    private long _leasesExpired;
+
+    public event Action<IReadOnlyList<string>>? OnMembersChanged;
+
+    public ClusterMembership(ILogger<ClusterMembership> logger, IOptions<AppSettings> settings)
+    {
+        _logger = logger;
+        _settings = settings.Value.Cluster;
+
+        InstanceId = string.IsNullOrEmpty(_settings.InstanceId)
+            ? $"{Environment.MachineName}-{Environment.ProcessId}"
+            : _settings.InstanceId;
+        _ring = new HashRing(new[] { InstanceId }, _settings.VirtualNodes);
+    }
+
+    public bool Enabled => _settings.Enabled;
+
+    public string InstanceId { get; }
+
+    public IReadOnlyList<string> Members => _ring.Members;
+
+    public string OwnerOf(string key) => _ring.Owner(key) ?? InstanceId;
+
+    public bool IsLocal(string key) => !Enabled || OwnerOf(key) == InstanceId;
+
+    /// <summary>
+    /// Renew an instance's lease, adding it to the ring if it was not on it.
+    /// </summary>
+    public void Heartbeat(string instanceId)
+    {
+        if (instanceId == InstanceId) return;
+
+        HashRing ring;
+        lock (_lock)
+        {
+            var joined = !_lastHeartbeat.ContainsKey(instanceId);
+            _lastHeartbeat[instanceId] = Stopwatch.GetTimestamp();
+            if (!joined) return;
+
+            _logger.LogInformation("Cluster: {Instance} joined", instanceId);
+            ring = Rebuild();
+        }
+        OnMembersChanged?.Invoke(ring.Members);
+    }
+
+    /// <summary>
+    /// Remove an instance that left or whose will arrived.
+    /// </summary>
+    public void Leave(string instanceId)
+    {
+        HashRing ring;
+        lock (_lock)
+        {
+            if (!_lastHeartbeat.Remove(instanceId, out var last)) return;
+
+            _logger.LogInformation("Cluster: {Instance} left, last heartbeat {Elapsed:F0} ms ago",
+                instanceId, Stopwatch.GetElapsedTime(last).TotalMilliseconds);
+            ring = Rebuild();
+        }
+        OnMembersChanged?.Invoke(ring.Members);
+    }
+
+    /// <summary>
+    /// Remove instances whose lease ran out without a heartbeat.
+    /// </summary>
+    public void ExpireLeases()
+    {
+        HashRing ring;
+        lock (_lock)
+        {
+            var lease = TimeSpan.FromMilliseconds(_settings.LeaseMs);
+            var expired = _lastHeartbeat
+                .Where(member => Stopwatch.GetElapsedTime(member.Value) > lease)
+                .Select(member => member.Key)
+                .ToList();
+            if (expired.Count == 0) return;
+
+            foreach (var instanceId in expired)
+            {
+                _logger.LogWarning("Cluster: lease of {Instance} expired after {Elapsed:F0} ms without a heartbeat",
+                    instanceId, Stopwatch.GetElapsedTime(_lastHeartbeat[instanceId]).TotalMilliseconds);
+                _lastHeartbeat.Remove(instanceId);
+                _leasesExpired++;
+            }
+            ring = Rebuild();
+        }
+        OnMembersChanged?.Invoke(ring.Members);
+    }
+
+    public void RecordReceived() => Interlocked.Increment(ref _received);
+
+    public void RecordForwarded() => Interlocked.Increment(ref _forwarded);
+
+    public void RecordForwardedIn() => Interlocked.Increment(ref _forwardedIn);
+
+    public ClusterMetrics GetMetrics()
+    {
+        lock (_lock)
+        {
+            return new ClusterMetrics
+            {
+                InstanceId = InstanceId,
+                Members = _ring.Members.Count,
+                Received = Interlocked.Read(ref _received),
+                Forwarded = Interlocked.Read(ref _forwarded),
+                ForwardedIn = Interlocked.Read(ref _forwardedIn),
+                Handovers = _handovers,
+                LeasesExpired = _leasesExpired
+            };
+        }
+    }
+
+    // Called with the lock held; the caller raises OnMembersChanged once it is released
+    private HashRing Rebuild()
+    {
+        var ring = new HashRing(_lastHeartbeat.Keys.Append(InstanceId), _settings.VirtualNodes);
+        _ring = ring;
+        _handovers++;
+
+        _logger.LogInformation("Cluster: {Count} instances ({Members})", ring.Members.Count,
+            string.Join(", ", ring.Members));
+        return ring;
+    }
+}
@@ -0,0 +1,65 @@
+using Microsoft.Extensions.Hosting;
+using Microsoft.Extensions.Logging;
+using Microsoft.Extensions.Options;
+using SpotiDialBackend.Models;
+
+namespace SpotiDialBackend.Services;
+
+/// <summary>
+/// Keeps this instance's lease alive and expires the leases of instances that stopped sending
+/// heartbeats. Heartbeats go out three times per lease, so one lost message does not hand the
+/// devices over.
+/// </summary>
+public class ClusterService : BackgroundService
+{
+    private readonly ILogger<ClusterService> _logger;
+    private readonly ClusterSettings _settings;
+    private readonly MqttService _mqttService;
+    private readonly ClusterMembership _membership;
+
+    public ClusterService(
+        ILogger<ClusterService> logger,
+        IOptions<AppSettings> settings,
+        MqttService mqttService,
+        ClusterMembership membership)
+    {
+        _logger = logger;
+        _settings = settings.Value.Cluster;
+        _mqttService = mqttService;
+        _membership = membership;
+    }
+
+    protected override async Task ExecuteAsync(CancellationToken stoppingToken)
+    {
+        if (!_membership.Enabled) return;
+
+        _logger.LogInformation("Cluster: running as {Instance}, lease {Lease} ms, shared group {Group}",
+            _membership.InstanceId, _settings.LeaseMs, _settings.SharedGroup);
+
+        var interval = TimeSpan.FromMilliseconds(Math.Max(_settings.LeaseMs / 3, 100));
+        while (!stoppingToken.IsCancellationRequested)
+        {
+            await _mqttService.PublishHeartbeatAsync();
+            _membership.ExpireLeases();
+
+            try
+            {
+                await Task.Delay(interval, stoppingToken);
+            }
+            catch (OperationCanceledException)
+            {
+                break;
+            }
+        }
+    }
+
+    // Stopped before the MQTT connection closes, so the others take over without waiting for the lease
+    public override async Task StopAsync(CancellationToken cancellationToken)
+    {
+        await base.StopAsync(cancellationToken);
+        if (_membership.Enabled)
+        {
+            await _mqttService.PublishLeaveAsync();
+        }
+    }
+}
@@ -0,0 +1,135 @@
+using SpotiDialBackend.Models;
+
+namespace SpotiDialBackend.Services;
+
+/// <summary>
+/// Collapses runs of queued commands that would be wasted Spotify calls.
+/// Only neighbours are merged, so the order of different commands is preserved.
+/// </summary>
+public static class CommandCoalescer
+{
+    public static List<DeviceCommand> Coalesce(IReadOnlyList<DeviceCommand> commands)
+    {
+        var result = new List<DeviceCommand>(commands.Count);
+
+        foreach (var command in commands)
+        {
+            // Presses that undo each other need no Spotify call at all
+            if (result.Count > 0 && CancelsOut(result[^1], command))
+            {
+                result.RemoveAt(result.Count - 1);
+                continue;
+            }
+
+            var merged = result.Count > 0 ? Merge(result[^1], command) : null;
+            if (merged != null)
+            {
+                result[^1] = merged;
+            }
+            else
+            {
+                result.Add(command);
+            }
+        }
+
+        return result;
+    }
+
+    /// <summary>
+    /// Commands in the same group replace each other: only the newest matters, so a newer one
+    /// makes queued and in-flight ones obsolete. Relative volume changes have no group.
+    /// </summary>
+    public static string? SupersedeGroup(DeviceCommand command)
+    {
+        return command.Command.ToLowerInvariant() switch
+        {
+            Commands.SetVolume => "volume",
+            Commands.Seek => "seek",
+            Commands.Play or Commands.Pause => "playback",
+            Commands.ChangePlaylist or Commands.ChangeAlbum => "context",
+            _ => null
+        };
+    }
+
+    private static bool CancelsOut(DeviceCommand previous, DeviceCommand next)
+    {
+        var previousName = previous.Command.ToLowerInvariant();
+        var nextName = next.Command.ToLowerInvariant();
+
+        return IsRelativeVolume(previousName) && IsRelativeVolume(nextName) &&
+               VolumeDelta(previous, previousName) + VolumeDelta(next, nextName) == 0;
+    }
+
+    private static DeviceCommand? Merge(DeviceCommand previous, DeviceCommand next)
+    {
+        var previousName = previous.Command.ToLowerInvariant();
+        var nextName = next.Command.ToLowerInvariant();
+
+        if (IsVolume(previousName) && IsVolume(nextName))
+        {
+            return MergeVolume(previous, next, previousName, nextName);
+        }
+
+        var group = SupersedeGroup(next);
+        if (group != null && group == SupersedeGroup(previous))
+        {
+            return Replace(previous, next, next.Command, next.Parameter);
+        }
+
+        // Repeated list requests produce the same answer
+        if (nextName == previousName && (nextName == Commands.GetPlaylists || nextName == Commands.GetAlbums))
+        {
+            return Replace(previous, next, next.Command, next.Parameter);
+        }
+
+        return null;
+    }
+
+    private static DeviceCommand MergeVolume(DeviceCommand previous, DeviceCommand next,
+        string previousName, string nextName)
+    {
+        if (nextName == Commands.SetVolume)
+        {
+            return Replace(previous, next, next.Command, next.Parameter);
+        }
+
+        var delta = VolumeDelta(next, nextName);
+
+        if (previousName == Commands.SetVolume && int.TryParse(previous.Parameter, out var volume))
+        {
+            return Replace(previous, next, Commands.SetVolume, Math.Clamp(volume + delta, 0, 100).ToString());
+        }
+
+        delta += VolumeDelta(previous, previousName);
+        return Replace(previous, next,
+            delta >= 0 ? Commands.VolumeUp : Commands.VolumeDown,
+            Math.Abs(delta).ToString());
+    }
+
+    private static bool IsVolume(string name) =>
+        name is Commands.SetVolume or Commands.VolumeUp or Commands.VolumeDown;
+
+    private static bool IsRelativeVolume(string name) =>
+        name is Commands.VolumeUp or Commands.VolumeDown;
+
+    private static int VolumeDelta(DeviceCommand command, string name)
+    {
+        var step = int.TryParse(command.Parameter, out var parsed) ? parsed : Commands.VolumeStep;
+        return name == Commands.VolumeDown ? -step : step;
+    }
+
+    // The merged command answers to the newest correlation id but keeps the oldest
+    // receive time, so latency still counts from the first press the user made
+    private static DeviceCommand Replace(DeviceCommand previous, DeviceCommand next, string command, string? parameter)
+    {
+        return new DeviceCommand
+        {
+            Command = command,
+            Parameter = parameter,
+            DeviceId = next.DeviceId,
+            CorrelationId = next.CorrelationId,
+            CommandId = next.CommandId,
+            ReceivedTimestamp = Math.Min(previous.ReceivedTimestamp, next.ReceivedTimestamp)
+        };
+    }
+}
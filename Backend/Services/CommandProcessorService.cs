@@ -9,18 +9,39 @@ public class CommandProcessorService : BackgroundService
     private readonly ILogger<CommandProcessorService> _logger;
     private readonly MqttService _mqttService;
     private readonly SpotifyService _spotifyService;
-    private readonly ImageProcessingService _imageService;
+    private readonly ImageCacheService _imageCache;
+    private readonly TraceCollectorService _traceCollector;
+    private readonly CommandQueueService _commandQueue;
+    private readonly LibraryCacheService _libraryCache;
+    private readonly OtaService _otaService;
+    private readonly StallCollectorService _stallCollector;
+    private readonly ClusterMembership _membership;
+
+    // Only the instance owning this key on the ring polls the shared Spotify playback state
+    private const string PlaybackMonitorKey = "playback-monitor";
 
     public CommandProcessorService(
         ILogger<CommandProcessorService> logger,
         MqttService mqttService,
         SpotifyService spotifyService,
-        ImageProcessingService imageService)
+        ImageCacheService imageCache,
+        TraceCollectorService traceCollector,
+        CommandQueueService commandQueue,
+        LibraryCacheService libraryCache,
+        OtaService otaService,
+        StallCollectorService stallCollector,
+        ClusterMembership membership)
     {
         _logger = logger;
         _mqttService = mqttService;
         _spotifyService = spotifyService;
-        _imageService = imageService;
+        _imageCache = imageCache;
+        _traceCollector = traceCollector;
+        _commandQueue = commandQueue;
+        _libraryCache = libraryCache;
+        _otaService = otaService;
+        _stallCollector = stallCollector;
+        _membership = membership;
     }
 
     protected override async Task ExecuteAsync(CancellationToken stoppingToken)
@@ -33,13 +54,20 @@ public class CommandProcessorService : BackgroundService
             await _spotifyService.InitializeAsync();
             await _mqttService.ConnectAsync();
 
+            // Commands run one at a time per device, in order
+            _commandQueue.Start(HandleCommandAsync, stoppingToken);
+
             // Subscribe to events
-            _mqttService.OnCommandReceived += async (command) => await HandleCommandAsync(command);
+            _mqttService.OnCommandReceived += _commandQueue.EnqueueAsync;
             _spotifyService.OnSongChanged += async (songInfo) => await HandleSongChangedAsync(songInfo);
+            _mqttService.OnTraceReceived += _traceCollector.RecordDeviceReport;
+            _mqttService.OnOtaRequest += _otaService.HandleRequestAsync;
+            _mqttService.OnStallReport += _stallCollector.RecordReport;
+            _mqttService.OnCoreDumpChunk += _stallCollector.RecordCoreDumpChunkAsync;
 
             // Start monitoring Spotify playback
             _logger.LogInformation("Command Processor Service started");
-            await _spotifyService.MonitorPlaybackAsync(stoppingToken);
+            await MonitorPlaybackAsync(stoppingToken);
         }
         catch (Exception ex)
         {
@@ -48,80 +76,171 @@ public class CommandProcessorService : BackgroundService
         }
     }
 
-    private async Task HandleCommandAsync(DeviceCommand command)
+    // Every instance would otherwise poll the same account; the monitor moves with the ring
+    private async Task MonitorPlaybackAsync(CancellationToken stoppingToken)
+    {
+        if (!_membership.Enabled)
+        {
+            await _spotifyService.MonitorPlaybackAsync(stoppingToken);
+            return;
+        }
+
+        while (!stoppingToken.IsCancellationRequested)
+        {
+            // Not disposed: a change raised while we unsubscribe may still cancel it
+            var changed = new CancellationTokenSource();
+            void OnMembersChanged(IReadOnlyList<string> members) => changed.Cancel();
+
+            _membership.OnMembersChanged += OnMembersChanged;
+            try
+            {
+                using var linked = CancellationTokenSource.CreateLinkedTokenSource(stoppingToken, changed.Token);
+                if (_membership.IsLocal(PlaybackMonitorKey))
+                {
+                    await _spotifyService.MonitorPlaybackAsync(linked.Token);
+                }
+                else
+                {
+                    _logger.LogInformation("Playback monitored by {Instance}",
+                        _membership.OwnerOf(PlaybackMonitorKey));
+                    await Task.Delay(Timeout.Infinite, linked.Token);
+                }
+            }
+            catch (OperationCanceledException)
+            {
+                // Membership changed or shutting down; check who monitors now
+            }
+            finally
+            {
+                _membership.OnMembersChanged -= OnMembersChanged;
+            }
+        }
+    }
+
+    private async Task HandleCommandAsync(DeviceCommand command, CancellationToken cancellationToken)
     {
         _logger.LogInformation("Processing command: {Command}", command.Command);
+        _traceCollector.Mark(command, TraceHops.Dispatch);
+        _spotifyService.NotifyCommand();
 
         try
         {
+            var changesPlayback = true;
+
             switch (command.Command.ToLowerInvariant())
             {
                 case Commands.Play:
-                    await _spotifyService.PlayAsync();
+                    await _spotifyService.PlayAsync(cancellationToken);
                     break;
 
                 case Commands.Pause:
-                    await _spotifyService.PauseAsync();
+                    await _spotifyService.PauseAsync(cancellationToken);
                     break;
 
                 case Commands.NextTrack:
-                    await _spotifyService.NextTrackAsync();
+                    await _spotifyService.NextTrackAsync(cancellationToken);
                     break;
 
                 case Commands.PreviousTrack:
-                    await _spotifyService.PreviousTrackAsync();
+                    await _spotifyService.PreviousTrackAsync(cancellationToken);
                     break;
 
+                // Coalesced volume presses carry the combined step as parameter
                 case Commands.VolumeUp:
-                    await _spotifyService.ChangeVolumeAsync(5);
+                    await _spotifyService.ChangeVolumeAsync(VolumeStep(command), cancellationToken);
                     break;
 
                 case Commands.VolumeDown:
-                    await _spotifyService.ChangeVolumeAsync(-5);
+                    await _spotifyService.ChangeVolumeAsync(-VolumeStep(command), cancellationToken);
                     break;
 
                 case Commands.SetVolume:
                     if (int.TryParse(command.Parameter, out int volume))
                     {
-                        await _spotifyService.SetVolumeAsync(volume);
+                        await _spotifyService.SetVolumeAsync(volume, cancellationToken);
+                    }
+                    break;
+
+                case Commands.Seek:
+                    if (int.TryParse(command.Parameter, out int positionMs))
+                    {
+                        await _spotifyService.SeekAsync(positionMs, cancellationToken);
                     }
                     break;
 
                 case Commands.ChangePlaylist:
                     if (!string.IsNullOrEmpty(command.Parameter))
                     {
-                        await _spotifyService.ChangePlaylistAsync(command.Parameter);
+                        await _spotifyService.ChangePlaylistAsync(command.Parameter, cancellationToken);
                     }
                     break;
 
                 case Commands.ChangeAlbum:
                     if (!string.IsNullOrEmpty(command.Parameter))
                     {
-                        await _spotifyService.ChangeAlbumAsync(command.Parameter);
+                        await _spotifyService.ChangeAlbumAsync(command.Parameter, cancellationToken);
                     }
                     break;
 
                 case Commands.GetPlaylists:
-                    var playlists = await _spotifyService.GetUserPlaylistsAsync();
-                    await _mqttService.PublishPlaylistsAsync(playlists);
+                    changesPlayback = false;
+                    await _libraryCache.BrowsePlaylistsAsync(_mqttService.PublishPlaylistsAsync,
+                        _mqttService.PublishPlaylistTableAsync, cancellationToken);
                     break;
 
                 case Commands.GetAlbums:
-                    var albums = await _spotifyService.GetUserAlbumsAsync();
-                    await _mqttService.PublishAlbumsAsync(albums);
+                    changesPlayback = false;
+                    await _libraryCache.BrowseAlbumsAsync(_mqttService.PublishAlbumsAsync,
+                        _mqttService.PublishAlbumTableAsync, cancellationToken);
                     break;
 
                 default:
+                    changesPlayback = false;
                     _logger.LogWarning("Unknown command: {Command}", command.Command);
                     break;
             }
+
+            _traceCollector.Mark(command, TraceHops.SpotifyCall);
+            _commandQueue.RecordApiCompleted(command);
+
+            // A newer command from the same device will publish a fresher status
+            if (changesPlayback && !_commandQueue.HasPending(command))
+            {
+                await PublishStatusAsync(command, cancellationToken);
+            }
+            else
+            {
+                _traceCollector.Complete(command);
+            }
         }
-        catch (Exception ex)
+        catch (Exception ex) when (ex is not OperationCanceledException)
         {
             _logger.LogError(ex, "Error handling command: {Command}", command.Command);
         }
     }
 
+    // Push the playback state right after a command so the device does not wait for the next poll
+    private async Task PublishStatusAsync(DeviceCommand command, CancellationToken cancellationToken)
+    {
+        var songInfo = await _spotifyService.GetCurrentSongInfoAsync(cancellationToken);
+        _traceCollector.Mark(command, TraceHops.StatusFetch);
+
+        var backendUs = _traceCollector.Complete(command);
+        if (songInfo == null) return;
+
+        songInfo.CorrelationId = backendUs.HasValue ? command.CorrelationId : null;
+        songInfo.BackendUs = backendUs;
+        songInfo.BackendInstance = _membership.Enabled ? _membership.InstanceId : null;
+        songInfo.ArtPreview = PreviewFor(songInfo);
+        await _mqttService.PublishSongInfoAsync(songInfo);
+    }
+
+    private string? PreviewFor(SongInfo songInfo) =>
+        string.IsNullOrEmpty(songInfo.AlbumImageUrl) ? null : _imageCache.TryGetPreview(songInfo.AlbumImageUrl);
+
+    private static int VolumeStep(DeviceCommand command) =>
+        int.TryParse(command.Parameter, out var step) ? step : Commands.VolumeStep;
+
     private async Task HandleSongChangedAsync(SongInfo songInfo)
     {
         _logger.LogInformation("Handling song change: {Artist} - {Track}",
@@ -129,21 +248,29 @@ public class CommandProcessorService : BackgroundService
 
         try
         {
-            // Publish song info to MQTT
+            // Publish song info to MQTT, with the cover's preview if it has been seen before
+            songInfo.ArtPreview = PreviewFor(songInfo);
             await _mqttService.PublishSongInfoAsync(songInfo);
 
             // Download and publish album artwork
             if (!string.IsNullOrEmpty(songInfo.AlbumImageUrl))
             {
-                var imageData = await _spotifyService.GetAlbumImageAsync(songInfo.AlbumImageUrl);
-                if (imageData != null)
+                var processedImage = await _imageCache.GetDeviceImageAsync(songInfo.AlbumImageUrl);
+
+                // A new cover: the preview is ready now, and still beats the full image to the dial
+                if (songInfo.ArtPreview == null)
                 {
-                    var processedImage = await _imageService.ProcessImageForDeviceAsync(imageData);
-                    if (processedImage != null)
+                    songInfo.ArtPreview = PreviewFor(songInfo);
+                    if (songInfo.ArtPreview != null)
                     {
-                        await _mqttService.PublishImageAsync(processedImage);
+                        await _mqttService.PublishSongInfoAsync(songInfo);
                     }
                 }
+
+                if (processedImage != null)
+                {
+                    await _mqttService.PublishImageAsync(processedImage);
+                }
             }
         }
         catch (Exception ex)
@@ -0,0 +1,289 @@
+using System.Collections.Concurrent;
+using System.Diagnostics;
+using System.Threading.Channels;
+using Microsoft.Extensions.Logging;
+using Microsoft.Extensions.Options;
+using SpotiDialBackend.Models;
+
+namespace SpotiDialBackend.Services;
+
+/// <summary>
+/// Bounded command queue per device with a single consumer each. Commands run in order,
+/// neighbours are coalesced and a newer command cancels an in-flight one it makes obsolete.
+/// </summary>
+public class CommandQueueService
+{
+    private const string DefaultDeviceId = "default";
+
+    // Covers a full device journal replayed more than once
+    private const int RecentCommandIds = 256;
+
+    private readonly ILogger<CommandQueueService> _logger;
+    private readonly CommandQueueSettings _settings;
+    private readonly ConcurrentDictionary<string, DeviceQueue> _queues = new();
+    private readonly LatencyHistogram _apiLatency = new();
+
+    private Func<DeviceCommand, CancellationToken, Task>? _handler;
+    private CancellationToken _stoppingToken;
+
+    private long _received;
+    private long _executed;
+    private long _coalesced;
+    private long _superseded;
+    private long _dropped;
+    private long _duplicates;
+    private int _maxDepth;
+
+    public CommandQueueService(ILogger<CommandQueueService> logger, IOptions<AppSettings> settings)
+    {
+        _logger = logger;
+        _settings = settings.Value.CommandQueue;
+    }
+
+    /// <summary>
+    /// Start consuming with the given handler until stoppingToken fires.
+    /// </summary>
+    public void Start(Func<DeviceCommand, CancellationToken, Task> handler, CancellationToken stoppingToken)
+    {
+        _handler = handler;
+        _stoppingToken = stoppingToken;
+    }
+
+    /// <summary>
+    /// Queue a command. Waits while the device's queue is full, which holds back the MQTT
+    /// receive loop; drops the command if the queue stays full past EnqueueTimeoutMs.
+    /// </summary>
+    public async Task EnqueueAsync(DeviceCommand command)
+    {
+        Interlocked.Increment(ref _received);
+
+        var deviceId = string.IsNullOrEmpty(command.DeviceId) ? DefaultDeviceId : command.DeviceId;
+        var queue = _queues.GetOrAdd(deviceId, CreateQueue);
+
+        if (!queue.MarkSeen(command.CommandId))
+        {
+            Interlocked.Increment(ref _duplicates);
+            _logger.LogDebug("Ignoring replayed {Command} {CommandId} from {Device}",
+                command.Command, command.CommandId, deviceId);
+            return;
+        }
+
+        // Before the write: once queued, the consumer may already be running this very command
+        queue.SupersedeInFlight(command);
+
+        if (!queue.Channel.Writer.TryWrite(command))
+        {
+            using var timeout = CancellationTokenSource.CreateLinkedTokenSource(_stoppingToken);
+            timeout.CancelAfter(_settings.EnqueueTimeoutMs);
+
+            try
+            {
+                await queue.Channel.Writer.WriteAsync(command, timeout.Token);
+            }
+            catch (OperationCanceledException)
+            {
+                Interlocked.Increment(ref _dropped);
+                _logger.LogWarning("Command queue for {Device} is full, dropped {Command}", deviceId, command.Command);
+                return;
+            }
+        }
+
+        UpdateMaxDepth(queue.Channel.Reader.Count);
+    }
+
+    /// <summary>
+    /// True when newer commands from the same device are waiting.
+    /// </summary>
+    public bool HasPending(DeviceCommand command)
+    {
+        var deviceId = string.IsNullOrEmpty(command.DeviceId) ? DefaultDeviceId : command.DeviceId;
+        return _queues.TryGetValue(deviceId, out var queue) && queue.Channel.Reader.Count > 0;
+    }
+
+    /// <summary>
+    /// Called by the handler once the Spotify call for a command has returned.
+    /// </summary>
+    public void RecordApiCompleted(DeviceCommand command)
+    {
+        if (command.ReceivedTimestamp != 0)
+        {
+            _apiLatency.Record(Stopwatch.GetElapsedTime(command.ReceivedTimestamp).TotalMilliseconds);
+        }
+    }
+
+    public CommandQueueMetrics GetMetrics()
+    {
+        var received = Interlocked.Read(ref _received);
+        var executed = Interlocked.Read(ref _executed);
+
+        return new CommandQueueMetrics
+        {
+            Devices = _queues.Count,
+            QueueDepth = _queues.Values.Sum(q => q.Channel.Reader.Count),
+            MaxQueueDepth = _maxDepth,
+            Received = received,
+            Executed = executed,
+            Coalesced = Interlocked.Read(ref _coalesced),
+            Superseded = Interlocked.Read(ref _superseded),
+            Dropped = Interlocked.Read(ref _dropped),
+            Duplicates = Interlocked.Read(ref _duplicates),
+            CoalesceRatio = executed > 0 ? Math.Round((double)received / executed, 2) : 0,
+            ApiLatencyP50Ms = _apiLatency.Percentile(50),
+            ApiLatencyP90Ms = _apiLatency.Percentile(90),
+            ApiLatencyP99Ms = _apiLatency.Percentile(99),
+            ApiLatencyMaxMs = Math.Round(_apiLatency.MaxMs, 1)
+        };
+    }
+
+    private void UpdateMaxDepth(int depth)
+    {
+        var max = Volatile.Read(ref _maxDepth);
+        while (depth > max)
+        {
+            var seen = Interlocked.CompareExchange(ref _maxDepth, depth, max);
+            if (seen == max) break;
+            max = seen;
+        }
+    }
+
+    private DeviceQueue CreateQueue(string deviceId)
+    {
+        var channel = Channel.CreateBounded<DeviceCommand>(new BoundedChannelOptions(Math.Max(_settings.Capacity, 1))
+        {
+            SingleReader = true,
+            FullMode = BoundedChannelFullMode.Wait
+        });
+
+        var queue = new DeviceQueue(deviceId, channel);
+        _ = Task.Run(() => ConsumeAsync(queue));
+
+        _logger.LogInformation("Created command queue for device {Device}", deviceId);
+        return queue;
+    }
+
+    private async Task ConsumeAsync(DeviceQueue queue)
+    {
+        var reader = queue.Channel.Reader;
+        var batch = new List<DeviceCommand>();
+
+        try
+        {
+            while (await reader.WaitToReadAsync(_stoppingToken))
+            {
+                batch.Clear();
+                while (reader.TryRead(out var queued))
+                {
+                    batch.Add(queued);
+                }
+
+                var commands = CommandCoalescer.Coalesce(batch);
+                Interlocked.Add(ref _coalesced, batch.Count - commands.Count);
+
+                foreach (var command in commands)
+                {
+                    await ExecuteAsync(queue, command);
+                }
+            }
+        }
+        catch (OperationCanceledException)
+        {
+            // Shutting down
+        }
+    }
+
+    private async Task ExecuteAsync(DeviceQueue queue, DeviceCommand command)
+    {
+        if (_handler == null) return;
+
+        using var cts = CancellationTokenSource.CreateLinkedTokenSource(_stoppingToken);
+        queue.SetInFlight(command, cts);
+
+        try
+        {
+            await _handler(command, cts.Token);
+            Interlocked.Increment(ref _executed);
+        }
+        catch (OperationCanceledException) when (!_stoppingToken.IsCancellationRequested)
+        {
+            Interlocked.Increment(ref _superseded);
+            _logger.LogDebug("Command {Command} superseded on {Device}", command.Command, queue.DeviceId);
+        }
+        catch (Exception ex)
+        {
+            _logger.LogError(ex, "Error executing command {Command} on {Device}", command.Command, queue.DeviceId);
+        }
+        finally
+        {
+            queue.ClearInFlight();
+        }
+    }
+
+    private class DeviceQueue
+    {
+        private readonly object _lock = new();
+        private DeviceCommand? _inFlight;
+        private CancellationTokenSource? _inFlightCts;
+        private readonly HashSet<string> _seenIds = new();
+        private readonly Queue<string> _seenOrder = new();
+
+        public DeviceQueue(string deviceId, Channel<DeviceCommand> channel)
+        {
+            DeviceId = deviceId;
+            Channel = channel;
+        }
+
+        public string DeviceId { get; }
+        public Channel<DeviceCommand> Channel { get; }
+
+        // False when the command id was already seen; commands without one always pass
+        public bool MarkSeen(string? commandId)
+        {
+            if (string.IsNullOrEmpty(commandId)) return true;
+
+            lock (_lock)
+            {
+                if (!_seenIds.Add(commandId)) return false;
+
+                _seenOrder.Enqueue(commandId);
+                if (_seenOrder.Count > RecentCommandIds)
+                {
+                    _seenIds.Remove(_seenOrder.Dequeue());
+                }
+                return true;
+            }
+        }
+
+        public void SetInFlight(DeviceCommand command, CancellationTokenSource cts)
+        {
+            lock (_lock)
+            {
+                _inFlight = command;
+                _inFlightCts = cts;
+            }
+        }
+
+        public void ClearInFlight()
+        {
+            lock (_lock)
+            {
+                _inFlight = null;
+                _inFlightCts = null;
+            }
+        }
+
+        // Cancel the running command if the new one replaces it
+        public void SupersedeInFlight(DeviceCommand command)
+        {
+            lock (_lock)
+            {
+                if (_inFlight == null || _inFlightCts == null) return;
+
+                var group = CommandCoalescer.SupersedeGroup(command);
+                if (group != null && group == CommandCoalescer.SupersedeGroup(_inFlight))
+                {
+                    _inFlightCts.Cancel();
+                }
+            }
+        }
+    }
+}
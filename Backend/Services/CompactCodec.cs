@@ -0,0 +1,130 @@
+using System.Buffers.Binary;
+using System.Text;
+using SpotiDialBackend.Models;
+
+namespace SpotiDialBackend.Services;
+
+/// <summary>
+/// The compact encoding dials can ask for on the status and list topics (see EncodingRequest).
+/// Only the fields the dial uses are kept, as binary records, and the records are
+/// LZSS-compressed with a small window that starts out holding a shared dictionary of words
+/// common in track, playlist and album names. All integers are little-endian:
+///
+///   u8 format, u8 kind, u8 dictionary version, u8 flags (bit 0: compressed), u16 raw length, body
+///
+/// Raw records:
+///   list:   u8 id length, id, u8 name length, name; repeated
+///   status: varint progressMs, varint durationMs, u8 volumePercent, u8 flags (bit 0: playing),
+///           varint backendUs, then u8 length and bytes of track, artist, album, correlation id
+///           and art preview
+///
+/// The dictionary is compiled into the firmware (src/mqtt/compact_reader.h); change both and
+/// bump <see cref="DictionaryVersion"/> together.
+/// </summary>
+public static class CompactCodec
+{
+    public const byte Format = 1;
+    public const byte DictionaryVersion = 1;
+    public const int WindowBits = 11;
+    public const int LengthBits = 6;
+    public const int HeaderSize = 6;
+
+    public const byte KindPlaylists = 1;
+    public const byte KindAlbums = 2;
+    public const byte KindStatus = 3;
+
+    private const byte FlagCompressed = 0x01;
+
+    public static readonly byte[] Dictionary = Encoding.ASCII.GetBytes(
+        "Original Motion Picture Soundtrack (Deluxe Edition) (Remastered) - Remastered 20" +
+        " (Live) Live at (feat. feat. (Radio Edit) - Radio Edit (Acoustic Version) Instrumental" +
+        " Remix (Extended Mix) Greatest Hits The Best of Essentials Collection Anniversary Edition" +
+        " Expanded Edition Special Edition - Single Vol. Part Symphony No. Concerto in Orchestra" +
+        " Sessions Daily Mix Discover Weekly Release Radar Liked Songs This Is On Repeat Top 50 -" +
+        " Global Top Hits Chill Vibes Lo-Fi Beats Peaceful Piano Deep Focus Workout Running Sleep" +
+        " Party Rock Classics Hip Hop Jazz Classical Love Songs Summer Christmas Radio Playlist" +
+        " Album Music Songs Mix the and The & of ");
+
+    public static byte[] EncodeList(byte kind, IEnumerable<(string Id, string Name)> items) =>
+        Pack(kind, ListRecords(items));
+
+    /// <summary>
+    /// A list that fits in maxBytes, dropping entries from the end until it does.
+    /// </summary>
+    public static byte[] EncodeList(byte kind, IReadOnlyList<(string Id, string Name)> items, int maxBytes)
+    {
+        var count = items.Count;
+        var payload = EncodeList(kind, items);
+        while (payload.Length > maxBytes && count > 0)
+        {
+            // Compressed size grows roughly with the entries; aim below the limit, at least one less
+            count = Math.Min(count - 1, (int)((long)count * maxBytes / payload.Length));
+            payload = EncodeList(kind, items.Take(count));
+        }
+        return payload;
+    }
+
+    public static byte[] EncodeStatus(SongInfo song)
+    {
+        var raw = new MemoryStream(256);
+        WriteVarint(raw, (uint)Math.Max(song.ProgressMs, 0));
+        WriteVarint(raw, (uint)Math.Max(song.DurationMs, 0));
+        raw.WriteByte((byte)Math.Clamp(song.VolumePercent, 0, 100));
+        raw.WriteByte((byte)(song.IsPlaying ? 1 : 0));
+        WriteVarint(raw, (uint)Math.Clamp(song.BackendUs ?? 0, 0, uint.MaxValue));
+        WriteString(raw, song.TrackName);
+        WriteString(raw, song.ArtistName);
+        WriteString(raw, song.AlbumName);
+        WriteString(raw, song.CorrelationId);
+        WriteString(raw, song.ArtPreview);
+        return Pack(KindStatus, raw.ToArray());
+    }
+
+    private static byte[] ListRecords(IEnumerable<(string Id, string Name)> items)
+    {
+        var raw = new MemoryStream(1024);
+        foreach (var (id, name) in items)
+        {
+            WriteString(raw, id);
+            WriteString(raw, name.Trim());
+        }
+        return raw.ToArray();
+    }
+
+    private static byte[] Pack(byte kind, byte[] raw)
+    {
+        if (raw.Length > ushort.MaxValue)
+            throw new ArgumentException("Compact payloads hold at most 64 KB", nameof(raw));
+
+        // Short or incompressible records go as they are
+        var compressed = Lzss.Compress(raw, WindowBits, LengthBits, Dictionary);
+        var stored = compressed.Length >= raw.Length;
+        var body = stored ? raw : compressed;
+
+        var payload = new byte[HeaderSize + body.Length];
+        payload[0] = Format;
+        payload[1] = kind;
+        payload[2] = DictionaryVersion;
+        payload[3] = stored ? (byte)0 : FlagCompressed;
+        BinaryPrimitives.WriteUInt16LittleEndian(payload.AsSpan(4), (ushort)raw.Length);
+        body.CopyTo(payload, HeaderSize);
+        return payload;
+    }
+
+    private static void WriteString(MemoryStream raw, string? value)
+    {
+        var bytes = NameTableEncoder.Truncate(value ?? string.Empty);
+        raw.WriteByte((byte)bytes.Length);
+        raw.Write(bytes);
+    }
+
+    private static void WriteVarint(MemoryStream raw, uint value)
+    {
+        while (value >= 0x80)
+        {
+            raw.WriteByte((byte)(value | 0x80));
+            value >>= 7;
+        }
+        raw.WriteByte((byte)value);
+    }
+}
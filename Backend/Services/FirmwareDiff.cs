@@ -0,0 +1,233 @@
+using System.Buffers.Binary;
+
+namespace SpotiDialBackend.Services;
+
+/// <summary>
+/// Builds the firmware patches the dial applies over the air (see Firmware/src/ota/patch_applier.h
+/// for the format). The new image is cut into blocks; each block is described as ops against the
+/// running image and the ops are LZSS-compressed on their own, so the dial can resume at any block
+/// and never needs more than a 4 KB window to decompress.
+///
+/// Matching is bsdiff-like: an exact match found through a hash of the base image is sent as a
+/// COPY and then stretched as far as most bytes still agree into an ADD of byte differences.
+/// Rebuilt firmware mostly differs in shifted addresses, so those differences are small, repeat
+/// and compress well. A patch against an empty base is the full image.
+/// </summary>
+public static class FirmwareDiff
+{
+    public const int HeaderSize = 24;
+    public const int WindowBits = 12;
+    public const int LengthBits = 8;
+    public const int SectorSize = 4096;
+
+    private const int MinCopy = 12;             // Shorter exact matches are cheaper as literals
+    private const int SeedBytes = 8;
+    private const int IndexBits = 20;
+    private const int ExtendSlack = 16;         // Net mismatches an ADD may run past its best point
+
+    private const byte OpCopy = 0;
+    private const byte OpAdd = 1;
+    private const byte OpInsert = 2;
+
+    private static readonly byte[] Magic = "SDP1"u8.ToArray();
+    private static readonly uint[] CrcTable = BuildCrcTable();
+
+    public static byte[] CreateFull(byte[] target, int blockSize) => Create(Array.Empty<byte>(), target, blockSize);
+
+    public static byte[] Create(byte[] baseImage, byte[] target, int blockSize)
+    {
+        if (blockSize <= 0 || blockSize % SectorSize != 0)
+            throw new ArgumentException($"Block size must be a multiple of {SectorSize}", nameof(blockSize));
+        if (target.Length == 0)
+            throw new ArgumentException("Empty image", nameof(target));
+
+        var index = baseImage.Length >= SeedBytes ? BuildIndex(baseImage) : null;
+        var patch = new MemoryStream();
+
+        var header = new byte[HeaderSize];
+        Magic.CopyTo(header, 0);
+        header[4] = WindowBits;
+        header[5] = LengthBits;
+        BinaryPrimitives.WriteUInt32LittleEndian(header.AsSpan(8), (uint)blockSize);
+        BinaryPrimitives.WriteUInt32LittleEndian(header.AsSpan(12), (uint)baseImage.Length);
+        BinaryPrimitives.WriteUInt32LittleEndian(header.AsSpan(16), (uint)target.Length);
+        BinaryPrimitives.WriteUInt32LittleEndian(header.AsSpan(20), Crc32(target));
+        patch.Write(header);
+
+        var blockHeader = new byte[8];
+        for (var start = 0; start < target.Length; start += blockSize)
+        {
+            var end = Math.Min(start + blockSize, target.Length);
+            var ops = DiffBlock(baseImage, index, target, start, end);
+            var compressed = Lzss.Compress(ops, WindowBits, LengthBits);
+
+            BinaryPrimitives.WriteUInt32LittleEndian(blockHeader, (uint)compressed.Length);
+            BinaryPrimitives.WriteUInt32LittleEndian(blockHeader.AsSpan(4), Crc32(target.AsSpan(start, end - start)));
+            patch.Write(blockHeader);
+            patch.Write(compressed);
+        }
+
+        return patch.ToArray();
+    }
+
+    /// <summary>
+    /// CRC-32 (IEEE), continuing from a previous result; the same as patchCrc32 on the dial.
+    /// </summary>
+    public static uint Crc32(ReadOnlySpan<byte> data, uint crc = 0)
+    {
+        crc = ~crc;
+        foreach (var b in data)
+        {
+            crc = CrcTable[(crc ^ b) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    private static uint[] BuildCrcTable()
+    {
+        var table = new uint[256];
+        for (uint i = 0; i < 256; i++)
+        {
+            var c = i;
+            for (var k = 0; k < 8; k++)
+            {
+                c = (c & 1) != 0 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        return table;
+    }
+
+    // Last base position of every seed hash, plus one (0 is empty)
+    private static int[] BuildIndex(byte[] baseImage)
+    {
+        var index = new int[1 << IndexBits];
+        for (var i = 0; i + SeedBytes <= baseImage.Length; i++)
+        {
+            index[SeedHash(baseImage, i)] = i + 1;
+        }
+        return index;
+    }
+
+    private static int SeedHash(byte[] data, int offset)
+    {
+        var seed = BinaryPrimitives.ReadUInt64LittleEndian(data.AsSpan(offset, SeedBytes));
+        return (int)((seed * 0x9E3779B97F4A7C15UL) >> (64 - IndexBits));
+    }
+
+    private static byte[] DiffBlock(byte[] baseImage, int[]? index, byte[] target, int start, int end)
+    {
+        var ops = new MemoryStream();
+        var cursor = start;
+        var literalStart = start;
+        var pos = start;
+
+        while (pos < end && index != null)
+        {
+            var (matchPos, matchLength) = FindMatch(baseImage, index, target, pos, end, cursor);
+            if (matchLength < MinCopy)
+            {
+                pos++;
+                continue;
+            }
+
+            WriteInsert(ops, target, literalStart, pos);
+            WriteOp(ops, OpCopy, matchLength, matchPos - cursor);
+            pos += matchLength;
+            cursor = matchPos + matchLength;
+
+            var addLength = Extend(baseImage, target, pos, end, cursor);
+            if (addLength > 0)
+            {
+                WriteOp(ops, OpAdd, addLength, 0);
+                for (var i = 0; i < addLength; i++)
+                {
+                    ops.WriteByte((byte)(target[pos + i] - baseImage[cursor + i]));
+                }
+                pos += addLength;
+                cursor += addLength;
+            }
+            literalStart = pos;
+        }
+
+        WriteInsert(ops, target, literalStart, end);
+        return ops.ToArray();
+    }
+
+    // Longest exact match at the base cursor or at the indexed seed; the cursor wins ties
+    private static (int Position, int Length) FindMatch(byte[] baseImage, int[] index, byte[] target, int pos, int end, int cursor)
+    {
+        var best = (Position: cursor, Length: MatchLength(baseImage, cursor, target, pos, end));
+
+        if (pos + SeedBytes <= target.Length)
+        {
+            var candidate = index[SeedHash(target, pos)] - 1;
+            if (candidate >= 0 && candidate != cursor)
+            {
+                var length = MatchLength(baseImage, candidate, target, pos, end);
+                if (length > best.Length) best = (candidate, length);
+            }
+        }
+
+        return best;
+    }
+
+    private static int MatchLength(byte[] baseImage, int basePos, byte[] target, int pos, int end)
+    {
+        if (basePos < 0 || basePos >= baseImage.Length) return 0;
+
+        var limit = Math.Min(end - pos, baseImage.Length - basePos);
+        var length = 0;
+        while (length < limit && baseImage[basePos + length] == target[pos + length]) length++;
+        return length;
+    }
+
+    // How far to carry on as an ADD: the length where matches most outnumber mismatches
+    private static int Extend(byte[] baseImage, byte[] target, int pos, int end, int cursor)
+    {
+        var limit = Math.Min(end - pos, baseImage.Length - cursor);
+        int score = 0, bestScore = 0, bestLength = 0;
+
+        for (var i = 0; i < limit; i++)
+        {
+            score += target[pos + i] == baseImage[cursor + i] ? 1 : -1;
+            if (score > bestScore)
+            {
+                bestScore = score;
+                bestLength = i + 1;
+            }
+            else if (score < bestScore - ExtendSlack)
+            {
+                break;
+            }
+        }
+
+        return bestLength;
+    }
+
+    private static void WriteInsert(MemoryStream ops, byte[] target, int start, int end)
+    {
+        if (end <= start) return;
+
+        ops.WriteByte(OpInsert);
+        WriteVarint(ops, (uint)(end - start));
+        ops.Write(target, start, end - start);
+    }
+
+    private static void WriteOp(MemoryStream ops, byte op, int length, int delta)
+    {
+        ops.WriteByte(op);
+        WriteVarint(ops, (uint)length);
+        WriteVarint(ops, (uint)((delta << 1) ^ (delta >> 31)));
+    }
+
+    private static void WriteVarint(MemoryStream ops, uint value)
+    {
+        while (value >= 0x80)
+        {
+            ops.WriteByte((byte)(value | 0x80));
+            value >>= 7;
+        }
+        ops.WriteByte((byte)value);
+    }
+}
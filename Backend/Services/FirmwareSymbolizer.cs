@@ -0,0 +1,152 @@
+using System.Collections.Concurrent;
+using System.ComponentModel;
+using System.Diagnostics;
+using System.Security.Cryptography;
+using Microsoft.Extensions.Logging;
+using SpotiDialBackend.Models;
+
+namespace SpotiDialBackend.Services;
+
+public sealed record SymbolizedFrame(uint Address, string Function, string Location)
+{
+    public bool Resolved => Function != "??";
+
+    public override string ToString() => Resolved ? $"0x{Address:x8} {Function} at {Location}" : $"0x{Address:x8}";
+}
+
+/// <summary>
+/// Turns firmware addresses into functions and source lines with the toolchain's addr2line.
+/// The ELF file of a build is found in the symbol directory by its SHA-256, which the dial
+/// reports; every address is looked up once per build.
+/// </summary>
+public class FirmwareSymbolizer
+{
+    private readonly ILogger _logger;
+    private readonly DiagnosticsSettings _settings;
+
+    private readonly object _elfLock = new();
+    private readonly Dictionary<string, (string Digest, DateTime Modified)> _elfByPath = new();
+    private readonly ConcurrentDictionary<(string Elf, uint Address), SymbolizedFrame> _frames = new();
+    private readonly ConcurrentDictionary<string, bool> _missingReported = new();
+    private bool _toolMissing;
+
+    private static readonly TimeSpan Addr2LineTimeout = TimeSpan.FromSeconds(10);
+
+    public FirmwareSymbolizer(ILogger logger, DiagnosticsSettings settings)
+    {
+        _logger = logger;
+        _settings = settings;
+    }
+
+    /// <summary>
+    /// Path of the ELF file with this digest (or digest prefix), if it is in the symbol directory.
+    /// </summary>
+    public string? FindElf(string digest)
+    {
+        if (string.IsNullOrEmpty(digest)) return null;
+
+        var elf = ScanElfFiles().FirstOrDefault(entry =>
+            entry.Digest.StartsWith(digest, StringComparison.OrdinalIgnoreCase) ||
+            digest.StartsWith(entry.Digest, StringComparison.OrdinalIgnoreCase)).Path;
+
+        if (elf == null && _missingReported.TryAdd(digest, true))
+        {
+            _logger.LogWarning("Diagnostics: no ELF file with SHA-256 {Digest} in {Directory}; its addresses stay raw",
+                digest, _settings.SymbolDirectory);
+        }
+        return elf;
+    }
+
+    public async Task<IReadOnlyList<SymbolizedFrame>> SymbolizeAsync(string elfDigest, IReadOnlyList<uint> addresses,
+        CancellationToken cancellationToken)
+    {
+        var elf = FindElf(elfDigest);
+        if (elf == null || _toolMissing)
+        {
+            return addresses.Select(Unresolved).ToList();
+        }
+
+        var missing = addresses.Where(address => !_frames.ContainsKey((elf, address))).Distinct().ToList();
+        if (missing.Count > 0)
+        {
+            await LookUpAsync(elf, missing, cancellationToken);
+        }
+
+        return addresses.Select(address => _frames.GetValueOrDefault((elf, address)) ?? Unresolved(address)).ToList();
+    }
+
+    private static SymbolizedFrame Unresolved(uint address) => new(address, "??", "??:0");
+
+    // addr2line -f prints two lines per address: the function, then file:line
+    private async Task LookUpAsync(string elf, List<uint> addresses, CancellationToken cancellationToken)
+    {
+        var startInfo = new ProcessStartInfo(_settings.Addr2LinePath)
+        {
+            RedirectStandardOutput = true,
+            RedirectStandardError = true,
+            UseShellExecute = false
+        };
+        foreach (var argument in new[] { "-f", "-C", "-e", elf })
+        {
+            startInfo.ArgumentList.Add(argument);
+        }
+        foreach (var address in addresses)
+        {
+            startInfo.ArgumentList.Add($"0x{address:x8}");
+        }
+
+        try
+        {
+            using var process = Process.Start(startInfo)!;
+            using var timeout = CancellationTokenSource.CreateLinkedTokenSource(cancellationToken);
+            timeout.CancelAfter(Addr2LineTimeout);
+
+            var output = await process.StandardOutput.ReadToEndAsync(timeout.Token);
+            await process.WaitForExitAsync(timeout.Token);
+
+            var lines = output.Split('\n', StringSplitOptions.TrimEntries);
+            for (var i = 0; i < addresses.Count && 2 * i + 1 < lines.Length; i++)
+            {
+                _frames[(elf, addresses[i])] = new SymbolizedFrame(addresses[i], lines[2 * i], lines[2 * i + 1]);
+            }
+        }
+        catch (Win32Exception ex)
+        {
+            _toolMissing = true;
+            _logger.LogWarning("Diagnostics: cannot run {Tool} ({Error}); stalls are grouped by step and build only",
+                _settings.Addr2LinePath, ex.Message);
+        }
+        catch (OperationCanceledException) when (!cancellationToken.IsCancellationRequested)
+        {
+            _logger.LogWarning("Diagnostics: addr2line timed out on {Elf}", elf);
+        }
+    }
+
+    // Hashes new and changed files only
+    private List<(string Path, string Digest)> ScanElfFiles()
+    {
+        lock (_elfLock)
+        {
+            if (!Directory.Exists(_settings.SymbolDirectory)) return new List<(string, string)>();
+
+            var seen = new HashSet<string>();
+            foreach (var path in Directory.EnumerateFiles(_settings.SymbolDirectory, "*.elf", SearchOption.AllDirectories))
+            {
+                seen.Add(path);
+                var modified = File.GetLastWriteTimeUtc(path);
+                if (_elfByPath.TryGetValue(path, out var known) && known.Modified == modified) continue;
+
+                using var stream = File.OpenRead(path);
+                var digest = Convert.ToHexString(SHA256.HashData(stream)).ToLowerInvariant();
+                _elfByPath[path] = (digest, modified);
+            }
+
+            foreach (var gone in _elfByPath.Keys.Where(path => !seen.Contains(path)).ToList())
+            {
+                _elfByPath.Remove(gone);
+            }
+
+            return _elfByPath.Select(entry => (entry.Key, entry.Value.Digest)).ToList();
+        }
+    }
+}
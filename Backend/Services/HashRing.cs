@@ -0,0 +1,63 @@
+using System.Text;
+
+namespace SpotiDialBackend.Services;
+
+/// <summary>
+/// Consistent hash ring over the backend instances. Every instance is placed at a number of
+/// points on a 64-bit ring and a key belongs to the first point at or after its own hash, so
+/// an instance joining or leaving only moves the keys next to its points. Immutable; membership
+/// changes build a new ring.
+/// </summary>
+public sealed class HashRing
+{
+    private readonly ulong[] _points;
+    private readonly string[] _owners;
+
+    public HashRing(IEnumerable<string> members, int virtualNodes)
+    {
+        Members = members.Distinct().OrderBy(member => member, StringComparer.Ordinal).ToArray();
+        virtualNodes = Math.Max(virtualNodes, 1);
+
+        var points = new List<(ulong Point, string Owner)>(Members.Count * virtualNodes);
+        foreach (var member in Members)
+        {
+            for (var i = 0; i < virtualNodes; i++)
+            {
+                points.Add((Hash($"{member}#{i}"), member));
+            }
+        }
+
+        // Ties (practically never) go to the lower name, the same on every instance
+        points.Sort((a, b) => a.Point != b.Point
+            ? a.Point.CompareTo(b.Point)
+            : string.CompareOrdinal(a.Owner, b.Owner));
+
+        _points = points.Select(point => point.Point).ToArray();
+        _owners = points.Select(point => point.Owner).ToArray();
+    }
+
+    public IReadOnlyList<string> Members { get; }
+
+    public string? Owner(string key)
+    {
+        if (_points.Length == 0) return null;
+
+        var index = Array.BinarySearch(_points, Hash(key));
+        if (index < 0) index = ~index;
+        return _owners[index == _points.Length ? 0 : index];
+    }
+
+    // FNV-1a, finished with the splitmix64 mixer so names differing in one character spread out
+    public static ulong Hash(string value)
+    {
+        var hash = 0xCBF29CE484222325UL;
+        foreach (var b in Encoding.UTF8.GetBytes(value))
+        {
+            hash = (hash ^ b) * 0x100000001B3UL;
+        }
+
+        hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9UL;
+        hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBUL;
+        return hash ^ (hash >> 31);
+    }
+}
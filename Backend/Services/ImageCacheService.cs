@@ -0,0 +1,336 @@
+using System.Collections.Concurrent;
+using System.Diagnostics;
+using System.Security.Cryptography;
+using System.Text;
+using Microsoft.Extensions.Logging;
+using Microsoft.Extensions.Options;
+using SpotiDialBackend.Models;
+
+namespace SpotiDialBackend.Services;
+
+public static class HttpClientNames
+{
+    // Shared connection pool for the Spotify API and image downloads
+    public const string Spotify = "spotify";
+}
+
+/// <summary>
+/// Device-ready album art, addressed by a hash of the source URL and the output format.
+/// Lookups go memory (LRU) -> disk -> download and process. Downloads reuse the shared
+/// connection pool and land in pooled buffers. Every cover that passes through also leaves a
+/// colour preview behind, small enough to ride along with the status.
+/// </summary>
+public class ImageCacheService
+{
+    private readonly ILogger<ImageCacheService> _logger;
+    private readonly ImageCacheSettings _settings;
+    private readonly IHttpClientFactory _httpClientFactory;
+    private readonly ImageProcessingService _imageService;
+    private readonly LatencyHistogram _processLatency = new();
+
+    // Memory tier: most recently used first
+    private readonly object _lock = new();
+    private readonly Dictionary<string, LinkedListNode<(string Key, byte[] Data)>> _memory = new();
+    private readonly LinkedList<(string Key, byte[] Data)> _lru = new();
+    private long _memoryBytes;
+
+    private long _diskBytes = -1;
+
+    // Misses on the same cover share one disk read or download
+    private readonly ConcurrentDictionary<string, Lazy<Task<byte[]?>>> _loads = new();
+
+    // Previews are a few dozen bytes each, so they are bounded by count and outlive the images
+    private const int MaxPreviews = 1024;
+    private readonly Dictionary<string, string> _previews = new();
+    private readonly Queue<string> _previewOrder = new();
+
+    private long _requests;
+    private long _memoryHits;
+    private long _diskHits;
+    private long _misses;
+    private long _downloadedBytes;
+    private long _processed;
+    private long _allocatedBytes;
+
+    public ImageCacheService(
+        ILogger<ImageCacheService> logger,
+        IOptions<AppSettings> settings,
+        IHttpClientFactory httpClientFactory,
+        ImageProcessingService imageService)
+    {
+        _logger = logger;
+        _settings = settings.Value.ImageCache;
+        _httpClientFactory = httpClientFactory;
+        _imageService = imageService;
+    }
+
+    /// <summary>
+    /// The processed image for a cover URL. The returned array is shared; do not modify it.
+    /// </summary>
+    public async Task<byte[]?> GetDeviceImageAsync(string imageUrl, CancellationToken cancellationToken = default)
+    {
+        Interlocked.Increment(ref _requests);
+        var key = CacheKey(imageUrl);
+
+        if (TryGetMemory(key, out var cached))
+        {
+            Interlocked.Increment(ref _memoryHits);
+            EnsurePreview(key, cached!);
+            return cached;
+        }
+
+        // A caller that gives up does not cancel the load for the others
+        var load = new Lazy<Task<byte[]?>>(() => LoadAsync(key, imageUrl));
+        var shared = _loads.GetOrAdd(key, load);
+        if (ReferenceEquals(shared, load))
+        {
+            _ = load.Value.ContinueWith(_ => _loads.TryRemove(KeyValuePair.Create(key, load)), TaskScheduler.Default);
+        }
+        return await shared.Value.WaitAsync(cancellationToken);
+    }
+
+    private async Task<byte[]?> LoadAsync(string key, string imageUrl)
+    {
+        var path = DiskPath(key);
+        try
+        {
+            if (File.Exists(path))
+            {
+                var data = await File.ReadAllBytesAsync(path);
+                File.SetLastWriteTimeUtc(path, DateTime.UtcNow);
+                Interlocked.Increment(ref _diskHits);
+                AddMemory(key, data);
+                EnsurePreview(key, data);
+                return data;
+            }
+        }
+        catch (Exception ex)
+        {
+            _logger.LogWarning(ex, "Ignoring unreadable cached image {Path}", path);
+        }
+
+        Interlocked.Increment(ref _misses);
+
+        var processed = await DownloadAndProcessAsync(imageUrl, CancellationToken.None);
+        if (processed == null) return null;
+
+        AddMemory(key, processed);
+        EnsurePreview(key, processed);
+        await SaveDiskAsync(path, processed);
+        return processed;
+    }
+
+    /// <summary>
+    /// The colour preview of a cover that has been fetched before, without waiting for anything.
+    /// </summary>
+    public string? TryGetPreview(string imageUrl)
+    {
+        if (_settings.PreviewGrid <= 0) return null;
+
+        var key = CacheKey(imageUrl);
+        lock (_lock)
+        {
+            return _previews.GetValueOrDefault(key);
+        }
+    }
+
+    public ImageCacheMetrics GetMetrics()
+    {
+        var requests = Interlocked.Read(ref _requests);
+        var hits = Interlocked.Read(ref _memoryHits) + Interlocked.Read(ref _diskHits);
+        var processed = Interlocked.Read(ref _processed);
+
+        lock (_lock)
+        {
+            return new ImageCacheMetrics
+            {
+                Requests = requests,
+                MemoryHits = Interlocked.Read(ref _memoryHits),
+                DiskHits = Interlocked.Read(ref _diskHits),
+                Misses = Interlocked.Read(ref _misses),
+                HitRatio = requests > 0 ? Math.Round((double)hits / requests, 3) : 0,
+                DownloadedBytes = Interlocked.Read(ref _downloadedBytes),
+                AllocatedBytesPerImage = processed > 0 ? Interlocked.Read(ref _allocatedBytes) / processed : 0,
+                ProcessP50Ms = _processLatency.Percentile(50),
+                ProcessP99Ms = _processLatency.Percentile(99),
+                MemoryCacheBytes = _memoryBytes,
+                MemoryCacheEntries = _memory.Count,
+                DiskCacheBytes = Math.Max(Interlocked.Read(ref _diskBytes), 0)
+            };
+        }
+    }
+
+    private async Task<byte[]?> DownloadAndProcessAsync(string imageUrl, CancellationToken cancellationToken)
+    {
+        try
+        {
+            var httpClient = _httpClientFactory.CreateClient(HttpClientNames.Spotify);
+            using var response = await httpClient.GetAsync(imageUrl, HttpCompletionOption.ResponseHeadersRead, cancellationToken);
+            response.EnsureSuccessStatusCode();
+
+            var contentLength = (int)(response.Content.Headers.ContentLength ?? 64 * 1024);
+            using var source = new PooledMemoryStream(contentLength);
+            await response.Content.CopyToAsync(source, cancellationToken);
+            Interlocked.Add(ref _downloadedBytes, source.Length);
+
+            // Processing is synchronous so the thread's allocation counter covers all of it
+            var started = Stopwatch.GetTimestamp();
+            var allocatedBefore = GC.GetAllocatedBytesForCurrentThread();
+
+            var processed = _imageService.ProcessImageForDevice(source.WrittenSegment);
+
+            Interlocked.Add(ref _allocatedBytes, GC.GetAllocatedBytesForCurrentThread() - allocatedBefore);
+            Interlocked.Increment(ref _processed);
+            _processLatency.Record(Stopwatch.GetElapsedTime(started).TotalMilliseconds);
+
+            return processed;
+        }
+        catch (Exception ex) when (ex is not OperationCanceledException)
+        {
+            _logger.LogError(ex, "Error downloading album image");
+            return null;
+        }
+    }
+
+    private bool TryGetMemory(string key, out byte[]? data)
+    {
+        lock (_lock)
+        {
+            if (_memory.TryGetValue(key, out var node))
+            {
+                _lru.Remove(node);
+                _lru.AddFirst(node);
+                data = node.Value.Data;
+                return true;
+            }
+        }
+
+        data = null;
+        return false;
+    }
+
+    private void AddMemory(string key, byte[] data)
+    {
+        var maxBytes = (long)_settings.MemoryCacheMb * 1024 * 1024;
+        if (data.Length > maxBytes) return;
+
+        lock (_lock)
+        {
+            if (_memory.ContainsKey(key)) return;
+
+            _memory[key] = _lru.AddFirst((key, data));
+            _memoryBytes += data.Length;
+
+            while (_memoryBytes > maxBytes && _lru.Last != null)
+            {
+                var oldest = _lru.Last;
+                _lru.RemoveLast();
+                _memory.Remove(oldest.Value.Key);
+                _memoryBytes -= oldest.Value.Data.Length;
+            }
+        }
+    }
+
+    private void EnsurePreview(string key, byte[] data)
+    {
+        if (_settings.PreviewGrid <= 0) return;
+
+        lock (_lock)
+        {
+            if (_previews.ContainsKey(key)) return;
+        }
+
+        var preview = _imageService.CreatePreview(data, _settings.PreviewGrid);
+        if (preview == null) return;
+
+        lock (_lock)
+        {
+            if (!_previews.TryAdd(key, preview)) return;
+
+            _previewOrder.Enqueue(key);
+            while (_previewOrder.Count > MaxPreviews)
+            {
+                _previews.Remove(_previewOrder.Dequeue());
+            }
+        }
+    }
+
+    private async Task SaveDiskAsync(string path, byte[] data)
+    {
+        if (_settings.DiskCacheMb <= 0) return;
+
+        try
+        {
+            // Unique, as instances of a cluster may share the directory
+            var temp = $"{path}.{Guid.NewGuid():N}.tmp";
+            await File.WriteAllBytesAsync(temp, data);
+            File.Move(temp, path, overwrite: true);
+
+            if (Interlocked.Read(ref _diskBytes) < 0)
+            {
+                Interlocked.Exchange(ref _diskBytes, DirectoryBytes());
+            }
+            else
+            {
+                Interlocked.Add(ref _diskBytes, data.Length);
+            }
+
+            if (Interlocked.Read(ref _diskBytes) > (long)_settings.DiskCacheMb * 1024 * 1024)
+            {
+                TrimDisk();
+            }
+        }
+        catch (Exception ex)
+        {
+            _logger.LogError(ex, "Error saving image to cache {Path}", path);
+        }
+    }
+
+    // Drop the least recently used files (hits touch the write time) down to 80% of the budget
+    private void TrimDisk()
+    {
+        var target = (long)_settings.DiskCacheMb * 1024 * 1024 * 8 / 10;
+        var files = new DirectoryInfo(CacheDirectory()).GetFiles("*.jpg")
+            .OrderBy(f => f.LastWriteTimeUtc)
+            .ToList();
+
+        var total = files.Sum(f => f.Length);
+        foreach (var file in files)
+        {
+            if (total <= target) break;
+
+            try
+            {
+                file.Delete();
+                total -= file.Length;
+            }
+            catch (IOException)
+            {
+                // In use by a concurrent read; try again next time
+            }
+        }
+
+        Interlocked.Exchange(ref _diskBytes, total);
+        _logger.LogInformation("Trimmed image cache to {Bytes} bytes", total);
+    }
+
+    private long DirectoryBytes() =>
+        new DirectoryInfo(CacheDirectory()).GetFiles("*.jpg").Sum(f => f.Length);
+
+    private static string CacheKey(string imageUrl)
+    {
+        var hash = SHA256.HashData(Encoding.UTF8.GetBytes($"{imageUrl}|{ImageProcessingService.OutputFormat}"));
+        return Convert.ToHexString(hash).ToLowerInvariant();
+    }
+
+    private string DiskPath(string key) => Path.Combine(CacheDirectory(), $"{key}.jpg");
+
+    private string CacheDirectory()
+    {
+        var directory = string.IsNullOrEmpty(_settings.CacheDirectory)
+            ? Path.Combine(AppContext.BaseDirectory, "image-cache")
+            : _settings.CacheDirectory;
+        Directory.CreateDirectory(directory);
+        return directory;
+    }
+}
@@ -1,5 +1,7 @@
 using Microsoft.Extensions.Logging;
 using SixLabors.ImageSharp;
+using SixLabors.ImageSharp.Formats;
+using SixLabors.ImageSharp.PixelFormats;
 using SixLabors.ImageSharp.Processing;
 using SixLabors.ImageSharp.Formats.Jpeg;
 
@@ -8,17 +10,39 @@ namespace SpotiDialBackend.Services;
 public class ImageProcessingService
 {
     private readonly ILogger<ImageProcessingService> _logger;
-    private const int TargetWidth = 240;  // M5Dial display width
-    private const int TargetHeight = 240; // M5Dial display height
+    public const int TargetWidth = 240;  // M5Dial display width
+    public const int TargetHeight = 240; // M5Dial display height
+    private const int JpegQuality = 80;
+
+    // Largest preview grid the dial decodes (ART_PREVIEW_MAX_GRID in the firmware)
+    public const int MaxPreviewGrid = 8;
+
+    // Identifies the output format in image cache keys; change it when the output changes
+    public const string OutputFormat = "jpeg-240x240-q80";
+
+    // Let the JPEG decoder scale down while decoding (album covers are square)
+    private static readonly DecoderOptions DecoderOptions = new()
+    {
+        TargetSize = new Size(TargetWidth, TargetHeight)
+    };
+
+    private static readonly JpegEncoder Encoder = new()
+    {
+        Quality = JpegQuality
+    };
 
     public ImageProcessingService(ILogger<ImageProcessingService> logger)
     {
         _logger = logger;
     }
 
-    public async Task<byte[]?> ProcessImageForDeviceAsync(byte[] imageData)
+    /// <summary>
+    /// Crop and re-encode an image for the display. Reads the source in place and encodes into
+    /// a pooled buffer, so the returned array is the only allocation that outlives the call.
+    /// </summary>
+    public byte[]? ProcessImageForDevice(ArraySegment<byte> imageData)
     {
-        if (imageData == null || imageData.Length == 0)
+        if (imageData.Count == 0)
         {
             _logger.LogWarning("Empty image data provided");
             return null;
@@ -26,8 +50,8 @@ public class ImageProcessingService
 
         try
         {
-            using var inputStream = new MemoryStream(imageData);
-            using var image = await Image.LoadAsync(inputStream);
+            using var inputStream = new MemoryStream(imageData.Array!, imageData.Offset, imageData.Count, writable: false);
+            using var image = Image.Load(DecoderOptions, inputStream);
 
             // Resize to fit M5Dial display
             image.Mutate(x => x.Resize(new ResizeOptions
@@ -38,15 +62,12 @@ public class ImageProcessingService
             }));
 
             // Save as JPEG with compression
-            using var outputStream = new MemoryStream();
-            await image.SaveAsJpegAsync(outputStream, new JpegEncoder
-            {
-                Quality = 80
-            });
+            using var outputStream = new PooledMemoryStream(32 * 1024);
+            image.SaveAsJpeg(outputStream, Encoder);
 
             var result = outputStream.ToArray();
             _logger.LogInformation("Image processed: {OriginalSize} bytes -> {ProcessedSize} bytes",
-                imageData.Length, result.Length);
+                imageData.Count, result.Length);
 
             return result;
         }
@@ -56,4 +77,35 @@ public class ImageProcessingService
             return null;
         }
     }
+
+    /// <summary>
+    /// A few dozen bytes the dial can show while the full cover is on its way: the processed
+    /// image averaged down to a grid x grid block of colours, base64 encoded as
+    /// [width, height, then R, G, B per cell row by row]. The dial scales it up smoothly.
+    /// </summary>
+    public string? CreatePreview(byte[] deviceImage, int grid)
+    {
+        grid = Math.Min(grid, MaxPreviewGrid);
+        if (grid <= 0 || deviceImage.Length == 0) return null;
+
+        try
+        {
+            // The JPEG decoder scales by up to 1/8 on its own, which does most of the averaging
+            var options = new DecoderOptions { TargetSize = new Size(grid * 8, grid * 8) };
+            using var inputStream = new MemoryStream(deviceImage, writable: false);
+            using var image = Image.Load<Rgb24>(options, inputStream);
+            image.Mutate(x => x.Resize(grid, grid, KnownResamplers.Box));
+
+            var preview = new byte[2 + grid * grid * 3];
+            preview[0] = (byte)grid;
+            preview[1] = (byte)grid;
+            image.CopyPixelDataTo(preview.AsSpan(2));
+            return Convert.ToBase64String(preview);
+        }
+        catch (Exception ex)
+        {
+            _logger.LogError(ex, "Error creating image preview");
+            return null;
+        }
+    }
 }
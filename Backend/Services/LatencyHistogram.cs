@@ -0,0 +1,80 @@
+namespace SpotiDialBackend.Services;
+
+/// <summary>
+/// Fixed-bucket latency histogram. Thread-safe; percentiles are reported as bucket upper bounds.
+/// </summary>
+public class LatencyHistogram
+{
+    // Bucket upper bounds in milliseconds; the last bucket catches everything above
+    private static readonly double[] BucketBoundsMs =
+    {
+        1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, double.PositiveInfinity
+    };
+
+    private readonly long[] _buckets = new long[BucketBoundsMs.Length];
+    private readonly object _lock = new();
+    private long _count;
+    private double _sumMs;
+    private double _maxMs;
+
+    public long Count
+    {
+        get { lock (_lock) return _count; }
+    }
+
+    public double MaxMs
+    {
+        get { lock (_lock) return _maxMs; }
+    }
+
+    public void Record(double milliseconds)
+    {
+        if (milliseconds < 0) milliseconds = 0;
+
+        lock (_lock)
+        {
+            var index = Array.FindIndex(BucketBoundsMs, bound => milliseconds <= bound);
+            _buckets[index]++;
+            _count++;
+            _sumMs += milliseconds;
+            _maxMs = Math.Max(_maxMs, milliseconds);
+        }
+    }
+
+    public double Percentile(double percentile)
+    {
+        lock (_lock)
+        {
+            if (_count == 0) return 0;
+
+            var target = (long)Math.Ceiling(_count * percentile / 100.0);
+            long seen = 0;
+            for (var i = 0; i < _buckets.Length; i++)
+            {
+                seen += _buckets[i];
+                if (seen >= target)
+                {
+                    return Math.Min(BucketBoundsMs[i], _maxMs);
+                }
+            }
+
+            return _maxMs;
+        }
+    }
+
+    public override string ToString()
+    {
+        lock (_lock)
+        {
+            if (_count == 0) return "no samples";
+
+            var buckets = string.Join(" ", BucketBoundsMs
+                .Select((bound, i) => (bound, count: _buckets[i]))
+                .Where(b => b.count > 0)
+                .Select(b => double.IsPositiveInfinity(b.bound) ? $">5000:{b.count}" : $"<={b.bound}:{b.count}"));
+
+            return $"n={_count} avg={_sumMs / _count:F1}ms p50<={Percentile(50):F0}ms " +
+                   $"p90<={Percentile(90):F0}ms p99<={Percentile(99):F0}ms max={_maxMs:F1}ms [{buckets}]";
+        }
+    }
+}
@@ -0,0 +1,330 @@
+using System.Diagnostics;
+using System.Text.Json;
+using System.Text.Json.Serialization;
+using Microsoft.Extensions.Logging;
+using Microsoft.Extensions.Options;
+using SpotiDialBackend.Models;
+
+namespace SpotiDialBackend.Services;
+
+/// <summary>
+/// Playlists and saved albums cached in memory and on disk, one file per Spotify user.
+/// Fresh entries are served without touching the API. Otherwise the library is synced
+/// incrementally: pages are fetched until one matches the cache (shifted by the change in
+/// total, since new items show up at the top), and the cached tail is reused from there.
+/// </summary>
+public class LibraryCacheService
+{
+    private readonly ILogger<LibraryCacheService> _logger;
+    private readonly LibrarySettings _settings;
+    private readonly SpotifyService _spotifyService;
+    private readonly SemaphoreSlim _lock = new(1, 1);
+    private readonly LatencyHistogram _firstEntryLatency = new();
+
+    private LibraryCacheFile? _cache;
+
+    private long _browses;
+    private long _cacheHits;
+    private long _pagesFetched;
+    private long _pagesReused;
+
+    private static readonly JsonSerializerOptions FileJsonOptions = new()
+    {
+        WriteIndented = false
+    };
+
+    public LibraryCacheService(
+        ILogger<LibraryCacheService> logger,
+        IOptions<AppSettings> settings,
+        SpotifyService spotifyService)
+    {
+        _logger = logger;
+        _settings = settings.Value.Library;
+        _spotifyService = spotifyService;
+    }
+
+    /// <summary>
+    /// Hand the playlists to publish, first a partial list as soon as there is something to
+    /// show, then the complete one if it differs. Complete lists also go to publishTable as a
+    /// name table (see <see cref="NameTableEncoder"/>) when enabled.
+    /// </summary>
+    public Task BrowsePlaylistsAsync(Func<List<PlaylistInfo>, Task> publish, Func<byte[], Task> publishTable,
+        CancellationToken cancellationToken)
+    {
+        return BrowseAsync("playlists", c => c.Playlists, _spotifyService.GetPlaylistsPageAsync,
+            p => (p.Id, p.Name), publish, publishTable, cancellationToken);
+    }
+
+    public Task BrowseAlbumsAsync(Func<List<AlbumInfo>, Task> publish, Func<byte[], Task> publishTable,
+        CancellationToken cancellationToken)
+    {
+        return BrowseAsync("albums", c => c.Albums, _spotifyService.GetAlbumsPageAsync,
+            a => (a.Id, a.Name), publish, publishTable, cancellationToken);
+    }
+
+    public LibraryMetrics GetMetrics()
+    {
+        return new LibraryMetrics
+        {
+            Browses = Interlocked.Read(ref _browses),
+            CacheHits = Interlocked.Read(ref _cacheHits),
+            PagesFetched = Interlocked.Read(ref _pagesFetched),
+            PagesReused = Interlocked.Read(ref _pagesReused),
+            FirstEntryP50Ms = _firstEntryLatency.Percentile(50),
+            FirstEntryP90Ms = _firstEntryLatency.Percentile(90),
+            FirstEntryMaxMs = Math.Round(_firstEntryLatency.MaxMs, 1)
+        };
+    }
+
+    private async Task BrowseAsync<T>(
+        string kind,
+        Func<LibraryCacheFile, CachedList<T>> select,
+        Func<int, int, CancellationToken, Task<LibraryPage<T>>> fetchPage,
+        Func<T, (string Id, string Name)> describe,
+        Func<List<T>, Task> publish,
+        Func<byte[], Task> publishTable,
+        CancellationToken cancellationToken)
+    {
+        var started = Stopwatch.GetTimestamp();
+        Interlocked.Increment(ref _browses);
+
+        // One sync at a time; a browse that waited here usually finds the cache fresh
+        await _lock.WaitAsync(cancellationToken);
+        try
+        {
+            var cache = await LoadAsync(cancellationToken);
+            if (cache == null) return;
+
+            var cached = select(cache);
+            var age = DateTime.UtcNow - cached.SyncedAt;
+            var published = false;
+            var tablePublished = false;
+
+            if (cached.SyncedAt != default)
+            {
+                await publish(cached.Items.Select(e => e.Info).ToList());
+                RecordFirstEntry(started, false);
+                published = true;
+                await PublishTableAsync(kind, cached, describe, publishTable);
+                tablePublished = true;
+
+                if (age < TimeSpan.FromSeconds(_settings.CacheTtlSeconds))
+                {
+                    Interlocked.Increment(ref _cacheHits);
+                    return;
+                }
+            }
+
+            // A full walk now and then catches edits the early stop cannot see
+            var fullSync = DateTime.UtcNow - cached.FullSyncedAt >= TimeSpan.FromMinutes(_settings.FullSyncIntervalMinutes);
+            var (entries, changed) = await SyncAsync(cached, fetchPage, fullSync, async firstPage =>
+            {
+                if (published) return;
+                await publish(firstPage.Select(e => e.Info).ToList());
+                RecordFirstEntry(started, false);
+                published = true;
+            }, cancellationToken);
+
+            cached.Items = entries;
+            cached.SyncedAt = DateTime.UtcNow;
+            if (changed)
+            {
+                cached.Table = null;
+            }
+            if (fullSync)
+            {
+                cached.FullSyncedAt = cached.SyncedAt;
+            }
+
+            if (changed || !published)
+            {
+                await publish(entries.Select(e => e.Info).ToList());
+                RecordFirstEntry(started, published);
+            }
+
+            if (changed || !tablePublished)
+            {
+                await PublishTableAsync(kind, cached, describe, publishTable);
+            }
+
+            if (changed)
+            {
+                await SaveAsync(cache);
+            }
+
+            _logger.LogInformation("Library {Kind}: {Count} items, {Changed} ({Elapsed:F0} ms)",
+                kind, entries.Count, changed ? "updated" : "unchanged", Stopwatch.GetElapsedTime(started).TotalMilliseconds);
+        }
+        catch (Exception ex) when (ex is not OperationCanceledException)
+        {
+            _logger.LogError(ex, "Error syncing library {Kind}", kind);
+        }
+        finally
+        {
+            _lock.Release();
+        }
+    }
+
+    private async Task<(List<LibraryEntry<T>> Entries, bool Changed)> SyncAsync<T>(
+        CachedList<T> cached,
+        Func<int, int, CancellationToken, Task<LibraryPage<T>>> fetchPage,
+        bool fullSync,
+        Func<List<LibraryEntry<T>>, Task> onFirstPage,
+        CancellationToken cancellationToken)
+    {
+        var pageSize = Math.Clamp(_settings.PageSize, 1, 50);
+        var previous = cached.Items;
+        var entries = new List<LibraryEntry<T>>(previous.Count);
+        var changed = false;
+
+        while (true)
+        {
+            var page = await fetchPage(entries.Count, pageSize, cancellationToken);
+            Interlocked.Increment(ref _pagesFetched);
+
+            // Stream the first page when more are coming
+            if (entries.Count == 0 && page.Items.Count < page.Total)
+            {
+                await onFirstPage(page.Items);
+            }
+
+            // Items added or removed above this page move everything below by the difference
+            var shift = page.Total - previous.Count;
+            var matches = PageMatches(previous, entries.Count - shift, page.Items);
+            changed |= !matches || shift != 0;
+            entries.AddRange(page.Items);
+
+            if (page.Items.Count == 0 || entries.Count >= page.Total)
+            {
+                changed |= entries.Count != previous.Count;
+                break;
+            }
+
+            // Same keys in the same order: assume the rest is unchanged
+            if (matches && !fullSync)
+            {
+                var reused = page.Total - entries.Count;
+                entries.AddRange(previous.Skip(entries.Count - shift));
+                Interlocked.Add(ref _pagesReused, (reused + pageSize - 1) / pageSize);
+                break;
+            }
+        }
+
+        return (entries, changed);
+    }
+
+    private async Task PublishTableAsync<T>(string kind, CachedList<T> cached,
+        Func<T, (string Id, string Name)> describe, Func<byte[], Task> publishTable)
+    {
+        if (!_settings.NameTable) return;
+
+        // Encoded once per version of the list
+        if (cached.Table == null)
+        {
+            var started = Stopwatch.GetTimestamp();
+            cached.Table = NameTableEncoder.Encode(cached.Items.Select(e => describe(e.Info)), _settings.NameTableRestartInterval);
+
+            var count = Math.Max(cached.Items.Count, 1);
+            _logger.LogInformation("Name table {Kind}: {Count} entries, {Bytes} bytes ({PerEntry:F1} per entry), encoded in {Elapsed:F1} ms",
+                kind, cached.Items.Count, cached.Table.Length, (double)cached.Table.Length / count,
+                Stopwatch.GetElapsedTime(started).TotalMilliseconds);
+        }
+
+        await publishTable(cached.Table);
+    }
+
+    private static bool PageMatches<T>(List<LibraryEntry<T>> previous, int offset, List<LibraryEntry<T>> page)
+    {
+        if (offset < 0 || offset + page.Count > previous.Count) return false;
+
+        for (var i = 0; i < page.Count; i++)
+        {
+            if (previous[offset + i].Key != page[i].Key) return false;
+        }
+
+        return true;
+    }
+
+    private void RecordFirstEntry(long started, bool alreadyPublished)
+    {
+        if (alreadyPublished) return;
+        _firstEntryLatency.Record(Stopwatch.GetElapsedTime(started).TotalMilliseconds);
+    }
+
+    private async Task<LibraryCacheFile?> LoadAsync(CancellationToken cancellationToken)
+    {
+        var userId = await _spotifyService.GetCurrentUserIdAsync(cancellationToken);
+        if (userId == null) return null;
+
+        if (_cache?.UserId == userId) return _cache;
+
+        var path = CachePath(userId);
+        try
+        {
+            if (File.Exists(path))
+            {
+                await using var stream = File.OpenRead(path);
+                _cache = await JsonSerializer.DeserializeAsync<LibraryCacheFile>(stream, FileJsonOptions, cancellationToken);
+                _logger.LogInformation("Loaded library cache for {User}: {Playlists} playlists, {Albums} albums",
+                    userId, _cache?.Playlists.Items.Count, _cache?.Albums.Items.Count);
+            }
+        }
+        catch (Exception ex) when (ex is not OperationCanceledException)
+        {
+            _logger.LogWarning(ex, "Ignoring unreadable library cache {Path}", path);
+            _cache = null;
+        }
+
+        if (_cache?.UserId != userId)
+        {
+            _cache = new LibraryCacheFile { UserId = userId };
+        }
+
+        return _cache;
+    }
+
+    private async Task SaveAsync(LibraryCacheFile cache)
+    {
+        var path = CachePath(cache.UserId);
+        try
+        {
+            // Write then rename so a crash never leaves a half-written cache behind
+            var temp = path + ".tmp";
+            await using (var stream = File.Create(temp))
+            {
+                await JsonSerializer.SerializeAsync(stream, cache, FileJsonOptions);
+            }
+            File.Move(temp, path, overwrite: true);
+        }
+        catch (Exception ex)
+        {
+            _logger.LogError(ex, "Error saving library cache to {Path}", path);
+        }
+    }
+
+    private string CachePath(string userId)
+    {
+        var directory = string.IsNullOrEmpty(_settings.CacheDirectory) ? AppContext.BaseDirectory : _settings.CacheDirectory;
+        Directory.CreateDirectory(directory);
+
+        var safeId = string.Concat(userId.Select(c => char.IsLetterOrDigit(c) ? c : '_'));
+        return Path.Combine(directory, $"library_{safeId}.json");
+    }
+
+    private class LibraryCacheFile
+    {
+        public string UserId { get; set; } = string.Empty;
+        public CachedList<PlaylistInfo> Playlists { get; set; } = new();
+        public CachedList<AlbumInfo> Albums { get; set; } = new();
+    }
+
+    private class CachedList<T>
+    {
+        public DateTime SyncedAt { get; set; }
+        public DateTime FullSyncedAt { get; set; }
+        public List<LibraryEntry<T>> Items { get; set; } = new();
+
+        [JsonIgnore]
+        public byte[]? Table { get; set; }
+    }
+}
@@ -0,0 +1,97 @@
+namespace SpotiDialBackend.Services;
+
+/// <summary>
+/// LZSS as the dial decodes it, for firmware patches and compact payloads: a 1 bit and a
+/// literal byte, or a 0 bit, distance - 1 and length - 3, MSB first, padded with zero bits to a
+/// whole byte. A dictionary primes the window: matches may reach back into it, and the decoder
+/// starts out with the same bytes in its window.
+/// </summary>
+public static class Lzss
+{
+    public const int MinMatch = 3;
+    private const int ChainDepth = 64;
+
+    public static byte[] Compress(byte[] data, int windowBits, int lengthBits) =>
+        Compress(data, windowBits, lengthBits, ReadOnlySpan<byte>.Empty);
+
+    public static byte[] Compress(ReadOnlySpan<byte> data, int windowBits, int lengthBits, ReadOnlySpan<byte> dictionary)
+    {
+        var window = 1 << windowBits;
+        var maxMatch = (1 << lengthBits) - 1 + MinMatch;
+
+        // Dictionary and data in one buffer, so a match can run from one into the other
+        var buffer = new byte[dictionary.Length + data.Length];
+        dictionary.CopyTo(buffer);
+        data.CopyTo(buffer.AsSpan(dictionary.Length));
+
+        var output = new MemoryStream(data.Length / 2 + 16);
+        var head = new Dictionary<int, int>();
+        var previous = new int[buffer.Length];
+        ulong bits = 0;
+        var bitCount = 0;
+
+        void Put(uint value, int count)
+        {
+            bits = (bits << count) | value;
+            bitCount += count;
+            while (bitCount >= 8)
+            {
+                bitCount -= 8;
+                output.WriteByte((byte)(bits >> bitCount));
+            }
+            bits &= (1UL << bitCount) - 1;
+        }
+
+        void Insert(int position)
+        {
+            if (position + MinMatch > buffer.Length) return;
+            var key = buffer[position] | (buffer[position + 1] << 8) | (buffer[position + 2] << 16);
+            previous[position] = head.TryGetValue(key, out var last) ? last : -1;
+            head[key] = position;
+        }
+
+        for (var i = 0; i < dictionary.Length; i++) Insert(i);
+
+        var pos = dictionary.Length;
+        while (pos < buffer.Length)
+        {
+            int bestLength = 0, bestDistance = 0;
+
+            if (pos + MinMatch <= buffer.Length)
+            {
+                var key = buffer[pos] | (buffer[pos + 1] << 8) | (buffer[pos + 2] << 16);
+                var candidate = head.TryGetValue(key, out var last) ? last : -1;
+                var limit = Math.Min(maxMatch, buffer.Length - pos);
+
+                for (var depth = 0; candidate >= 0 && pos - candidate <= window && depth < ChainDepth; depth++)
+                {
+                    var length = 0;
+                    while (length < limit && buffer[candidate + length] == buffer[pos + length]) length++;
+                    if (length > bestLength)
+                    {
+                        bestLength = length;
+                        bestDistance = pos - candidate;
+                        if (length == limit) break;
+                    }
+                    candidate = previous[candidate];
+                }
+            }
+
+            if (bestLength >= MinMatch)
+            {
+                Put((uint)(((bestDistance - 1) << lengthBits) | (bestLength - MinMatch)), 1 + windowBits + lengthBits);
+                for (var i = 0; i < bestLength; i++) Insert(pos + i);
+                pos += bestLength;
+            }
+            else
+            {
+                Put(0x100u | buffer[pos], 9);
+                Insert(pos);
+                pos++;
+            }
+        }
+
+        if (bitCount > 0) Put(0, 8 - bitCount);
+        return output.ToArray();
+    }
+}
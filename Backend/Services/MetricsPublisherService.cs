@@ -0,0 +1,124 @@
+using Microsoft.Extensions.Hosting;
+using Microsoft.Extensions.Logging;
+using Microsoft.Extensions.Options;
+using SpotiDialBackend.Models;
+
+namespace SpotiDialBackend.Services;
+
+/// <summary>
+/// Periodically logs the backend's metrics and publishes them to the metrics topic.
+/// </summary>
+public class MetricsPublisherService : BackgroundService
+{
+    private readonly ILogger<MetricsPublisherService> _logger;
+    private readonly MetricsSettings _settings;
+    private readonly MqttService _mqttService;
+    private readonly CommandQueueService _commandQueue;
+    private readonly SpotifyService _spotifyService;
+    private readonly LibraryCacheService _libraryCache;
+    private readonly ImageCacheService _imageCache;
+    private readonly StallCollectorService _stallCollector;
+    private readonly ClusterMembership _membership;
+
+    public MetricsPublisherService(
+        ILogger<MetricsPublisherService> logger,
+        IOptions<AppSettings> settings,
+        MqttService mqttService,
+        CommandQueueService commandQueue,
+        SpotifyService spotifyService,
+        LibraryCacheService libraryCache,
+        ImageCacheService imageCache,
+        StallCollectorService stallCollector,
+        ClusterMembership membership)
+    {
+        _logger = logger;
+        _settings = settings.Value.Metrics;
+        _mqttService = mqttService;
+        _commandQueue = commandQueue;
+        _spotifyService = spotifyService;
+        _libraryCache = libraryCache;
+        _imageCache = imageCache;
+        _stallCollector = stallCollector;
+        _membership = membership;
+    }
+
+    protected override async Task ExecuteAsync(CancellationToken stoppingToken)
+    {
+        var interval = TimeSpan.FromSeconds(Math.Max(_settings.IntervalSeconds, 1));
+
+        while (!stoppingToken.IsCancellationRequested)
+        {
+            try
+            {
+                await Task.Delay(interval, stoppingToken);
+            }
+            catch (OperationCanceledException)
+            {
+                break;
+            }
+
+            var metrics = new BackendMetrics
+            {
+                CommandQueue = _commandQueue.GetMetrics(),
+                Playback = _spotifyService.GetPlaybackMetrics(),
+                Library = _libraryCache.GetMetrics(),
+                Images = _imageCache.GetMetrics(),
+                Cluster = _membership.Enabled ? _membership.GetMetrics() : null,
+                Stalls = _stallCollector.IsEnabled ? _stallCollector.GetMetrics() : null
+            };
+
+            var queue = metrics.CommandQueue;
+            if (queue.Received > 0)
+            {
+                _logger.LogInformation(
+                    "Command queue: {Received} received, {Executed} executed (x{Ratio}), {Coalesced} coalesced, " +
+                    "{Superseded} superseded, {Dropped} dropped, {Duplicates} duplicates, depth {Depth}/{MaxDepth}, " +
+                    "command->API p50<={P50}ms p99<={P99}ms",
+                    queue.Received, queue.Executed, queue.CoalesceRatio, queue.Coalesced,
+                    queue.Superseded, queue.Dropped, queue.Duplicates, queue.QueueDepth, queue.MaxQueueDepth,
+                    queue.ApiLatencyP50Ms, queue.ApiLatencyP99Ms);
+            }
+
+            var playback = metrics.Playback;
+            _logger.LogInformation(
+                "Spotify API: {Calls} calls ({CallsPerHour}/h), {Polls} polls ({PollsPerHour}/h), " +
+                "next poll in {Interval}ms, {RateLimited} rate limited, {TrackChanges} track changes, " +
+                "detection lag p50<={LagP50}ms p90<={LagP90}ms",
+                playback.ApiCalls, playback.ApiCallsPerHour, playback.Polls, playback.PollsPerHour,
+                playback.CurrentPollIntervalMs, playback.RateLimited, playback.TrackChanges,
+                playback.TrackChangeLagP50Ms, playback.TrackChangeLagP90Ms);
+
+            var library = metrics.Library;
+            if (library.Browses > 0)
+            {
+                _logger.LogInformation(
+                    "Library: {Browses} browses, {CacheHits} from cache, {PagesFetched} pages fetched, " +
+                    "{PagesReused} reused, first entry p50<={P50}ms p90<={P90}ms",
+                    library.Browses, library.CacheHits, library.PagesFetched, library.PagesReused,
+                    library.FirstEntryP50Ms, library.FirstEntryP90Ms);
+            }
+
+            var images = metrics.Images;
+            if (images.Requests > 0)
+            {
+                _logger.LogInformation(
+                    "Images: {Requests} requests, hit ratio {HitRatio} ({MemoryHits} memory, {DiskHits} disk), " +
+                    "{AllocatedBytes} bytes allocated per image, processing p50<={P50}ms p99<={P99}ms",
+                    images.Requests, images.HitRatio, images.MemoryHits, images.DiskHits,
+                    images.AllocatedBytesPerImage, images.ProcessP50Ms, images.ProcessP99Ms);
+            }
+
+            var cluster = metrics.Cluster;
+            if (cluster != null)
+            {
+                _logger.LogInformation(
+                    "Cluster: {Instance} of {Members} instances, {Received} received, {Forwarded} forwarded to their owner, " +
+                    "{ForwardedIn} forwarded here, {Handovers} ring changes ({LeasesExpired} expired leases)",
+                    cluster.InstanceId, cluster.Members, cluster.Received, cluster.Forwarded,
+                    cluster.ForwardedIn, cluster.Handovers, cluster.LeasesExpired);
+            }
+
+            await _mqttService.PublishMetricsAsync(metrics);
+        }
+    }
+}
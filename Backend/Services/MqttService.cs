@@ -1,3 +1,6 @@
+using System.Buffers.Binary;
+using System.Collections.Concurrent;
+using System.Diagnostics;
 using System.Text;
 using System.Text.Json;
 using Microsoft.Extensions.Logging;
@@ -5,6 +8,7 @@ using Microsoft.Extensions.Options;
 using MQTTnet;
 using MQTTnet.Client;
 using MQTTnet.Extensions.ManagedClient;
+using MQTTnet.Packets;
 using SpotiDialBackend.Models;
 
 namespace SpotiDialBackend.Services;
@@ -13,16 +17,48 @@ public class MqttService
 {
     private readonly ILogger<MqttService> _logger;
     private readonly MqttSettings _settings;
+    private readonly ClusterSettings _clusterSettings;
+    private readonly ClusterMembership _membership;
     private IManagedMqttClient? _mqttClient;
+    private ManagedMqttClientOptions? _managedOptions;
+    private int _reconnectDelayMs;
 
-    public event Action<DeviceCommand>? OnCommandReceived;
+    // Dials that negotiated the compact encoding, with the topics they get in it
+    private readonly ConcurrentDictionary<string, string[]> _compactClients = new();
 
-    public MqttService(ILogger<MqttService> logger, IOptions<AppSettings> settings)
+    // The firmware reads camelCase keys (trackName, id, name, ...)
+    private static readonly JsonSerializerOptions PublishJsonOptions = new()
+    {
+        PropertyNamingPolicy = JsonNamingPolicy.CamelCase
+    };
+
+    private static readonly JsonSerializerOptions ReceiveJsonOptions = new()
+    {
+        PropertyNameCaseInsensitive = true
+    };
+
+    // Awaited, so a slow handler holds back further messages instead of piling up work
+    public event Func<DeviceCommand, Task>? OnCommandReceived;
+    public event Action<TraceReport>? OnTraceReceived;
+    public event Func<OtaRequest, Task>? OnOtaRequest;
+    public event Action<StallReport>? OnStallReport;
+    public event Func<string, byte[], Task>? OnCoreDumpChunk;
+
+    public MqttService(ILogger<MqttService> logger, IOptions<AppSettings> settings, ClusterMembership membership)
     {
         _logger = logger;
         _settings = settings.Value.Mqtt;
+        _clusterSettings = settings.Value.Cluster;
+        _membership = membership;
     }
 
+    private const string CompactTopicSuffix = "/compact";
+
+    private string MemberTopicPrefix => $"{_clusterSettings.TopicPrefix}members/";
+
+    // Messages for a device another instance owns go to <prefix>forward/<owner>/<original topic>
+    private string ForwardTopicPrefix(string instanceId) => $"{_clusterSettings.TopicPrefix}forward/{instanceId}/";
+
     public async Task ConnectAsync()
     {
         try
@@ -35,25 +71,49 @@ public class MqttService
 
             var mqttClientOptions = new MqttClientOptionsBuilder()
                 .WithTcpServer(_settings.BrokerHost, _settings.BrokerPort)
-                .WithClientId(_settings.ClientId);
+                .WithClientId(_settings.ClientId)
+                .WithCleanSession(_settings.CleanSession);
+
+            if (_membership.Enabled)
+            {
+                // A session left behind on the broker would keep taking its share of the commands
+                // while the instance is gone, so instances always start clean. The will clears our
+                // heartbeat, which hands our devices over before the lease runs out.
+                mqttClientOptions
+                    .WithClientId($"{_settings.ClientId}-{_membership.InstanceId}")
+                    .WithProtocolVersion(MQTTnet.Formatter.MqttProtocolVersion.V500)
+                    .WithCleanSession(true)
+                    .WithWillTopic(MemberTopicPrefix + _membership.InstanceId)
+                    .WithWillPayload(Array.Empty<byte>())
+                    .WithWillRetain(true)
+                    .WithWillQualityOfServiceLevel(MQTTnet.Protocol.MqttQualityOfServiceLevel.AtLeastOnce);
+            }
 
             if (!string.IsNullOrEmpty(_settings.Username))
             {
                 mqttClientOptions.WithCredentials(_settings.Username, _settings.Password);
             }
 
-            var managedOptions = new ManagedMqttClientOptionsBuilder()
-                .WithAutoReconnectDelay(TimeSpan.FromSeconds(5))
+            _reconnectDelayMs = Math.Max(_settings.ReconnectMinDelayMs, 100);
+            _managedOptions = new ManagedMqttClientOptionsBuilder()
+                .WithAutoReconnectDelay(TimeSpan.FromMilliseconds(_reconnectDelayMs))
                 .WithClientOptions(mqttClientOptions.Build())
                 .Build();
 
             _mqttClient.ApplicationMessageReceivedAsync += OnMessageReceivedAsync;
             _mqttClient.ConnectedAsync += OnConnectedAsync;
             _mqttClient.DisconnectedAsync += OnDisconnectedAsync;
+            _mqttClient.ConnectingFailedAsync += OnConnectingFailedAsync;
+
+            await _mqttClient.StartAsync(_managedOptions);
 
-            await _mqttClient.StartAsync(managedOptions);
+            // The managed client remembers these and only sends them again when the broker
+            // did not keep our session
+            await _mqttClient.SubscribeAsync(Subscriptions());
 
-            _logger.LogInformation("MQTT client started");
+            _logger.LogInformation("MQTT client started, subscribed to {CommandTopic} and {TraceTopic}{Shared}",
+                _settings.CommandTopic, _settings.TraceTopic,
+                _membership.Enabled ? $" shared with group {_clusterSettings.SharedGroup}" : "");
         }
         catch (Exception ex)
         {
@@ -62,19 +122,59 @@ public class MqttService
         }
     }
 
-    private async Task OnConnectedAsync(MqttClientConnectedEventArgs args)
+    private List<MqttTopicFilter> Subscriptions()
     {
-        _logger.LogInformation("Connected to MQTT broker");
-
-        try
+        if (!_membership.Enabled)
         {
-            await _mqttClient!.SubscribeAsync(_settings.CommandTopic);
-            _logger.LogInformation("Subscribed to topic: {Topic}", _settings.CommandTopic);
+            return new List<MqttTopicFilter>
+            {
+                new MqttTopicFilterBuilder().WithTopic(_settings.CommandTopic).WithAtLeastOnceQoS().Build(),
+                new MqttTopicFilterBuilder().WithTopic(_settings.TraceTopic).WithAtMostOnceQoS().Build(),
+                new MqttTopicFilterBuilder().WithTopic(_settings.OtaRequestTopic).WithAtMostOnceQoS().Build(),
+                new MqttTopicFilterBuilder().WithTopic(_settings.EncodingTopicPrefix + "+/request").WithAtLeastOnceQoS().Build(),
+                new MqttTopicFilterBuilder().WithTopic(_settings.StallTopic).WithAtMostOnceQoS().Build(),
+                new MqttTopicFilterBuilder().WithTopic(_settings.CoreDumpTopicPrefix + "+").WithAtMostOnceQoS().Build()
+            };
         }
-        catch (Exception ex)
+
+        // The broker hands each message to one instance of the group; the device's owner on the
+        // ring gets it from there. Encoding requests go to every instance, since any may publish;
+        // so do stall reports, so that each ranks the whole fleet, and core dumps, kept by the owner
+        var shared = $"$share/{_clusterSettings.SharedGroup}/";
+        return new List<MqttTopicFilter>
         {
-            _logger.LogError(ex, "Error subscribing to topics");
-        }
+            new MqttTopicFilterBuilder().WithTopic(shared + _settings.CommandTopic).WithAtLeastOnceQoS().Build(),
+            new MqttTopicFilterBuilder().WithTopic(shared + _settings.TraceTopic).WithAtMostOnceQoS().Build(),
+            new MqttTopicFilterBuilder().WithTopic(shared + _settings.OtaRequestTopic).WithAtMostOnceQoS().Build(),
+            new MqttTopicFilterBuilder().WithTopic(_settings.EncodingTopicPrefix + "+/request").WithAtLeastOnceQoS().Build(),
+            new MqttTopicFilterBuilder().WithTopic(_settings.StallTopic).WithAtMostOnceQoS().Build(),
+            new MqttTopicFilterBuilder().WithTopic(_settings.CoreDumpTopicPrefix + "+").WithAtMostOnceQoS().Build(),
+            new MqttTopicFilterBuilder().WithTopic(MemberTopicPrefix + "+").WithAtLeastOnceQoS().Build(),
+            new MqttTopicFilterBuilder().WithTopic(ForwardTopicPrefix(_membership.InstanceId) + "#").WithAtLeastOnceQoS().Build()
+        };
+    }
+
+    private Task OnConnectedAsync(MqttClientConnectedEventArgs args)
+    {
+        _logger.LogInformation("Connected to MQTT broker ({Session})",
+            args.ConnectResult.IsSessionPresent ? "session resumed" : "new session");
+
+        _reconnectDelayMs = Math.Max(_settings.ReconnectMinDelayMs, 100);
+        _managedOptions!.AutoReconnectDelay = TimeSpan.FromMilliseconds(_reconnectDelayMs);
+        return Task.CompletedTask;
+    }
+
+    // Same policy as the dials: exponential backoff with a cap, each wait drawn from the
+    // upper half of the current delay so clients restarted together spread out
+    private Task OnConnectingFailedAsync(ConnectingFailedEventArgs args)
+    {
+        var wait = _reconnectDelayMs / 2 + Random.Shared.Next(_reconnectDelayMs / 2 + 1);
+        _managedOptions!.AutoReconnectDelay = TimeSpan.FromMilliseconds(wait);
+        _reconnectDelayMs = Math.Min(_reconnectDelayMs * 2, Math.Max(_settings.ReconnectMaxDelayMs, _settings.ReconnectMinDelayMs));
+
+        _logger.LogWarning("MQTT connect failed ({Message}), retrying in {Wait} ms",
+            args.Exception?.Message, wait);
+        return Task.CompletedTask;
     }
 
     private Task OnDisconnectedAsync(MqttClientDisconnectedEventArgs args)
@@ -83,27 +183,98 @@ public class MqttService
         return Task.CompletedTask;
     }
 
-    private Task OnMessageReceivedAsync(MqttApplicationMessageReceivedEventArgs args)
+    private async Task OnMessageReceivedAsync(MqttApplicationMessageReceivedEventArgs args)
     {
+        var receivedTimestamp = Stopwatch.GetTimestamp();
+
         try
         {
+            var topic = args.ApplicationMessage.Topic;
             var payload = Encoding.UTF8.GetString(args.ApplicationMessage.PayloadSegment);
-            _logger.LogDebug("Received message on topic {Topic}: {Payload}",
-                args.ApplicationMessage.Topic, payload);
+            _logger.LogDebug("Received message on topic {Topic}: {Payload}", topic, payload);
 
-            if (args.ApplicationMessage.Topic == _settings.CommandTopic)
+            // Forwarded by the instance the broker gave it to; ours whatever the ring says by now,
+            // so a message never travels more than one hop
+            var forwarded = false;
+            if (_membership.Enabled)
             {
-                var options = new JsonSerializerOptions
+                var forwardPrefix = ForwardTopicPrefix(_membership.InstanceId);
+                if (topic.StartsWith(forwardPrefix, StringComparison.Ordinal))
+                {
+                    topic = topic[forwardPrefix.Length..];
+                    forwarded = true;
+                    _membership.RecordForwardedIn();
+                }
+                else if (topic.StartsWith(MemberTopicPrefix, StringComparison.Ordinal))
                 {
-                    PropertyNameCaseInsensitive = true
-                };
+                    // An empty message is a leave or the will of an instance that died
+                    var instanceId = topic[MemberTopicPrefix.Length..];
+                    if (args.ApplicationMessage.PayloadSegment.Count == 0) _membership.Leave(instanceId);
+                    else _membership.Heartbeat(instanceId);
+                    return;
+                }
+            }
 
-                var command = JsonSerializer.Deserialize<DeviceCommand>(payload, options);
+            if (topic.StartsWith(_settings.EncodingTopicPrefix, StringComparison.Ordinal) &&
+                topic.EndsWith("/request", StringComparison.Ordinal))
+            {
+                var clientId = topic[_settings.EncodingTopicPrefix.Length..^"/request".Length];
+                await HandleEncodingRequestAsync(clientId, payload);
+            }
+            else if (topic == _settings.CommandTopic)
+            {
+                var command = JsonSerializer.Deserialize<DeviceCommand>(payload, ReceiveJsonOptions);
                 if (command != null)
                 {
+                    if (!forwarded && await ForwardToOwnerAsync(command.DeviceId, topic, args.ApplicationMessage.PayloadSegment))
+                    {
+                        return;
+                    }
+
+                    command.ReceivedTimestamp = receivedTimestamp;
                     _logger.LogInformation("Command received: {Command} {Parameter}",
                         command.Command, command.Parameter ?? "");
-                    OnCommandReceived?.Invoke(command);
+                    if (OnCommandReceived != null)
+                    {
+                        await OnCommandReceived(command);
+                    }
+                }
+            }
+            else if (topic == _settings.TraceTopic)
+            {
+                var report = JsonSerializer.Deserialize<TraceReport>(payload, ReceiveJsonOptions);
+                if (report != null)
+                {
+                    OnTraceReceived?.Invoke(report);
+                }
+            }
+            else if (topic == _settings.OtaRequestTopic)
+            {
+                var request = JsonSerializer.Deserialize<OtaRequest>(payload, ReceiveJsonOptions);
+                if (request == null ||
+                    (!forwarded && await ForwardToOwnerAsync(request.ClientId, topic, args.ApplicationMessage.PayloadSegment)))
+                {
+                    return;
+                }
+                if (OnOtaRequest != null)
+                {
+                    await OnOtaRequest(request);
+                }
+            }
+            else if (topic == _settings.StallTopic)
+            {
+                var report = JsonSerializer.Deserialize<StallReport>(payload, ReceiveJsonOptions);
+                if (report != null)
+                {
+                    OnStallReport?.Invoke(report);
+                }
+            }
+            else if (topic.StartsWith(_settings.CoreDumpTopicPrefix, StringComparison.Ordinal))
+            {
+                var clientId = topic[_settings.CoreDumpTopicPrefix.Length..];
+                if (OnCoreDumpChunk != null && _membership.IsLocal(clientId))
+                {
+                    await OnCoreDumpChunk(clientId, args.ApplicationMessage.PayloadSegment.ToArray());
                 }
             }
         }
@@ -111,8 +282,151 @@ public class MqttService
         {
             _logger.LogError(ex, "Error processing MQTT message");
         }
+    }
 
-        return Task.CompletedTask;
+    /// <summary>
+    /// Record the topics a dial wants in the compact encoding and tell it which of them it gets.
+    /// Requests are retained, so after a restart the backend knows its dials again at once.
+    /// </summary>
+    private async Task HandleEncodingRequestAsync(string clientId, string payload)
+    {
+        // A cleared request puts the dial back on JSON
+        var request = payload.Length > 0 ? JsonSerializer.Deserialize<EncodingRequest>(payload, ReceiveJsonOptions) : null;
+        if (request == null)
+        {
+            _compactClients.TryRemove(clientId, out _);
+            return;
+        }
+
+        var supported = _settings.CompactEncoding &&
+                        request.Format == CompactCodec.Format &&
+                        request.Dictionary == CompactCodec.DictionaryVersion;
+        var topics = supported ? request.Topics.Intersect(CompactTopics.All).ToArray() : Array.Empty<string>();
+        if (topics.Length > 0)
+        {
+            _compactClients[clientId] = topics;
+        }
+        else
+        {
+            _compactClients.TryRemove(clientId, out _);
+        }
+
+        _logger.LogInformation("Dial {ClientId} asked for compact {Requested} (format {Format}, dictionary {Dictionary}), accepted {Accepted}",
+            clientId, string.Join(", ", request.Topics), request.Format, request.Dictionary,
+            topics.Length > 0 ? string.Join(", ", topics) : "none");
+
+        // Every instance keeps the list; the dial's owner answers
+        if (_mqttClient == null || !_membership.IsLocal(clientId)) return;
+
+        var accept = new EncodingRequest
+        {
+            Format = CompactCodec.Format,
+            Dictionary = CompactCodec.DictionaryVersion,
+            Topics = topics.ToList()
+        };
+        var message = new MqttApplicationMessageBuilder()
+            .WithTopic($"{_settings.EncodingTopicPrefix}{clientId}/accept")
+            .WithPayload(JsonSerializer.Serialize(accept, PublishJsonOptions))
+            .WithQualityOfServiceLevel(MQTTnet.Protocol.MqttQualityOfServiceLevel.AtLeastOnce)
+            .WithRetainFlag(true)
+            .Build();
+
+        await _mqttClient.EnqueueAsync(message);
+    }
+
+    private bool WantsCompact(string compactTopic) =>
+        _compactClients.Values.Any(topics => topics.Contains(compactTopic));
+
+    private async Task PublishCompactAsync(string topic, byte[] payload, bool retain)
+    {
+        var message = new MqttApplicationMessageBuilder()
+            .WithTopic(topic + CompactTopicSuffix)
+            .WithPayload(payload)
+            .WithQualityOfServiceLevel(MQTTnet.Protocol.MqttQualityOfServiceLevel.AtLeastOnce)
+            .WithRetainFlag(retain)
+            .Build();
+
+        await _mqttClient!.EnqueueAsync(message);
+    }
+
+    /// <summary>
+    /// Pass a message for a device to the instance that owns it. Returns false when the device
+    /// is ours (or clustering is off) and the message should be handled here.
+    /// </summary>
+    private async Task<bool> ForwardToOwnerAsync(string? deviceId, string topic, ArraySegment<byte> payload)
+    {
+        if (!_membership.Enabled) return false;
+        _membership.RecordReceived();
+
+        // Same key as the command queue: devices without an id share one
+        var owner = _membership.OwnerOf(string.IsNullOrEmpty(deviceId) ? "default" : deviceId);
+        if (owner == _membership.InstanceId || _mqttClient == null) return false;
+
+        var message = new MqttApplicationMessageBuilder()
+            .WithTopic(ForwardTopicPrefix(owner) + topic)
+            .WithPayload(payload)
+            .WithQualityOfServiceLevel(MQTTnet.Protocol.MqttQualityOfServiceLevel.AtLeastOnce)
+            .WithRetainFlag(false)
+            .Build();
+
+        await _mqttClient.EnqueueAsync(message);
+        _membership.RecordForwarded();
+        return true;
+    }
+
+    /// <summary>
+    /// Renew this instance's lease. Retained, so an instance that starts later sees us at once.
+    /// </summary>
+    public async Task PublishHeartbeatAsync()
+    {
+        if (_mqttClient == null || !_mqttClient.IsConnected) return;
+
+        try
+        {
+            var payload = JsonSerializer.Serialize(new
+            {
+                instanceId = _membership.InstanceId,
+                leaseMs = _clusterSettings.LeaseMs
+            });
+            var message = new MqttApplicationMessageBuilder()
+                .WithTopic(MemberTopicPrefix + _membership.InstanceId)
+                .WithPayload(payload)
+                .WithQualityOfServiceLevel(MQTTnet.Protocol.MqttQualityOfServiceLevel.AtLeastOnce)
+                .WithRetainFlag(true)
+                .Build();
+
+            await _mqttClient.EnqueueAsync(message);
+        }
+        catch (Exception ex)
+        {
+            _logger.LogError(ex, "Error publishing cluster heartbeat");
+        }
+    }
+
+    /// <summary>
+    /// Clear our heartbeat on shutdown. Sent directly rather than queued, since the connection
+    /// closes right after.
+    /// </summary>
+    public async Task PublishLeaveAsync()
+    {
+        if (_mqttClient == null || !_mqttClient.IsConnected) return;
+
+        try
+        {
+            var message = new MqttApplicationMessageBuilder()
+                .WithTopic(MemberTopicPrefix + _membership.InstanceId)
+                .WithPayload(Array.Empty<byte>())
+                .WithQualityOfServiceLevel(MQTTnet.Protocol.MqttQualityOfServiceLevel.AtLeastOnce)
+                .WithRetainFlag(true)
+                .Build();
+
+            await _mqttClient.InternalClient.PublishAsync(message);
+            _logger.LogInformation("Cluster: left as {Instance}", _membership.InstanceId);
+        }
+        catch (Exception ex)
+        {
+            _logger.LogError(ex, "Error publishing cluster leave");
+        }
     }
 
     public async Task PublishSongInfoAsync(SongInfo songInfo)
@@ -121,7 +435,7 @@ public class MqttService
 
         try
         {
-            var payload = JsonSerializer.Serialize(songInfo);
+            var payload = JsonSerializer.Serialize(songInfo, PublishJsonOptions);
             var message = new MqttApplicationMessageBuilder()
                 .WithTopic(_settings.StatusTopic)
                 .WithPayload(payload)
@@ -130,6 +444,11 @@ public class MqttService
                 .Build();
 
             await _mqttClient.EnqueueAsync(message);
+
+            if (WantsCompact(CompactTopics.Status))
+            {
+                await PublishCompactAsync(_settings.StatusTopic, CompactCodec.EncodeStatus(songInfo), retain: true);
+            }
             _logger.LogDebug("Published song info to {Topic}", _settings.StatusTopic);
         }
         catch (Exception ex)
@@ -167,7 +486,7 @@ public class MqttService
 
         try
         {
-            var payload = JsonSerializer.Serialize(playlists);
+            var payload = JsonSerializer.Serialize(playlists, PublishJsonOptions);
             var message = new MqttApplicationMessageBuilder()
                 .WithTopic(_settings.PlaylistTopic)
                 .WithPayload(payload)
@@ -176,7 +495,17 @@ public class MqttService
                 .Build();
 
             await _mqttClient.EnqueueAsync(message);
-            _logger.LogInformation("Published {Count} playlists to {Topic}", playlists.Count, _settings.PlaylistTopic);
+
+            var compactBytes = 0;
+            if (WantsCompact(CompactTopics.Playlists))
+            {
+                var compact = CompactCodec.EncodeList(CompactCodec.KindPlaylists,
+                    playlists.Select(p => (p.Id, p.Name)).ToList(), _settings.TableChunkBytes);
+                await PublishCompactAsync(_settings.PlaylistTopic, compact, retain: false);
+                compactBytes = compact.Length;
+            }
+            _logger.LogInformation("Published {Count} playlists to {Topic} ({Bytes} bytes, compact {CompactBytes})",
+                playlists.Count, _settings.PlaylistTopic, Encoding.UTF8.GetByteCount(payload), compactBytes);
         }
         catch (Exception ex)
         {
@@ -190,7 +519,7 @@ public class MqttService
 
         try
         {
-            var payload = JsonSerializer.Serialize(albums);
+            var payload = JsonSerializer.Serialize(albums, PublishJsonOptions);
             var message = new MqttApplicationMessageBuilder()
                 .WithTopic(_settings.AlbumTopic)
                 .WithPayload(payload)
@@ -199,7 +528,17 @@ public class MqttService
                 .Build();
 
             await _mqttClient.EnqueueAsync(message);
-            _logger.LogInformation("Published {Count} albums to {Topic}", albums.Count, _settings.AlbumTopic);
+
+            var compactBytes = 0;
+            if (WantsCompact(CompactTopics.Albums))
+            {
+                var compact = CompactCodec.EncodeList(CompactCodec.KindAlbums,
+                    albums.Select(a => (a.Id, a.Name)).ToList(), _settings.TableChunkBytes);
+                await PublishCompactAsync(_settings.AlbumTopic, compact, retain: false);
+                compactBytes = compact.Length;
+            }
+            _logger.LogInformation("Published {Count} albums to {Topic} ({Bytes} bytes, compact {CompactBytes})",
+                albums.Count, _settings.AlbumTopic, Encoding.UTF8.GetByteCount(payload), compactBytes);
         }
         catch (Exception ex)
         {
@@ -207,6 +546,137 @@ public class MqttService
         }
     }
 
+    public Task PublishPlaylistTableAsync(byte[] table) => PublishNameTableAsync(_settings.PlaylistTableTopic, table);
+
+    public Task PublishAlbumTableAsync(byte[] table) => PublishNameTableAsync(_settings.AlbumTableTopic, table);
+
+    /// <summary>
+    /// Send a name table in chunks that fit the dial's MQTT buffer. Each chunk starts with the
+    /// table version, its offset and the table length (u32, little-endian); the dial reassembles
+    /// them in order and skips a version it already holds.
+    /// </summary>
+    private async Task PublishNameTableAsync(string topic, byte[] table)
+    {
+        if (_mqttClient == null || !_mqttClient.IsConnected) return;
+
+        try
+        {
+            var version = NameTableEncoder.Version(table);
+            var chunkBytes = Math.Max(_settings.TableChunkBytes, 64);
+            var chunks = 0;
+
+            for (var offset = 0; offset < table.Length; offset += chunkBytes)
+            {
+                var length = Math.Min(chunkBytes, table.Length - offset);
+                var payload = new byte[12 + length];
+                BinaryPrimitives.WriteUInt32LittleEndian(payload, version);
+                BinaryPrimitives.WriteUInt32LittleEndian(payload.AsSpan(4), (uint)offset);
+                BinaryPrimitives.WriteUInt32LittleEndian(payload.AsSpan(8), (uint)table.Length);
+                Buffer.BlockCopy(table, offset, payload, 12, length);
+
+                var message = new MqttApplicationMessageBuilder()
+                    .WithTopic(topic)
+                    .WithPayload(payload)
+                    .WithQualityOfServiceLevel(MQTTnet.Protocol.MqttQualityOfServiceLevel.AtLeastOnce)
+                    .WithRetainFlag(false)
+                    .Build();
+
+                await _mqttClient.EnqueueAsync(message);
+                chunks++;
+            }
+
+            _logger.LogInformation("Published name table {Version:x8} to {Topic} ({Size} bytes, {Chunks} chunks)",
+                version, topic, table.Length, chunks);
+        }
+        catch (Exception ex)
+        {
+            _logger.LogError(ex, "Error publishing name table");
+        }
+    }
+
+    public async Task PublishOtaOfferAsync(string clientId, OtaOffer offer)
+    {
+        if (_mqttClient == null || !_mqttClient.IsConnected) return;
+
+        try
+        {
+            var payload = JsonSerializer.Serialize(offer, PublishJsonOptions);
+            var message = new MqttApplicationMessageBuilder()
+                .WithTopic($"{_settings.OtaTopicPrefix}{clientId}/offer")
+                .WithPayload(payload)
+                .WithQualityOfServiceLevel(MQTTnet.Protocol.MqttQualityOfServiceLevel.AtLeastOnce)
+                .WithRetainFlag(false)
+                .Build();
+
+            await _mqttClient.EnqueueAsync(message);
+        }
+        catch (Exception ex)
+        {
+            _logger.LogError(ex, "Error publishing OTA offer");
+        }
+    }
+
+    /// <summary>
+    /// Send a range of a firmware patch to one dial. Each chunk starts with the patch id, its
+    /// offset and the CRC-32 of its data (u32, little-endian). At most once: the dial asks for
+    /// whatever did not arrive intact.
+    /// </summary>
+    public async Task PublishOtaChunksAsync(string clientId, uint patchId, byte[] patch, int offset, int length, int chunkBytes)
+    {
+        if (_mqttClient == null || !_mqttClient.IsConnected) return;
+
+        try
+        {
+            var topic = $"{_settings.OtaTopicPrefix}{clientId}/data";
+            var end = offset + length;
+
+            for (var position = offset; position < end; position += chunkBytes)
+            {
+                var size = Math.Min(chunkBytes, end - position);
+                var payload = new byte[12 + size];
+                BinaryPrimitives.WriteUInt32LittleEndian(payload, patchId);
+                BinaryPrimitives.WriteUInt32LittleEndian(payload.AsSpan(4), (uint)position);
+                BinaryPrimitives.WriteUInt32LittleEndian(payload.AsSpan(8), FirmwareDiff.Crc32(patch.AsSpan(position, size)));
+                Buffer.BlockCopy(patch, position, payload, 12, size);
+
+                var message = new MqttApplicationMessageBuilder()
+                    .WithTopic(topic)
+                    .WithPayload(payload)
+                    .WithQualityOfServiceLevel(MQTTnet.Protocol.MqttQualityOfServiceLevel.AtMostOnce)
+                    .WithRetainFlag(false)
+                    .Build();
+
+                await _mqttClient.EnqueueAsync(message);
+            }
+        }
+        catch (Exception ex)
+        {
+            _logger.LogError(ex, "Error publishing OTA data");
+        }
+    }
+
+    public async Task PublishMetricsAsync(BackendMetrics metrics)
+    {
+        if (_mqttClient == null || !_mqttClient.IsConnected) return;
+
+        try
+        {
+            var payload = JsonSerializer.Serialize(metrics, PublishJsonOptions);
+            var message = new MqttApplicationMessageBuilder()
+                .WithTopic(_settings.MetricsTopic)
+                .WithPayload(payload)
+                .WithQualityOfServiceLevel(MQTTnet.Protocol.MqttQualityOfServiceLevel.AtMostOnce)
+                .WithRetainFlag(false)
+                .Build();
+
+            await _mqttClient.EnqueueAsync(message);
+        }
+        catch (Exception ex)
+        {
+            _logger.LogError(ex, "Error publishing metrics");
+        }
+    }
+
     public async Task DisconnectAsync()
     {
         if (_mqttClient != null)
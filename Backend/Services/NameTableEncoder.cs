@@ -0,0 +1,129 @@
+using System.Buffers.Binary;
+using System.Text;
+
+namespace SpotiDialBackend.Services;
+
+/// <summary>
+/// Packs a playlist or album list into the sorted, front-coded name table the dial browses
+/// large libraries with. All integers are little-endian:
+///
+///   magic "SDNT", u8 format, u8 restart interval K, u16 count
+///   u16 first entry of each bucket ('#', then A to Z)
+///   u32 offset of every K-th entry, relative to the first entry
+///   entries: u8 shared prefix length, u8 suffix length, suffix, u8 id length, id
+///
+/// Entries are sorted by bucket, then by name ignoring case. An entry shares a prefix with the
+/// one before it, except at restart points, so the dial decodes any row after at most K - 1
+/// others and reaches the first entry of a letter with a single lookup.
+/// </summary>
+public static class NameTableEncoder
+{
+    public const byte Format = 1;
+    public const int BucketCount = 27;
+    public const int HeaderSize = 8 + BucketCount * 2;
+
+    private static readonly byte[] Magic = "SDNT"u8.ToArray();
+
+    public static byte[] Encode(IEnumerable<(string Id, string Name)> items, int restartInterval)
+    {
+        var interval = Math.Clamp(restartInterval, 1, 255);
+        var sorted = items
+            .Select(item => (Id: Truncate(item.Id), Name: Truncate(item.Name.Trim()), Bucket: BucketOf(item.Name)))
+            .OrderBy(item => item.Bucket)
+            .ThenBy(item => Encoding.UTF8.GetString(item.Name), StringComparer.OrdinalIgnoreCase)
+            .ThenBy(item => Encoding.UTF8.GetString(item.Name), StringComparer.Ordinal)
+            .Take(ushort.MaxValue)
+            .ToList();
+
+        var restarts = (sorted.Count + interval - 1) / interval;
+        var entries = new MemoryStream();
+        var restartOffsets = new uint[restarts];
+        var buckets = new ushort[BucketCount];
+        Array.Fill(buckets, (ushort)sorted.Count);
+
+        byte[] previous = Array.Empty<byte>();
+        for (var i = 0; i < sorted.Count; i++)
+        {
+            var (id, name, bucket) = sorted[i];
+            if (buckets[bucket] == sorted.Count) buckets[bucket] = (ushort)i;
+
+            var shared = 0;
+            if (i % interval == 0)
+            {
+                restartOffsets[i / interval] = (uint)entries.Length;
+            }
+            else
+            {
+                var limit = Math.Min(previous.Length, name.Length);
+                while (shared < limit && previous[shared] == name[shared]) shared++;
+            }
+
+            entries.WriteByte((byte)shared);
+            entries.WriteByte((byte)(name.Length - shared));
+            entries.Write(name, shared, name.Length - shared);
+            entries.WriteByte((byte)id.Length);
+            entries.Write(id);
+            previous = name;
+        }
+
+        // A letter without entries points at the next one that has some
+        for (var b = BucketCount - 2; b >= 0; b--)
+        {
+            if (buckets[b] == sorted.Count) buckets[b] = buckets[b + 1];
+        }
+
+        var table = new byte[HeaderSize + restarts * 4 + entries.Length];
+        var span = table.AsSpan();
+        Magic.CopyTo(span);
+        span[4] = Format;
+        span[5] = (byte)interval;
+        BinaryPrimitives.WriteUInt16LittleEndian(span[6..], (ushort)sorted.Count);
+        for (var b = 0; b < BucketCount; b++)
+        {
+            BinaryPrimitives.WriteUInt16LittleEndian(span[(8 + b * 2)..], buckets[b]);
+        }
+        for (var r = 0; r < restarts; r++)
+        {
+            BinaryPrimitives.WriteUInt32LittleEndian(span[(HeaderSize + r * 4)..], restartOffsets[r]);
+        }
+        entries.GetBuffer().AsSpan(0, (int)entries.Length).CopyTo(span[(HeaderSize + restarts * 4)..]);
+
+        return table;
+    }
+
+    /// <summary>
+    /// Jump bucket of a name: 1 to 26 for names starting with A to Z, 0 for everything else.
+    /// </summary>
+    public static int BucketOf(string name)
+    {
+        var trimmed = name.TrimStart();
+        if (trimmed.Length == 0) return 0;
+
+        var first = char.ToUpperInvariant(trimmed[0]);
+        return first is >= 'A' and <= 'Z' ? first - 'A' + 1 : 0;
+    }
+
+    /// <summary>
+    /// FNV-1a of the table, sent with every chunk so the dial skips a table it already has.
+    /// </summary>
+    public static uint Version(byte[] table)
+    {
+        var hash = 2166136261u;
+        foreach (var b in table)
+        {
+            hash = (hash ^ b) * 16777619u;
+        }
+        return hash;
+    }
+
+    // Lengths are single bytes on the wire; cut on a character boundary
+    internal static byte[] Truncate(string value)
+    {
+        var bytes = Encoding.UTF8.GetBytes(value);
+        if (bytes.Length <= byte.MaxValue) return bytes;
+
+        var length = byte.MaxValue;
+        while (length > 0 && (bytes[length] & 0xC0) == 0x80) length--;
+        return bytes[..length];
+    }
+}
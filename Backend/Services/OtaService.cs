@@ -0,0 +1,265 @@
+using System.Collections.Concurrent;
+using System.Diagnostics;
+using Microsoft.Extensions.Logging;
+using Microsoft.Extensions.Options;
+using SpotiDialBackend.Models;
+
+namespace SpotiDialBackend.Services;
+
+/// <summary>
+/// Firmware updates over MQTT. A dial announces the image it runs when it connects; if that is
+/// not the target image it is offered a patch against its own image (or the full image when
+/// that is not in the firmware directory) and then pulls the patch range by range. Patches are
+/// built off the receive loop and cached, so a fleet on the same image shares one.
+/// </summary>
+public class OtaService
+{
+    private readonly ILogger<OtaService> _logger;
+    private readonly OtaSettings _settings;
+    private readonly MqttService _mqttService;
+
+    // Images by the SHA-256 digest the ESP-IDF build appends, which is what the dial reports
+    private readonly object _imagesLock = new();
+    private readonly Dictionary<string, FirmwareImage> _imagesByPath = new();
+
+    private readonly ConcurrentDictionary<string, Lazy<Task<FirmwarePatch>>> _patchBuilds = new();
+    private readonly ConcurrentDictionary<uint, FirmwarePatch> _patches = new();
+
+    // Targets a dial rolled back from are not offered to it again
+    private readonly ConcurrentDictionary<string, string> _rejectedTargets = new();
+
+    // Last successful result per mode, to compare a delta with a full image
+    private readonly ConcurrentDictionary<bool, OtaRequest> _lastResults = new();
+    private readonly ConcurrentDictionary<string, long> _restartingSince = new();
+
+    private const int ImageHeaderSize = 24;
+    private const int DigestSize = 32;
+    private const int MaxRequestBytes = 64 * 1024;
+
+    public OtaService(ILogger<OtaService> logger, IOptions<AppSettings> settings, MqttService mqttService)
+    {
+        _logger = logger;
+        _settings = settings.Value.Ota;
+        _mqttService = mqttService;
+    }
+
+    public async Task HandleRequestAsync(OtaRequest request)
+    {
+        if (!_settings.Enabled || string.IsNullOrEmpty(request.ClientId)) return;
+
+        switch (request.Type)
+        {
+            case OtaRequestTypes.Hello:
+                HandleHello(request);
+                break;
+
+            case OtaRequestTypes.Get:
+                await ServeRangeAsync(request);
+                break;
+
+            case OtaRequestTypes.Result:
+                RecordResult(request);
+                break;
+
+            case OtaRequestTypes.Confirmed:
+                RecordConfirmed(request);
+                break;
+        }
+    }
+
+    private void HandleHello(OtaRequest request)
+    {
+        var target = GetTargetImage();
+        if (target == null || string.IsNullOrEmpty(request.Image) || request.Image == target.Digest) return;
+
+        if (!string.IsNullOrEmpty(request.RolledBack))
+        {
+            var failed = uint.TryParse(request.RolledBack, System.Globalization.NumberStyles.HexNumber, null, out var id) &&
+                         _patches.TryGetValue(id, out var patch)
+                ? patch.Target
+                : target.Digest;
+            _logger.LogWarning("OTA {Client}: update {Patch} was rolled back, not offering its image again",
+                request.ClientId, request.RolledBack);
+            _rejectedTargets[request.ClientId] = failed;
+        }
+        if (_rejectedTargets.TryGetValue(request.ClientId, out var rejected) && rejected == target.Digest) return;
+
+        var baseImage = _settings.ForceFullImage ? null : FindImage(request.Image);
+
+        // The build can take a moment; offer when it is ready instead of holding up the receive loop
+        _ = OfferAsync(request.ClientId, baseImage, target);
+    }
+
+    private async Task OfferAsync(string clientId, FirmwareImage? baseImage, FirmwareImage target)
+    {
+        try
+        {
+            var patch = await GetPatchAsync(baseImage, target);
+            _logger.LogInformation("OTA {Client}: offering {Mode} patch {Patch:x8} to {Target} ({Size} bytes)",
+                clientId, patch.Full ? "full" : "delta", patch.Id, target.Name, patch.Bytes.Length);
+
+            await _mqttService.PublishOtaOfferAsync(clientId, new OtaOffer
+            {
+                Patch = patch.Id.ToString("x8"),
+                Base = baseImage?.Digest ?? string.Empty,
+                Target = target.Digest,
+                Full = patch.Full,
+                Size = patch.Bytes.Length,
+                ImageSize = target.Bytes.Length
+            });
+        }
+        catch (Exception ex)
+        {
+            _logger.LogError(ex, "OTA {Client}: could not build a patch for {Target}", clientId, target.Name);
+        }
+    }
+
+    private async Task<FirmwarePatch> GetPatchAsync(FirmwareImage? baseImage, FirmwareImage target)
+    {
+        var key = $"{baseImage?.Digest ?? "full"}>{target.Digest}";
+        var build = _patchBuilds.GetOrAdd(key, _ => new Lazy<Task<FirmwarePatch>>(
+            () => Task.Run(() => BuildPatch(baseImage, target))));
+        try
+        {
+            return await build.Value;
+        }
+        catch
+        {
+            // Build it again on the next request instead of keeping the failure
+            _patchBuilds.TryRemove(KeyValuePair.Create(key, build));
+            throw;
+        }
+    }
+
+    private FirmwarePatch BuildPatch(FirmwareImage? baseImage, FirmwareImage target)
+    {
+        var stopwatch = Stopwatch.StartNew();
+        var bytes = baseImage == null
+            ? FirmwareDiff.CreateFull(target.Bytes, _settings.BlockSize)
+            : FirmwareDiff.Create(baseImage.Bytes, target.Bytes, _settings.BlockSize);
+
+        var patch = new FirmwarePatch(FirmwareDiff.Crc32(bytes), bytes, baseImage == null, target.Digest);
+        _patches[patch.Id] = patch;
+
+        _logger.LogInformation("OTA: built {Mode} patch {Patch:x8} {Base} -> {Target} in {Elapsed} ms: " +
+                               "{Size} bytes for a {ImageSize} byte image ({Percent:F1}%)",
+            patch.Full ? "full" : "delta", patch.Id, baseImage?.Name ?? "-", target.Name,
+            stopwatch.ElapsedMilliseconds, bytes.Length, target.Bytes.Length,
+            100.0 * bytes.Length / target.Bytes.Length);
+        return patch;
+    }
+
+    private async Task ServeRangeAsync(OtaRequest request)
+    {
+        if (!uint.TryParse(request.Patch, System.Globalization.NumberStyles.HexNumber, null, out var id) ||
+            !_patches.TryGetValue(id, out var patch))
+        {
+            _logger.LogWarning("OTA {Client}: request for unknown patch {Patch}", request.ClientId, request.Patch);
+            return;
+        }
+
+        var offset = Math.Clamp(request.Offset, 0, patch.Bytes.Length);
+        var length = Math.Clamp(request.Length, 0, Math.Min(MaxRequestBytes, patch.Bytes.Length - offset));
+        if (length == 0) return;
+
+        await _mqttService.PublishOtaChunksAsync(request.ClientId, patch.Id, patch.Bytes, offset, length,
+            Math.Max(_settings.ChunkBytes, 64));
+    }
+
+    private void RecordResult(OtaRequest request)
+    {
+        var mode = request.Full ? "full" : "delta";
+        if (!request.Ok)
+        {
+            _logger.LogWarning("OTA {Client}: {Mode} update {Patch} failed: {Error}",
+                request.ClientId, mode, request.Patch, request.Error);
+            return;
+        }
+
+        _restartingSince[request.ClientId] = Stopwatch.GetTimestamp();
+        _logger.LogInformation("OTA {Client}: {Mode} update {Patch} written: {Bytes} bytes received for a " +
+                               "{ImageSize} byte image, {TotalMs} ms in total, {FlashMs} ms of it erasing and " +
+                               "writing flash, {ActivateMs} ms to verify and switch slots",
+            request.ClientId, mode, request.Patch, request.Bytes, request.ImageSize,
+            request.TotalMs, request.FlashMs, request.ActivateMs);
+
+        _lastResults[request.Full] = request;
+        if (_lastResults.TryGetValue(true, out var full) && _lastResults.TryGetValue(false, out var delta))
+        {
+            _logger.LogInformation("OTA delta vs full image: {DeltaBytes} vs {FullBytes} bytes, " +
+                                   "{DeltaMs} vs {FullMs} ms, flash {DeltaFlashMs} vs {FullFlashMs} ms",
+                delta.Bytes, full.Bytes, delta.TotalMs, full.TotalMs, delta.FlashMs, full.FlashMs);
+        }
+    }
+
+    private void RecordConfirmed(OtaRequest request)
+    {
+        // The restart as seen from here: result received to the new image verified, which
+        // includes the time the dial stays connected before it calls the image good
+        var restart = _restartingSince.TryRemove(request.ClientId, out var since)
+            ? $"{Stopwatch.GetElapsedTime(since).TotalMilliseconds:F0} ms after the result"
+            : "result not seen";
+
+        _logger.LogInformation("OTA {Client}: update {Patch} verified, connected {ConnectMs} ms after boot ({Restart})",
+            request.ClientId, request.Patch, request.ConnectMs, restart);
+    }
+
+    private FirmwareImage? GetTargetImage()
+    {
+        var images = ScanImages();
+        if (!string.IsNullOrEmpty(_settings.TargetImage))
+        {
+            return images.FirstOrDefault(image => image.Name == _settings.TargetImage);
+        }
+        return images.OrderByDescending(image => image.Modified).FirstOrDefault();
+    }
+
+    private FirmwareImage? FindImage(string digest) => ScanImages().FirstOrDefault(image => image.Digest == digest);
+
+    // Reads new and changed files only
+    private List<FirmwareImage> ScanImages()
+    {
+        lock (_imagesLock)
+        {
+            if (!Directory.Exists(_settings.FirmwareDirectory)) return new List<FirmwareImage>();
+
+            var seen = new HashSet<string>();
+            foreach (var path in Directory.EnumerateFiles(_settings.FirmwareDirectory, "*.bin"))
+            {
+                seen.Add(path);
+                var modified = File.GetLastWriteTimeUtc(path);
+                if (_imagesByPath.TryGetValue(path, out var known) && known.Modified == modified) continue;
+
+                var image = LoadImage(path, modified);
+                if (image != null) _imagesByPath[path] = image;
+                else _imagesByPath.Remove(path);
+            }
+
+            foreach (var gone in _imagesByPath.Keys.Where(path => !seen.Contains(path)).ToList())
+            {
+                _imagesByPath.Remove(gone);
+            }
+
+            return _imagesByPath.Values.ToList();
+        }
+    }
+
+    private FirmwareImage? LoadImage(string path, DateTime modified)
+    {
+        var bytes = File.ReadAllBytes(path);
+
+        // esp_image_header_t: magic 0xE9 ... hash_appended as its last byte
+        if (bytes.Length <= ImageHeaderSize + DigestSize || bytes[0] != 0xE9 || bytes[ImageHeaderSize - 1] != 1)
+        {
+            _logger.LogWarning("OTA: {Path} is not an app image with an appended SHA-256, skipped", path);
+            return null;
+        }
+
+        var digest = Convert.ToHexString(bytes, bytes.Length - DigestSize, DigestSize).ToLowerInvariant();
+        return new FirmwareImage(Path.GetFileName(path), digest, bytes, modified);
+    }
+
+    private sealed record FirmwareImage(string Name, string Digest, byte[] Bytes, DateTime Modified);
+
+    private sealed record FirmwarePatch(uint Id, byte[] Bytes, bool Full, string Target);
+}
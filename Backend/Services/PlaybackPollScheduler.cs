@@ -0,0 +1,53 @@
+using SpotiDialBackend.Models;
+
+namespace SpotiDialBackend.Services;
+
+/// <summary>
+/// Decides how long the cached playback state stays good enough. Track changes are predicted
+/// from progress and duration, so polls cluster around the boundary instead of running at a
+/// fixed rate; paused or idle players are polled with exponential backoff.
+/// </summary>
+public static class PlaybackPollScheduler
+{
+    // Poll this long after the predicted end so the next track has started
+    private const int BoundaryMarginMs = 300;
+    private const int MaxBackoffShift = 5;
+
+    /// <summary>
+    /// Interval between the fetch of this state and the next poll.
+    /// </summary>
+    /// <param name="song">Last fetched song, or null when nothing is playing</param>
+    /// <param name="sinceCommandMs">Time since the last user command, null if none</param>
+    /// <param name="unchangedPolls">Consecutive polls that returned the same track and play state</param>
+    public static int NextIntervalMs(SpotifySettings settings, SongInfo? song, double? sinceCommandMs, int unchangedPolls)
+    {
+        var dense = Math.Max(settings.PollingIntervalMs, 100);
+
+        if (!settings.AdaptivePolling)
+        {
+            return dense;
+        }
+
+        // Right after a command the user is watching the dial
+        if (sinceCommandMs.HasValue && sinceCommandMs.Value < settings.CommandPollWindowMs)
+        {
+            return dense;
+        }
+
+        if (song == null || !song.IsPlaying)
+        {
+            var backoff = (long)settings.PausedPollingIntervalMs << Math.Min(unchangedPolls, MaxBackoffShift);
+            return (int)Math.Clamp(backoff, dense, Math.Max(settings.MaxPollingIntervalMs, dense));
+        }
+
+        // Playing: sleep until just past the predicted boundary, but check in now and then
+        // for seeks and skips made from other Spotify clients
+        var remainingMs = (long)song.DurationMs - song.ProgressMs + BoundaryMarginMs;
+        if (remainingMs <= 0)
+        {
+            return dense;
+        }
+
+        return (int)Math.Clamp(remainingMs, dense, Math.Max(settings.PlayingCheckIntervalMs, dense));
+    }
+}
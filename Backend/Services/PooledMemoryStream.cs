@@ -0,0 +1,116 @@
+using System.Buffers;
+
+namespace SpotiDialBackend.Services;
+
+/// <summary>
+/// Write-mostly memory stream backed by ArrayPool buffers. Growing rents a larger buffer
+/// instead of allocating, and the written bytes can be read back through WrittenSegment
+/// without a copy. Dispose returns the buffer to the pool.
+/// </summary>
+public sealed class PooledMemoryStream : Stream
+{
+    private byte[] _buffer;
+    private int _length;
+    private int _position;
+
+    public PooledMemoryStream(int initialCapacity = 64 * 1024)
+    {
+        _buffer = ArrayPool<byte>.Shared.Rent(Math.Max(initialCapacity, 256));
+    }
+
+    /// <summary>
+    /// The bytes written so far. Only valid until the stream is written to again or disposed.
+    /// </summary>
+    public ArraySegment<byte> WrittenSegment => new(_buffer, 0, _length);
+
+    public override bool CanRead => false;
+    public override bool CanSeek => true;
+    public override bool CanWrite => true;
+    public override long Length => _length;
+
+    public override long Position
+    {
+        get => _position;
+        set => _position = (int)Math.Clamp(value, 0, _length);
+    }
+
+    public override void Write(byte[] buffer, int offset, int count) => Write(buffer.AsSpan(offset, count));
+
+    public override void Write(ReadOnlySpan<byte> buffer)
+    {
+        EnsureCapacity(_position + buffer.Length);
+        buffer.CopyTo(_buffer.AsSpan(_position));
+        _position += buffer.Length;
+        _length = Math.Max(_length, _position);
+    }
+
+    public override ValueTask WriteAsync(ReadOnlyMemory<byte> buffer, CancellationToken cancellationToken = default)
+    {
+        Write(buffer.Span);
+        return ValueTask.CompletedTask;
+    }
+
+    public override Task WriteAsync(byte[] buffer, int offset, int count, CancellationToken cancellationToken)
+    {
+        Write(buffer.AsSpan(offset, count));
+        return Task.CompletedTask;
+    }
+
+    public override void WriteByte(byte value)
+    {
+        EnsureCapacity(_position + 1);
+        _buffer[_position++] = value;
+        _length = Math.Max(_length, _position);
+    }
+
+    /// <summary>
+    /// Exact-size copy of the written bytes, for results that outlive the stream.
+    /// </summary>
+    public byte[] ToArray() => WrittenSegment.ToArray();
+
+    public override long Seek(long offset, SeekOrigin origin)
+    {
+        Position = origin switch
+        {
+            SeekOrigin.Begin => offset,
+            SeekOrigin.Current => _position + offset,
+            _ => _length + offset
+        };
+        return _position;
+    }
+
+    public override void SetLength(long value)
+    {
+        EnsureCapacity((int)value);
+        _length = (int)value;
+        _position = Math.Min(_position, _length);
+    }
+
+    public override int Read(byte[] buffer, int offset, int count) => throw new NotSupportedException();
+
+    public override void Flush()
+    {
+    }
+
+    protected override void Dispose(bool disposing)
+    {
+        var buffer = Interlocked.Exchange(ref _buffer, Array.Empty<byte>());
+        if (buffer.Length > 0)
+        {
+            ArrayPool<byte>.Shared.Return(buffer);
+        }
+        _length = 0;
+        _position = 0;
+        base.Dispose(disposing);
+    }
+
+    private void EnsureCapacity(int required)
+    {
+        if (required <= _buffer.Length) return;
+
+        var grown = ArrayPool<byte>.Shared.Rent(Math.Max(required, _buffer.Length * 2));
+        _buffer.AsSpan(0, _length).CopyTo(grown);
+        ArrayPool<byte>.Shared.Return(_buffer);
+        _buffer = grown;
+    }
+}
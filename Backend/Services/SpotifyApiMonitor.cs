@@ -0,0 +1,71 @@
+using System.Diagnostics;
+using System.Globalization;
+using System.Net;
+using Microsoft.Extensions.Logging;
+using SpotifyAPI.Web.Http;
+
+namespace SpotiDialBackend.Services;
+
+/// <summary>
+/// Sees every request the Spotify client sends. Counts API calls for the metrics and
+/// remembers the Retry-After of the last 429 so pollers can stay quiet until it expires.
+/// </summary>
+public class SpotifyApiMonitor : IHTTPLogger
+{
+    private static readonly TimeSpan DefaultRetryAfter = TimeSpan.FromSeconds(1);
+
+    private readonly ILogger<SpotifyApiMonitor> _logger;
+    private readonly long _startTimestamp = Stopwatch.GetTimestamp();
+
+    private long _requests;
+    private long _rateLimited;
+    private long _retryAfterUntil;
+
+    public SpotifyApiMonitor(ILogger<SpotifyApiMonitor> logger)
+    {
+        _logger = logger;
+    }
+
+    public long Requests => Interlocked.Read(ref _requests);
+    public long RateLimited => Interlocked.Read(ref _rateLimited);
+    public TimeSpan Uptime => Stopwatch.GetElapsedTime(_startTimestamp);
+
+    /// <summary>
+    /// Time left before Spotify wants to hear from us again; zero when not rate limited.
+    /// </summary>
+    public TimeSpan RetryAfterRemaining
+    {
+        get
+        {
+            var until = Interlocked.Read(ref _retryAfterUntil);
+            var now = Stopwatch.GetTimestamp();
+            return until > now ? Stopwatch.GetElapsedTime(now, until) : TimeSpan.Zero;
+        }
+    }
+
+    public void OnRequest(IRequest request)
+    {
+        Interlocked.Increment(ref _requests);
+    }
+
+    public void OnResponse(IResponse response)
+    {
+        if (response.StatusCode != HttpStatusCode.TooManyRequests) return;
+
+        Interlocked.Increment(ref _rateLimited);
+
+        var retryAfter = DefaultRetryAfter;
+        foreach (var (name, value) in response.Headers)
+        {
+            if (name.Equals("Retry-After", StringComparison.OrdinalIgnoreCase) &&
+                int.TryParse(value, NumberStyles.Integer, CultureInfo.InvariantCulture, out var seconds))
+            {
+                retryAfter = TimeSpan.FromSeconds(Math.Max(seconds, 1));
+            }
+        }
+
+        var until = Stopwatch.GetTimestamp() + (long)(retryAfter.TotalSeconds * Stopwatch.Frequency);
+        Interlocked.Exchange(ref _retryAfterUntil, until);
+        _logger.LogWarning("Spotify rate limited, retrying after {Seconds} s", retryAfter.TotalSeconds);
+    }
+}
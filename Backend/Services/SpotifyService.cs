@@ -1,3 +1,4 @@
+using System.Diagnostics;
 using Microsoft.Extensions.Logging;
 using Microsoft.Extensions.Options;
 using SpotifyAPI.Web;
@@ -11,26 +12,63 @@ public class SpotifyService
     private readonly ILogger<SpotifyService> _logger;
     private readonly SpotifySettings _settings;
     private readonly TokenStorageService _tokenStorage;
+    private readonly SpotifyApiMonitor _apiMonitor;
+    private readonly IHttpClientFactory _httpClientFactory;
     private SpotifyClient? _spotify;
-    private string? _currentTrackId;
     private string? _refreshToken;
+    private string? _userId;
+
+    // Latest playback state from a single GetCurrentPlayback call, swapped atomically
+    private volatile PlaybackState? _playback;
+    private readonly SemaphoreSlim _refreshLock = new(1, 1);
+    private readonly SemaphoreSlim _commandSignal = new(0, 1);
+    private long _lastCommandTimestamp;
+
+    private static readonly TimeSpan CachedVolumeMaxAge = TimeSpan.FromSeconds(30);
+
+    private long _polls;
+    private long _trackChanges;
+    private int _currentPollIntervalMs;
+    private readonly LatencyHistogram _trackChangeLag = new();
 
     public event Action<SongInfo>? OnSongChanged;
 
     public SpotifyService(
         ILogger<SpotifyService> logger,
         IOptions<AppSettings> settings,
-        TokenStorageService tokenStorage)
+        TokenStorageService tokenStorage,
+        SpotifyApiMonitor apiMonitor,
+        IHttpClientFactory httpClientFactory)
     {
         _logger = logger;
         _settings = settings.Value.Spotify;
         _tokenStorage = tokenStorage;
+        _apiMonitor = apiMonitor;
+        _httpClientFactory = httpClientFactory;
     }
 
     public async Task InitializeAsync()
     {
         try
         {
+            if (!string.IsNullOrEmpty(_settings.ApiBaseUrl))
+            {
+                // Local stub server (benchmarks and end-to-end tests): no OAuth, static token
+                var baseUrl = _settings.ApiBaseUrl.EndsWith('/') ? _settings.ApiBaseUrl : _settings.ApiBaseUrl + "/";
+                var stubConfig = new SpotifyClientConfig(
+                    new Uri(baseUrl),
+                    new TokenAuthenticator("stub", "Bearer"),
+                    new NewtonsoftJSONSerializer(),
+                    new NetHttpClient(_httpClientFactory.CreateClient(HttpClientNames.Spotify)),
+                    null,
+                    _apiMonitor,
+                    new SimplePaginator());
+
+                _spotify = new SpotifyClient(stubConfig);
+                _logger.LogWarning("Spotify client using alternative API endpoint {BaseUrl}", baseUrl);
+                return;
+            }
+
             _logger.LogInformation("Initializing Spotify client with automatic token refresh...");
 
             // Try to get refresh token from storage first
@@ -81,7 +119,9 @@ public class SpotifyService
 
             var config = SpotifyClientConfig
                 .CreateDefault()
-                .WithAuthenticator(authenticator);
+                .WithAuthenticator(authenticator)
+                .WithHTTPClient(new NetHttpClient(_httpClientFactory.CreateClient(HttpClientNames.Spotify)))
+                .WithHTTPLogger(_apiMonitor);
 
             _spotify = new SpotifyClient(config);
 
@@ -209,60 +249,191 @@ public class SpotifyService
         }
     }
 
-    public async Task<SongInfo?> GetCurrentSongInfoAsync()
+    /// <summary>
+    /// Fetch the playback state and make it the cached one. Callers get a copy they may modify.
+    /// </summary>
+    public async Task<SongInfo?> GetCurrentSongInfoAsync(CancellationToken cancellationToken = default)
+    {
+        var state = await RefreshPlaybackAsync(cancellationToken);
+        return state?.Song?.Clone();
+    }
+
+    /// <summary>
+    /// Tell the monitor a command just went out so it polls densely for a while.
+    /// </summary>
+    public void NotifyCommand()
+    {
+        Interlocked.Exchange(ref _lastCommandTimestamp, Stopwatch.GetTimestamp());
+
+        // Wake the monitor to reschedule; it does not poll until the new interval says so
+        if (_commandSignal.CurrentCount == 0)
+        {
+            try
+            {
+                _commandSignal.Release();
+            }
+            catch (SemaphoreFullException)
+            {
+                // Already signalled
+            }
+        }
+    }
+
+    public PlaybackMetrics GetPlaybackMetrics()
+    {
+        var hours = Math.Max(_apiMonitor.Uptime.TotalHours, 1.0 / 3600);
+        var apiCalls = _apiMonitor.Requests;
+        var polls = Interlocked.Read(ref _polls);
+
+        return new PlaybackMetrics
+        {
+            ApiCalls = apiCalls,
+            ApiCallsPerHour = Math.Round(apiCalls / hours, 1),
+            Polls = polls,
+            PollsPerHour = Math.Round(polls / hours, 1),
+            CurrentPollIntervalMs = Volatile.Read(ref _currentPollIntervalMs),
+            RateLimited = _apiMonitor.RateLimited,
+            TrackChanges = Interlocked.Read(ref _trackChanges),
+            TrackChangeLagP50Ms = _trackChangeLag.Percentile(50),
+            TrackChangeLagP90Ms = _trackChangeLag.Percentile(90),
+            TrackChangeLagMaxMs = Math.Round(_trackChangeLag.MaxMs, 1)
+        };
+    }
+
+    // The one place GetCurrentPlayback is called. Concurrent callers (monitor and a command's
+    // status push) share the fetch in flight rather than issuing a second request.
+    private async Task<PlaybackState?> RefreshPlaybackAsync(CancellationToken cancellationToken)
     {
         if (_spotify == null) return null;
 
+        var requested = Stopwatch.GetTimestamp();
+        await _refreshLock.WaitAsync(cancellationToken);
         try
         {
-            var playback = await _spotify.Player.GetCurrentPlayback();
-            if (playback?.Item is FullTrack track)
+            var cached = _playback;
+            if (cached != null && cached.FetchedTimestamp >= requested)
             {
-                return new SongInfo
-                {
-                    TrackName = track.Name,
-                    ArtistName = string.Join(", ", track.Artists.Select(a => a.Name)),
-                    AlbumName = track.Album.Name,
-                    DurationMs = track.DurationMs,
-                    ProgressMs = playback.ProgressMs,
-                    IsPlaying = playback.IsPlaying,
-                    VolumePercent = playback.Device?.VolumePercent ?? 0,
-                    AlbumImageUrl = track.Album.Images.FirstOrDefault()?.Url
-                };
+                return cached;
             }
+
+            // Stamped before the request: a fetch that started earlier may predate a command
+            var fetched = Stopwatch.GetTimestamp();
+            var playback = await _spotify.Player.GetCurrentPlayback(cancellationToken);
+            var state = ToPlaybackState(playback, fetched);
+            _playback = state;
+
+            if (state.TrackId != null && state.TrackId != cached?.TrackId)
+            {
+                OnTrackChanged(cached, state);
+            }
+
+            return state;
         }
-        catch (Exception ex)
+        catch (Exception ex) when (ex is not OperationCanceledException)
         {
             _logger.LogError(ex, "Error getting current song info");
+            return null;
+        }
+        finally
+        {
+            _refreshLock.Release();
         }
+    }
+
+    private void OnTrackChanged(PlaybackState? previous, PlaybackState state)
+    {
+        Interlocked.Increment(ref _trackChanges);
+
+        // Progress into the new track is how late we noticed. Only tracks that started on
+        // their own count: after a command the status push already carries the change.
+        if (previous?.TrackId != null && state.Song != null && !CommandRecently())
+        {
+            _trackChangeLag.Record(state.Song.ProgressMs);
+        }
+
+        _logger.LogInformation("Song changed: {Artist} - {Track}", state.Song?.ArtistName, state.Song?.TrackName);
+        if (state.Song != null)
+        {
+            OnSongChanged?.Invoke(state.Song.Clone());
+        }
+    }
+
+    private static PlaybackState ToPlaybackState(CurrentlyPlayingContext? playback, long fetchedTimestamp)
+    {
+        if (playback?.Item is not FullTrack track)
+        {
+            return new PlaybackState(null, null, fetchedTimestamp);
+        }
+
+        var song = new SongInfo
+        {
+            TrackName = track.Name,
+            ArtistName = string.Join(", ", track.Artists.Select(a => a.Name)),
+            AlbumName = track.Album.Name,
+            DurationMs = track.DurationMs,
+            ProgressMs = playback.ProgressMs,
+            IsPlaying = playback.IsPlaying,
+            VolumePercent = playback.Device?.VolumePercent ?? 0,
+            AlbumImageUrl = PickImageUrl(track.Album.Images)
+        };
+
+        return new PlaybackState(track.Id, song, fetchedTimestamp);
+    }
 
-        return null;
+    private double? SinceCommandMs()
+    {
+        var last = Interlocked.Read(ref _lastCommandTimestamp);
+        return last == 0 ? null : Stopwatch.GetElapsedTime(last).TotalMilliseconds;
     }
 
+    private bool CommandRecently() => SinceCommandMs() < _settings.CommandPollWindowMs;
+
     public async Task MonitorPlaybackAsync(CancellationToken cancellationToken)
     {
-        _logger.LogInformation("Starting playback monitoring...");
+        _logger.LogInformation("Starting playback monitoring ({Mode} polling)...",
+            _settings.AdaptivePolling ? "adaptive" : "fixed");
+
+        var unchangedPolls = 0;
 
         while (!cancellationToken.IsCancellationRequested)
         {
             try
             {
-                var songInfo = await GetCurrentSongInfoAsync();
-                if (songInfo != null && _spotify != null)
+                var state = _playback;
+                var interval = PlaybackPollScheduler.NextIntervalMs(_settings, state?.Song, SinceCommandMs(), unchangedPolls);
+                Volatile.Write(ref _currentPollIntervalMs, interval);
+
+                // The interval counts from the last fetch, which a command may have refreshed
+                var wait = state == null
+                    ? TimeSpan.Zero
+                    : TimeSpan.FromMilliseconds(interval) - Stopwatch.GetElapsedTime(state.FetchedTimestamp);
+
+                var retryAfter = _apiMonitor.RetryAfterRemaining;
+                if (retryAfter > wait)
+                {
+                    wait = retryAfter;
+                }
+
+                if (wait > TimeSpan.Zero)
                 {
-                    var playback = await _spotify.Player.GetCurrentPlayback();
-                    if (playback?.Item is FullTrack track)
-                    {
-                        if (_currentTrackId != track.Id)
-                        {
-                            _currentTrackId = track.Id;
-                            _logger.LogInformation("Song changed: {Artist} - {Track}", songInfo.ArtistName, songInfo.TrackName);
-                            OnSongChanged?.Invoke(songInfo);
-                        }
-                    }
+                    // A command cuts the wait short so the schedule is recomputed
+                    await _commandSignal.WaitAsync(wait, cancellationToken);
+                    continue;
                 }
 
-                await Task.Delay(_settings.PollingIntervalMs, cancellationToken);
+                var fresh = await RefreshPlaybackAsync(cancellationToken);
+                Interlocked.Increment(ref _polls);
+
+                if (fresh == null)
+                {
+                    // Request failed; the backoff keeps a broken connection from spinning
+                    unchangedPolls++;
+                    await Task.Delay(Math.Max(_settings.PollingIntervalMs, 1000), cancellationToken);
+                    continue;
+                }
+
+                var unchanged = fresh.TrackId == state?.TrackId && fresh.Song?.IsPlaying == state?.Song?.IsPlaying;
+                unchangedPolls = unchanged ? unchangedPolls + 1 : 0;
             }
             catch (OperationCanceledException)
             {
@@ -278,12 +449,12 @@ public class SpotifyService
         _logger.LogInformation("Playback monitoring stopped");
     }
 
-    public async Task PlayAsync()
+    public async Task PlayAsync(CancellationToken cancellationToken = default)
     {
         if (_spotify == null) return;
         try
         {
-            await _spotify.Player.ResumePlayback();
+            await _spotify.Player.ResumePlayback(cancellationToken);
             _logger.LogInformation("Playback resumed");
         }
         catch (SpotifyAPI.Web.APIException apiEx)
@@ -297,89 +468,117 @@ public class SpotifyService
                 _logger.LogError(apiEx, "Spotify API error while resuming playback");
             }
         }
-        catch (Exception ex)
+        catch (Exception ex) when (ex is not OperationCanceledException)
         {
             _logger.LogError(ex, "Error resuming playback");
         }
     }
 
-    public async Task PauseAsync()
+    public async Task PauseAsync(CancellationToken cancellationToken = default)
     {
         if (_spotify == null) return;
         try
         {
-            await _spotify.Player.PausePlayback();
+            await _spotify.Player.PausePlayback(cancellationToken);
             _logger.LogInformation("Playback paused");
         }
-        catch (Exception ex)
+        catch (Exception ex) when (ex is not OperationCanceledException)
         {
             _logger.LogError(ex, "Error pausing playback");
         }
     }
 
-    public async Task NextTrackAsync()
+    public async Task NextTrackAsync(CancellationToken cancellationToken = default)
     {
         if (_spotify == null) return;
         try
         {
-            await _spotify.Player.SkipNext();
+            await _spotify.Player.SkipNext(cancellationToken);
             _logger.LogInformation("Skipped to next track");
         }
-        catch (Exception ex)
+        catch (Exception ex) when (ex is not OperationCanceledException)
         {
             _logger.LogError(ex, "Error skipping to next track");
         }
     }
 
-    public async Task PreviousTrackAsync()
+    public async Task PreviousTrackAsync(CancellationToken cancellationToken = default)
     {
         if (_spotify == null) return;
         try
         {
-            await _spotify.Player.SkipPrevious();
+            await _spotify.Player.SkipPrevious(cancellationToken);
             _logger.LogInformation("Skipped to previous track");
         }
-        catch (Exception ex)
+        catch (Exception ex) when (ex is not OperationCanceledException)
         {
             _logger.LogError(ex, "Error skipping to previous track");
         }
     }
 
-    public async Task SetVolumeAsync(int volumePercent)
+    public async Task SetVolumeAsync(int volumePercent, CancellationToken cancellationToken = default)
     {
         if (_spotify == null) return;
         try
         {
             volumePercent = Math.Clamp(volumePercent, 0, 100);
-            await _spotify.Player.SetVolume(new PlayerVolumeRequest(volumePercent));
+            await _spotify.Player.SetVolume(new PlayerVolumeRequest(volumePercent), cancellationToken);
             _logger.LogInformation("Volume set to {Volume}%", volumePercent);
+
+            // Keep the cached state current so relative changes need no extra fetch
+            var state = _playback;
+            if (state?.Song != null)
+            {
+                var song = state.Song.Clone();
+                song.VolumePercent = volumePercent;
+                Interlocked.CompareExchange(ref _playback, state with { Song = song }, state);
+            }
         }
-        catch (Exception ex)
+        catch (Exception ex) when (ex is not OperationCanceledException)
         {
             _logger.LogError(ex, "Error setting volume");
         }
     }
 
-    public async Task ChangeVolumeAsync(int delta)
+    public async Task ChangeVolumeAsync(int delta, CancellationToken cancellationToken = default)
     {
         if (_spotify == null) return;
         try
         {
-            var playback = await _spotify.Player.GetCurrentPlayback();
-            if (playback?.Device != null)
+            var state = _playback;
+            if (state == null || Stopwatch.GetElapsedTime(state.FetchedTimestamp) > CachedVolumeMaxAge)
             {
-                var currentVolume = playback.Device.VolumePercent ?? 50;
-                var newVolume = Math.Clamp(currentVolume + delta, 0, 100);
-                await SetVolumeAsync(newVolume);
+                state = await RefreshPlaybackAsync(cancellationToken);
+            }
+
+            if (state?.Song != null)
+            {
+                var newVolume = Math.Clamp(state.Song.VolumePercent + delta, 0, 100);
+                await SetVolumeAsync(newVolume, cancellationToken);
             }
         }
-        catch (Exception ex)
+        catch (Exception ex) when (ex is not OperationCanceledException)
         {
             _logger.LogError(ex, "Error changing volume");
         }
     }
 
-    public async Task ChangePlaylistAsync(string playlistId)
+    public async Task SeekAsync(int positionMs, CancellationToken cancellationToken = default)
+    {
+        if (_spotify == null) return;
+        try
+        {
+            positionMs = Math.Max(positionMs, 0);
+            await _spotify.Player.SeekTo(new PlayerSeekToRequest(positionMs), cancellationToken);
+            _logger.LogInformation("Seeked to {Position} ms", positionMs);
+        }
+        catch (Exception ex) when (ex is not OperationCanceledException)
+        {
+            _logger.LogError(ex, "Error seeking");
+        }
+    }
+
+    public async Task ChangePlaylistAsync(string playlistId, CancellationToken cancellationToken = default)
     {
         if (_spotify == null) return;
         try
@@ -387,16 +586,16 @@ public class SpotifyService
             await _spotify.Player.ResumePlayback(new PlayerResumePlaybackRequest
             {
                 ContextUri = $"spotify:playlist:{playlistId}"
-            });
+            }, cancellationToken);
             _logger.LogInformation("Changed to playlist: {PlaylistId}", playlistId);
         }
-        catch (Exception ex)
+        catch (Exception ex) when (ex is not OperationCanceledException)
         {
             _logger.LogError(ex, "Error changing playlist");
         }
     }
 
-    public async Task ChangeAlbumAsync(string albumId)
+    public async Task ChangeAlbumAsync(string albumId, CancellationToken cancellationToken = default)
     {
         if (_spotify == null) return;
         try
@@ -404,63 +603,65 @@ public class SpotifyService
             await _spotify.Player.ResumePlayback(new PlayerResumePlaybackRequest
             {
                 ContextUri = $"spotify:album:{albumId}"
-            });
+            }, cancellationToken);
             _logger.LogInformation("Changed to album: {AlbumId}", albumId);
         }
-        catch (Exception ex)
+        catch (Exception ex) when (ex is not OperationCanceledException)
         {
             _logger.LogError(ex, "Error changing album");
         }
     }
 
-    public async Task<byte[]?> GetAlbumImageAsync(string? imageUrl)
+    /// <summary>
+    /// Spotify user id of the account, used to key the library cache.
+    /// </summary>
+    public async Task<string?> GetCurrentUserIdAsync(CancellationToken cancellationToken = default)
     {
-        if (string.IsNullOrEmpty(imageUrl)) return null;
+        if (_spotify == null) return null;
 
-        try
+        if (_userId == null)
         {
-            using var httpClient = new HttpClient();
-            return await httpClient.GetByteArrayAsync(imageUrl);
-        }
-        catch (Exception ex)
-        {
-            _logger.LogError(ex, "Error downloading album image");
-            return null;
+            var profile = await _spotify.UserProfile.Current(cancellationToken);
+            _userId = profile.Id;
         }
+
+        return _userId;
     }
 
-    public async Task<List<PlaylistInfo>> GetUserPlaylistsAsync()
+    /// <summary>
+    /// One page of the user's playlists, keyed by snapshot id so changed playlists can be spotted.
+    /// </summary>
+    public async Task<LibraryPage<PlaylistInfo>> GetPlaylistsPageAsync(int offset, int limit,
+        CancellationToken cancellationToken = default)
     {
-        if (_spotify == null) return new List<PlaylistInfo>();
+        if (_spotify == null) return LibraryPage<PlaylistInfo>.Empty;
 
-        try
-        {
-            var playlists = new List<PlaylistInfo>();
-            var currentPlaylists = await _spotify.Playlists.CurrentUsers();
+        var page = await _spotify.Playlists.CurrentUsers(
+            new PlaylistCurrentUsersRequest { Offset = offset, Limit = limit }, cancellationToken);
 
-            await foreach (var playlist in _spotify.Paginate(currentPlaylists))
-            {
-                playlists.Add(new PlaylistInfo
-                {
-                    Id = playlist.Id ?? string.Empty,
-                    Name = playlist.Name ?? string.Empty,
-                    Description = playlist.Description,
-                    TrackCount = playlist.Tracks?.Total ?? 0,
-                    ImageUrl = playlist.Images?.FirstOrDefault()?.Url,
-                    Owner = playlist.Owner?.DisplayName ?? string.Empty,
-                    IsPublic = playlist.Public ?? false,
-                    Uri = playlist.Uri ?? string.Empty
-                });
-            }
+        var items = (page.Items ?? new List<FullPlaylist>())
+            .Select(p => new LibraryEntry<PlaylistInfo>($"{p.Id}:{p.SnapshotId}", ToPlaylistInfo(p)))
+            .ToList();
 
-            _logger.LogInformation("Retrieved {Count} playlists", playlists.Count);
-            return playlists;
-        }
-        catch (Exception ex)
-        {
-            _logger.LogError(ex, "Error getting user playlists");
-            return new List<PlaylistInfo>();
-        }
+        return new LibraryPage<PlaylistInfo>(items, page.Total ?? items.Count);
+    }
+
+    /// <summary>
+    /// One page of the user's saved albums, newest first, keyed by id and save time.
+    /// </summary>
+    public async Task<LibraryPage<AlbumInfo>> GetAlbumsPageAsync(int offset, int limit,
+        CancellationToken cancellationToken = default)
+    {
+        if (_spotify == null) return LibraryPage<AlbumInfo>.Empty;
+
+        var page = await _spotify.Library.GetAlbums(
+            new LibraryAlbumsRequest { Offset = offset, Limit = limit }, cancellationToken);
+
+        var items = (page.Items ?? new List<SavedAlbum>())
+            .Select(a => new LibraryEntry<AlbumInfo>($"{a.Album.Id}:{a.AddedAt:O}", ToAlbumInfo(a.Album)))
+            .ToList();
+
+        return new LibraryPage<AlbumInfo>(items, page.Total ?? items.Count);
     }
 
     public async Task<PlaylistInfo?> GetPlaylistAsync(string playlistId)
@@ -472,17 +673,7 @@ public class SpotifyService
             var playlist = await _spotify.Playlists.Get(playlistId);
             if (playlist == null) return null;
 
-            var playlistInfo = new PlaylistInfo
-            {
-                Id = playlist.Id ?? string.Empty,
-                Name = playlist.Name ?? string.Empty,
-                Description = playlist.Description,
-                TrackCount = playlist.Tracks?.Total ?? 0,
-                ImageUrl = playlist.Images?.FirstOrDefault()?.Url,
-                Owner = playlist.Owner?.DisplayName ?? string.Empty,
-                IsPublic = playlist.Public ?? false,
-                Uri = playlist.Uri ?? string.Empty
-            };
+            var playlistInfo = ToPlaylistInfo(playlist);
 
             _logger.LogInformation("Retrieved playlist: {PlaylistName}", playlistInfo.Name);
             return playlistInfo;
@@ -494,41 +685,6 @@ public class SpotifyService
         }
     }
 
-    public async Task<List<AlbumInfo>> GetUserAlbumsAsync()
-    {
-        if (_spotify == null) return new List<AlbumInfo>();
-
-        try
-        {
-            var albums = new List<AlbumInfo>();
-            var currentAlbums = await _spotify.Library.GetAlbums();
-
-            await foreach (var savedAlbum in _spotify.Paginate(currentAlbums))
-            {
-                var album = savedAlbum.Album;
-                albums.Add(new AlbumInfo
-                {
-                    Id = album.Id ?? string.Empty,
-                    Name = album.Name ?? string.Empty,
-                    Artist = string.Join(", ", album.Artists.Select(a => a.Name)),
-                    TrackCount = album.TotalTracks,
-                    ImageUrl = album.Images?.FirstOrDefault()?.Url,
-                    ReleaseDate = album.ReleaseDate ?? string.Empty,
-                    AlbumType = album.AlbumType ?? string.Empty,
-                    Uri = album.Uri ?? string.Empty
-                });
-            }
-
-            _logger.LogInformation("Retrieved {Count} albums", albums.Count);
-            return albums;
-        }
-        catch (Exception ex)
-        {
-            _logger.LogError(ex, "Error getting user albums");
-            return new List<AlbumInfo>();
-        }
-    }
-
     public async Task<AlbumInfo?> GetAlbumAsync(string albumId)
     {
         if (_spotify == null) return null;
@@ -538,17 +694,7 @@ public class SpotifyService
             var album = await _spotify.Albums.Get(albumId);
             if (album == null) return null;
 
-            var albumInfo = new AlbumInfo
-            {
-                Id = album.Id ?? string.Empty,
-                Name = album.Name ?? string.Empty,
-                Artist = string.Join(", ", album.Artists.Select(a => a.Name)),
-                TrackCount = album.TotalTracks,
-                ImageUrl = album.Images?.FirstOrDefault()?.Url,
-                ReleaseDate = album.ReleaseDate ?? string.Empty,
-                AlbumType = album.AlbumType ?? string.Empty,
-                Uri = album.Uri ?? string.Empty
-            };
+            var albumInfo = ToAlbumInfo(album);
 
             _logger.LogInformation("Retrieved album: {AlbumName}", albumInfo.Name);
             return albumInfo;
@@ -559,4 +705,40 @@ public class SpotifyService
             return null;
         }
     }
+
+    // Smallest cover that still fills the display; Spotify usually offers 640, 300 and 64 px
+    private static string? PickImageUrl(List<Image>? images)
+    {
+        if (images == null || images.Count == 0) return null;
+
+        var fitting = images
+            .Where(i => i.Width >= ImageProcessingService.TargetWidth && i.Height >= ImageProcessingService.TargetHeight)
+            .MinBy(i => i.Width);
+
+        return (fitting ?? images.MaxBy(i => i.Width))?.Url;
+    }
+
+    private static PlaylistInfo ToPlaylistInfo(FullPlaylist playlist) => new()
+    {
+        Id = playlist.Id ?? string.Empty,
+        Name = playlist.Name ?? string.Empty,
+        Description = playlist.Description,
+        TrackCount = playlist.Tracks?.Total ?? 0,
+        ImageUrl = playlist.Images?.FirstOrDefault()?.Url,
+        Owner = playlist.Owner?.DisplayName ?? string.Empty,
+        IsPublic = playlist.Public ?? false,
+        Uri = playlist.Uri ?? string.Empty
+    };
+
+    private static AlbumInfo ToAlbumInfo(FullAlbum album) => new()
+    {
+        Id = album.Id ?? string.Empty,
+        Name = album.Name ?? string.Empty,
+        Artist = string.Join(", ", album.Artists.Select(a => a.Name)),
+        TrackCount = album.TotalTracks,
+        ImageUrl = album.Images?.FirstOrDefault()?.Url,
+        ReleaseDate = album.ReleaseDate ?? string.Empty,
+        AlbumType = album.AlbumType ?? string.Empty,
+        Uri = album.Uri ?? string.Empty
+    };
 }
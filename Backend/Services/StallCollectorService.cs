@@ -0,0 +1,356 @@
+using System.Buffers.Binary;
+using System.Collections.Concurrent;
+using System.Text;
+using System.Threading.Channels;
+using Microsoft.Extensions.Hosting;
+using Microsoft.Extensions.Logging;
+using Microsoft.Extensions.Options;
+using SpotiDialBackend.Models;
+
+namespace SpotiDialBackend.Services;
+
+/// <summary>
+/// Collects the stall and panic reports dials upload from their flash ring, symbolizes the
+/// backtraces and ranks the stalls across the fleet by how long dials spent in them. Stalls are
+/// grouped by step and by the first frame in the firmware's own sources, so the same slow call
+/// from different dials and builds adds up. Core dumps that follow a panic are reassembled and
+/// written to the core dump directory.
+/// </summary>
+public class StallCollectorService : BackgroundService
+{
+    private readonly ILogger<StallCollectorService> _logger;
+    private readonly DiagnosticsSettings _settings;
+    private readonly FirmwareSymbolizer _symbolizer;
+
+    // Symbolizing may start addr2line; reports wait here instead of in the MQTT receive loop
+    private readonly Channel<StallReport> _reports = Channel.CreateBounded<StallReport>(
+        new BoundedChannelOptions(1024) { SingleReader = true, FullMode = BoundedChannelFullMode.DropOldest });
+
+    private readonly ConcurrentDictionary<string, StallGroup> _groups = new();
+    private readonly Dictionary<string, CoreDumpAssembly> _coreDumps = new();
+    private readonly ConcurrentDictionary<string, string> _elfByDevice = new();
+    private long _reportCount;
+    private long _panicCount;
+    private long _coreDumpCount;
+    private long _coreDumpsIgnored;
+    private DateTime _lastIgnoredWarning;
+
+    private const int CoreDumpHeaderSize = 12;
+    private const int MaxCoreDumpBytes = 1024 * 1024;
+
+    // Anyone on the broker can publish chunks, so few dumps are reassembled at once and a dump
+    // that stops arriving is dropped
+    private const int MaxCoreDumpAssemblies = 4;
+    private static readonly TimeSpan CoreDumpChunkTimeout = TimeSpan.FromSeconds(60);
+
+    // The watchdog samples a busy loop from its timer interrupt; these frames sit on top
+    private static readonly string[] InterruptFrames =
+    {
+        "StallWatchdog::", "_xt_", "_frxt_", "xt_int", "__timerISR", "timerFnWrapper", "timer_isr_default",
+        "timer_group_", "shared_intr_isr", "esp_backtrace_get_start"
+    };
+
+    public StallCollectorService(ILogger<StallCollectorService> logger, IOptions<AppSettings> settings)
+    {
+        _logger = logger;
+        _settings = settings.Value.Diagnostics;
+        _symbolizer = new FirmwareSymbolizer(logger, _settings);
+    }
+
+    public bool IsEnabled => _settings.Enabled;
+
+    public void RecordReport(StallReport report)
+    {
+        if (!_settings.Enabled || string.IsNullOrEmpty(report.DeviceId)) return;
+        _reports.Writer.TryWrite(report);
+    }
+
+    /// <summary>
+    /// Add a chunk of a dial's core dump. Each starts with the seq of the panic report, its offset
+    /// and the dump size (u32, little-endian). The dial starts over at offset 0 after a reconnect.
+    /// </summary>
+    public async Task RecordCoreDumpChunkAsync(string clientId, byte[] chunk)
+    {
+        if (!_settings.Enabled || chunk.Length < CoreDumpHeaderSize) return;
+
+        var seq = BinaryPrimitives.ReadUInt32LittleEndian(chunk);
+        var offset = BinaryPrimitives.ReadUInt32LittleEndian(chunk.AsSpan(4));
+        var total = BinaryPrimitives.ReadUInt32LittleEndian(chunk.AsSpan(8));
+        var length = chunk.Length - CoreDumpHeaderSize;
+        if (total == 0 || total > MaxCoreDumpBytes || offset + (long)length > total) return;
+
+        CoreDumpAssembly? assembly;
+        lock (_coreDumps)
+        {
+            var now = DateTime.UtcNow;
+            foreach (var stale in _coreDumps.Where(entry => now - entry.Value.LastChunk > CoreDumpChunkTimeout).ToList())
+            {
+                _coreDumps.Remove(stale.Key);
+                _logger.LogWarning("Core dump of {Device} dropped after {Received} of {Total} bytes: no chunk for {Timeout} s",
+                    stale.Key, stale.Value.Bytes.Length, stale.Value.Total, CoreDumpChunkTimeout.TotalSeconds);
+            }
+
+            if (offset == 0)
+            {
+                if (!_coreDumps.ContainsKey(clientId) && _coreDumps.Count >= MaxCoreDumpAssemblies)
+                {
+                    // Once per timeout, so a flood of starts does not flood the log too
+                    _coreDumpsIgnored++;
+                    if (now - _lastIgnoredWarning > CoreDumpChunkTimeout)
+                    {
+                        _lastIgnoredWarning = now;
+                        _logger.LogWarning("Core dump of {Device} ignored: {Count} dumps are already arriving " +
+                                           "({Ignored} ignored so far)", clientId, _coreDumps.Count, _coreDumpsIgnored);
+                    }
+                    return;
+                }
+                assembly = new CoreDumpAssembly(seq, total, length);
+                _coreDumps[clientId] = assembly;
+            }
+            else if (!_coreDumps.TryGetValue(clientId, out assembly) ||
+                     assembly.Seq != seq || assembly.Total != total || assembly.Bytes.Length != offset)
+            {
+                // A chunk went missing; wait for the dial to start over
+                _coreDumps.Remove(clientId);
+                return;
+            }
+
+            // Memory grows with what has arrived, not with the size the first chunk claims
+            assembly.Bytes.Write(chunk, CoreDumpHeaderSize, length);
+            assembly.LastChunk = now;
+            if (assembly.Bytes.Length < total) return;
+
+            _coreDumps.Remove(clientId);
+        }
+
+        var path = Path.Combine(CoreDumpDirectory(), $"{clientId}-{seq}-{DateTime.UtcNow:yyyyMMdd-HHmmss}.core");
+        await using (var file = File.Create(path))
+        {
+            assembly.Bytes.Position = 0;
+            await assembly.Bytes.CopyToAsync(file);
+        }
+        Interlocked.Increment(ref _coreDumpCount);
+
+        var elf = _elfByDevice.TryGetValue(clientId, out var digest) ? _symbolizer.FindElf(digest) : null;
+        _logger.LogWarning("Core dump of {Device} saved to {Path} ({Size} bytes); " +
+                           "espcoredump.py info_corefile --core-format raw --core {Path} {Elf}",
+            clientId, path, total, path, elf ?? "firmware.elf");
+    }
+
+    public StallMetrics GetMetrics() => new()
+    {
+        Reports = Interlocked.Read(ref _reportCount),
+        Panics = Interlocked.Read(ref _panicCount),
+        CoreDumps = Interlocked.Read(ref _coreDumpCount),
+        Top = Ranking().Take(Math.Max(_settings.TopStalls, 1)).ToList()
+    };
+
+    public string FormatSummary()
+    {
+        var summary = new StringBuilder();
+        foreach (var group in Ranking().Take(Math.Max(_settings.TopStalls, 1)))
+        {
+            summary.AppendLine(
+                $"  {group.Kind,-5} {group.Step,-8} {group.Function} ({group.Location}): " +
+                $"{group.Count}x{(group.Unreported > 0 ? $" +{group.Unreported} unreported" : "")} on {group.Devices} dials, " +
+                $"total {group.TotalMs} ms, max {group.MaxMs} ms" +
+                (group.Blocked > 0 ? $", {group.Blocked} waiting in {group.WaitingIn}" : ""));
+        }
+        return summary.ToString();
+    }
+
+    protected override async Task ExecuteAsync(CancellationToken stoppingToken)
+    {
+        if (!_settings.Enabled) return;
+
+        await Task.WhenAll(ProcessReportsAsync(stoppingToken), LogRankingAsync(stoppingToken));
+    }
+
+    // Panics first, then stalls by the time dials lost to them
+    private IEnumerable<StallGroupMetrics> Ranking() =>
+        _groups.Values.Select(group => group.ToMetrics())
+            .OrderBy(group => group.Kind == StallKinds.Panic ? 0 : 1)
+            .ThenByDescending(group => group.Kind == StallKinds.Panic ? group.Count : group.TotalMs)
+            .ThenByDescending(group => group.Count + group.Unreported);
+
+    private async Task ProcessReportsAsync(CancellationToken stoppingToken)
+    {
+        try
+        {
+            await foreach (var report in _reports.Reader.ReadAllAsync(stoppingToken))
+            {
+                try
+                {
+                    await ProcessAsync(report, stoppingToken);
+                }
+                catch (Exception ex) when (ex is not OperationCanceledException)
+                {
+                    _logger.LogError(ex, "Error processing stall report from {Device}", report.DeviceId);
+                }
+            }
+        }
+        catch (OperationCanceledException)
+        {
+        }
+    }
+
+    private async Task LogRankingAsync(CancellationToken stoppingToken)
+    {
+        var interval = TimeSpan.FromSeconds(Math.Max(_settings.ReportIntervalSeconds, 1));
+
+        while (!stoppingToken.IsCancellationRequested)
+        {
+            try
+            {
+                await Task.Delay(interval, stoppingToken);
+            }
+            catch (OperationCanceledException)
+            {
+                break;
+            }
+
+            if (!_groups.IsEmpty)
+            {
+                _logger.LogInformation("Worst dial stalls ({Reports} reports, {Panics} panics):{NewLine}{Summary}",
+                    Interlocked.Read(ref _reportCount), Interlocked.Read(ref _panicCount),
+                    Environment.NewLine, FormatSummary());
+            }
+        }
+    }
+
+    private async Task ProcessAsync(StallReport report, CancellationToken cancellationToken)
+    {
+        var panic = report.Kind == StallKinds.Panic;
+        Interlocked.Increment(ref _reportCount);
+        if (panic) Interlocked.Increment(ref _panicCount);
+        if (!string.IsNullOrEmpty(report.Elf)) _elfByDevice[report.DeviceId] = report.Elf;
+
+        var frames = await _symbolizer.SymbolizeAsync(report.Elf, report.Backtrace.Select(CallSite).ToList(),
+            cancellationToken);
+        if (!panic && !report.Blocked)
+        {
+            frames = DropInterruptFrames(frames);
+        }
+
+        // Group by where in our code it happened; the innermost frame says what it was doing
+        var app = frames.FirstOrDefault(frame => frame.Location.Contains(_settings.AppSourcePath, StringComparison.Ordinal));
+        var function = app?.Function ?? frames.FirstOrDefault(frame => frame.Resolved)?.Function ?? "?";
+        var location = app != null ? ShortLocation(app.Location) : $"ELF {ShortDigest(report.Elf)}";
+        var waitingIn = frames.FirstOrDefault(frame => frame.Resolved)?.Function ?? "?";
+
+        var key = $"{report.Kind}|{report.Step}|{function}|{(app != null ? "" : report.Elf)}";
+        _groups.GetOrAdd(key, _ => new StallGroup(report.Kind, report.Step, function, location))
+            .Record(report, waitingIn);
+
+        if (panic)
+        {
+            _logger.LogWarning("Dial {Device} ({Version}) reset on {Reason} in step {Step}, task {Task}:{NewLine}{Backtrace}",
+                report.DeviceId, report.Version, report.Reason ?? "?", report.Step, report.Task ?? "?",
+                Environment.NewLine, string.Join(Environment.NewLine, frames.Select(frame => $"  {frame}")));
+        }
+        else
+        {
+            _logger.LogDebug("Dial {Device} stalled {DurationMs} ms in {Step} at {Function} ({Location}){Blocked}",
+                report.DeviceId, report.DurationMs, report.Step, function, location,
+                report.Blocked ? $", waiting in {waitingIn}" : "");
+        }
+    }
+
+    private static IReadOnlyList<SymbolizedFrame> DropInterruptFrames(IReadOnlyList<SymbolizedFrame> frames)
+    {
+        var last = -1;
+        for (var i = 0; i < frames.Count; i++)
+        {
+            if (InterruptFrames.Any(prefix => frames[i].Function.StartsWith(prefix, StringComparison.Ordinal)))
+            {
+                last = i;
+            }
+        }
+        return last < 0 ? frames : frames.Skip(last + 1).ToList();
+    }
+
+    // Panic backtraces may hold raw return addresses, with the caller's window size in the top
+    // bits; the watchdog's own samples are call sites already
+    private static uint CallSite(uint address) =>
+        (address & 0x80000000) != 0 ? ((address & 0x3fffffff) | 0x40000000) - 3 : address;
+
+    private string ShortLocation(string location)
+    {
+        var index = location.IndexOf(_settings.AppSourcePath, StringComparison.Ordinal);
+        return index < 0 ? location : location[(index + _settings.AppSourcePath.Length)..];
+    }
+
+    private static string ShortDigest(string digest) => digest.Length > 12 ? digest[..12] : digest;
+
+    private string CoreDumpDirectory()
+    {
+        var directory = string.IsNullOrEmpty(_settings.CoreDumpDirectory)
+            ? Path.Combine(AppContext.BaseDirectory, "coredumps")
+            : _settings.CoreDumpDirectory;
+        Directory.CreateDirectory(directory);
+        return directory;
+    }
+
+    private sealed class StallGroup
+    {
+        private readonly object _lock = new();
+        private readonly HashSet<string> _devices = new();
+        private readonly StallGroupMetrics _metrics;
+
+        public StallGroup(string kind, string step, string function, string location)
+        {
+            _metrics = new StallGroupMetrics { Kind = kind, Step = step, Function = function, Location = location };
+        }
+
+        public void Record(StallReport report, string waitingIn)
+        {
+            lock (_lock)
+            {
+                _metrics.Count++;
+                _metrics.Unreported += report.Suppressed;
+                _metrics.TotalMs += report.DurationMs;
+                _metrics.MaxMs = Math.Max(_metrics.MaxMs, report.DurationMs);
+                if (report.Blocked) _metrics.Blocked++;
+                _metrics.WaitingIn = waitingIn;
+                _devices.Add(report.DeviceId);
+                _metrics.Devices = _devices.Count;
+            }
+        }
+
+        public StallGroupMetrics ToMetrics()
+        {
+            lock (_lock)
+            {
+                return new StallGroupMetrics
+                {
+                    Kind = _metrics.Kind,
+                    Step = _metrics.Step,
+                    Function = _metrics.Function,
+                    Location = _metrics.Location,
+                    WaitingIn = _metrics.WaitingIn,
+                    Count = _metrics.Count,
+                    Unreported = _metrics.Unreported,
+                    Devices = _metrics.Devices,
+                    TotalMs = _metrics.TotalMs,
+                    MaxMs = _metrics.MaxMs,
+                    Blocked = _metrics.Blocked
+                };
+            }
+        }
+    }
+
+    private sealed class CoreDumpAssembly
+    {
+        public CoreDumpAssembly(uint seq, uint total, int firstChunk)
+        {
+            Seq = seq;
+            Total = total;
+            Bytes = new MemoryStream(firstChunk);
+        }
+
+        public uint Seq { get; }
+        public uint Total { get; }
+        public MemoryStream Bytes { get; }
+        public DateTime LastChunk { get; set; }
+    }
+}
@@ -0,0 +1,167 @@
+using System.Collections.Concurrent;
+using System.Diagnostics;
+using System.Text;
+using Microsoft.Extensions.Hosting;
+using Microsoft.Extensions.Logging;
+using Microsoft.Extensions.Options;
+using SpotiDialBackend.Models;
+
+namespace SpotiDialBackend.Services;
+
+public static class TraceHops
+{
+    // Backend hops (backend clock)
+    public const string Dispatch = "backend.dispatch";       // MQTT receive -> handler start
+    public const string SpotifyCall = "backend.spotify";     // handler start -> Spotify command done
+    public const string StatusFetch = "backend.status";      // Spotify command done -> fresh playback state
+    public const string BackendTotal = "backend.total";
+
+    // Device hops (device clock)
+    public const string DeviceInput = "device.input";        // encoder/touch -> command published
+    public const string Network = "network.round_trip";      // device<->broker<->backend, minus backend time
+    public const string DeviceRender = "device.render";      // status received -> first pixel flushed
+    public const string EndToEnd = "end_to_end";
+}
+
+/// <summary>
+/// Collects per-hop timings for traced commands and periodically logs latency histograms.
+/// </summary>
+public class TraceCollectorService : BackgroundService
+{
+    private readonly ILogger<TraceCollectorService> _logger;
+    private readonly TraceSettings _settings;
+    private readonly ConcurrentDictionary<string, CommandTrace> _active = new();
+    private readonly ConcurrentDictionary<string, LatencyHistogram> _histograms = new();
+
+    private static readonly TimeSpan TraceTimeout = TimeSpan.FromSeconds(30);
+
+    public TraceCollectorService(ILogger<TraceCollectorService> logger, IOptions<AppSettings> settings)
+    {
+        _logger = logger;
+        _settings = settings.Value.Trace;
+    }
+
+    public bool IsEnabled => _settings.Enabled;
+
+    /// <summary>
+    /// Record that a traced command reached the given hop.
+    /// </summary>
+    public void Mark(DeviceCommand command, string hop)
+    {
+        if (!_settings.Enabled || string.IsNullOrEmpty(command.CorrelationId)) return;
+
+        var trace = _active.GetOrAdd(command.CorrelationId,
+            _ => new CommandTrace(command.Command, command.ReceivedTimestamp));
+        trace.Mark(hop, Stopwatch.GetTimestamp());
+    }
+
+    /// <summary>
+    /// Finish the backend part of a trace and return the time spent in the backend.
+    /// </summary>
+    public long? Complete(DeviceCommand command)
+    {
+        if (!_settings.Enabled || string.IsNullOrEmpty(command.CorrelationId)) return null;
+        if (!_active.TryRemove(command.CorrelationId, out var trace)) return null;
+
+        var previous = trace.ReceivedTimestamp;
+        foreach (var (hop, timestamp) in trace.Hops)
+        {
+            Record(hop, Stopwatch.GetElapsedTime(previous, timestamp));
+            previous = timestamp;
+        }
+
+        var total = Stopwatch.GetElapsedTime(trace.ReceivedTimestamp, previous);
+        Record(TraceHops.BackendTotal, total);
+
+        return (long)(total.TotalMilliseconds * 1000);
+    }
+
+    /// <summary>
+    /// Record the device-measured hops reported after the status reached the screen.
+    /// </summary>
+    public void RecordDeviceReport(TraceReport report)
+    {
+        if (!_settings.Enabled) return;
+
+        Record(TraceHops.DeviceInput, report.InputToPublishUs / 1000.0);
+        Record(TraceHops.Network, (report.PublishToStatusUs - report.BackendUs) / 1000.0);
+        Record(TraceHops.DeviceRender, report.StatusToRenderUs / 1000.0);
+        Record(TraceHops.EndToEnd,
+            (report.InputToPublishUs + report.PublishToStatusUs + report.StatusToRenderUs) / 1000.0);
+    }
+
+    public string FormatSummary()
+    {
+        var summary = new StringBuilder();
+        foreach (var (hop, histogram) in _histograms.OrderBy(h => h.Key))
+        {
+            summary.AppendLine($"  {hop,-20} {histogram}");
+        }
+        return summary.ToString();
+    }
+
+    protected override async Task ExecuteAsync(CancellationToken stoppingToken)
+    {
+        if (!_settings.Enabled) return;
+
+        var interval = TimeSpan.FromSeconds(Math.Max(_settings.ReportIntervalSeconds, 1));
+
+        while (!stoppingToken.IsCancellationRequested)
+        {
+            try
+            {
+                await Task.Delay(interval, stoppingToken);
+            }
+            catch (OperationCanceledException)
+            {
+                break;
+            }
+
+            // Drop traces whose command never completed
+            var now = Stopwatch.GetTimestamp();
+            foreach (var (id, trace) in _active)
+            {
+                if (Stopwatch.GetElapsedTime(trace.ReceivedTimestamp, now) > TraceTimeout)
+                {
+                    _active.TryRemove(id, out _);
+                }
+            }
+
+            if (!_histograms.IsEmpty)
+            {
+                _logger.LogInformation("Latency per hop:{NewLine}{Summary}", Environment.NewLine, FormatSummary());
+            }
+        }
+    }
+
+    private void Record(string hop, TimeSpan elapsed) => Record(hop, elapsed.TotalMilliseconds);
+
+    private void Record(string hop, double milliseconds)
+    {
+        _histograms.GetOrAdd(hop, _ => new LatencyHistogram()).Record(milliseconds);
+    }
+
+    private class CommandTrace
+    {
+        private readonly List<(string Hop, long Timestamp)> _hops = new();
+
+        public CommandTrace(string command, long receivedTimestamp)
+        {
+            Command = command;
+            ReceivedTimestamp = receivedTimestamp != 0 ? receivedTimestamp : Stopwatch.GetTimestamp();
+        }
+
+        public string Command { get; }
+        public long ReceivedTimestamp { get; }
+
+        public IReadOnlyList<(string Hop, long Timestamp)> Hops
+        {
+            get { lock (_hops) return _hops.ToList(); }
+        }
+
+        public void Mark(string hop, long timestamp)
+        {
+            lock (_hops) _hops.Add((hop, timestamp));
+        }
+    }
+}
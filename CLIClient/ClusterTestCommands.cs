@@ -0,0 +1,288 @@
+using System.Collections.Concurrent;
+using System.Diagnostics;
+using System.Text;
+using System.Text.Json;
+using MQTTnet;
+using MQTTnet.Client;
+using Spectre.Console;
+
+namespace CLIClient;
+
+partial class Program
+{
+    /// <summary>
+    /// Start several backend instances as a cluster against the in-process stub Spotify API,
+    /// drive traced commands from simulated dials through them, kill one instance halfway and
+    /// report each instance's throughput and how long its dials went without an answer.
+    /// </summary>
+    private static async Task RunClusterTest(string host, int port, string username, string password,
+        string backendPath, int instances, int rate, int durationSeconds, int devices, int listenPort,
+        int leaseMs, int killAfterSeconds)
+    {
+        _brokerHost = host;
+        _brokerPort = port;
+        _username = username;
+        _password = password;
+
+        var rule = new Rule("[bold cyan]SpotiDial Cluster Test[/]");
+        AnsiConsole.Write(rule);
+        AnsiConsole.MarkupLine($"[dim]{instances} instances, {rate} commands/s for {durationSeconds} s from {devices} devices, " +
+                               $"lease {leaseMs} ms, killing one instance after {killAfterSeconds} s[/]");
+
+        if (!File.Exists(backendPath))
+        {
+            AnsiConsole.MarkupLine($"[red]✗ Backend not found at {Markup.Escape(backendPath)}; " +
+                                   "build it with dotnet build -c Release or pass --backend[/]");
+            return;
+        }
+
+        var server = new StubSpotifyServer(listenPort, 0, 25, 25);
+        using var cts = new CancellationTokenSource();
+        var serverTask = server.RunAsync(cts.Token);
+        var backends = new List<(string Id, Process Process)>();
+
+        try
+        {
+            await ConnectToMqtt();
+
+            var metrics = new ConcurrentDictionary<string, JsonElement>();
+            var echoes = new ConcurrentDictionary<string, int>();
+            var lastEcho = new ConcurrentDictionary<string, (long Timestamp, string Instance)>();
+            var recovered = new ConcurrentDictionary<string, double>();
+            var killedAt = 0L;
+            string? victim = null;
+            HashSet<string> victimDevices = new();
+
+            _mqttClient!.ApplicationMessageReceivedAsync += e =>
+            {
+                var now = Stopwatch.GetTimestamp();
+                var payload = Encoding.UTF8.GetString(e.ApplicationMessage.PayloadSegment);
+
+                try
+                {
+                    var json = JsonSerializer.Deserialize<JsonElement>(payload);
+                    if (e.ApplicationMessage.Topic == _metricsTopic)
+                    {
+                        if (json.TryGetProperty("cluster", out var cluster))
+                        {
+                            metrics[cluster.GetProperty("instanceId").GetString()!] = json;
+                        }
+                        return Task.CompletedTask;
+                    }
+
+                    if (!json.TryGetProperty("correlationId", out var id) ||
+                        !json.TryGetProperty("backendInstance", out var instanceElement))
+                    {
+                        return Task.CompletedTask;
+                    }
+
+                    var device = id.GetString()!.Split(':')[0];
+                    var instance = instanceElement.GetString()!;
+                    echoes.AddOrUpdate(instance, 1, (_, count) => count + 1);
+                    lastEcho[device] = (now, instance);
+
+                    // First answer from a survivor for a dial the killed instance owned
+                    var killed = Interlocked.Read(ref killedAt);
+                    if (killed != 0 && instance != victim && victimDevices.Contains(device))
+                    {
+                        recovered.TryAdd(device, Stopwatch.GetElapsedTime(killed, now).TotalMilliseconds);
+                    }
+                }
+                catch (Exception ex) when (ex is JsonException or KeyNotFoundException or InvalidOperationException)
+                {
+                    // Not a message we can read; ignore
+                }
+
+                return Task.CompletedTask;
+            };
+
+            await _mqttClient.SubscribeAsync(new MqttTopicFilterBuilder().WithTopic(_statusTopic).Build());
+            await _mqttClient.SubscribeAsync(new MqttTopicFilterBuilder().WithTopic(_metricsTopic).Build());
+
+            for (var i = 1; i <= instances; i++)
+            {
+                var id = $"cluster-test-{i}";
+                backends.Add((id, StartBackend(backendPath, id, listenPort, leaseMs)));
+            }
+
+            // Every instance reports itself once it sees the whole cluster
+            AnsiConsole.MarkupLine("[dim]Waiting for the instances to find each other...[/]");
+            var formed = Stopwatch.StartNew();
+            while (formed.Elapsed < TimeSpan.FromSeconds(60) &&
+                   (metrics.Count < instances || metrics.Values.Any(m => Members(m) < instances)))
+            {
+                await Task.Delay(250);
+            }
+            if (metrics.Count < instances)
+            {
+                AnsiConsole.MarkupLine($"[red]✗ Only {metrics.Count} of {instances} instances reported; see their logs in {Markup.Escape(Path.GetTempPath())}[/]");
+                return;
+            }
+            AnsiConsole.MarkupLine($"[green]✓[/] Cluster formed in {formed.Elapsed.TotalSeconds:F1} s");
+
+            var executedAtStart = metrics.ToDictionary(m => m.Key, m => Executed(m.Value));
+            var sent = 0L;
+            var stopwatch = Stopwatch.StartNew();
+            var duration = TimeSpan.FromSeconds(durationSeconds);
+            var killAfter = TimeSpan.FromSeconds(killAfterSeconds);
+            var nextReport = TimeSpan.FromSeconds(1);
+
+            while (stopwatch.Elapsed < duration)
+            {
+                var due = (long)(stopwatch.Elapsed.TotalSeconds * rate);
+                while (sent < due)
+                {
+                    var device = $"cluster-{sent % devices}";
+                    var json = JsonSerializer.Serialize(new
+                    {
+                        command = "set_volume",
+                        parameter = (sent % 101).ToString(),
+                        deviceId = device,
+                        correlationId = $"{device}:{sent}"
+                    });
+
+                    await _mqttClient.PublishAsync(new MqttApplicationMessageBuilder()
+                        .WithTopic(_commandTopic)
+                        .WithPayload(json)
+                        .WithQualityOfServiceLevel(MQTTnet.Protocol.MqttQualityOfServiceLevel.AtLeastOnce)
+                        .Build());
+                    sent++;
+                }
+
+                if (victim == null && stopwatch.Elapsed >= killAfter)
+                {
+                    // Kill, not stop: no leave message, the survivors see the will or the lease run out
+                    var (id, process) = backends[0];
+                    victimDevices = lastEcho.Where(e => e.Value.Instance == id).Select(e => e.Key).ToHashSet();
+                    victim = id;
+                    Interlocked.Exchange(ref killedAt, Stopwatch.GetTimestamp());
+                    process.Kill(entireProcessTree: true);
+                    AnsiConsole.MarkupLine($"[yellow]![/] Killed {id}, which owned {victimDevices.Count} devices");
+                }
+
+                if (stopwatch.Elapsed >= nextReport)
+                {
+                    AnsiConsole.MarkupLine($"[dim]{stopwatch.Elapsed.TotalSeconds:F0}s: {sent} sent, " +
+                                           $"{echoes.Values.Sum()} answered[/]");
+                    nextReport += TimeSpan.FromSeconds(1);
+                }
+
+                await Task.Delay(5);
+            }
+
+            var elapsed = stopwatch.Elapsed.TotalSeconds;
+            await Task.Delay(2000);
+
+            var table = new Table();
+            table.Border(TableBorder.Rounded);
+            table.AddColumn(new TableColumn("[bold]Instance[/]").LeftAligned());
+            table.AddColumn(new TableColumn("[bold]Devices[/]").RightAligned());
+            table.AddColumn(new TableColumn("[bold]Answered[/]").RightAligned());
+            table.AddColumn(new TableColumn("[bold]Executed/s[/]").RightAligned());
+            table.AddColumn(new TableColumn("[bold]Received[/]").RightAligned());
+            table.AddColumn(new TableColumn("[bold]Forwarded[/]").RightAligned());
+            table.AddColumn(new TableColumn("[bold]Forwarded in[/]").RightAligned());
+
+            foreach (var (id, _) in backends)
+            {
+                if (!metrics.TryGetValue(id, out var last)) continue;
+
+                var cluster = last.GetProperty("cluster");
+                var executed = Executed(last) - executedAtStart.GetValueOrDefault(id);
+                var owned = lastEcho.Count(e => e.Value.Instance == id);
+                table.AddRow(
+                    id == victim ? $"{id} [red](killed)[/]" : id,
+                    id == victim ? victimDevices.Count.ToString() : owned.ToString(),
+                    echoes.GetValueOrDefault(id).ToString(),
+                    $"{executed / (id == victim ? killAfter.TotalSeconds : elapsed):F0}",
+                    cluster.GetProperty("received").ToString(),
+                    cluster.GetProperty("forwarded").ToString(),
+                    cluster.GetProperty("forwardedIn").ToString());
+            }
+
+            AnsiConsole.Write(table);
+            AnsiConsole.MarkupLine($"Sent {sent} commands in {elapsed:F1} s ({sent / elapsed:F0}/s), " +
+                                   $"{server.PlayerRequestCount} player requests reached the stub");
+
+            if (victimDevices.Count == 0)
+            {
+                AnsiConsole.MarkupLine("[yellow]![/] The killed instance had no devices; nothing failed over");
+                return;
+            }
+
+            // Kill to the first answer from a survivor, per device the killed instance owned
+            var gaps = recovered.Values.OrderBy(ms => ms).ToList();
+            if (gaps.Count == 0)
+            {
+                AnsiConsole.MarkupLine($"[red]✗[/] None of the {victimDevices.Count} devices was taken over");
+                return;
+            }
+
+            double Percentile(double p) => gaps[Math.Clamp((int)Math.Ceiling(gaps.Count * p / 100.0) - 1, 0, gaps.Count - 1)];
+            AnsiConsole.MarkupLine($"Failover: {gaps.Count} of {victimDevices.Count} devices taken over, " +
+                                   $"p50 {Percentile(50):F0} ms, p90 {Percentile(90):F0} ms, " +
+                                   $"max {gaps[^1]:F0} ms (lease {leaseMs} ms)");
+        }
+        catch (Exception ex)
+        {
+            AnsiConsole.MarkupLine($"[red]✗ Error: {Markup.Escape(ex.Message)}[/]");
+        }
+        finally
+        {
+            foreach (var (_, process) in backends)
+            {
+                if (!process.HasExited) process.Kill(entireProcessTree: true);
+                process.Dispose();
+            }
+
+            await DisconnectFromMqtt();
+            cts.Cancel();
+            await serverTask;
+        }
+    }
+
+    // A backend instance with its own working directory (so no .env is picked up) and log
+    private static Process StartBackend(string backendPath, string instanceId, int listenPort, int leaseMs)
+    {
+        var directory = Path.Combine(Path.GetTempPath(), $"spotidial-{instanceId}");
+        Directory.CreateDirectory(directory);
+
+        var dll = backendPath.EndsWith(".dll", StringComparison.OrdinalIgnoreCase);
+        var startInfo = new ProcessStartInfo(dll ? "dotnet" : backendPath)
+        {
+            WorkingDirectory = directory,
+            RedirectStandardOutput = true,
+            RedirectStandardError = true,
+            UseShellExecute = false
+        };
+        if (dll) startInfo.ArgumentList.Add(Path.GetFullPath(backendPath));
+
+        startInfo.Environment["MQTT_BROKER_HOST"] = _brokerHost;
+        startInfo.Environment["MQTT_BROKER_PORT"] = _brokerPort.ToString();
+        startInfo.Environment["MQTT_USERNAME"] = _username;
+        startInfo.Environment["MQTT_PASSWORD"] = _password;
+        startInfo.Environment["SPOTIFY_API_BASE_URL"] = $"http://localhost:{listenPort}/v1/";
+        startInfo.Environment["CLUSTER_ENABLED"] = "true";
+        startInfo.Environment["CLUSTER_INSTANCE_ID"] = instanceId;
+        startInfo.Environment["CLUSTER_LEASE_MS"] = leaseMs.ToString();
+        startInfo.Environment["METRICS_INTERVAL_SECONDS"] = "1";
+        startInfo.Environment["TRACE_ENABLED"] = "true";
+        startInfo.Environment["LIBRARY_CACHE_DIR"] = directory;
+        startInfo.Environment["IMAGE_CACHE_DIR"] = Path.Combine(directory, "image-cache");
+
+        var log = new StreamWriter(Path.Combine(directory, "backend.log")) { AutoFlush = true };
+        var process = new Process { StartInfo = startInfo };
+        process.OutputDataReceived += (_, e) => { if (e.Data != null) lock (log) log.WriteLine(e.Data); };
+        process.ErrorDataReceived += (_, e) => { if (e.Data != null) lock (log) log.WriteLine(e.Data); };
+
+        process.Start();
+        process.BeginOutputReadLine();
+        process.BeginErrorReadLine();
+        AnsiConsole.MarkupLine($"[dim]Started {instanceId} (pid {process.Id}), log in {Markup.Escape(directory)}[/]");
+        return process;
+    }
+
+    private static int Members(JsonElement metrics) => metrics.GetProperty("cluster").GetProperty("members").GetInt32();
+
+    private static long Executed(JsonElement metrics) => metrics.GetProperty("commandQueue").GetProperty("executed").GetInt64();
+}
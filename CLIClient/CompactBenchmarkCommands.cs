@@ -0,0 +1,287 @@
+using System.Diagnostics;
+using System.Text.Json;
+using MQTTnet;
+using MQTTnet.Client;
+using Spectre.Console;
+
+namespace CLIClient;
+
+partial class Program
+{
+    private const string EncodingTopicPrefix = "spotidial/encoding/";
+    private const string CompactSuffix = "/compact";
+    private const int CompactFormat = 1;             // COMPACT_FORMAT and COMPACT_DICTIONARY_VERSION
+    private const int CompactDictionaryVersion = 1;  // in the firmware's compact_reader.h
+    private const int DialPacketBytes = 2048;        // MQTT_MAX_PACKET_SIZE; larger messages are dropped
+
+    /// <summary>
+    /// Negotiate the compact encoding as a dial would, then fetch the status and both lists in
+    /// JSON and compact form and compare them: bytes on the wire, and the decoding time and
+    /// memory of the dial's own code, run on the captured payloads by the firmware's host build
+    /// in Firmware/tools/compact_bench.
+    /// </summary>
+    private static async Task RunCompactBenchmark(string host, int port, string username, string password,
+        int listenPort, int items, int rounds, string readerPath)
+    {
+        _brokerHost = host;
+        _brokerPort = port;
+        _username = username;
+        _password = password;
+
+        var rule = new Rule("[bold cyan]SpotiDial Compact Encoding Benchmark[/]");
+        AnsiConsole.Write(rule);
+        AnsiConsole.MarkupLine($"[dim]{items} playlists and albums, decoding timed over {rounds} rounds[/]");
+        AnsiConsole.MarkupLine($"[dim]Start the backend with SPOTIFY_API_BASE_URL=http://localhost:{listenPort}/v1/[/]");
+
+        var server = new StubSpotifyServer(listenPort, 0, items, items);
+        using var cts = new CancellationTokenSource();
+        var serverTask = server.RunAsync(cts.Token);
+
+        var clientId = $"compact-benchmark-{Guid.NewGuid():N}"[..30];
+        var requestTopic = $"{EncodingTopicPrefix}{clientId}/request";
+        var acceptTopic = $"{EncodingTopicPrefix}{clientId}/accept";
+
+        try
+        {
+            await ConnectToMqtt();
+
+            var payloads = new Dictionary<string, byte[]>();
+            var messages = 0;
+            var accepted = new TaskCompletionSource<string[]>(TaskCreationOptions.RunContinuationsAsynchronously);
+
+            _mqttClient!.ApplicationMessageReceivedAsync += e =>
+            {
+                var topic = e.ApplicationMessage.Topic;
+                var payload = e.ApplicationMessage.PayloadSegment.ToArray();
+
+                if (topic == acceptTopic)
+                {
+                    if (payload.Length == 0) return Task.CompletedTask;
+                    try
+                    {
+                        var accept = JsonSerializer.Deserialize<JsonElement>(payload);
+                        accepted.TrySetResult(accept.GetProperty("topics").EnumerateArray()
+                            .Select(t => t.GetString() ?? string.Empty).ToArray());
+                    }
+                    catch (Exception ex) when (ex is JsonException or InvalidOperationException or KeyNotFoundException)
+                    {
+                        accepted.TrySetResult(Array.Empty<string>());
+                    }
+                    return Task.CompletedTask;
+                }
+
+                // Lists arrive page by page; keep the latest of each
+                lock (payloads)
+                {
+                    payloads[topic] = payload;
+                    messages++;
+                }
+                return Task.CompletedTask;
+            };
+
+            foreach (var topic in new[] { _statusTopic, _playlistTopic, _albumTopic })
+            {
+                await _mqttClient.SubscribeAsync(new MqttTopicFilterBuilder().WithTopic(topic).WithAtLeastOnceQoS().Build());
+                await _mqttClient.SubscribeAsync(new MqttTopicFilterBuilder().WithTopic(topic + CompactSuffix).WithAtLeastOnceQoS().Build());
+            }
+            await _mqttClient.SubscribeAsync(new MqttTopicFilterBuilder().WithTopic(acceptTopic).WithAtLeastOnceQoS().Build());
+
+            var request = JsonSerializer.Serialize(new
+            {
+                format = CompactFormat,
+                dictionary = CompactDictionaryVersion,
+                topics = new[] { "status", "playlists", "albums" }
+            });
+            await PublishRetained(requestTopic, request);
+
+            var acceptTask = await Task.WhenAny(accepted.Task, Task.Delay(TimeSpan.FromSeconds(10)));
+            if (acceptTask != accepted.Task)
+            {
+                AnsiConsole.MarkupLine("[red]✗ No answer to the encoding request; is the backend running?[/]");
+                return;
+            }
+            var topics = accepted.Task.Result;
+            AnsiConsole.MarkupLine($"Backend accepted compact: [bold]{(topics.Length > 0 ? string.Join(", ", topics) : "nothing (MQTT_COMPACT_ENCODING=false?)")}[/]");
+
+            // Play publishes a status; the lists come from the stub library
+            await PublishMessage(_commandTopic, JsonSerializer.Serialize(new { command = "play" }));
+            await PublishMessage(_commandTopic, JsonSerializer.Serialize(new { command = "get_playlists" }));
+            await PublishMessage(_commandTopic, JsonSerializer.Serialize(new { command = "get_albums" }));
+
+            // Wait until every topic has both forms and nothing new came for a moment
+            var expected = new[] { _statusTopic, _playlistTopic, _albumTopic }
+                .SelectMany(t => topics.Contains(t[(t.LastIndexOf('/') + 1)..]) ? new[] { t, t + CompactSuffix } : new[] { t })
+                .ToArray();
+            var stopwatch = Stopwatch.StartNew();
+            var lastCount = -1;
+            var quietSince = stopwatch.Elapsed;
+            while (stopwatch.Elapsed < TimeSpan.FromSeconds(60))
+            {
+                await Task.Delay(200);
+                int count;
+                bool complete;
+                lock (payloads)
+                {
+                    count = messages;
+                    complete = expected.All(payloads.ContainsKey);
+                }
+                if (count != lastCount)
+                {
+                    lastCount = count;
+                    quietSince = stopwatch.Elapsed;
+                }
+                if (complete && stopwatch.Elapsed - quietSince > TimeSpan.FromSeconds(2)) break;
+            }
+
+            // Saved for the host build, which reads them like the dial does
+            var directory = Path.Combine(Path.GetTempPath(), "spotidial-compact-payloads");
+            Directory.CreateDirectory(directory);
+            foreach (var (name, topic) in new[] { ("status", _statusTopic), ("playlists", _playlistTopic), ("albums", _albumTopic) })
+            {
+                lock (payloads)
+                {
+                    foreach (var (extension, key) in new[] { ("json", topic), ("compact", topic + CompactSuffix) })
+                    {
+                        var file = Path.Combine(directory, $"{name}.{extension}");
+                        if (payloads.TryGetValue(key, out var payload)) File.WriteAllBytes(file, payload);
+                        else File.Delete(file);
+                    }
+                }
+            }
+
+            var results = await RunCompactReader(readerPath, directory, rounds);
+
+            var table = new Table();
+            table.Border(TableBorder.Rounded);
+            table.AddColumn(new TableColumn("[bold]Topic[/]").LeftAligned());
+            table.AddColumn(new TableColumn("[bold]entries[/]").RightAligned());
+            table.AddColumn(new TableColumn("[bold]JSON[/]").RightAligned());
+            table.AddColumn(new TableColumn("[bold]compact[/]").RightAligned());
+            table.AddColumn(new TableColumn("[bold]decode JSON[/]").RightAligned());
+            table.AddColumn(new TableColumn("[bold]decode compact[/]").RightAligned());
+            table.AddColumn(new TableColumn("[bold]RAM JSON[/]").RightAligned());
+            table.AddColumn(new TableColumn("[bold]RAM compact[/]").RightAligned());
+            table.AddColumn(new TableColumn("[bold]same fields[/]").LeftAligned());
+
+            foreach (var (name, topic) in new[] { ("status", _statusTopic), ("playlists", _playlistTopic), ("albums", _albumTopic) })
+            {
+                byte[]? json;
+                byte[]? compact;
+                lock (payloads)
+                {
+                    json = payloads.GetValueOrDefault(topic);
+                    compact = payloads.GetValueOrDefault(topic + CompactSuffix);
+                }
+                table.AddRow(CompareEncodings(name, json, compact,
+                    results?.GetValueOrDefault((name, "json")), results?.GetValueOrDefault((name, "compact"))));
+            }
+
+            AnsiConsole.Write(table);
+            AnsiConsole.MarkupLine($"[dim]Payloads in {Markup.Escape(directory)}. decode: average over {rounds} rounds of the dial's code on this machine; " +
+                                   "RAM: peak stack + heap + static buffers while decoding, besides the MQTT buffer both share.[/]");
+            AnsiConsole.MarkupLine($"[dim]* over {DialPacketBytes} bytes: the dial drops the message. On the dial every compact list logs \"Compact list: N entries, ... decoded in X us\"[/]");
+        }
+        catch (Exception ex)
+        {
+            AnsiConsole.MarkupLine($"[red]✗ Error: {ex.Message}[/]");
+        }
+        finally
+        {
+            // Leave no negotiation behind for a client id that will never come back
+            if (_mqttClient != null && _mqttClient.IsConnected)
+            {
+                await PublishRetained(requestTopic, string.Empty);
+                await PublishRetained(acceptTopic, string.Empty);
+            }
+            await DisconnectFromMqtt();
+            cts.Cancel();
+            await serverTask;
+        }
+    }
+
+    // One line of compact_bench output: bytes, entries, decode time, stack, heap, static, same fields
+    private sealed record ReaderResult(int Bytes, int Entries, double DecodeUs, int Stack, int Heap, int Static, string Same)
+    {
+        public int Ram => Stack + Heap + Static;
+    }
+
+    private static async Task<Dictionary<(string Name, string Encoding), ReaderResult>?> RunCompactReader(
+        string readerPath, string directory, int rounds)
+    {
+        if (!File.Exists(readerPath))
+        {
+            AnsiConsole.MarkupLine($"[yellow]Host build of the dial's reader not found at {Markup.Escape(readerPath)}; " +
+                                   "build it with make -C Firmware/tools/compact_bench or pass --reader. Showing sizes only.[/]");
+            return null;
+        }
+
+        var startInfo = new ProcessStartInfo(readerPath)
+        {
+            RedirectStandardOutput = true,
+            RedirectStandardError = true,
+            UseShellExecute = false
+        };
+        startInfo.ArgumentList.Add("--rounds");
+        startInfo.ArgumentList.Add(rounds.ToString());
+        startInfo.ArgumentList.Add(directory);
+
+        using var process = Process.Start(startInfo)!;
+        var output = await process.StandardOutput.ReadToEndAsync();
+        await process.WaitForExitAsync();
+        if (process.ExitCode != 0)
+        {
+            AnsiConsole.MarkupLine($"[red]✗ {Markup.Escape(readerPath)} failed: {Markup.Escape(await process.StandardError.ReadToEndAsync())}[/]");
+            return null;
+        }
+
+        var results = new Dictionary<(string, string), ReaderResult>();
+        foreach (var line in output.Split('\n', StringSplitOptions.RemoveEmptyEntries))
+        {
+            var fields = line.Split('\t');
+            if (line.StartsWith('#') || fields.Length < 9) continue;
+
+            results[(fields[0], fields[1])] = new ReaderResult(int.Parse(fields[2]), int.Parse(fields[3]),
+                double.Parse(fields[4], System.Globalization.CultureInfo.InvariantCulture),
+                int.Parse(fields[5]), int.Parse(fields[6]), int.Parse(fields[7]), fields[8].Trim());
+        }
+        return results;
+    }
+
+    private static string[] CompareEncodings(string name, byte[]? json, byte[]? compact,
+        ReaderResult? fromJson, ReaderResult? fromCompact)
+    {
+        if (json == null) return new[] { name, "-", "not received", "-", "-", "-", "-", "-", "-" };
+
+        // Lists are cut to fit a table chunk in the compact form
+        var entries = fromJson == null ? "-"
+            : fromCompact != null && fromCompact.Entries != fromJson.Entries ? $"{fromJson.Entries} / {fromCompact.Entries}"
+            : fromJson.Entries.ToString();
+
+        return new[]
+        {
+            name,
+            entries,
+            FormatBytes(json.Length),
+            compact == null ? "-" : $"{FormatBytes(compact.Length)} ({100.0 * compact.Length / json.Length:F0}%)",
+            fromJson == null ? "-" : $"{fromJson.DecodeUs:F1} us",
+            fromCompact == null ? "-" : $"{fromCompact.DecodeUs:F1} us",
+            fromJson == null ? "-" : $"{fromJson.Ram:N0} B",
+            fromCompact == null ? "-" : $"{fromCompact.Ram:N0} B",
+            fromCompact == null ? "-" : fromCompact.Same == "yes" ? "[green]yes[/]" : fromCompact.Same == "no" ? "[red]no[/]" : "-"
+        };
+    }
+
+    private static string FormatBytes(int bytes) => bytes > DialPacketBytes ? $"{bytes:N0} B*" : $"{bytes:N0} B";
+
+    private static async Task PublishRetained(string topic, string payload)
+    {
+        var message = new MqttApplicationMessageBuilder()
+            .WithTopic(topic)
+            .WithPayload(payload)
+            .WithQualityOfServiceLevel(MQTTnet.Protocol.MqttQualityOfServiceLevel.AtLeastOnce)
+            .WithRetainFlag(true)
+            .Build();
+
+        await _mqttClient!.PublishAsync(message);
+    }
+}
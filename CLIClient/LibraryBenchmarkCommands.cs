@@ -0,0 +1,244 @@
+using System.Buffers.Binary;
+using System.Diagnostics;
+using System.Text;
+using System.Text.Json;
+using MQTTnet;
+using MQTTnet.Client;
+using Spectre.Console;
+
+namespace CLIClient;
+
+partial class Program
+{
+    /// <summary>
+    /// Browse a large synthetic library served by an in-process stub and report how long the
+    /// first and the complete playlist list take to arrive, and how many pages the backend
+    /// fetched for each browse. The library is edited between browses so incremental sync shows.
+    /// The name table published with the complete list is decoded like the dial does, to report
+    /// its size per entry and the work behind a letter jump.
+    /// </summary>
+    private static async Task RunLibraryBenchmark(string host, int port, string username, string password,
+        int listenPort, int items, int latencyMs)
+    {
+        _brokerHost = host;
+        _brokerPort = port;
+        _username = username;
+        _password = password;
+
+        var rule = new Rule("[bold cyan]SpotiDial Library Benchmark[/]");
+        AnsiConsole.Write(rule);
+        AnsiConsole.MarkupLine($"[dim]{items} playlists, {latencyMs} ms per request[/]");
+        AnsiConsole.MarkupLine($"[dim]Start the backend with SPOTIFY_API_BASE_URL=http://localhost:{listenPort}/v1/ " +
+                               "(LIBRARY_CACHE_TTL_SECONDS=0 to sync on every browse)[/]");
+
+        var server = new StubSpotifyServer(listenPort, latencyMs, items, 0);
+        using var cts = new CancellationTokenSource();
+        var serverTask = server.RunAsync(cts.Token);
+
+        try
+        {
+            await ConnectToMqtt();
+
+            // Lengths of the playlist lists published for the current browse
+            var received = new List<(int Count, TimeSpan At)>();
+            var stopwatch = new Stopwatch();
+
+            // Last complete list as JSON and as a name table (reassembled from its chunks)
+            var lastJsonBytes = 0;
+            byte[]? tableBuffer = null;
+            byte[]? completeTable = null;
+            var tableReceived = 0;
+
+            _mqttClient!.ApplicationMessageReceivedAsync += e =>
+            {
+                if (e.ApplicationMessage.Topic == _playlistTableTopic)
+                {
+                    var chunk = e.ApplicationMessage.PayloadSegment;
+                    if (chunk.Count < 12) return Task.CompletedTask;
+
+                    var offset = (int)BinaryPrimitives.ReadUInt32LittleEndian(chunk.AsSpan(4));
+                    var total = (int)BinaryPrimitives.ReadUInt32LittleEndian(chunk.AsSpan(8));
+                    lock (received)
+                    {
+                        if (offset == 0)
+                        {
+                            tableBuffer = new byte[total];
+                            tableReceived = 0;
+                        }
+                        if (tableBuffer == null || offset != tableReceived || offset + chunk.Count - 12 > tableBuffer.Length)
+                        {
+                            return Task.CompletedTask;
+                        }
+
+                        chunk.AsSpan(12).CopyTo(tableBuffer.AsSpan(offset));
+                        tableReceived += chunk.Count - 12;
+                        if (tableReceived == tableBuffer.Length)
+                        {
+                            completeTable = tableBuffer;
+                        }
+                    }
+                    return Task.CompletedTask;
+                }
+
+                if (e.ApplicationMessage.Topic != _playlistTopic) return Task.CompletedTask;
+
+                try
+                {
+                    var list = JsonSerializer.Deserialize<JsonElement>(
+                        Encoding.UTF8.GetString(e.ApplicationMessage.PayloadSegment));
+                    lock (received)
+                    {
+                        received.Add((list.GetArrayLength(), stopwatch.Elapsed));
+                        lastJsonBytes = e.ApplicationMessage.PayloadSegment.Count;
+                    }
+                }
+                catch (Exception ex) when (ex is JsonException or InvalidOperationException)
+                {
+                    // Not a list we can read; ignore
+                }
+
+                return Task.CompletedTask;
+            };
+
+            await _mqttClient.SubscribeAsync(new MqttTopicFilterBuilder()
+                .WithTopic(_playlistTopic)
+                .Build());
+            await _mqttClient.SubscribeAsync(new MqttTopicFilterBuilder()
+                .WithTopic(_playlistTableTopic)
+                .WithAtLeastOnceQoS()
+                .Build());
+
+            var table = new Table();
+            table.Border(TableBorder.Rounded);
+            table.AddColumn(new TableColumn("[bold]Browse[/]").LeftAligned());
+            table.AddColumn(new TableColumn("[bold]first entry[/]").RightAligned());
+            table.AddColumn(new TableColumn("[bold]complete[/]").RightAligned());
+            table.AddColumn(new TableColumn("[bold]items[/]").RightAligned());
+            table.AddColumn(new TableColumn("[bold]API pages[/]").RightAligned());
+
+            var scenarios = new (string Name, Action? Change)[]
+            {
+                ("first", null),
+                ("unchanged", null),
+                ("playlist added", server.AddPlaylist),
+                ("top playlist edited", () => server.EditPlaylist(0))
+            };
+
+            foreach (var (name, change) in scenarios)
+            {
+                change?.Invoke();
+                var expected = server.PlaylistCount;
+                var requestsBefore = server.LibraryRequestCount;
+
+                lock (received)
+                {
+                    received.Clear();
+                }
+                stopwatch.Restart();
+                await PublishMessage(_commandTopic, JsonSerializer.Serialize(new { command = "get_playlists" }));
+
+                // Done once the full list arrived and nothing else came for a moment
+                TimeSpan? complete = null;
+                while (stopwatch.Elapsed < TimeSpan.FromSeconds(120))
+                {
+                    await Task.Delay(100);
+                    lock (received)
+                    {
+                        var last = received.Count > 0 ? received[^1] : default;
+                        if (last.Count == expected && stopwatch.Elapsed - last.At > TimeSpan.FromSeconds(1))
+                        {
+                            complete = last.At;
+                        }
+                    }
+                    if (complete.HasValue) break;
+                }
+
+                (int Count, TimeSpan At)? first;
+                lock (received)
+                {
+                    first = received.Count > 0 ? received[0] : null;
+                }
+
+                table.AddRow(name,
+                    first.HasValue ? $"{first.Value.At.TotalMilliseconds:F0} ms" : "-",
+                    complete.HasValue ? $"{complete.Value.TotalMilliseconds:F0} ms" : "timeout",
+                    first.HasValue ? $"{first.Value.Count} / {expected}" : "0",
+                    (server.LibraryRequestCount - requestsBefore).ToString());
+            }
+
+            await DisconnectFromMqtt();
+
+            AnsiConsole.Write(table);
+            AnsiConsole.MarkupLine("[dim]items: size of the first list received / library size[/]");
+
+            byte[]? nameTable;
+            lock (received)
+            {
+                nameTable = completeTable;
+            }
+
+            if (nameTable == null)
+            {
+                AnsiConsole.MarkupLine("[yellow]No name table received (LIBRARY_NAME_TABLE=false?)[/]");
+            }
+            else
+            {
+                ReportNameTable(new NameTableReader(nameTable), lastJsonBytes);
+            }
+        }
+        catch (Exception ex)
+        {
+            AnsiConsole.MarkupLine($"[red]✗ Error: {ex.Message}[/]");
+        }
+        finally
+        {
+            cts.Cancel();
+            await serverTask;
+        }
+    }
+
+    /// <summary>
+    /// Size of the name table against the JSON list, and what a press-and-turn jump to every
+    /// letter costs: the rows decoded for the dial's roller window and the time on this machine.
+    /// </summary>
+    private static void ReportNameTable(NameTableReader reader, int jsonBytes)
+    {
+        const int windowRows = 9;  // LIST_WINDOW_ROWS in the firmware
+        var count = Math.Max(reader.Count, 1);
+
+        var jumps = new List<(char Letter, int Row, int Skipped, long Decoded, double Us)>();
+        var row = 0;
+        while (true)
+        {
+            var started = Stopwatch.GetTimestamp();
+            reader.EntriesDecoded = 0;
+            var target = reader.Jump(row, 1);
+            if (target == row) break;
+
+            reader.Rows(Math.Max(target - windowRows / 2, 0), windowRows);
+            var elapsedUs = Stopwatch.GetElapsedTime(started).TotalMicroseconds;
+            jumps.Add((NameTableReader.BucketLabel(reader.BucketOf(target)), target, target - row, reader.EntriesDecoded, elapsedUs));
+            row = target;
+        }
+
+        var summary = new Table();
+        summary.Border(TableBorder.Rounded);
+        summary.AddColumn(new TableColumn("[bold]Name table[/]").LeftAligned());
+        summary.AddColumn(new TableColumn("[bold]value[/]").RightAligned());
+        summary.AddRow("entries", reader.Count.ToString());
+        summary.AddRow("table size", $"{reader.Size:N0} bytes ({(double)reader.Size / count:F1} per entry)");
+        summary.AddRow("JSON list size", jsonBytes > 0 ? $"{jsonBytes:N0} bytes ({(double)jsonBytes / count:F1} per entry)" : "-");
+        var letters = NameTableReader.BucketLabel(reader.BucketOf(0)) + string.Concat(jumps.Select(j => j.Letter));
+        summary.AddRow("letters", $"{letters.Length} ({letters})");
+
+        if (jumps.Count > 0)
+        {
+            summary.AddRow("detents per letter without jumps", $"{jumps.Average(j => j.Skipped):F0} avg, {jumps.Max(j => j.Skipped)} max");
+            summary.AddRow("rows decoded per jump", $"{jumps.Average(j => j.Decoded):F1} avg, {jumps.Max(j => j.Decoded)} max");
+            summary.AddRow("jump time (this machine)", $"{jumps.Average(j => j.Us):F1} us avg, {jumps.Max(j => j.Us):F1} us max");
+        }
+
+        AnsiConsole.Write(summary);
+        AnsiConsole.MarkupLine("[dim]On the dial every jump logs \"Jump to row N: rows decoded in X us, on screen in Y us\"[/]");
+    }
+}
@@ -0,0 +1,139 @@
+using System.Diagnostics;
+using System.Text;
+using System.Text.Json;
+using MQTTnet;
+using MQTTnet.Client;
+using Spectre.Console;
+
+namespace CLIClient;
+
+partial class Program
+{
+    private static string _metricsTopic = "spotidial/metrics";
+
+    /// <summary>
+    /// Fire commands from several simulated dials at a fixed rate and show the backend's queue
+    /// metrics. Pair with `stub-spotify` to see how many calls actually reach the API.
+    /// </summary>
+    private static async Task RunLoadTest(string host, int port, string username, string password,
+        int rate, int durationSeconds, int devices)
+    {
+        _brokerHost = host;
+        _brokerPort = port;
+        _username = username;
+        _password = password;
+
+        var rule = new Rule("[bold cyan]SpotiDial Command Load Test[/]");
+        AnsiConsole.Write(rule);
+        AnsiConsole.MarkupLine($"[dim]{rate} commands/s for {durationSeconds} s from {devices} devices[/]");
+
+        try
+        {
+            await ConnectToMqtt();
+
+            string? lastMetrics = null;
+            _mqttClient!.ApplicationMessageReceivedAsync += e =>
+            {
+                if (e.ApplicationMessage.Topic == _metricsTopic)
+                {
+                    lastMetrics = Encoding.UTF8.GetString(e.ApplicationMessage.PayloadSegment);
+                }
+                return Task.CompletedTask;
+            };
+
+            await _mqttClient.SubscribeAsync(new MqttTopicFilterBuilder()
+                .WithTopic(_metricsTopic)
+                .Build());
+
+            var random = new Random();
+            var sent = 0L;
+            var stopwatch = Stopwatch.StartNew();
+            var duration = TimeSpan.FromSeconds(durationSeconds);
+            var nextReport = TimeSpan.FromSeconds(1);
+
+            while (stopwatch.Elapsed < duration)
+            {
+                // Catch up to where the schedule says we should be
+                var due = (long)(stopwatch.Elapsed.TotalSeconds * rate);
+                while (sent < due)
+                {
+                    var (command, parameter) = RandomCommand(random);
+                    var json = JsonSerializer.Serialize(new
+                    {
+                        command,
+                        parameter,
+                        deviceId = $"loadtest-{sent % devices}"
+                    });
+
+                    var message = new MqttApplicationMessageBuilder()
+                        .WithTopic(_commandTopic)
+                        .WithPayload(json)
+                        .WithQualityOfServiceLevel(MQTTnet.Protocol.MqttQualityOfServiceLevel.AtMostOnce)
+                        .Build();
+
+                    await _mqttClient.PublishAsync(message);
+                    sent++;
+                }
+
+                if (stopwatch.Elapsed >= nextReport)
+                {
+                    AnsiConsole.MarkupLine($"[dim]{stopwatch.Elapsed.TotalSeconds:F0}s: {sent} sent[/]");
+                    nextReport += TimeSpan.FromSeconds(1);
+                }
+
+                await Task.Delay(5);
+            }
+
+            AnsiConsole.MarkupLine($"[green]✓[/] Sent {sent} commands in {stopwatch.Elapsed.TotalSeconds:F1} s " +
+                                   $"({sent / stopwatch.Elapsed.TotalSeconds:F0}/s)");
+            AnsiConsole.MarkupLine("[dim]Waiting for the backend to drain and publish metrics...[/]");
+
+            // Metrics arrive every METRICS_INTERVAL_SECONDS on the backend
+            var waitUntil = DateTime.UtcNow.AddSeconds(35);
+            var seen = lastMetrics;
+            while (DateTime.UtcNow < waitUntil && lastMetrics == seen)
+            {
+                await Task.Delay(250);
+            }
+
+            await DisconnectFromMqtt();
+
+            if (lastMetrics == null)
+            {
+                AnsiConsole.MarkupLine("[yellow]![/] No metrics received from the backend");
+                return;
+            }
+
+            var metrics = JsonSerializer.Deserialize<JsonElement>(lastMetrics).GetProperty("commandQueue");
+            var table = new Table();
+            table.Border(TableBorder.Rounded);
+            table.AddColumn(new TableColumn("[bold]Metric[/]").LeftAligned());
+            table.AddColumn(new TableColumn("[bold]Value[/]").RightAligned());
+
+            foreach (var property in metrics.EnumerateObject())
+            {
+                table.AddRow(property.Name, property.Value.ToString());
+            }
+
+            AnsiConsole.Write(table);
+        }
+        catch (Exception ex)
+        {
+            AnsiConsole.MarkupLine($"[red]✗ Error: {ex.Message}[/]");
+        }
+    }
+
+    // Roughly what a user spinning the dial and tapping looks like
+    private static (string Command, string? Parameter) RandomCommand(Random random)
+    {
+        var roll = random.Next(100);
+        return roll switch
+        {
+            < 60 => ("set_volume", random.Next(0, 101).ToString()),
+            < 75 => (random.Next(2) == 0 ? "volume_up" : "volume_down", null),
+            < 85 => ("seek", random.Next(0, 180_000).ToString()),
+            < 95 => (random.Next(2) == 0 ? "next" : "previous", null),
+            _ => (random.Next(2) == 0 ? "play" : "pause", null)
+        };
+    }
+}
@@ -0,0 +1,108 @@
+using System.Buffers.Binary;
+using System.Text;
+
+namespace CLIClient;
+
+/// <summary>
+/// Reads the front-coded name tables the backend sends on spotidial/*/table, the same way the
+/// dial does: rows are decoded from the nearest restart point and letter jumps use the index.
+/// </summary>
+public class NameTableReader
+{
+    public const int BucketCount = 27;
+    private const int HeaderSize = 8 + BucketCount * 2;
+
+    private readonly byte[] _table;
+    private readonly int _restartInterval;
+    private readonly int _entriesStart;
+
+    public int Count { get; }
+    public int Size => _table.Length;
+
+    // Entries decoded since the last reset, to compare jumps independent of the machine
+    public long EntriesDecoded { get; set; }
+
+    public NameTableReader(byte[] table)
+    {
+        if (table.Length < HeaderSize || Encoding.ASCII.GetString(table, 0, 4) != "SDNT" || table[4] != 1 || table[5] == 0)
+        {
+            throw new InvalidDataException("Not a name table");
+        }
+
+        _table = table;
+        _restartInterval = table[5];
+        Count = BinaryPrimitives.ReadUInt16LittleEndian(table.AsSpan(6));
+        _entriesStart = HeaderSize + (Count + _restartInterval - 1) / _restartInterval * 4;
+    }
+
+    public int BucketStart(int bucket) =>
+        bucket < BucketCount ? BinaryPrimitives.ReadUInt16LittleEndian(_table.AsSpan(8 + bucket * 2)) : Count;
+
+    public int BucketOf(int index)
+    {
+        for (var b = BucketCount - 1; b > 0; b--)
+        {
+            if (BucketStart(b) <= index) return b;
+        }
+        return 0;
+    }
+
+    public static char BucketLabel(int bucket) => bucket == 0 ? '#' : (char)('A' + bucket - 1);
+
+    /// <summary>
+    /// First row of the next non-empty letter, or for direction &lt; 0 the top of the current one
+    /// and then the previous letter. Same rules as the dial.
+    /// </summary>
+    public int Jump(int index, int direction)
+    {
+        var bucket = BucketOf(index);
+        if (direction > 0)
+        {
+            for (var b = bucket + 1; b < BucketCount; b++)
+            {
+                var start = BucketStart(b);
+                if (start > index && start < Count) return start;
+            }
+            return index;
+        }
+
+        var current = BucketStart(bucket);
+        if (index > current || current == 0) return current;
+        return BucketStart(BucketOf(current - 1));
+    }
+
+    /// <summary>
+    /// Decode count rows starting at first, as the dial does for its roller window.
+    /// </summary>
+    public List<(string Name, string Id)> Rows(int first, int count)
+    {
+        var rows = new List<(string Name, string Id)>(count);
+        if (first >= Count) return rows;
+
+        var restart = first / _restartInterval;
+        var offset = _entriesStart + (int)BinaryPrimitives.ReadUInt32LittleEndian(_table.AsSpan(HeaderSize + restart * 4));
+        var name = new byte[256];
+        var nameLength = 0;
+
+        for (var index = restart * _restartInterval; index < Count && rows.Count < count; index++)
+        {
+            int shared = _table[offset];
+            int suffix = _table[offset + 1];
+            Array.Copy(_table, offset + 2, name, shared, suffix);
+            nameLength = shared + suffix;
+            offset += 2 + suffix;
+
+            int idLength = _table[offset];
+            var id = Encoding.UTF8.GetString(_table, offset + 1, idLength);
+            offset += 1 + idLength;
+            EntriesDecoded++;
+
+            if (index >= first)
+            {
+                rows.Add((Encoding.UTF8.GetString(name, 0, nameLength), id));
+            }
+        }
+
+        return rows;
+    }
+}
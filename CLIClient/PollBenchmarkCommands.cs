@@ -0,0 +1,166 @@
+using System.Diagnostics;
+using System.Text;
+using System.Text.Json;
+using MQTTnet;
+using MQTTnet.Client;
+using Spectre.Console;
+
+namespace CLIClient;
+
+partial class Program
+{
+    /// <summary>
+    /// Run the stub Spotify API in-process with short tracks and occasional pauses, and watch
+    /// how many playback polls the backend makes and how late it notices each track change.
+    /// Run once with SPOTIFY_ADAPTIVE_POLLING=false and once with true to compare.
+    /// </summary>
+    private static async Task RunPollBenchmark(string host, int port, string username, string password,
+        int listenPort, int durationSeconds, int trackSeconds, int pauseEverySeconds, int pauseSeconds)
+    {
+        _brokerHost = host;
+        _brokerPort = port;
+        _username = username;
+        _password = password;
+
+        var rule = new Rule("[bold cyan]SpotiDial Playback Poll Benchmark[/]");
+        AnsiConsole.Write(rule);
+        AnsiConsole.MarkupLine($"[dim]{durationSeconds} s, {trackSeconds} s tracks, " +
+                               (pauseEverySeconds > 0 ? $"{pauseSeconds} s pause every {pauseEverySeconds} s[/]" : "no pauses[/]"));
+        AnsiConsole.MarkupLine($"[dim]Start the backend with SPOTIFY_API_BASE_URL=http://localhost:{listenPort}/v1/[/]");
+
+        var server = new StubSpotifyServer(listenPort, 0, 0, 0, trackSeconds * 1000);
+        using var cts = new CancellationTokenSource();
+        var serverTask = server.RunAsync(cts.Token);
+
+        try
+        {
+            await ConnectToMqtt();
+
+            var lags = new List<double>();
+            string? lastTrack = null;
+            string? lastMetrics = null;
+
+            _mqttClient!.ApplicationMessageReceivedAsync += e =>
+            {
+                var payload = Encoding.UTF8.GetString(e.ApplicationMessage.PayloadSegment);
+
+                if (e.ApplicationMessage.Topic == _metricsTopic)
+                {
+                    lastMetrics = payload;
+                    return Task.CompletedTask;
+                }
+
+                try
+                {
+                    // Progress into the new track when its status arrives is the detection lag
+                    var status = JsonSerializer.Deserialize<JsonElement>(payload);
+                    var track = status.GetProperty("trackName").GetString();
+                    if (track != lastTrack)
+                    {
+                        if (lastTrack != null)
+                        {
+                            lock (lags)
+                            {
+                                lags.Add(status.GetProperty("progressMs").GetInt32());
+                            }
+                        }
+                        lastTrack = track;
+                    }
+                }
+                catch (Exception ex) when (ex is JsonException or KeyNotFoundException or InvalidOperationException)
+                {
+                    // Not a status we can read; ignore
+                }
+
+                return Task.CompletedTask;
+            };
+
+            await _mqttClient.SubscribeAsync(new MqttTopicFilterBuilder()
+                .WithTopic(_statusTopic)
+                .Build());
+            await _mqttClient.SubscribeAsync(new MqttTopicFilterBuilder()
+                .WithTopic(_metricsTopic)
+                .Build());
+
+            // Only count what happens while the benchmark runs
+            var startRequests = server.PlayerRequestCount;
+            var startChanges = server.TrackChanges;
+            var stopwatch = Stopwatch.StartNew();
+            var duration = TimeSpan.FromSeconds(durationSeconds);
+            var nextReport = TimeSpan.FromSeconds(30);
+            var paused = false;
+
+            while (stopwatch.Elapsed < duration)
+            {
+                if (pauseEverySeconds > 0)
+                {
+                    var cycle = stopwatch.Elapsed.TotalSeconds % (pauseEverySeconds + pauseSeconds);
+                    var shouldPause = cycle >= pauseEverySeconds;
+                    if (shouldPause != paused)
+                    {
+                        paused = shouldPause;
+                        server.SetPlaying(!paused);
+                        AnsiConsole.MarkupLine($"[dim]{stopwatch.Elapsed.TotalSeconds:F0}s: {(paused ? "paused" : "resumed")}[/]");
+                    }
+                }
+
+                if (stopwatch.Elapsed >= nextReport)
+                {
+                    AnsiConsole.MarkupLine($"[dim]{stopwatch.Elapsed.TotalSeconds:F0}s: " +
+                                           $"{server.PlayerRequestCount - startRequests} playback requests[/]");
+                    nextReport += TimeSpan.FromSeconds(30);
+                }
+
+                await Task.Delay(250);
+            }
+
+            var elapsed = stopwatch.Elapsed;
+            var requests = server.PlayerRequestCount - startRequests;
+            var changes = server.TrackChanges - startChanges;
+
+            await DisconnectFromMqtt();
+
+            AnsiConsole.WriteLine();
+            var table = new Table();
+            table.Border(TableBorder.Rounded);
+            table.AddColumn(new TableColumn("[bold]Metric[/]").LeftAligned());
+            table.AddColumn(new TableColumn("[bold]Value[/]").RightAligned());
+            table.AddRow("GET /me/player", requests.ToString());
+            table.AddRow("calls per hour", $"{requests / elapsed.TotalHours:F0}");
+            table.AddRow("track changes", changes.ToString());
+            table.AddRow("detected", lags.Count.ToString());
+            AnsiConsole.Write(table);
+
+            var lagTable = new Table();
+            lagTable.Border(TableBorder.Rounded);
+            lagTable.AddColumn(new TableColumn("[bold]Hop[/]").LeftAligned());
+            lagTable.AddColumn(new TableColumn("[bold]n[/]").RightAligned());
+            lagTable.AddColumn(new TableColumn("[bold]p50[/]").RightAligned());
+            lagTable.AddColumn(new TableColumn("[bold]p90[/]").RightAligned());
+            lagTable.AddColumn(new TableColumn("[bold]p99[/]").RightAligned());
+            lagTable.AddColumn(new TableColumn("[bold]max[/]").RightAligned());
+            lock (lags)
+            {
+                AddLatencyRow(lagTable, "track change lag", lags);
+            }
+            AnsiConsole.Write(lagTable);
+
+            if (lastMetrics != null)
+            {
+                var playback = JsonSerializer.Deserialize<JsonElement>(lastMetrics).GetProperty("playback");
+                AnsiConsole.MarkupLine($"[dim]Backend reports {playback.GetProperty("apiCallsPerHour")} API calls/h, " +
+                                       $"{playback.GetProperty("pollsPerHour")} polls/h, " +
+                                       $"{playback.GetProperty("rateLimited")} rate limited[/]");
+            }
+        }
+        catch (Exception ex)
+        {
+            AnsiConsole.MarkupLine($"[red]✗ Error: {ex.Message}[/]");
+        }
+        finally
+        {
+            cts.Cancel();
+            await serverTask;
+        }
+    }
+}
@@ -7,7 +7,7 @@ using System.Text.Json;
 
 namespace CLIClient;
 
-class Program
+partial class Program
 {
     private static IMqttClient? _mqttClient;
     private static string _brokerHost = "localhost";
@@ -19,6 +19,7 @@ class Program
     private static string _imageTopic = "spotidial/image";
     private static string _playlistTopic = "spotidial/playlists";
     private static string _albumTopic = "spotidial/albums";
+    private static string _playlistTableTopic = "spotidial/playlists/table";
 
     static async Task<int> Main(string[] args)
     {
@@ -62,6 +63,10 @@ class Program
         var volumeArgument = new Argument<int>("level", "Volume level (0-100)");
         setVolumeCommand.AddArgument(volumeArgument);
 
+        var seekCommand = new Command("seek", "Seek within the current track");
+        var positionArgument = new Argument<int>("position-ms", "Position in milliseconds");
+        seekCommand.AddArgument(positionArgument);
+
         var changePlaylistCommand = new Command("change-playlist", "Change to a playlist");
         var playlistArgument = new Argument<string>("playlist-id", "Spotify playlist ID");
         changePlaylistCommand.AddArgument(playlistArgument);
@@ -76,6 +81,93 @@ class Program
 
         var monitorCommand = new Command("monitor", "Monitor status and image updates from the backend");
 
+        var traceCommand = new Command("trace", "Send traced commands and report end-to-end latency");
+        var traceCommandArgument = new Argument<string>("command", () => "volume_up", "Command to trace (e.g. volume_up, play, next)");
+        var traceParameterOption = new Option<string?>("--parameter", "Command parameter");
+        var traceCountOption = new Option<int>("--count", () => 20, "Number of commands to send");
+        var traceIntervalOption = new Option<int>("--interval", () => 250, "Delay between commands in milliseconds");
+        traceCommand.AddArgument(traceCommandArgument);
+        traceCommand.AddOption(traceParameterOption);
+        traceCommand.AddOption(traceCountOption);
+        traceCommand.AddOption(traceIntervalOption);
+
+        var loadTestCommand = new Command("load-test", "Flood the backend with commands from simulated devices");
+        var rateOption = new Option<int>("--rate", () => 2000, "Commands per second");
+        var durationOption = new Option<int>("--duration", () => 10, "Test duration in seconds");
+        var devicesOption = new Option<int>("--devices", () => 4, "Number of simulated devices");
+        loadTestCommand.AddOption(rateOption);
+        loadTestCommand.AddOption(durationOption);
+        loadTestCommand.AddOption(devicesOption);
+
+        var stubSpotifyCommand = new Command("stub-spotify", "Run a local stub of the Spotify Web API for the backend");
+        var listenPortOption = new Option<int>("--listen-port", () => 5055, "HTTP port to listen on");
+        var latencyOption = new Option<int>("--latency", () => 0, "Artificial latency per request in milliseconds");
+        var playlistCountOption = new Option<int>("--playlists", () => 25, "Number of playlists to serve");
+        var albumCountOption = new Option<int>("--albums", () => 25, "Number of saved albums to serve");
+        var trackSecondsOption = new Option<int>("--track-seconds", () => 180, "Length of every stub track in seconds");
+        var rateLimitOption = new Option<int>("--rate-limit", () => 0, "Answer 429 above this many requests per second (0 = off)");
+        stubSpotifyCommand.AddOption(listenPortOption);
+        stubSpotifyCommand.AddOption(latencyOption);
+        stubSpotifyCommand.AddOption(playlistCountOption);
+        stubSpotifyCommand.AddOption(albumCountOption);
+        stubSpotifyCommand.AddOption(trackSecondsOption);
+        stubSpotifyCommand.AddOption(rateLimitOption);
+
+        var pollBenchmarkCommand = new Command("poll-benchmark", "Measure the backend's playback polling against an in-process stub");
+        var benchmarkDurationOption = new Option<int>("--duration", () => 600, "Benchmark duration in seconds");
+        var benchmarkTrackSecondsOption = new Option<int>("--track-seconds", () => 30, "Length of every stub track in seconds");
+        var pauseEveryOption = new Option<int>("--pause-every", () => 120, "Pause playback every N seconds (0 = never)");
+        var pauseSecondsOption = new Option<int>("--pause-seconds", () => 30, "How long each pause lasts in seconds");
+        pollBenchmarkCommand.AddOption(listenPortOption);
+        pollBenchmarkCommand.AddOption(benchmarkDurationOption);
+        pollBenchmarkCommand.AddOption(benchmarkTrackSecondsOption);
+        pollBenchmarkCommand.AddOption(pauseEveryOption);
+        pollBenchmarkCommand.AddOption(pauseSecondsOption);
+
+        var libraryBenchmarkCommand = new Command("library-benchmark", "Measure playlist browsing against a large in-process stub library");
+        var itemsOption = new Option<int>("--items", () => 5000, "Number of playlists in the stub library");
+        libraryBenchmarkCommand.AddOption(listenPortOption);
+        libraryBenchmarkCommand.AddOption(itemsOption);
+        libraryBenchmarkCommand.AddOption(latencyOption);
+
+        var compactBenchmarkCommand = new Command("compact-benchmark", "Compare the compact status and list encoding with JSON as a dial would receive them");
+        var compactItemsOption = new Option<int>("--items", () => 60, "Number of playlists and albums in the stub library");
+        var roundsOption = new Option<int>("--rounds", () => 1000, "Decoding rounds to average over");
+        var readerOption = new Option<string>("--reader", () => "../Firmware/tools/compact_bench/compact_bench", "Host build of the dial's decoding (make -C Firmware/tools/compact_bench)");
+        compactBenchmarkCommand.AddOption(listenPortOption);
+        compactBenchmarkCommand.AddOption(compactItemsOption);
+        compactBenchmarkCommand.AddOption(roundsOption);
+        compactBenchmarkCommand.AddOption(readerOption);
+
+        var reconnectStormCommand = new Command("reconnect-storm", "Drop many virtual dials at once and measure how the broker copes with them reconnecting");
+        var dialsOption = new Option<int>("--dials", () => 300, "Number of virtual dials");
+        var outageOption = new Option<int>("--outage", () => 10, "How long connections stay down in seconds");
+        var proxyPortOption = new Option<int>("--proxy-port", () => 1884, "Local port of the proxy in front of the broker");
+        var imageKbOption = new Option<int>("--image-kb", () => 20, "Size of the retained image in KB");
+        var legacyOption = new Option<bool>("--legacy", "Use the old policy: fixed 5 s retry, clean session, resubscribe");
+        reconnectStormCommand.AddOption(dialsOption);
+        reconnectStormCommand.AddOption(outageOption);
+        reconnectStormCommand.AddOption(proxyPortOption);
+        reconnectStormCommand.AddOption(imageKbOption);
+        reconnectStormCommand.AddOption(legacyOption);
+
+        var clusterTestCommand = new Command("cluster-test", "Run backend instances as a cluster and measure throughput and failover");
+        var backendOption = new Option<string>("--backend", () => "../Backend/bin/Release/net10.0/SpotiDialBackend.dll", "Backend build to start (SpotiDialBackend.dll or executable)");
+        var instancesOption = new Option<int>("--instances", () => 3, "Number of backend instances");
+        var clusterRateOption = new Option<int>("--rate", () => 200, "Commands per second");
+        var clusterDurationOption = new Option<int>("--duration", () => 30, "Test duration in seconds");
+        var clusterDevicesOption = new Option<int>("--devices", () => 30, "Number of simulated devices");
+        var leaseOption = new Option<int>("--lease", () => 3000, "Cluster lease in milliseconds");
+        var killAfterOption = new Option<int>("--kill-after", () => 15, "Kill the first instance after this many seconds");
+        clusterTestCommand.AddOption(backendOption);
+        clusterTestCommand.AddOption(instancesOption);
+        clusterTestCommand.AddOption(clusterRateOption);
+        clusterTestCommand.AddOption(clusterDurationOption);
+        clusterTestCommand.AddOption(clusterDevicesOption);
+        clusterTestCommand.AddOption(listenPortOption);
+        clusterTestCommand.AddOption(leaseOption);
+        clusterTestCommand.AddOption(killAfterOption);
+
         // Add commands to root
         rootCommand.AddCommand(playCommand);
         rootCommand.AddCommand(pauseCommand);
@@ -84,11 +176,20 @@ class Program
         rootCommand.AddCommand(volumeUpCommand);
         rootCommand.AddCommand(volumeDownCommand);
         rootCommand.AddCommand(setVolumeCommand);
+        rootCommand.AddCommand(seekCommand);
         rootCommand.AddCommand(changePlaylistCommand);
         rootCommand.AddCommand(changeAlbumCommand);
         rootCommand.AddCommand(getPlaylistsCommand);
         rootCommand.AddCommand(getAlbumsCommand);
         rootCommand.AddCommand(monitorCommand);
+        rootCommand.AddCommand(traceCommand);
+        rootCommand.AddCommand(loadTestCommand);
+        rootCommand.AddCommand(stubSpotifyCommand);
+        rootCommand.AddCommand(pollBenchmarkCommand);
+        rootCommand.AddCommand(libraryBenchmarkCommand);
+        rootCommand.AddCommand(compactBenchmarkCommand);
+        rootCommand.AddCommand(reconnectStormCommand);
+        rootCommand.AddCommand(clusterTestCommand);
 
         // Set handlers
         playCommand.SetHandler(async (host, port, username, password) =>
@@ -126,6 +227,11 @@ class Program
             await ExecuteCommand(host, port, username, password, "set_volume", level.ToString());
         }, hostOption, portOption, usernameOption, passwordOption, volumeArgument);
 
+        seekCommand.SetHandler(async (host, port, username, password, position) =>
+        {
+            await ExecuteCommand(host, port, username, password, "seek", position.ToString());
+        }, hostOption, portOption, usernameOption, passwordOption, positionArgument);
+
         changePlaylistCommand.SetHandler(async (host, port, username, password, playlistId) =>
         {
             await ExecuteCommand(host, port, username, password, "change_playlist", playlistId);
@@ -151,6 +257,120 @@ class Program
             await MonitorUpdates(host, port, username, password);
         }, hostOption, portOption, usernameOption, passwordOption);
 
+        traceCommand.SetHandler(async (context) =>
+        {
+            var parse = context.ParseResult;
+            await RunLatencyTrace(
+                parse.GetValueForOption(hostOption)!,
+                parse.GetValueForOption(portOption),
+                parse.GetValueForOption(usernameOption)!,
+                parse.GetValueForOption(passwordOption)!,
+                parse.GetValueForArgument(traceCommandArgument),
+                parse.GetValueForOption(traceParameterOption),
+                parse.GetValueForOption(traceCountOption),
+                parse.GetValueForOption(traceIntervalOption));
+        });
+
+        loadTestCommand.SetHandler(async (context) =>
+        {
+            var parse = context.ParseResult;
+            await RunLoadTest(
+                parse.GetValueForOption(hostOption)!,
+                parse.GetValueForOption(portOption),
+                parse.GetValueForOption(usernameOption)!,
+                parse.GetValueForOption(passwordOption)!,
+                parse.GetValueForOption(rateOption),
+                parse.GetValueForOption(durationOption),
+                Math.Max(parse.GetValueForOption(devicesOption), 1));
+        });
+
+        stubSpotifyCommand.SetHandler(async (context) =>
+        {
+            var parse = context.ParseResult;
+            await RunStubSpotify(
+                parse.GetValueForOption(listenPortOption),
+                parse.GetValueForOption(latencyOption),
+                parse.GetValueForOption(playlistCountOption),
+                parse.GetValueForOption(albumCountOption),
+                parse.GetValueForOption(trackSecondsOption),
+                parse.GetValueForOption(rateLimitOption));
+        });
+
+        pollBenchmarkCommand.SetHandler(async (context) =>
+        {
+            var parse = context.ParseResult;
+            await RunPollBenchmark(
+                parse.GetValueForOption(hostOption)!,
+                parse.GetValueForOption(portOption),
+                parse.GetValueForOption(usernameOption)!,
+                parse.GetValueForOption(passwordOption)!,
+                parse.GetValueForOption(listenPortOption),
+                parse.GetValueForOption(benchmarkDurationOption),
+                parse.GetValueForOption(benchmarkTrackSecondsOption),
+                parse.GetValueForOption(pauseEveryOption),
+                parse.GetValueForOption(pauseSecondsOption));
+        });
+
+        libraryBenchmarkCommand.SetHandler(async (context) =>
+        {
+            var parse = context.ParseResult;
+            await RunLibraryBenchmark(
+                parse.GetValueForOption(hostOption)!,
+                parse.GetValueForOption(portOption),
+                parse.GetValueForOption(usernameOption)!,
+                parse.GetValueForOption(passwordOption)!,
+                parse.GetValueForOption(listenPortOption),
+                parse.GetValueForOption(itemsOption),
+                parse.GetValueForOption(latencyOption));
+        });
+
+        compactBenchmarkCommand.SetHandler(async (context) =>
+        {
+            var parse = context.ParseResult;
+            await RunCompactBenchmark(
+                parse.GetValueForOption(hostOption)!,
+                parse.GetValueForOption(portOption),
+                parse.GetValueForOption(usernameOption)!,
+                parse.GetValueForOption(passwordOption)!,
+                parse.GetValueForOption(listenPortOption),
+                Math.Max(parse.GetValueForOption(compactItemsOption), 1),
+                Math.Max(parse.GetValueForOption(roundsOption), 1),
+                parse.GetValueForOption(readerOption)!);
+        });
+
+        reconnectStormCommand.SetHandler(async (context) =>
+        {
+            var parse = context.ParseResult;
+            await RunReconnectStorm(
+                parse.GetValueForOption(hostOption)!,
+                parse.GetValueForOption(portOption),
+                parse.GetValueForOption(usernameOption)!,
+                parse.GetValueForOption(passwordOption)!,
+                Math.Max(parse.GetValueForOption(dialsOption), 1),
+                parse.GetValueForOption(outageOption),
+                parse.GetValueForOption(proxyPortOption),
+                parse.GetValueForOption(imageKbOption),
+                parse.GetValueForOption(legacyOption));
+        });
+
+        clusterTestCommand.SetHandler(async (context) =>
+        {
+            var parse = context.ParseResult;
+            await RunClusterTest(
+                parse.GetValueForOption(hostOption)!,
+                parse.GetValueForOption(portOption),
+                parse.GetValueForOption(usernameOption)!,
+                parse.GetValueForOption(passwordOption)!,
+                parse.GetValueForOption(backendOption)!,
+                Math.Max(parse.GetValueForOption(instancesOption), 2),
+                parse.GetValueForOption(clusterRateOption),
+                parse.GetValueForOption(clusterDurationOption),
+                Math.Max(parse.GetValueForOption(clusterDevicesOption), 1),
+                parse.GetValueForOption(listenPortOption),
+                parse.GetValueForOption(leaseOption),
+                parse.GetValueForOption(killAfterOption));
+        });
+
         return await rootCommand.InvokeAsync(args);
     }
 
@@ -0,0 +1,412 @@
+using System.Collections.Concurrent;
+using System.Diagnostics;
+using System.Net;
+using System.Net.Sockets;
+using System.Text.Json;
+using MQTTnet;
+using MQTTnet.Client;
+using Spectre.Console;
+
+namespace CLIClient;
+
+partial class Program
+{
+    private const string StormTopicPrefix = "loadtest/storm/";
+
+    /// <summary>
+    /// Connect many virtual dials to the broker through an in-process TCP proxy, cut every
+    /// connection for a while as a broker restart would, and measure what the broker sends
+    /// while the fleet comes back and how long it takes until every dial is settled again.
+    /// The dials follow the firmware's reconnect policy, or the old one with --legacy.
+    /// </summary>
+    private static async Task RunReconnectStorm(string host, int port, string username, string password,
+        int dials, int outageSeconds, int proxyPort, int imageKb, bool legacy)
+    {
+        _brokerHost = host;
+        _brokerPort = port;
+        _username = username;
+        _password = password;
+
+        var rule = new Rule("[bold cyan]SpotiDial Reconnect Storm[/]");
+        AnsiConsole.Write(rule);
+        AnsiConsole.MarkupLine($"[dim]{dials} dials, {outageSeconds} s outage, {imageKb} KB retained image, " +
+                               (legacy
+                                   ? "legacy policy (fixed 5 s retry, clean session, resubscribe)[/]"
+                                   : "firmware policy (jittered backoff, persistent session)[/]"));
+
+        var proxy = new BrokerProxy(proxyPort, host, port);
+        using var cts = new CancellationTokenSource();
+        var proxyTask = proxy.RunAsync(cts.Token);
+        var fleet = Enumerable.Range(0, dials)
+            .Select(i => new VirtualDial($"loadtest-dial-{i:D4}", proxyPort, legacy))
+            .ToList();
+        var dialTasks = new List<Task>();
+
+        try
+        {
+            // Retained state every subscriber gets on subscribe, like status and album art
+            await ConnectToMqtt();
+            await PublishRetained(StormTopicPrefix + "status",
+                JsonSerializer.SerializeToUtf8Bytes(new { trackName = "Load Test", artistName = "SpotiDial", isPlaying = true }));
+            await PublishRetained(StormTopicPrefix + "image", RandomBytes(imageKb * 1024));
+
+            dialTasks.AddRange(fleet.Select(dial => dial.RunAsync(cts.Token)));
+
+            if (!await WaitForFleet(fleet, 0, TimeSpan.FromSeconds(60)))
+            {
+                AnsiConsole.MarkupLine("[red]✗ Not every dial connected; is the broker running?[/]");
+                return;
+            }
+            AnsiConsole.MarkupLine($"[green]✓[/] {dials} dials connected");
+
+            await Task.Delay(2000);
+            var attemptsBefore = fleet.Sum(d => d.Attempts);
+
+            AnsiConsole.MarkupLine($"[dim]Cutting all connections for {outageSeconds} s...[/]");
+            proxy.SetDown(true);
+            await Task.Delay(TimeSpan.FromSeconds(outageSeconds));
+            var outageEnd = proxy.Elapsed;
+            proxy.SetDown(false);
+
+            // Generous: a dial may just have started its longest wait
+            var converged = await WaitForFleet(fleet, outageEnd.Ticks, TimeSpan.FromSeconds(180));
+            var settledAt = fleet.Where(d => d.SettledTicks > outageEnd.Ticks).Select(d => d.SettledTicks).DefaultIfEmpty(0).Max();
+            var convergence = settledAt > 0 ? TimeSpan.FromTicks(settledAt) - outageEnd : TimeSpan.Zero;
+
+            await Task.Delay(2000);
+            var (peakBytes, peakSecond) = proxy.PeakDownstream(outageEnd);
+
+            var table = new Table();
+            table.Border(TableBorder.Rounded);
+            table.AddColumn(new TableColumn("[bold]Metric[/]").LeftAligned());
+            table.AddColumn(new TableColumn("[bold]Value[/]").RightAligned());
+            table.AddRow("converged", converged ? "yes" : "[red]no[/]");
+            table.AddRow("convergence time", $"{convergence.TotalSeconds:F1} s");
+            table.AddRow("connect attempts", (fleet.Sum(d => d.Attempts) - attemptsBefore).ToString());
+            table.AddRow("sessions resumed", fleet.Count(d => d.LastResumed).ToString());
+            table.AddRow("resubscribed", fleet.Count(d => !d.LastResumed).ToString());
+            table.AddRow("broker -> dials total", $"{proxy.DownstreamSince(outageEnd) / 1024.0:F0} KB");
+            table.AddRow("broker -> dials peak", $"{peakBytes / 1024.0:F0} KB/s (at +{(peakSecond - outageEnd).TotalSeconds:F0} s)");
+            AnsiConsole.Write(table);
+        }
+        catch (Exception ex)
+        {
+            AnsiConsole.MarkupLine($"[red]✗ Error: {ex.Message}[/]");
+        }
+        finally
+        {
+            cts.Cancel();
+            await Task.WhenAll(dialTasks);
+            await proxyTask;
+
+            // Leave nothing behind on the broker: sessions and retained messages
+            await Task.WhenAll(fleet.Select(d => d.ForgetSessionAsync(host, port)));
+            if (_mqttClient != null && _mqttClient.IsConnected)
+            {
+                await PublishRetained(StormTopicPrefix + "status", Array.Empty<byte>());
+                await PublishRetained(StormTopicPrefix + "image", Array.Empty<byte>());
+                await DisconnectFromMqtt();
+            }
+        }
+    }
+
+    // True once every dial is connected and settled after the given BrokerProxy clock time (ticks)
+    private static async Task<bool> WaitForFleet(List<VirtualDial> fleet, long afterTicks, TimeSpan timeout)
+    {
+        var stopwatch = Stopwatch.StartNew();
+        var nextReport = TimeSpan.FromSeconds(5);
+        while (stopwatch.Elapsed < timeout)
+        {
+            var settled = fleet.Count(d => d.Connected && d.SettledTicks > afterTicks);
+            if (settled == fleet.Count) return true;
+
+            if (stopwatch.Elapsed >= nextReport)
+            {
+                AnsiConsole.MarkupLine($"[dim]{stopwatch.Elapsed.TotalSeconds:F0}s: {settled}/{fleet.Count} settled[/]");
+                nextReport += TimeSpan.FromSeconds(5);
+            }
+            await Task.Delay(100);
+        }
+        return false;
+    }
+
+    private static async Task PublishRetained(string topic, byte[] payload)
+    {
+        var message = new MqttApplicationMessageBuilder()
+            .WithTopic(topic)
+            .WithPayload(payload)
+            .WithQualityOfServiceLevel(MQTTnet.Protocol.MqttQualityOfServiceLevel.AtLeastOnce)
+            .WithRetainFlag(true)
+            .Build();
+
+        await _mqttClient!.PublishAsync(message);
+    }
+
+    private static byte[] RandomBytes(int length)
+    {
+        var bytes = new byte[length];
+        Random.Shared.NextBytes(bytes);
+        return bytes;
+    }
+
+    /// <summary>
+    /// One dial's MQTT connection with the firmware's reconnect policy.
+    /// </summary>
+    private sealed class VirtualDial
+    {
+        private readonly string _clientId;
+        private readonly int _port;
+        private readonly bool _legacy;
+        private readonly IMqttClient _client = new MqttFactory().CreateMqttClient();
+        private bool _subscribed;
+        private int _attempts;
+        private long _settledTicks;
+
+        public VirtualDial(string clientId, int port, bool legacy)
+        {
+            _clientId = clientId;
+            _port = port;
+            _legacy = legacy;
+        }
+
+        public int Attempts => Volatile.Read(ref _attempts);
+        public bool Connected => _client.IsConnected;
+        public bool LastResumed { get; private set; }
+
+        // BrokerProxy clock ticks when the dial last had its subscriptions in place
+        public long SettledTicks => Interlocked.Read(ref _settledTicks);
+
+        public async Task RunAsync(CancellationToken cancellationToken)
+        {
+            var delayMs = 1000;
+            var wait = 0;
+
+            while (!cancellationToken.IsCancellationRequested)
+            {
+                try
+                {
+                    if (_client.IsConnected)
+                    {
+                        await Task.Delay(50, cancellationToken);
+                        continue;
+                    }
+
+                    await Task.Delay(wait, cancellationToken);
+                    Interlocked.Increment(ref _attempts);
+
+                    if (await TryConnectAsync(cancellationToken))
+                    {
+                        delayMs = 1000;
+                        // The old firmware retried right away after losing the connection
+                        wait = _legacy ? 0 : delayMs / 2 + Random.Shared.Next(delayMs / 2 + 1);
+                    }
+                    else if (_legacy)
+                    {
+                        wait = 5000;
+                    }
+                    else
+                    {
+                        wait = delayMs / 2 + Random.Shared.Next(delayMs / 2 + 1);
+                        delayMs = Math.Min(delayMs * 2, 30000);
+                    }
+                }
+                catch (OperationCanceledException)
+                {
+                    break;
+                }
+            }
+
+            try
+            {
+                await _client.DisconnectAsync();
+            }
+            catch (Exception)
+            {
+                // The proxy may already be gone
+            }
+        }
+
+        private async Task<bool> TryConnectAsync(CancellationToken cancellationToken)
+        {
+            try
+            {
+                var options = DialOptions("127.0.0.1", _port, cleanSession: _legacy);
+                var result = await _client.ConnectAsync(options, cancellationToken);
+
+                // The firmware probes its session topic; the result flag says the same here
+                LastResumed = !_legacy && _subscribed && result.IsSessionPresent;
+                if (!LastResumed)
+                {
+                    await _client.SubscribeAsync(new MqttTopicFilterBuilder()
+                        .WithTopic(StormTopicPrefix + "#")
+                        .WithAtLeastOnceQoS()
+                        .Build(), cancellationToken);
+                    _subscribed = true;
+                }
+
+                Interlocked.Exchange(ref _settledTicks, BrokerProxy.Now.Ticks);
+                return true;
+            }
+            catch (Exception ex) when (ex is not OperationCanceledException)
+            {
+                return false;
+            }
+        }
+
+        // Connect once with a clean session so the broker drops what it kept for this dial
+        public async Task ForgetSessionAsync(string host, int port)
+        {
+            try
+            {
+                using var client = new MqttFactory().CreateMqttClient();
+                await client.ConnectAsync(DialOptions(host, port, cleanSession: true));
+                await client.DisconnectAsync();
+            }
+            catch (Exception)
+            {
+                // Best effort
+            }
+        }
+
+        private MqttClientOptions DialOptions(string host, int port, bool cleanSession)
+        {
+            var builder = new MqttClientOptionsBuilder()
+                .WithTcpServer(host, port)
+                .WithClientId(_clientId)
+                .WithCleanSession(cleanSession)
+                .WithTimeout(TimeSpan.FromSeconds(5));
+
+            if (!string.IsNullOrEmpty(_username))
+            {
+                builder.WithCredentials(_username, _password);
+            }
+
+            return builder.Build();
+        }
+    }
+
+    /// <summary>
+    /// TCP forwarder in front of the broker that can drop every connection and refuse new
+    /// ones, and counts the bytes the broker sends per second.
+    /// </summary>
+    private sealed class BrokerProxy
+    {
+        private static readonly Stopwatch Clock = Stopwatch.StartNew();
+
+        private readonly int _listenPort;
+        private readonly string _brokerHost;
+        private readonly int _brokerPort;
+        private readonly ConcurrentDictionary<TcpClient, TcpClient> _connections = new();
+        private readonly ConcurrentDictionary<long, long> _downstreamPerSecond = new();
+        private volatile bool _down;
+
+        public BrokerProxy(int listenPort, string brokerHost, int brokerPort)
+        {
+            _listenPort = listenPort;
+            _brokerHost = brokerHost;
+            _brokerPort = brokerPort;
+        }
+
+        public static TimeSpan Now => Clock.Elapsed;
+        public TimeSpan Elapsed => Clock.Elapsed;
+
+        public void SetDown(bool down)
+        {
+            _down = down;
+            if (!down) return;
+
+            foreach (var (client, upstream) in _connections)
+            {
+                client.Close();
+                upstream.Close();
+            }
+            _connections.Clear();
+        }
+
+        public long DownstreamSince(TimeSpan from) =>
+            _downstreamPerSecond.Where(b => b.Key >= (long)from.TotalSeconds).Sum(b => b.Value);
+
+        public (long Bytes, TimeSpan Second) PeakDownstream(TimeSpan from)
+        {
+            var peak = _downstreamPerSecond
+                .Where(b => b.Key >= (long)from.TotalSeconds)
+                .OrderByDescending(b => b.Value)
+                .FirstOrDefault();
+            return (peak.Value, TimeSpan.FromSeconds(peak.Key));
+        }
+
+        public async Task RunAsync(CancellationToken cancellationToken)
+        {
+            var listener = new TcpListener(IPAddress.Loopback, _listenPort);
+            listener.Start(1024);
+
+            try
+            {
+                while (!cancellationToken.IsCancellationRequested)
+                {
+                    var client = await listener.AcceptTcpClientAsync(cancellationToken);
+                    if (_down)
+                    {
+                        client.Close();
+                        continue;
+                    }
+
+                    _ = ForwardAsync(client, cancellationToken);
+                }
+            }
+            catch (OperationCanceledException)
+            {
+            }
+            finally
+            {
+                listener.Stop();
+                SetDown(true);
+            }
+        }
+
+        private async Task ForwardAsync(TcpClient client, CancellationToken cancellationToken)
+        {
+            var upstream = new TcpClient();
+            try
+            {
+                await upstream.ConnectAsync(_brokerHost, _brokerPort, cancellationToken);
+                _connections[client] = upstream;
+
+                await Task.WhenAny(
+                    PumpAsync(client.GetStream(), upstream.GetStream(), false, cancellationToken),
+                    PumpAsync(upstream.GetStream(), client.GetStream(), true, cancellationToken));
+            }
+            catch (Exception)
+            {
+                // Either side went away
+            }
+            finally
+            {
+                _connections.TryRemove(client, out _);
+                client.Close();
+                upstream.Close();
+            }
+        }
+
+        private async Task PumpAsync(NetworkStream from, NetworkStream to, bool downstream, CancellationToken cancellationToken)
+        {
+            var buffer = new byte[16 * 1024];
+            try
+            {
+                int read;
+                while ((read = await from.ReadAsync(buffer, cancellationToken)) > 0)
+                {
+                    if (downstream)
+                    {
+                        _downstreamPerSecond.AddOrUpdate((long)Clock.Elapsed.TotalSeconds, read, (_, total) => total + read);
+                    }
+                    await to.WriteAsync(buffer.AsMemory(0, read), cancellationToken);
+                }
+            }
+            catch (Exception)
+            {
+                // Connection closed
+            }
+        }
+    }
+}
@@ -0,0 +1,395 @@
+using System.Net;
+using System.Text;
+using System.Text.Json;
+
+namespace CLIClient;
+
+/// <summary>
+/// Minimal stand-in for the Spotify Web API, enough for the backend's player and library calls.
+/// Point the backend at it with SPOTIFY_API_BASE_URL=http://localhost:&lt;port&gt;/v1/
+/// </summary>
+public class StubSpotifyServer
+{
+    private static readonly JsonSerializerOptions JsonOptions = new()
+    {
+        PropertyNamingPolicy = JsonNamingPolicy.SnakeCaseLower
+    };
+
+    private readonly int _port;
+    private readonly int _latencyMs;
+    private readonly int _trackDurationMs;
+    private readonly int _rateLimit;
+    // Library in API order: playlist (index, snapshot version) and saved album index, newest first
+    private readonly List<(int Index, int Version)> _playlists;
+    private readonly List<int> _albums;
+    private readonly object _lock = new();
+
+    private int _trackIndex;
+    private bool _isPlaying = true;
+    private int _volumePercent = 50;
+    private int _positionMs;
+    private DateTime _positionUpdated = DateTime.UtcNow;
+    private long _requestCount;
+    private long _playerRequestCount;
+    private long _rateLimitedCount;
+    private long _libraryRequestCount;
+    private int _trackChanges;
+    private long _windowStart;
+    private int _windowRequests;
+
+    private const int TrackCount = 20;
+    private const int PageLimit = 50;
+
+    /// <param name="trackDurationMs">Length of every stub track</param>
+    /// <param name="rateLimit">Requests per second before answering 429, 0 for no limit</param>
+    public StubSpotifyServer(int port, int latencyMs, int playlistCount, int albumCount,
+        int trackDurationMs = 180_000, int rateLimit = 0)
+    {
+        _port = port;
+        _latencyMs = latencyMs;
+        _trackDurationMs = Math.Max(trackDurationMs, 1000);
+        _rateLimit = rateLimit;
+        _playlists = Enumerable.Range(0, playlistCount).Select(i => (i, 1)).ToList();
+        _albums = Enumerable.Range(0, albumCount).ToList();
+    }
+
+    public long RequestCount => Interlocked.Read(ref _requestCount);
+
+    // GET /me/player only, the calls the backend's playback poller makes
+    public long PlayerRequestCount => Interlocked.Read(ref _playerRequestCount);
+
+    public long RateLimitedCount => Interlocked.Read(ref _rateLimitedCount);
+
+    // GET /me/playlists and /me/albums pages
+    public long LibraryRequestCount => Interlocked.Read(ref _libraryRequestCount);
+
+    public int PlaylistCount
+    {
+        get
+        {
+            lock (_lock) return _playlists.Count;
+        }
+    }
+
+    /// <summary>
+    /// Create a playlist; like Spotify it appears at the top of the list.
+    /// </summary>
+    public void AddPlaylist()
+    {
+        lock (_lock)
+        {
+            _playlists.Insert(0, (_playlists.Count, 1));
+        }
+    }
+
+    /// <summary>
+    /// Edit the playlist at the given position, which changes its snapshot id.
+    /// </summary>
+    public void EditPlaylist(int position)
+    {
+        lock (_lock)
+        {
+            if (position < 0 || position >= _playlists.Count) return;
+            var (index, version) = _playlists[position];
+            _playlists[position] = (index, version + 1);
+        }
+    }
+
+    /// <summary>
+    /// Tracks changed so far, by rollover or skip.
+    /// </summary>
+    public int TrackChanges
+    {
+        get
+        {
+            lock (_lock)
+            {
+                CurrentPositionMs();
+                return _trackChanges;
+            }
+        }
+    }
+
+    /// <summary>
+    /// Pause or resume as if another Spotify client did it.
+    /// </summary>
+    public void SetPlaying(bool playing)
+    {
+        lock (_lock)
+        {
+            _positionMs = CurrentPositionMs();
+            _positionUpdated = DateTime.UtcNow;
+            _isPlaying = playing;
+        }
+    }
+
+    public async Task RunAsync(CancellationToken cancellationToken)
+    {
+        using var listener = new HttpListener();
+        listener.Prefixes.Add($"http://localhost:{_port}/");
+        listener.Start();
+
+        using var registration = cancellationToken.Register(() => listener.Stop());
+
+        while (!cancellationToken.IsCancellationRequested)
+        {
+            HttpListenerContext context;
+            try
+            {
+                context = await listener.GetContextAsync();
+            }
+            catch (Exception) when (cancellationToken.IsCancellationRequested)
+            {
+                break;
+            }
+
+            _ = Task.Run(() => HandleAsync(context), cancellationToken);
+        }
+    }
+
+    private async Task HandleAsync(HttpListenerContext context)
+    {
+        Interlocked.Increment(ref _requestCount);
+
+        try
+        {
+            if (_latencyMs > 0)
+            {
+                await Task.Delay(_latencyMs);
+            }
+
+            var request = context.Request;
+            var path = request.Url!.AbsolutePath.TrimEnd('/');
+            var query = request.QueryString;
+            object? body = null;
+            var status = HttpStatusCode.OK;
+
+            if (IsRateLimited())
+            {
+                Interlocked.Increment(ref _rateLimitedCount);
+                context.Response.StatusCode = 429;
+                context.Response.AddHeader("Retry-After", "1");
+                return;
+            }
+
+            lock (_lock)
+            {
+                switch (request.HttpMethod, path)
+                {
+                    case ("GET", "/v1/me/player"):
+                        Interlocked.Increment(ref _playerRequestCount);
+                        body = CurrentPlayback();
+                        break;
+                    case ("PUT", "/v1/me/player/play"):
+                        _positionMs = CurrentPositionMs();
+                        _positionUpdated = DateTime.UtcNow;
+                        _isPlaying = true;
+                        status = HttpStatusCode.NoContent;
+                        break;
+                    case ("PUT", "/v1/me/player/pause"):
+                        _positionMs = CurrentPositionMs();
+                        _isPlaying = false;
+                        status = HttpStatusCode.NoContent;
+                        break;
+                    case ("POST", "/v1/me/player/next"):
+                        ChangeTrack(1);
+                        status = HttpStatusCode.NoContent;
+                        break;
+                    case ("POST", "/v1/me/player/previous"):
+                        ChangeTrack(-1);
+                        status = HttpStatusCode.NoContent;
+                        break;
+                    case ("PUT", "/v1/me/player/volume"):
+                        _volumePercent = int.TryParse(query["volume_percent"], out var volume) ? volume : _volumePercent;
+                        status = HttpStatusCode.NoContent;
+                        break;
+                    case ("PUT", "/v1/me/player/seek"):
+                        _positionMs = int.TryParse(query["position_ms"], out var position) ? position : _positionMs;
+                        _positionUpdated = DateTime.UtcNow;
+                        status = HttpStatusCode.NoContent;
+                        break;
+                    case ("GET", "/v1/me"):
+                        body = new { Id = "stubuser", DisplayName = "Stub User", Type = "user", Uri = "spotify:user:stubuser" };
+                        break;
+                    case ("GET", "/v1/me/playlists"):
+                        Interlocked.Increment(ref _libraryRequestCount);
+                        body = Page(_playlists.Count, i => CreatePlaylist(_playlists[i]), "me/playlists", query);
+                        break;
+                    case ("GET", "/v1/me/albums"):
+                        Interlocked.Increment(ref _libraryRequestCount);
+                        body = Page(_albums.Count, i => CreateSavedAlbum(_albums[i]), "me/albums", query);
+                        break;
+                    case ("GET", _) when path.StartsWith("/v1/playlists/"):
+                        body = _playlists.Count > 0 ? CreatePlaylist(_playlists[0]) : null;
+                        break;
+                    default:
+                        status = HttpStatusCode.NotFound;
+                        break;
+                }
+            }
+
+            context.Response.StatusCode = (int)status;
+            if (body != null)
+            {
+                var json = JsonSerializer.SerializeToUtf8Bytes(body, JsonOptions);
+                context.Response.ContentType = "application/json";
+                context.Response.ContentLength64 = json.Length;
+                await context.Response.OutputStream.WriteAsync(json);
+            }
+        }
+        catch (Exception ex)
+        {
+            Console.WriteLine($"✗ Stub error: {ex.Message}");
+            context.Response.StatusCode = (int)HttpStatusCode.InternalServerError;
+        }
+        finally
+        {
+            context.Response.Close();
+        }
+    }
+
+    // Fixed one-second windows are enough to exercise the backend's Retry-After handling
+    private bool IsRateLimited()
+    {
+        if (_rateLimit <= 0) return false;
+
+        lock (_lock)
+        {
+            var second = DateTime.UtcNow.Ticks / TimeSpan.TicksPerSecond;
+            if (second != _windowStart)
+            {
+                _windowStart = second;
+                _windowRequests = 0;
+            }
+
+            return ++_windowRequests > _rateLimit;
+        }
+    }
+
+    private int CurrentPositionMs()
+    {
+        if (!_isPlaying) return _positionMs;
+
+        var elapsed = (int)(DateTime.UtcNow - _positionUpdated).TotalMilliseconds;
+        var position = _positionMs + elapsed;
+
+        // Roll over to the next track like a real player
+        while (position >= _trackDurationMs)
+        {
+            position -= _trackDurationMs;
+            _trackIndex = (_trackIndex + 1) % TrackCount;
+            _trackChanges++;
+        }
+
+        _positionMs = position;
+        _positionUpdated = DateTime.UtcNow;
+        return position;
+    }
+
+    private void ChangeTrack(int delta)
+    {
+        _trackIndex = (_trackIndex + delta + TrackCount) % TrackCount;
+        _trackChanges++;
+        _positionMs = 0;
+        _positionUpdated = DateTime.UtcNow;
+    }
+
+    private object CurrentPlayback()
+    {
+        var position = CurrentPositionMs();
+
+        return new
+        {
+            Device = new { Id = "stub-device", Name = "Stub Player", Type = "Computer", IsActive = true, VolumePercent = _volumePercent },
+            Timestamp = DateTimeOffset.UtcNow.ToUnixTimeMilliseconds(),
+            ProgressMs = position,
+            IsPlaying = _isPlaying,
+            CurrentlyPlayingType = "track",
+            Item = new
+            {
+                Id = $"stubtrack{_trackIndex:D4}",
+                Name = $"Stub Track {_trackIndex + 1}",
+                Type = "track",
+                Uri = $"spotify:track:stubtrack{_trackIndex:D4}",
+                DurationMs = _trackDurationMs,
+                Artists = new[] { new { Id = "stubartist", Name = "Stub Artist", Type = "artist" } },
+                Album = new
+                {
+                    Id = "stubalbum0000",
+                    Name = "Stub Album",
+                    Images = Array.Empty<object>()
+                }
+            }
+        };
+    }
+
+    private object Page(int total, Func<int, object> create, string path, System.Collections.Specialized.NameValueCollection query)
+    {
+        var offset = int.TryParse(query["offset"], out var o) ? o : 0;
+        var limit = int.TryParse(query["limit"], out var l) ? Math.Min(l, PageLimit) : 20;
+        var pageItems = Enumerable.Range(offset, Math.Max(Math.Min(limit, total - offset), 0)).Select(create).ToList();
+        var hasNext = offset + limit < total;
+
+        return new
+        {
+            Href = $"http://localhost:{_port}/v1/{path}?offset={offset}&limit={limit}",
+            Items = pageItems,
+            Limit = limit,
+            Next = hasNext ? $"http://localhost:{_port}/v1/{path}?offset={offset + limit}&limit={limit}" : null,
+            Offset = offset,
+            Previous = (string?)null,
+            Total = total
+        };
+    }
+
+    // Varied but stable names, so sorting and the dial's letter index see a realistic spread
+    private static readonly string[] NameWords =
+    {
+        "90s", "Acoustic", "Afternoon", "Ambient", "Best of", "Chill", "Coffee", "Dance", "Deep", "Evening",
+        "Focus", "Golden", "Happy", "Indie", "Jazz", "Kitchen", "Late Night", "Morning", "Night Drive",
+        "Old School", "Party", "Quiet", "Road Trip", "Summer", "The", "Throwback", "Upbeat", "Vinyl",
+        "Weekend", "Workout", "Yoga", "Zen"
+    };
+
+    private static readonly string[] NameNouns =
+    {
+        "Classics", "Favourites", "Grooves", "Hits", "Jams", "Mix", "Session", "Songs", "Tunes", "Vibes"
+    };
+
+    private static string StubName(int seed)
+    {
+        var random = new Random(seed);
+        return $"{NameWords[random.Next(NameWords.Length)]} {NameNouns[random.Next(NameNouns.Length)]} {seed % 1_000_000 + 1}";
+    }
+
+    private static object CreatePlaylist((int Index, int Version) playlist) => new
+    {
+        Id = $"stubplaylist{playlist.Index:D5}",
+        Name = StubName(playlist.Index),
+        Description = "Generated by the stub server",
+        Public = true,
+        SnapshotId = $"snapshot{playlist.Index:D5}-{playlist.Version}",
+        Uri = $"spotify:playlist:stubplaylist{playlist.Index:D5}",
+        Type = "playlist",
+        Images = Array.Empty<object>(),
+        Owner = new { Id = "stubuser", DisplayName = "Stub User", Type = "user" },
+        Tracks = new { Total = TrackCount }
+    };
+
+    private static object CreateSavedAlbum(int index) => new
+    {
+        AddedAt = "2024-01-01T00:00:00Z",
+        Album = new
+        {
+            Id = $"stubalbum{index:D5}",
+            Name = StubName(1_000_000 + index),
+            AlbumType = "album",
+            TotalTracks = TrackCount,
+            ReleaseDate = "2024-01-01",
+            Uri = $"spotify:album:stubalbum{index:D5}",
+            Type = "album",
+            Images = Array.Empty<object>(),
+            Artists = new[] { new { Id = "stubartist", Name = "Stub Artist", Type = "artist" } }
+        }
+    };
+}
@@ -0,0 +1,186 @@
+using System.Diagnostics;
+using System.Text;
+using System.Text.Json;
+using MQTTnet;
+using MQTTnet.Client;
+using Spectre.Console;
+
+namespace CLIClient;
+
+partial class Program
+{
+    private static string _traceTopic = "spotidial/trace";
+
+    private static async Task RunStubSpotify(int listenPort, int latencyMs, int playlistCount, int albumCount,
+        int trackSeconds, int rateLimit)
+    {
+        var rule = new Rule("[bold cyan]SpotiDial Stub Spotify API[/]");
+        AnsiConsole.Write(rule);
+
+        var server = new StubSpotifyServer(listenPort, latencyMs, playlistCount, albumCount, trackSeconds * 1000, rateLimit);
+        using var cts = new CancellationTokenSource();
+        Console.CancelKeyPress += (_, e) =>
+        {
+            e.Cancel = true;
+            cts.Cancel();
+        };
+
+        AnsiConsole.MarkupLine($"[green]✓[/] Listening on http://localhost:{listenPort}/v1/ " +
+                               $"(latency {latencyMs} ms, {playlistCount} playlists, {albumCount} albums)");
+        AnsiConsole.MarkupLine($"[dim]Start the backend with SPOTIFY_API_BASE_URL=http://localhost:{listenPort}/v1/[/]");
+        AnsiConsole.MarkupLine("[dim]Press Ctrl+C to stop[/]");
+
+        // Request rate, to compare with the commands sent during a load test
+        _ = Task.Run(async () =>
+        {
+            var last = 0L;
+            while (!cts.IsCancellationRequested)
+            {
+                await Task.Delay(5000);
+                var total = server.RequestCount;
+                if (total != last)
+                {
+                    AnsiConsole.MarkupLine($"[dim]{total} requests ({(total - last) / 5.0:F1}/s)[/]");
+                    last = total;
+                }
+            }
+        });
+
+        await server.RunAsync(cts.Token);
+
+        AnsiConsole.MarkupLine($"[dim]Served {server.RequestCount} requests ({server.RateLimitedCount} rate limited)[/]");
+    }
+
+    /// <summary>
+    /// Act as a device: send traced commands, wait for the status echo and report the timings
+    /// to the trace topic so the backend can fold them into its histograms.
+    /// </summary>
+    private static async Task RunLatencyTrace(string host, int port, string username, string password,
+        string command, string? parameter, int count, int intervalMs)
+    {
+        _brokerHost = host;
+        _brokerPort = port;
+        _username = username;
+        _password = password;
+
+        var rule = new Rule("[bold cyan]SpotiDial Latency Trace[/]");
+        AnsiConsole.Write(rule);
+        AnsiConsole.MarkupLine($"[dim]Connecting to {host}:{port}...[/]");
+
+        try
+        {
+            await ConnectToMqtt();
+
+            TaskCompletionSource<long>? pending = null;
+            string? pendingId = null;
+
+            _mqttClient!.ApplicationMessageReceivedAsync += e =>
+            {
+                if (e.ApplicationMessage.Topic != _statusTopic) return Task.CompletedTask;
+
+                try
+                {
+                    var payload = Encoding.UTF8.GetString(e.ApplicationMessage.PayloadSegment);
+                    var status = JsonSerializer.Deserialize<JsonElement>(payload);
+                    if (status.TryGetProperty("correlationId", out var id) && id.GetString() == pendingId)
+                    {
+                        var backendUs = status.TryGetProperty("backendUs", out var us) ? us.GetInt64() : 0;
+                        pending?.TrySetResult(backendUs);
+                    }
+                }
+                catch (JsonException)
+                {
+                    // Not a status we can read; ignore
+                }
+
+                return Task.CompletedTask;
+            };
+
+            await _mqttClient.SubscribeAsync(new MqttTopicFilterBuilder()
+                .WithTopic(_statusTopic)
+                .Build());
+
+            var roundTrips = new List<double>();
+            var backendTimes = new List<double>();
+            var timeouts = 0;
+            var runId = Guid.NewGuid().ToString("N")[..6];
+
+            for (var i = 0; i < count; i++)
+            {
+                pendingId = $"cli{runId}-{i}";
+                pending = new TaskCompletionSource<long>(TaskCreationOptions.RunContinuationsAsynchronously);
+
+                var json = JsonSerializer.Serialize(new { command, parameter, correlationId = pendingId });
+                var started = Stopwatch.GetTimestamp();
+                await PublishMessage(_commandTopic, json);
+
+                var completed = await Task.WhenAny(pending.Task, Task.Delay(TimeSpan.FromSeconds(10)));
+                if (completed != pending.Task)
+                {
+                    timeouts++;
+                    AnsiConsole.MarkupLine($"[yellow]![/] {pendingId}: no status within 10 s");
+                    continue;
+                }
+
+                var roundTripUs = (long)(Stopwatch.GetElapsedTime(started).TotalMilliseconds * 1000);
+                var backendUs = await pending.Task;
+                roundTrips.Add(roundTripUs / 1000.0);
+                backendTimes.Add(backendUs / 1000.0);
+
+                var report = JsonSerializer.Serialize(new
+                {
+                    correlationId = pendingId,
+                    command,
+                    inputToPublishUs = 0,
+                    publishToStatusUs = roundTripUs,
+                    statusToRenderUs = 0,
+                    backendUs
+                });
+                await PublishMessage(_traceTopic, report);
+
+                if (intervalMs > 0)
+                {
+                    await Task.Delay(intervalMs);
+                }
+            }
+
+            await DisconnectFromMqtt();
+
+            AnsiConsole.WriteLine();
+            var table = new Table();
+            table.Border(TableBorder.Rounded);
+            table.AddColumn(new TableColumn("[bold]Hop[/]").LeftAligned());
+            table.AddColumn(new TableColumn("[bold]n[/]").RightAligned());
+            table.AddColumn(new TableColumn("[bold]p50[/]").RightAligned());
+            table.AddColumn(new TableColumn("[bold]p90[/]").RightAligned());
+            table.AddColumn(new TableColumn("[bold]p99[/]").RightAligned());
+            table.AddColumn(new TableColumn("[bold]max[/]").RightAligned());
+
+            AddLatencyRow(table, "publish -> status", roundTrips);
+            AddLatencyRow(table, "backend", backendTimes);
+            AddLatencyRow(table, "network", roundTrips.Zip(backendTimes, (rt, be) => rt - be).ToList());
+
+            AnsiConsole.Write(table);
+            AnsiConsole.MarkupLine($"[dim]{roundTrips.Count} traced, {timeouts} timed out (times in ms)[/]");
+        }
+        catch (Exception ex)
+        {
+            AnsiConsole.MarkupLine($"[red]✗ Error: {ex.Message}[/]");
+        }
+    }
+
+    private static void AddLatencyRow(Table table, string hop, List<double> samples)
+    {
+        if (samples.Count == 0)
+        {
+            table.AddRow(hop, "0", "-", "-", "-", "-");
+            return;
+        }
+
+        var sorted = samples.OrderBy(s => s).ToList();
+        double Percentile(double p) => sorted[Math.Clamp((int)Math.Ceiling(sorted.Count * p / 100.0) - 1, 0, sorted.Count - 1)];
+
+        table.AddRow(hop, sorted.Count.ToString(),
+            $"{Percentile(50):F1}", $"{Percentile(90):F1}", $"{Percentile(99):F1}", $"{sorted[^1]:F1}");
+    }
+}
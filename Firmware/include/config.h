@@ -27,10 +27,46 @@
 #define MQTT_TOPIC_IMAGE "spotidial/image"
 #define MQTT_TOPIC_PLAYLISTS "spotidial/playlists"
 #define MQTT_TOPIC_ALBUMS "spotidial/albums"
+#define MQTT_TOPIC_PLAYLIST_TABLE "spotidial/playlists/table"
+#define MQTT_TOPIC_ALBUM_TABLE "spotidial/albums/table"
+#define MQTT_TOPIC_TRACE "spotidial/trace"
+#define MQTT_TOPIC_SESSION_PREFIX "spotidial/session/"  // + client id; probes whether the broker kept our session
+#define MQTT_TOPIC_OTA_REQUEST "spotidial/ota/request"
+#define MQTT_TOPIC_OTA_PREFIX "spotidial/ota/"  // + client id + "/offer" or "/data"
+#define MQTT_TOPIC_ENCODING_PREFIX "spotidial/encoding/"  // + client id + "/request" or "/accept"
+#define MQTT_TOPIC_STALL "spotidial/diag/stall"
+#define MQTT_TOPIC_COREDUMP_PREFIX "spotidial/diag/coredump/"  // + client id
+#define MQTT_COMPACT_SUFFIX "/compact"  // Status and list topics in the compact encoding
 
 // MQTT Settings
-#define MQTT_RECONNECT_DELAY 5000
+#define MQTT_RECONNECT_MIN_DELAY 1000   // First retry; doubled after every failed attempt
+#define MQTT_RECONNECT_MAX_DELAY 30000  // Backoff cap. Each wait is jittered between half and all of
+                                        // the current delay so a fleet does not reconnect in lockstep
+#define MQTT_CLEAN_SESSION false        // Keep subscriptions on the broker across reconnects
+#define MQTT_SESSION_PROBE_MS 3000      // Resubscribe if the session probe is not echoed within this
 #define MQTT_KEEPALIVE 60
+#define MQTT_CONNECT_TASK_STACK 8192  // Connects run in their own task so the UI keeps going;
+                                      // a TLS handshake needs the headroom
+
+// MQTT over TLS. The broker CA and public key pin live in mqtt_tls_certs.h,
+// generated by mosquitto/make-certs.sh for mosquitto-tls.conf
+#define MQTT_USE_TLS false
+#define MQTT_TLS_PORT 8883
+#define MQTT_TLS_HANDSHAKE_TIMEOUT_MS 10000
+#define MQTT_TLS_SESSION_RESUME true       // Keep the TLS session in RTC memory for abbreviated handshakes
+#define MQTT_TLS_SESSION_CACHE_SIZE 2048   // Serialized session, including the broker certificate
+
+// Offline command journal: commands issued while the broker is unreachable are
+// coalesced and replayed in order on reconnect, each with a commandId so the
+// backend ignores duplicates
+#define COMMAND_JOURNAL_SIZE 16
+#define COMMAND_JOURNAL_MAX_AGE_MS 300000  // Intents older than 5 minutes are dropped
+#define COMMAND_REPLAY_BURST 4             // Entries published per loop() while replaying
+#define COMMAND_PARAM_LENGTH LIST_ID_LENGTH
+
+// Ask the backend for status and lists in the compact encoding (see compact_reader.h)
+// instead of JSON; we stay on JSON until a backend accepts
+#define MQTT_COMPACT_ENABLE true
 
 // ============================================
 // Display Configuration
@@ -43,12 +79,135 @@
 #define UI_UPDATE_INTERVAL 100
 #define STATUS_UPDATE_INTERVAL 1000
 
+// Screen cache (rendered frames kept in PSRAM for instant switching)
+#define SCREEN_CACHE_ENABLE true
+#define SCREEN_EVICT_AFTER_MS 60000  // Destroy screens not visited for this long
+#define SCREEN_CACHE_SETTLE_MS 300   // Snapshot the shown screen once the panel has been idle this long
+#define SCREEN_CACHE_REFRESH_MS 5000 // and again at most this often while it stays on screen
+
 // ============================================
 // Encoder Configuration
 // ============================================
-#define ENCODER_STEPS_PER_DETENT 4
+// Counted in hardware (PCNT) and sampled by a task on the other core
+#define ENCODER_PIN_A 41
+#define ENCODER_PIN_B 40               // Swap A and B if turning is reversed
+#define ENCODER_STEPS_PER_DETENT 4     // Quadrature counts per click
+#define ENCODER_GLITCH_FILTER 1000     // Ignore pulses shorter than this many APB cycles (max 1023)
+#define ENCODER_SAMPLE_INTERVAL_MS 1
+#define ENCODER_SAMPLE_TASK_STACK 2048
+#define ENCODER_IDLE_RESET_MS 150      // A pause this long starts acceleration over
+
+// Acceleration: every click is one step up to SLOW_DPS (detents per second),
+// then the gain rises to MAX_GAIN at FAST_DPS
 #define ENCODER_VOLUME_STEP 5  // Volume change per encoder step
-#define ENCODER_DEBOUNCE_MS 50
+#define ENCODER_VOLUME_SLOW_DPS 8
+#define ENCODER_VOLUME_FAST_DPS 30
+#define ENCODER_VOLUME_MAX_GAIN 4
+#define ENCODER_LIST_SLOW_DPS 6
+#define ENCODER_LIST_FAST_DPS 30
+#define ENCODER_LIST_MAX_GAIN 12
+#define ENCODER_SEEK_STEP_MS 5000  // Press and turn on Now Playing scrubs; sent on release
+#define ENCODER_SEEK_SLOW_DPS 6
+#define ENCODER_SEEK_FAST_DPS 30
+#define ENCODER_SEEK_MAX_GAIN 6
+
+// ============================================
+// Power Management
+// ============================================
+// Untouched, the dial dims and then, while paused, blanks: backlight and panel
+// off, rendering suspended, CPU slowed and WiFi in max modem sleep. Input or a
+// track/play state change wakes it with the last frame restored from the cache
+#define POWER_ENABLE true
+#define POWER_BRIGHTNESS_ACTIVE 128
+#define POWER_BRIGHTNESS_DIM 16
+#define POWER_DIM_AFTER_MS 30000
+#define POWER_BLANK_AFTER_MS 120000   // Only while paused; playing stays dimmed
+#define POWER_CPU_MHZ_ACTIVE 240
+#define POWER_CPU_MHZ_BLANK 80        // Lowest clock that keeps WiFi running
+#define POWER_WIFI_LISTEN_INTERVAL 3  // Beacons between wakes in modem sleep; keep it a multiple of the AP's DTIM period
+
+// ============================================
+// Touch Configuration
+// ============================================
+#define TOUCH_INT_PIN 14  // FT3267 interrupt line on the M5Dial
+#define BUTTON_PIN 42     // Dial button, low while pressed
+
+// ============================================
+// List Configuration
+// ============================================
+#define LIST_MAX_ITEMS 64
+#define LIST_ID_LENGTH 32  // Spotify IDs are 22 characters
+#define LIST_NAME_ARENA_BYTES 4096  // Names of a compact list until the roller has copied them
+
+// Large libraries arrive as a sorted, front-coded name table (see name_table.h).
+// Only the rows around the selection are decoded into the roller
+#define LIST_WINDOW_ROWS 9                  // Rows given to the roller at a time
+#define NAME_TABLE_MAX_BYTES (512 * 1024)   // Larger tables are rejected
+#define NAME_TABLE_NAME_LENGTH 256          // Names are at most 255 bytes on the wire
+
+// ============================================
+// Album Art
+// ============================================
+// The status carries a few dozen bytes of colour preview, drawn at once and
+// scaled up; the full cover is decoded over it and faded in when it arrives
+#define ART_SIZE 120              // Album art widget on Now Playing, square
+#define ART_SOURCE_SIZE 240       // Covers as processed by the backend
+#define ART_CROSSFADE_MS 300
+#define ART_PREVIEW_MAX_GRID 8    // Matches the backend's MaxPreviewGrid
+
+// ============================================
+// Latency Tracing
+// ============================================
+// Commands carry a correlation id; the backend echoes it in the status it
+// publishes and per-hop timings are reported back on MQTT_TOPIC_TRACE
+#define TRACE_ENABLE true
+#define TRACE_SLOTS 4                 // Commands traced concurrently
+#define TRACE_INPUT_MAX_AGE_MS 1000   // Ignore inputs that did not lead to a command
+#define TRACE_STATUS_TIMEOUT_MS 5000  // Give up waiting for the status echo
+#define TRACE_RENDER_TIMEOUT_MS 500   // Status did not change anything on screen
+
+// ============================================
+// Diagnostics
+// ============================================
+// The Settings screen shows render, loop, memory and network figures. Nothing
+// is sampled while it is not on screen
+#define PERF_HUD_ENABLE true
+#define PERF_HUD_INTERVAL_MS 1000    // Refresh and measurement window
+#define PERF_LOOP_BUCKET_US 250      // Loop time histogram resolution
+#define PERF_LOOP_BUCKETS 64         // Longer loops land in the last bucket
+
+// ============================================
+// Stall Watchdog
+// ============================================
+// loop() marks each subsystem step; a timer interrupt on the loop core takes a
+// backtrace of a step running longer than STALL_THRESHOLD_MS. Stalls, and the
+// step and core dump of a panic or watchdog reset, are kept in an NVS ring and
+// uploaded on MQTT_TOPIC_STALL once connected
+#define STALL_ENABLE true
+#define STALL_THRESHOLD_MS 250        // A step taking longer is a stall
+#define STALL_CHECK_MS 50             // Timer period; backtraces are taken this late at most
+#define STALL_TIMER 3                 // Hardware timer, 0-3 on the ESP32-S3
+#define STALL_BACKTRACE_DEPTH 24      // Frames, including the few of the interrupt itself
+#define STALL_RING_SIZE 16            // Records kept until uploaded; the oldest are overwritten
+#define STALL_RECORD_INTERVAL_MS 10000  // Per step; more stalls within it are only counted
+#define STALL_COREDUMP_CHUNK_BYTES 1024 // Core dump bytes per MQTT message
+
+// ============================================
+// Firmware Updates
+// ============================================
+// The backend offers a patch against the running image (a full image when it
+// does not have ours). It is fetched in windows of CRC-checked chunks and
+// patched straight into the inactive app slot; an interrupted update resumes
+// at the last completed 64 KB block, even after a reboot. The new image runs
+// on trial and is rolled back unless it stays connected to the broker for
+// OTA_VERIFY_AFTER_MS within OTA_TRIAL_BOOTS boots
+#define OTA_ENABLE true
+#define OTA_WINDOW_BYTES 8192        // Requested at a time, arrives in several chunks
+#define OTA_CHUNK_TIMEOUT_MS 5000    // Ask for the rest of the window again after this
+#define OTA_MAX_RETRIES 5            // Timeouts or bad chunks in a row before giving up
+#define OTA_TRIAL_BOOTS 3
+#define OTA_VERIFY_AFTER_MS 30000
+#define OTA_RESTART_DELAY_MS 1000    // Lets the result reach the broker before restarting
 
 // ============================================
 // Application Settings
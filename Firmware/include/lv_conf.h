@@ -53,6 +53,9 @@
 // Animation
 #define LV_USE_ANIMATION 1
 
+// Extra components
+#define LV_USE_SNAPSHOT 1  // Used by the screen cache to keep rendered frames
+
 // Logging
 #define LV_USE_LOG 1
 #define LV_LOG_LEVEL LV_LOG_LEVEL_WARN
@@ -9,4 +9,21 @@
  */
 bool lv_display_init();
 
+/**
+ * Push a pre-rendered block of pixels straight to the panel, bypassing LVGL.
+ * Used to show a cached frame while LVGL redraws the live object tree.
+ */
+void lv_display_blit(const lv_area_t* area, const lv_color_t* pixels);
+
+/**
+ * Number of flushes completed since boot
+ * Lets callers detect when the first pixels of a new frame reached the panel
+ */
+uint32_t lv_display_flush_count();
+
+/**
+ * Total time spent writing pixels to the panel since boot
+ */
+uint64_t lv_display_flush_us();
+
 #endif // LV_DISPLAY_H
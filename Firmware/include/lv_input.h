@@ -0,0 +1,33 @@
+#ifndef LV_INPUT_H
+#define LV_INPUT_H
+
+#include <lvgl.h>
+
+/**
+ * Register the touch panel and encoder as LVGL input devices
+ * Must be called after lv_display_init()
+ */
+bool lv_input_init();
+
+/**
+ * Feed encoder rotation and clicks to the LVGL encoder device
+ */
+void lv_input_encoder_feed(int delta);
+void lv_input_encoder_click();
+
+/**
+ * Group that receives encoder focus and selection
+ */
+lv_group_t* lv_input_group();
+
+/**
+ * Drop the touch in progress: reported as released until the finger lifts
+ */
+void lv_input_discard_touch();
+
+/**
+ * Time (micros) of the most recent touch interrupt
+ */
+unsigned long lv_input_last_touch_us();
+
+#endif // LV_INPUT_H
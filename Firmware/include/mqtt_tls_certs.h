@@ -0,0 +1,18 @@
+#ifndef MQTT_TLS_CERTS_H
+#define MQTT_TLS_CERTS_H
+
+// Trust anchors for MQTT over TLS (MQTT_USE_TLS in config.h).
+// Regenerate with mosquitto/make-certs.sh <broker host or IP>.
+
+// CA that signed the broker certificate (mosquitto/config/certs/ca.crt)
+static const char MQTT_TLS_CA_CERT[] = R"PEM(
+-----BEGIN CERTIFICATE-----
+Replace with the output of mosquitto/make-certs.sh
+-----END CERTIFICATE-----
+)PEM";
+
+// SHA-256 of the broker's public key (SubjectPublicKeyInfo) as hex.
+// Empty trusts any certificate the CA signed for MQTT_BROKER.
+#define MQTT_TLS_PIN_SHA256 ""
+
+#endif // MQTT_TLS_CERTS_H
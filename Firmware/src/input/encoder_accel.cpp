@@ -0,0 +1,57 @@
+#include "encoder_accel.h"
+
+EncoderAccel::EncoderAccel(uint32_t idleResetUs)
+    : _idleResetUs(idleResetUs),
+      _lastUs(0),
+      _lastDirection(0),
+      _velocity(0) {
+}
+
+void EncoderAccel::reset() {
+    _lastDirection = 0;
+    _velocity = 0;
+}
+
+void EncoderAccel::addDetent(uint32_t timeUs, int direction) {
+    int8_t dir = direction > 0 ? 1 : -1;
+    uint32_t elapsedUs = timeUs - _lastUs;
+    _lastUs = timeUs;
+
+    // Reversing or picking the knob up again is a fresh, slow start
+    if (dir != _lastDirection || elapsedUs > _idleResetUs) {
+        _lastDirection = dir;
+        _velocity = 0;
+        return;
+    }
+
+    // Average with the previous estimate so one short gap does not spike the gain
+    uint32_t instant = elapsedUs > 0 ? 1000000UL / elapsedUs : 1000000UL;
+    if (instant > UINT16_MAX) instant = UINT16_MAX;
+    _velocity = (uint16_t)((_velocity + instant) / 2);
+}
+
+uint16_t EncoderAccel::gainX16(uint16_t velocity, const AccelCurve& curve) {
+    const uint32_t unity = 16;
+    uint32_t maxGain = curve.maxGain > 1 ? curve.maxGain * unity : unity;
+
+    if (velocity <= curve.slowDps || curve.fastDps <= curve.slowDps) return unity;
+    if (velocity >= curve.fastDps) return maxGain;
+
+    uint32_t num = velocity - curve.slowDps;
+    uint32_t den = curve.fastDps - curve.slowDps;
+    return (uint16_t)(unity + (maxGain - unity) * num * num / (den * den));
+}
+
+int AccelAxis::steps(int detents, uint16_t velocity) {
+    if (detents == 0) return 0;
+
+    // Leftovers from the other direction do not count
+    if ((detents > 0) != (_carryX16 > 0) && _carryX16 != 0) {
+        _carryX16 = 0;
+    }
+
+    _carryX16 += (int32_t)detents * EncoderAccel::gainX16(velocity, _curve);
+    int result = _carryX16 / 16;
+    _carryX16 -= result * 16;
+    return result;
+}
@@ -0,0 +1,56 @@
+#ifndef ENCODER_ACCEL_H
+#define ENCODER_ACCEL_H
+
+#include <stdint.h>
+
+// Gain as a function of speed: 1 up to slowDps, rising with the square of the
+// speed to maxGain at fastDps (detents per second)
+struct AccelCurve {
+    uint16_t slowDps;
+    uint16_t fastDps;
+    uint8_t maxGain;
+};
+
+/**
+ * Angular velocity of the encoder, estimated from detent timestamps.
+ * Plain C++ without Arduino dependencies so it builds on the host.
+ */
+class EncoderAccel {
+public:
+    // A pause longer than idleResetUs, or a change of direction, starts from rest
+    explicit EncoderAccel(uint32_t idleResetUs);
+
+    void addDetent(uint32_t timeUs, int direction);
+    void reset();
+
+    // Smoothed speed in detents per second, 0 when turning slowly or just started
+    uint16_t velocity() const { return _velocity; }
+
+    // Gain for a speed in 1/16 steps; 16 is 1:1
+    static uint16_t gainX16(uint16_t velocity, const AccelCurve& curve);
+
+private:
+    uint32_t _idleResetUs;
+    uint32_t _lastUs;
+    int8_t _lastDirection;
+    uint16_t _velocity;
+};
+
+/**
+ * Turns detents into steps for one control (volume, list, seek) with its own
+ * curve. The fractional part is carried, so slow turns stay exactly 1:1 and
+ * nothing is lost to rounding at speed.
+ */
+class AccelAxis {
+public:
+    explicit AccelAxis(const AccelCurve& curve) : _curve(curve), _carryX16(0) {}
+
+    int steps(int detents, uint16_t velocity);
+    void reset() { _carryX16 = 0; }
+
+private:
+    AccelCurve _curve;
+    int32_t _carryX16;
+};
+
+#endif // ENCODER_ACCEL_H
@@ -0,0 +1,125 @@
+#include "encoder_input.h"
+#include <driver/pcnt.h>
+
+#define ENCODER_PCNT_UNIT PCNT_UNIT_0
+
+// Clear the counter well before it reaches its 16-bit limit
+#define ENCODER_COUNT_RECENTER 8192
+
+EncoderInput::EncoderInput()
+    : _accel(ENCODER_IDLE_RESET_MS * 1000UL),
+      _pending{0, 0, 0},
+      _lastCount(0),
+      _remainder(0),
+      _lastSampleUs(0) {
+}
+
+bool EncoderInput::begin() {
+    // Full quadrature: both channels count on both edges of their pin, with
+    // the other pin deciding the direction
+    pcnt_config_t config = {};
+    config.pulse_gpio_num = ENCODER_PIN_A;
+    config.ctrl_gpio_num = ENCODER_PIN_B;
+    config.unit = ENCODER_PCNT_UNIT;
+    config.channel = PCNT_CHANNEL_0;
+    config.pos_mode = PCNT_COUNT_DEC;
+    config.neg_mode = PCNT_COUNT_INC;
+    config.lctrl_mode = PCNT_MODE_REVERSE;
+    config.hctrl_mode = PCNT_MODE_KEEP;
+    config.counter_h_lim = INT16_MAX;
+    config.counter_l_lim = INT16_MIN;
+
+    if (pcnt_unit_config(&config) != ESP_OK) {
+        Serial.println("Failed to configure encoder counter");
+        return false;
+    }
+
+    config.pulse_gpio_num = ENCODER_PIN_B;
+    config.ctrl_gpio_num = ENCODER_PIN_A;
+    config.channel = PCNT_CHANNEL_1;
+    config.pos_mode = PCNT_COUNT_INC;
+    config.neg_mode = PCNT_COUNT_DEC;
+
+    if (pcnt_unit_config(&config) != ESP_OK) {
+        Serial.println("Failed to configure encoder counter");
+        return false;
+    }
+
+    // The counter config leaves the pins floating; the encoder switches to ground
+    gpio_pullup_en((gpio_num_t)ENCODER_PIN_A);
+    gpio_pullup_en((gpio_num_t)ENCODER_PIN_B);
+
+    pcnt_set_filter_value(ENCODER_PCNT_UNIT, ENCODER_GLITCH_FILTER);
+    pcnt_filter_enable(ENCODER_PCNT_UNIT);
+
+    pcnt_counter_pause(ENCODER_PCNT_UNIT);
+    pcnt_counter_clear(ENCODER_PCNT_UNIT);
+    pcnt_counter_resume(ENCODER_PCNT_UNIT);
+
+    _lastSampleUs = micros();
+
+    if (xTaskCreatePinnedToCore(sampleTask, "encoder", ENCODER_SAMPLE_TASK_STACK,
+                                this, 2, nullptr, 0) != pdPASS) {
+        Serial.println("Failed to start encoder task");
+        return false;
+    }
+
+    Serial.printf("Encoder: PCNT on GPIO %d/%d, sampled every %d ms\n",
+                  ENCODER_PIN_A, ENCODER_PIN_B, ENCODER_SAMPLE_INTERVAL_MS);
+    return true;
+}
+
+void EncoderInput::sampleTask(void* arg) {
+    EncoderInput* self = static_cast<EncoderInput*>(arg);
+
+    while (true) {
+        self->sample();
+        vTaskDelay(pdMS_TO_TICKS(ENCODER_SAMPLE_INTERVAL_MS));
+    }
+}
+
+void EncoderInput::sample() {
+    int16_t count = 0;
+    pcnt_get_counter_value(ENCODER_PCNT_UNIT, &count);
+    unsigned long nowUs = micros();
+    unsigned long sinceUs = _lastSampleUs;
+    _lastSampleUs = nowUs;
+
+    int delta = count - _lastCount;
+    _lastCount = count;
+
+    if (count > ENCODER_COUNT_RECENTER || count < -ENCODER_COUNT_RECENTER) {
+        pcnt_counter_clear(ENCODER_PCNT_UNIT);
+        _lastCount = 0;
+    }
+
+    if (delta == 0) return;
+
+    _remainder += delta;
+    int detents = _remainder / ENCODER_STEPS_PER_DETENT;
+    _remainder -= detents * ENCODER_STEPS_PER_DETENT;
+    if (detents == 0) return;
+
+    // Detents that landed in the same sample are spread over its interval,
+    // otherwise they would look infinitely fast
+    int direction = detents > 0 ? 1 : -1;
+    int n = abs(detents);
+    for (int i = 1; i <= n; i++) {
+        _accel.addDetent(sinceUs + (nowUs - sinceUs) * i / n, direction);
+    }
+
+    portENTER_CRITICAL(&_lock);
+    _pending.detents += detents;
+    _pending.velocity = _accel.velocity();
+    _pending.timeUs = nowUs;
+    portEXIT_CRITICAL(&_lock);
+}
+
+bool EncoderInput::poll(EncoderIntent& intent) {
+    portENTER_CRITICAL(&_lock);
+    intent = _pending;
+    _pending.detents = 0;
+    portEXIT_CRITICAL(&_lock);
+
+    return intent.detents != 0;
+}
@@ -0,0 +1,43 @@
+#ifndef ENCODER_INPUT_H
+#define ENCODER_INPUT_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "encoder_accel.h"
+
+// Rotation collected since the last poll
+struct EncoderIntent {
+    int detents;           // Signed, before acceleration
+    uint16_t velocity;     // Detents per second at the last detent
+    unsigned long timeUs;  // When the last detent was seen
+};
+
+/**
+ * Encoder input counted by the PCNT peripheral and sampled by a task on the
+ * other core, so rotation is neither lost nor mistimed while the loop draws.
+ * Every detent is timestamped for the velocity estimate; the loop polls the
+ * accumulated intent and applies the acceleration curve of whatever it controls.
+ */
+class EncoderInput {
+public:
+    EncoderInput();
+
+    bool begin();
+
+    // Take the rotation since the last call; false if there was none
+    bool poll(EncoderIntent& intent);
+
+private:
+    static void sampleTask(void* arg);
+    void sample();
+
+    EncoderAccel _accel;
+    portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED;
+    EncoderIntent _pending;
+
+    int16_t _lastCount;
+    int _remainder;  // Counts short of a full detent
+    unsigned long _lastSampleUs;
+};
+
+#endif // ENCODER_INPUT_H
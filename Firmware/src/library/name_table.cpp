@@ -0,0 +1,228 @@
+#include "name_table.h"
+#include <esp_heap_caps.h>
+
+// Table layout (little-endian), written by the backend's NameTableEncoder
+#define NAME_TABLE_MAGIC "SDNT"
+#define NAME_TABLE_FORMAT 1
+#define NAME_TABLE_HEADER_SIZE (8 + NAME_TABLE_BUCKETS * 2)
+
+// Every chunk starts with the table version, the chunk offset and the table size
+#define NAME_TABLE_CHUNK_HEADER 12
+
+NameTable::NameTable()
+    : _data(nullptr),
+      _size(0),
+      _version(0),
+      _count(0),
+      _restartInterval(1),
+      _restarts(nullptr),
+      _entries(nullptr),
+      _entriesSize(0),
+      _pending(nullptr),
+      _pendingSize(0),
+      _pendingReceived(0),
+      _pendingVersion(0),
+      _pendingStartMs(0) {
+}
+
+NameTable::~NameTable() {
+    heap_caps_free(_data);
+    heap_caps_free(_pending);
+}
+
+bool NameTable::addChunk(const uint8_t* data, size_t length) {
+    if (length < NAME_TABLE_CHUNK_HEADER) return false;
+
+    uint32_t version = read32(data);
+    uint32_t offset = read32(data + 4);
+    uint32_t total = read32(data + 8);
+    data += NAME_TABLE_CHUNK_HEADER;
+    length -= NAME_TABLE_CHUNK_HEADER;
+
+    if (offset == 0) {
+        // Browsing again republishes the same table; keep the one we have
+        if (ready() && version == _version) return false;
+
+        if (total < NAME_TABLE_HEADER_SIZE || total > NAME_TABLE_MAX_BYTES) {
+            Serial.printf("Name table %08lx rejected: %lu bytes\n", (unsigned long)version, (unsigned long)total);
+            return false;
+        }
+
+        heap_caps_free(_pending);
+        _pending = allocate(total);
+        if (!_pending) {
+            Serial.printf("Name table: failed to allocate %lu bytes\n", (unsigned long)total);
+            return false;
+        }
+        _pendingSize = total;
+        _pendingReceived = 0;
+        _pendingVersion = version;
+        _pendingStartMs = millis();
+    }
+
+    // Chunks arrive in order; after a gap wait for the next table
+    if (!_pending || version != _pendingVersion || offset != _pendingReceived ||
+        length > _pendingSize - _pendingReceived) {
+        return false;
+    }
+
+    memcpy(_pending + _pendingReceived, data, length);
+    _pendingReceived += length;
+    if (_pendingReceived < _pendingSize) return false;
+
+    if (!validate(_pending, _pendingSize)) {
+        Serial.printf("Name table %08lx is malformed, ignored\n", (unsigned long)_pendingVersion);
+        heap_caps_free(_pending);
+        _pending = nullptr;
+        return false;
+    }
+
+    unsigned long elapsedMs = millis() - _pendingStartMs;
+    activate();
+
+    Serial.printf("Name table %08lx: %u names, %lu bytes (%lu per name), received in %lu ms\n",
+                  (unsigned long)_version, _count, (unsigned long)_size,
+                  (unsigned long)(_size / max<uint16_t>(_count, 1)), elapsedMs);
+    return true;
+}
+
+uint8_t* NameTable::allocate(size_t size) {
+    // Tables for large libraries run to tens of kilobytes; internal RAM is the fallback
+    uint8_t* data = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!data) {
+        data = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+    return data;
+}
+
+bool NameTable::validate(const uint8_t* data, size_t size) const {
+    if (memcmp(data, NAME_TABLE_MAGIC, 4) != 0 || data[4] != NAME_TABLE_FORMAT || data[5] == 0) {
+        return false;
+    }
+
+    uint16_t count = read16(data + 6);
+    size_t restarts = (count + data[5] - 1) / data[5];
+    size_t entriesStart = NAME_TABLE_HEADER_SIZE + restarts * 4;
+    if (entriesStart > size) return false;
+
+    // Buckets never decrease and never point past the end
+    uint16_t previous = 0;
+    for (uint8_t b = 0; b < NAME_TABLE_BUCKETS; b++) {
+        uint16_t start = read16(data + 8 + b * 2);
+        if (start < previous || start > count) return false;
+        previous = start;
+    }
+
+    // Entries themselves are bounds-checked as they are decoded
+    for (size_t r = 0; r < restarts; r++) {
+        if (read32(data + NAME_TABLE_HEADER_SIZE + r * 4) >= size - entriesStart) return false;
+    }
+
+    return true;
+}
+
+void NameTable::activate() {
+    heap_caps_free(_data);
+
+    _data = _pending;
+    _size = _pendingSize;
+    _version = _pendingVersion;
+    _count = read16(_data + 6);
+    _restartInterval = _data[5];
+    _restarts = _data + NAME_TABLE_HEADER_SIZE;
+    _entries = _restarts + ((_count + _restartInterval - 1) / _restartInterval) * 4;
+    _entriesSize = _size - (_entries - _data);
+
+    _pending = nullptr;
+}
+
+bool NameTable::seek(Cursor& cursor, uint16_t index) const {
+    if (!_data || index >= _count) return false;
+
+    uint16_t restart = index / _restartInterval;
+    cursor.index = restart * _restartInterval;
+    cursor.offset = read32(_restarts + restart * 4);
+    cursor.name[0] = '\0';
+    if (!decode(cursor)) return false;
+
+    while (cursor.index < index) {
+        if (!next(cursor)) return false;
+    }
+    return true;
+}
+
+bool NameTable::next(Cursor& cursor) const {
+    if (!_data || cursor.index + 1 >= _count) return false;
+
+    cursor.index++;
+    return decode(cursor);
+}
+
+// Decode the entry at cursor.offset on top of the previous name
+bool NameTable::decode(Cursor& cursor) const {
+    const uint8_t* p = _entries + cursor.offset;
+    const uint8_t* end = _entries + _entriesSize;
+
+    if (end - p < 2) return false;
+    uint8_t shared = p[0];
+    uint8_t suffix = p[1];
+    p += 2;
+
+    if (shared > strlen(cursor.name) || shared + suffix >= NAME_TABLE_NAME_LENGTH ||
+        end - p < suffix + 1) {
+        return false;
+    }
+    memcpy(cursor.name + shared, p, suffix);
+    cursor.name[shared + suffix] = '\0';
+    p += suffix;
+
+    uint8_t idLength = *p++;
+    if (end - p < idLength) return false;
+    size_t copied = min<size_t>(idLength, LIST_ID_LENGTH - 1);
+    memcpy(cursor.id, p, copied);
+    cursor.id[copied] = '\0';
+    p += idLength;
+
+    cursor.offset = p - _entries;
+    return true;
+}
+
+bool NameTable::idAt(uint16_t index, char* id, size_t size) const {
+    Cursor cursor;
+    if (!seek(cursor, index)) return false;
+
+    strlcpy(id, cursor.id, size);
+    return true;
+}
+
+uint16_t NameTable::bucketStart(uint8_t bucket) const {
+    if (!_data) return 0;
+    return bucket < NAME_TABLE_BUCKETS ? read16(_data + 8 + bucket * 2) : _count;
+}
+
+uint8_t NameTable::bucketOf(uint16_t index) const {
+    // Empty letters share the start of the next one, so take the last match
+    for (int b = NAME_TABLE_BUCKETS - 1; b > 0; b--) {
+        if (bucketStart(b) <= index) return b;
+    }
+    return 0;
+}
+
+uint16_t NameTable::jump(uint16_t index, int direction) const {
+    if (!_data || _count == 0) return 0;
+
+    uint8_t bucket = bucketOf(index);
+
+    if (direction > 0) {
+        for (uint8_t b = bucket + 1; b < NAME_TABLE_BUCKETS; b++) {
+            uint16_t start = bucketStart(b);
+            if (start > index && start < _count) return start;
+        }
+        return index;
+    }
+
+    // Back to the top of the current letter first, then to the previous letter
+    uint16_t start = bucketStart(bucket);
+    if (index > start || start == 0) return start;
+    return bucketStart(bucketOf(start - 1));
+}
@@ -0,0 +1,84 @@
+#ifndef NAME_TABLE_H
+#define NAME_TABLE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Jump buckets: '#' for names not starting with a letter, then A to Z
+#define NAME_TABLE_BUCKETS 27
+
+/**
+ * Sorted, front-coded playlist or album names sent by the backend (see
+ * NameTableEncoder there for the layout), kept in PSRAM as received.
+ * Nothing is expanded up front: rows are decoded on demand starting from the
+ * nearest restart point, and the letter index gives the first row of every
+ * bucket, so jumping to the next letter costs the same for 50 or 5,000 names.
+ *
+ * The table arrives in chunks; the one being received is assembled in a
+ * second buffer so the list stays usable until it is complete.
+ */
+class NameTable {
+public:
+    // One decoded row; next() reuses the previous name for the shared prefix
+    struct Cursor {
+        uint16_t index;
+        uint32_t offset;  // Of the next entry, relative to the first one
+        char name[NAME_TABLE_NAME_LENGTH];
+        char id[LIST_ID_LENGTH];
+    };
+
+    NameTable();
+    ~NameTable();
+
+    // Add one MQTT chunk; true when it completed a new table
+    bool addChunk(const uint8_t* data, size_t length);
+
+    bool ready() const { return _data != nullptr; }
+    uint16_t count() const { return _count; }
+    size_t bytes() const { return _size; }
+    uint32_t version() const { return _version; }
+
+    // Decode row index into the cursor, walking at most restartInterval - 1 entries
+    bool seek(Cursor& cursor, uint16_t index) const;
+    bool next(Cursor& cursor) const;
+
+    // Id of one row, for selecting it
+    bool idAt(uint16_t index, char* id, size_t size) const;
+
+    // Letter index
+    uint8_t bucketOf(uint16_t index) const;
+    uint16_t bucketStart(uint8_t bucket) const;
+    static char bucketLabel(uint8_t bucket) { return bucket == 0 ? '#' : 'A' + bucket - 1; }
+
+    // First row of the next (direction > 0) or previous non-empty letter
+    uint16_t jump(uint16_t index, int direction) const;
+
+private:
+    uint8_t* allocate(size_t size);
+    bool decode(Cursor& cursor) const;
+    bool validate(const uint8_t* data, size_t size) const;
+    void activate();
+    static uint16_t read16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+    static uint32_t read32(const uint8_t* p) {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    // Active table
+    uint8_t* _data;
+    size_t _size;
+    uint32_t _version;
+    uint16_t _count;
+    uint8_t _restartInterval;
+    const uint8_t* _restarts;
+    const uint8_t* _entries;
+    size_t _entriesSize;
+
+    // Table being received
+    uint8_t* _pending;
+    size_t _pendingSize;
+    size_t _pendingReceived;
+    uint32_t _pendingVersion;
+    unsigned long _pendingStartMs;
+};
+
+#endif // NAME_TABLE_H
@@ -6,18 +6,19 @@
 static lv_disp_draw_buf_t draw_buf;
 static lv_color_t buf[DISPLAY_WIDTH * DISPLAY_HEIGHT / 10];
 
-// LVGL display driver callback
-static void display_flush_cb(lv_disp_drv_t* disp_drv, const lv_area_t* area,
-                             lv_color_t* color_p) {
-    uint32_t w = (area->x2 - area->x1 + 1);
-    uint32_t h = (area->y2 - area->y1 + 1);
+// Completed flushes (read by the UI to measure time to first pixel)
+static volatile uint32_t flush_count = 0;
+static uint64_t flush_us = 0;
 
+// Write a block of LVGL pixels to the panel
+static void write_pixels(int32_t x, int32_t y, uint32_t w, uint32_t h,
+                         const lv_color_t* color_p) {
     // Get M5Dial display instance
     auto& display = M5.Lcd;
 
     // Set the drawing area
     display.startWrite();
-    display.setAddrWindow(area->x1, area->y1, w, h);
+    display.setAddrWindow(x, y, w, h);
 
     // Write pixel data
     uint32_t pixel_count = w * h;
@@ -27,6 +28,18 @@ static void display_flush_cb(lv_disp_drv_t* disp_drv, const lv_area_t* area,
         display.pushColor(color, 1);
     }
     display.endWrite();
+}
+
+// LVGL display driver callback
+static void display_flush_cb(lv_disp_drv_t* disp_drv, const lv_area_t* area,
+                             lv_color_t* color_p) {
+    uint32_t w = (area->x2 - area->x1 + 1);
+    uint32_t h = (area->y2 - area->y1 + 1);
+
+    unsigned long start_us = micros();
+    write_pixels(area->x1, area->y1, w, h, color_p);
+    flush_us += micros() - start_us;
+    flush_count++;
 
     // Flush complete
     lv_disp_flush_ready(disp_drv);
@@ -54,3 +67,34 @@ bool lv_display_init() {
 
     return true;
 }
+
+void lv_display_blit(const lv_area_t* area, const lv_color_t* pixels) {
+    uint32_t w = lv_area_get_width(area);
+
+    // Clip rows and columns that fall outside the panel
+    int32_t x1 = LV_MAX(area->x1, 0);
+    int32_t x2 = LV_MIN(area->x2, DISPLAY_WIDTH - 1);
+    int32_t y1 = LV_MAX(area->y1, 0);
+    int32_t y2 = LV_MIN(area->y2, DISPLAY_HEIGHT - 1);
+    if (x1 > x2 || y1 > y2) return;
+
+    uint32_t clippedW = x2 - x1 + 1;
+    const lv_color_t* row = pixels + (y1 - area->y1) * w + (x1 - area->x1);
+
+    if (clippedW == w) {
+        write_pixels(x1, y1, clippedW, y2 - y1 + 1, row);
+        return;
+    }
+
+    for (int32_t y = y1; y <= y2; y++, row += w) {
+        write_pixels(x1, y, clippedW, 1, row);
+    }
+}
+
+uint32_t lv_display_flush_count() {
+    return flush_count;
+}
+
+uint64_t lv_display_flush_us() {
+    return flush_us;
+}
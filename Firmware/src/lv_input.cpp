@@ -0,0 +1,109 @@
+#include "lv_input.h"
+#include <M5Dial.h>
+#include <lvgl.h>
+#include "config.h"
+
+static lv_group_t* input_group = nullptr;
+
+// Touch state (the interrupt only marks that the controller has new data)
+static volatile bool touch_irq = false;
+static volatile unsigned long touch_irq_us = 0;
+static bool touch_down = false;
+static bool touch_discard = false;   // Finger that woke the dial, ignored until lifted
+static lv_point_t touch_point = {0, 0};
+
+// Encoder state fed from the main loop
+static int enc_diff = 0;
+static int enc_clicks = 0;
+static bool enc_pressed = false;
+
+static void IRAM_ATTR touch_isr() {
+    touch_irq = true;
+    touch_irq_us = micros();
+}
+
+// LVGL touch read callback
+static void touch_read_cb(lv_indev_drv_t* drv, lv_indev_data_t* data) {
+    // Only talk to the controller after it raised its interrupt, or while a
+    // finger is down so the release is not missed
+    if (touch_irq || touch_down || touch_discard) {
+        touch_irq = false;
+
+        lgfx::touch_point_t tp;
+        if (M5.Lcd.getTouch(&tp, 1)) {
+            touch_down = !touch_discard;
+            touch_point.x = tp.x;
+            touch_point.y = tp.y;
+        } else {
+            touch_down = false;
+            touch_discard = false;
+        }
+    }
+
+    data->point = touch_point;
+    data->state = touch_down ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+}
+
+// LVGL encoder read callback
+static void encoder_read_cb(lv_indev_drv_t* drv, lv_indev_data_t* data) {
+    data->enc_diff = enc_diff;
+    enc_diff = 0;
+
+    // Each click is reported as one press followed by one release
+    if (enc_pressed) {
+        enc_pressed = false;
+        data->state = LV_INDEV_STATE_RELEASED;
+    } else if (enc_clicks > 0) {
+        enc_clicks--;
+        enc_pressed = true;
+        data->state = LV_INDEV_STATE_PRESSED;
+    } else {
+        data->state = LV_INDEV_STATE_RELEASED;
+    }
+}
+
+bool lv_input_init() {
+    // Touch panel
+    pinMode(TOUCH_INT_PIN, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(TOUCH_INT_PIN), touch_isr, FALLING);
+
+    static lv_indev_drv_t touch_drv;
+    lv_indev_drv_init(&touch_drv);
+    touch_drv.type = LV_INDEV_TYPE_POINTER;
+    touch_drv.read_cb = touch_read_cb;
+    lv_indev_drv_register(&touch_drv);
+
+    // Encoder
+    static lv_indev_drv_t encoder_drv;
+    lv_indev_drv_init(&encoder_drv);
+    encoder_drv.type = LV_INDEV_TYPE_ENCODER;
+    encoder_drv.read_cb = encoder_read_cb;
+    lv_indev_t* encoder = lv_indev_drv_register(&encoder_drv);
+
+    input_group = lv_group_create();
+    lv_indev_set_group(encoder, input_group);
+
+    return true;
+}
+
+void lv_input_encoder_feed(int delta) {
+    enc_diff += delta;
+}
+
+void lv_input_encoder_click() {
+    enc_clicks++;
+}
+
+lv_group_t* lv_input_group() {
+    return input_group;
+}
+
+void lv_input_discard_touch() {
+    touch_irq = false;
+    touch_down = false;
+    touch_discard = true;
+}
+
+unsigned long lv_input_last_touch_us() {
+    return touch_irq_us;
+}
@@ -4,28 +4,88 @@
 #include "config.h"
 #include "mqtt/mqtt_client.h"
 #include "ui/ui_manager.h"
+#include "trace/latency_tracer.h"
+#include "trace/perf_monitor.h"
+#include "trace/stall_watchdog.h"
+#include "library/name_table.h"
+#include "input/encoder_input.h"
+#include "power/power_manager.h"
+#include "ota/ota_updater.h"
 #include "lv_display.h"
+#include "lv_input.h"
 
 // Global objects
 MQTTClient mqttClient;
 UIManager uiManager;
+LatencyTracer latencyTracer;
+PerfMonitor perfMonitor;
+StallWatchdog stallWatchdog;
 WiFiManager wifiManager;
+EncoderInput encoderInput;
+PowerManager powerManager;
+OtaUpdater otaUpdater;
 
 // State variables
 int currentVolume = 50;
-long oldEncoderPosition = 0;
-unsigned long lastEncoderTime = 0;
 bool encoderPressed = false;
+bool turnedWhilePressed = false;  // The press was a jump or a scrub, not a click
+
+// Each control has its own acceleration curve
+AccelAxis volumeAxis({ENCODER_VOLUME_SLOW_DPS, ENCODER_VOLUME_FAST_DPS, ENCODER_VOLUME_MAX_GAIN});
+AccelAxis listAxis({ENCODER_LIST_SLOW_DPS, ENCODER_LIST_FAST_DPS, ENCODER_LIST_MAX_GAIN});
+AccelAxis seekAxis({ENCODER_SEEK_SLOW_DPS, ENCODER_SEEK_FAST_DPS, ENCODER_SEEK_MAX_GAIN});
+
+// Playback position from the last status, extrapolated while playing
+int currentProgressMs = 0;
+int currentDurationMs = 0;
+bool currentlyPlaying = false;
+unsigned long progressUpdatedAt = 0;
+
+// Press-and-turn scrub target on Now Playing, sent when the button is released
+bool seeking = false;
+int seekTargetMs = 0;
+
+// Last track and play state, to wake the display only when they change
+char lastTrackName[128] = "";
+bool lastPlaying = false;
+unsigned long lastTouchUs = 0;
+
+// IDs of the entries shown in the list screens
+char playlistIds[LIST_MAX_ITEMS][LIST_ID_LENGTH];
+size_t playlistCount = 0;
+char albumIds[LIST_MAX_ITEMS][LIST_ID_LENGTH];
+size_t albumCount = 0;
+
+// Names of the last compact list, until the roller has copied them
+char listNames[LIST_NAME_ARENA_BYTES];
+
+// Complete lists as name tables; once loaded they replace the JSON lists above
+NameTable playlistTable;
+NameTable albumTable;
 
 // Function declarations
 void setupWiFi();
 void handleEncoder();
+void handleTouchActivity();
+void cycleScreen(int direction);
+int estimatedProgressMs();
 void onStatusUpdate(const char* trackName, const char* artistName,
                    const char* albumName, int progressMs, int durationMs,
                    int volumePercent, bool isPlaying);
+void onArtPreview(const char* preview);
 void onImageUpdate(uint8_t* imageData, size_t length);
 void onPlaylistsUpdate(JsonArray playlists);
 void onAlbumsUpdate(JsonArray albums);
+void onPlaylistsCompact(CompactReader& reader);
+void onAlbumsCompact(CompactReader& reader);
+size_t readCompactList(CompactReader& reader, char ids[][LIST_ID_LENGTH], const char** names);
+void onPlaylistTableChunk(const uint8_t* chunk, size_t length);
+void onAlbumTableChunk(const uint8_t* chunk, size_t length);
+void onOtaOffer(const uint8_t* payload, size_t length);
+void onOtaData(const uint8_t* payload, size_t length);
+void onListSelect(UIScreen screen, uint16_t index);
+void onSeek(int positionMs);
+void onSwipe(int direction);
 
 void setup() {
     // Initialize Serial for debugging (FIRST!)
@@ -34,10 +94,17 @@ void setup() {
     Serial.println("\n\n" APP_NAME " v" APP_VERSION);
     Serial.println("================================");
 
+    // Count this boot if it is a new image on trial; may roll back and restart
+    otaUpdater.begin();
+
+    // Record a panic or watchdog reset and start timing loop() steps
+    stallWatchdog.begin();
+
     // Initialize M5Dial
     Serial.println("Initializing M5Dial...");
     auto cfg = M5.config();
-    M5Dial.begin(cfg, true, false);
+    M5Dial.begin(cfg, false, false);  // The encoder is counted by EncoderInput instead
+    pinMode(BUTTON_PIN, INPUT_PULLUP);
     Serial.println("M5Dial initialized");
 
     // Initialize LVGL with M5Dial display
@@ -48,6 +115,12 @@ void setup() {
     }
     Serial.println("LVGL initialized");
 
+    // Register touch and encoder input devices
+    Serial.println("Initializing input...");
+    lv_input_init();
+    encoderInput.begin();
+    Serial.println("Input initialized");
+
     // Initialize UI
     Serial.println("Initializing UI...");
     if (!uiManager.begin()) {
@@ -56,24 +129,45 @@ void setup() {
     }
     Serial.println("UI initialized");
 
+    powerManager.setUI(&uiManager);
+    powerManager.begin();
+
+    // Register UI callbacks
+    uiManager.onListSelect(onListSelect);
+    uiManager.onSeek(onSeek);
+    uiManager.onSwipe(onSwipe);
+
     // Show splash screen
     uiManager.showScreen(SCREEN_SPLASH);
     Serial.println("Splash screen shown");
 
     // Setup WiFi (delayed after UI is ready)
     Serial.println("Setting up WiFi...");
+    powerManager.configureWiFi();
     setupWiFi();
     Serial.println("WiFi setup complete");
 
     // Initialize MQTT
     Serial.println("Connecting to MQTT broker...");
+    latencyTracer.begin();
+    mqttClient.setTracer(&latencyTracer);
+    perfMonitor.setSources(&uiManager, &mqttClient);
+    otaUpdater.setClient(&mqttClient);
+    stallWatchdog.setClient(&mqttClient);
     mqttClient.begin();
 
     // Register MQTT callbacks
     mqttClient.onStatus(onStatusUpdate);
+    mqttClient.onArtPreview(onArtPreview);
     mqttClient.onImage(onImageUpdate);
     mqttClient.onPlaylists(onPlaylistsUpdate);
     mqttClient.onAlbums(onAlbumsUpdate);
+    mqttClient.onPlaylistsCompact(onPlaylistsCompact);
+    mqttClient.onAlbumsCompact(onAlbumsCompact);
+    mqttClient.onPlaylistTable(onPlaylistTableChunk);
+    mqttClient.onAlbumTable(onAlbumTableChunk);
+    mqttClient.onOtaOffer(onOtaOffer);
+    mqttClient.onOtaData(onOtaData);
 
     // Show now playing screen
     uiManager.showScreen(SCREEN_NOW_PLAYING);
@@ -83,20 +177,50 @@ void setup() {
 }
 
 void loop() {
-    M5Dial.update();
+    unsigned long loopStartUs = micros();
+    stallWatchdog.step(STALL_STEP_INPUT);
+    // Only the button: M5Dial.update() would also poll the touch controller,
+    // which lv_input reads when its interrupt fires
+    M5Dial.BtnA.setRawState(millis(), digitalRead(BUTTON_PIN) == LOW);
 
     // Handle WiFiManager config portal (needed when in AP mode)
+    stallWatchdog.step(STALL_STEP_WIFI);
     wifiManager.process();
 
     // Handle MQTT
+    stallWatchdog.step(STALL_STEP_MQTT);
     mqttClient.loop();
 
     // Handle encoder
+    stallWatchdog.step(STALL_STEP_ENCODER);
     handleEncoder();
+    handleTouchActivity();
 
     // Update UI
+    stallWatchdog.step(STALL_STEP_UI);
     uiManager.update();
 
+    // Dim or blank when idle
+    stallWatchdog.step(STALL_STEP_POWER);
+    powerManager.update();
+
+    // Firmware updates and verifying a new image
+    stallWatchdog.step(STALL_STEP_OTA);
+    otaUpdater.poll();
+
+    // Close traces whose status has reached the screen
+    stallWatchdog.step(STALL_STEP_TRACE);
+    latencyTracer.poll();
+
+    // Diagnostics page, only while it is on screen
+    perfMonitor.poll();
+
+    // Store and upload stalls and core dumps
+    stallWatchdog.step(STALL_STEP_STALLS);
+    stallWatchdog.poll();
+    stallWatchdog.endLoop();
+    perfMonitor.recordLoop(micros() - loopStartUs);
+
     // Update LVGL tick timer (for animations and timers)
     lv_tick_inc(5);
 
@@ -135,35 +259,49 @@ void setupWiFi() {
 }
 
 void handleEncoder() {
-    long newPosition = M5Dial.Encoder.read();
-
-    // Handle rotation
-    if (newPosition != oldEncoderPosition) {
-        int delta = newPosition - oldEncoderPosition;
-        oldEncoderPosition = newPosition;
-
-        // Debounce encoder
-        if (millis() - lastEncoderTime < ENCODER_DEBOUNCE_MS) {
-            return;
-        }
-        lastEncoderTime = millis();
+    EncoderIntent intent;
 
-        // Handle based on current screen
+    // Handle rotation collected by the sampling task
+    // A turn that wakes the display only wakes it
+    if (encoderInput.poll(intent) && !powerManager.activity(WAKE_ENCODER, intent.timeUs)) {
         UIScreen currentScreen = uiManager.getCurrentScreen();
+        bool pressed = M5Dial.BtnA.isPressed();
+        if (pressed) {
+            turnedWhilePressed = true;
+        }
 
         switch (currentScreen) {
             case SCREEN_NOW_PLAYING:
-                // Control volume with encoder
-                currentVolume += (delta * ENCODER_VOLUME_STEP);
-                currentVolume = constrain(currentVolume, 0, 100);
-                mqttClient.setVolume(currentVolume);
-                uiManager.showVolumeOverlay(currentVolume);
+                if (pressed) {
+                    // Press and turn scrubs through the track
+                    if (!seeking) {
+                        seeking = true;
+                        seekTargetMs = estimatedProgressMs();
+                        seekAxis.reset();
+                    }
+                    seekTargetMs += seekAxis.steps(intent.detents, intent.velocity) * ENCODER_SEEK_STEP_MS;
+                    seekTargetMs = constrain(seekTargetMs, 0, max(currentDurationMs - 1000, 0));
+                    uiManager.showSeekOverlay(seekTargetMs);
+                } else {
+                    // Control volume with encoder
+                    latencyTracer.markInput(intent.timeUs);
+                    currentVolume += volumeAxis.steps(intent.detents, intent.velocity) * ENCODER_VOLUME_STEP;
+                    currentVolume = constrain(currentVolume, 0, 100);
+                    mqttClient.setVolume(currentVolume);
+                    uiManager.showVolumeOverlay(currentVolume);
+                }
                 break;
 
             case SCREEN_PLAYLISTS:
             case SCREEN_ALBUMS:
-                // Scroll through lists
-                uiManager.onEncoderChange(delta);
+                // Press and turn jumps between letters, turning alone scrolls
+                if (pressed) {
+                    for (int i = 0; i < abs(intent.detents); i++) {
+                        uiManager.onEncoderJump(intent.detents > 0 ? 1 : -1);
+                    }
+                } else {
+                    uiManager.onEncoderChange(listAxis.steps(intent.detents, intent.velocity));
+                }
                 break;
 
             default:
@@ -175,59 +313,104 @@ void handleEncoder() {
     if (M5Dial.BtnA.wasPressed()) {
         Serial.println("Button pressed");
 
-        UIScreen currentScreen = uiManager.getCurrentScreen();
-
-        switch (currentScreen) {
-            case SCREEN_NOW_PLAYING:
-                // Toggle play/pause
-                // TODO: Track playing state
-                mqttClient.play(); // or pause()
-                break;
+        // Ignore the rest of a press that woke the display
+        if (powerManager.activity(WAKE_BUTTON, micros())) {
+            encoderPressed = true;
+        }
+    }
 
-            case SCREEN_PLAYLISTS:
-            case SCREEN_ALBUMS:
-                // Select item
-                uiManager.onEncoderClick();
-                break;
+    // Clicks act on release, unless the press was used to jump or scrub
+    if (M5Dial.BtnA.wasReleased()) {
+        UIScreen currentScreen = uiManager.getCurrentScreen();
 
-            default:
-                break;
+        if (seeking) {
+            seeking = false;
+            if (currentScreen == SCREEN_NOW_PLAYING) {
+                Serial.printf("Seek to %d ms\n", seekTargetMs);
+                latencyTracer.markInput(micros());
+                mqttClient.seek(seekTargetMs);
+            }
+        } else if (!turnedWhilePressed && !encoderPressed) {
+            switch (currentScreen) {
+                case SCREEN_NOW_PLAYING:
+                    // Toggle play/pause
+                    // TODO: Track playing state
+                    latencyTracer.markInput(micros());
+                    mqttClient.play(); // or pause()
+                    break;
+
+                case SCREEN_PLAYLISTS:
+                case SCREEN_ALBUMS:
+                    latencyTracer.markInput(micros());
+                    uiManager.onEncoderClick();
+                    break;
+
+                default:
+                    break;
+            }
         }
+        turnedWhilePressed = false;
     }
 
     // Long press to change screens
-    if (M5Dial.BtnA.pressedFor(1000) && !encoderPressed) {
+    if (M5Dial.BtnA.pressedFor(1000) && !encoderPressed && !turnedWhilePressed) {
         encoderPressed = true;
         Serial.println("Button long pressed - cycling screens");
+        cycleScreen(1);
+    }
 
-        UIScreen currentScreen = uiManager.getCurrentScreen();
-        UIScreen nextScreen = SCREEN_NOW_PLAYING;
+    if (!M5Dial.BtnA.isPressed()) {
+        encoderPressed = false;
+    }
+}
 
-        switch (currentScreen) {
-            case SCREEN_NOW_PLAYING:
-                nextScreen = SCREEN_PLAYLISTS;
-                mqttClient.getPlaylists();
-                break;
-            case SCREEN_PLAYLISTS:
-                nextScreen = SCREEN_ALBUMS;
-                mqttClient.getAlbums();
-                break;
-            case SCREEN_ALBUMS:
-                nextScreen = SCREEN_SETTINGS;
-                break;
-            case SCREEN_SETTINGS:
-                nextScreen = SCREEN_NOW_PLAYING;
-                break;
-            default:
-                break;
+void handleTouchActivity() {
+    // The touch interrupt is noticed even while LVGL is not polling the panel
+    unsigned long touchUs = lv_input_last_touch_us();
+    if (touchUs != lastTouchUs) {
+        lastTouchUs = touchUs;
+
+        // A tap on a blank dial only wakes it; keep LVGL from acting on it once it resumes
+        if (powerManager.activity(WAKE_TOUCH, touchUs)) {
+            lv_input_discard_touch();
         }
+    }
+}
+
+void cycleScreen(int direction) {
+    // Screen order: now playing -> playlists -> albums -> settings
+    static const UIScreen order[] = {
+        SCREEN_NOW_PLAYING, SCREEN_PLAYLISTS, SCREEN_ALBUMS, SCREEN_SETTINGS
+    };
+    const int count = sizeof(order) / sizeof(order[0]);
 
-        uiManager.showScreen(nextScreen);
+    int current = 0;
+    for (int i = 0; i < count; i++) {
+        if (order[i] == uiManager.getCurrentScreen()) current = i;
     }
 
-    if (!M5Dial.BtnA.isPressed()) {
-        encoderPressed = false;
+    UIScreen nextScreen = order[(current + direction + count) % count];
+
+    switch (nextScreen) {
+        case SCREEN_PLAYLISTS:
+            mqttClient.getPlaylists();
+            break;
+        case SCREEN_ALBUMS:
+            mqttClient.getAlbums();
+            break;
+        default:
+            break;
     }
+
+    uiManager.showScreen(nextScreen);
+}
+
+int estimatedProgressMs() {
+    int progress = currentProgressMs;
+    if (currentlyPlaying) {
+        progress += (int)(millis() - progressUpdatedAt);
+    }
+    return constrain(progress, 0, currentDurationMs);
 }
 
 void onStatusUpdate(const char* trackName, const char* artistName,
@@ -241,14 +424,36 @@ void onStatusUpdate(const char* trackName, const char* artistName,
     Serial.printf("  Volume: %d%%\n", volumePercent);
     Serial.printf("  Playing: %s\n", isPlaying ? "Yes" : "No");
 
-    // Update current volume
+    // Update current volume and position
     currentVolume = volumePercent;
+    currentProgressMs = progressMs;
+    currentDurationMs = durationMs;
+    currentlyPlaying = isPlaying;
+    progressUpdatedAt = millis();
+
+    // A new track or a play/pause from elsewhere is worth waking for
+    powerManager.setPlaying(isPlaying);
+    bool trackChanged = strncmp(trackName, lastTrackName, sizeof(lastTrackName) - 1) != 0;
+    if (trackChanged || isPlaying != lastPlaying) {
+        strlcpy(lastTrackName, trackName, sizeof(lastTrackName));
+        lastPlaying = isPlaying;
+        powerManager.activity(WAKE_MQTT, micros());
+    }
+
+    // Time to the new cover's first colour and to the full image
+    if (trackChanged) {
+        uiManager.startArtTiming();
+    }
 
     // Update UI
     uiManager.updateNowPlaying(trackName, artistName, albumName,
                                progressMs, durationMs, volumePercent, isPlaying);
 }
 
+void onArtPreview(const char* preview) {
+    uiManager.updateArtPreview(preview);
+}
+
 void onImageUpdate(uint8_t* imageData, size_t length) {
     Serial.printf("Image update received: %d bytes\n", length);
     uiManager.updateAlbumArt(imageData, length);
@@ -256,23 +461,128 @@ void onImageUpdate(uint8_t* imageData, size_t length) {
 
 void onPlaylistsUpdate(JsonArray playlists) {
     Serial.printf("Playlists update received: %d playlists\n", playlists.size());
+    if (playlistTable.ready()) return;
+
+    const char* names[LIST_MAX_ITEMS];
+    playlistCount = 0;
 
-    // Convert to array of strings for UI
-    // TODO: Implement proper playlist display
     for (JsonVariant playlist : playlists) {
-        const char* name = playlist["name"];
-        Serial.printf("  - %s\n", name);
+        if (playlistCount >= LIST_MAX_ITEMS) break;
+
+        strlcpy(playlistIds[playlistCount], playlist["id"] | "", LIST_ID_LENGTH);
+        names[playlistCount] = playlist["name"] | "";
+        playlistCount++;
     }
+
+    uiManager.updatePlaylists(names, playlistCount);
 }
 
 void onAlbumsUpdate(JsonArray albums) {
     Serial.printf("Albums update received: %d albums\n", albums.size());
+    if (albumTable.ready()) return;
+
+    const char* names[LIST_MAX_ITEMS];
+    albumCount = 0;
 
-    // Convert to array of strings for UI
-    // TODO: Implement proper album display
     for (JsonVariant album : albums) {
-        const char* name = album["name"];
-        const char* artist = album["artist"];
-        Serial.printf("  - %s by %s\n", name, artist);
+        if (albumCount >= LIST_MAX_ITEMS) break;
+
+        strlcpy(albumIds[albumCount], album["id"] | "", LIST_ID_LENGTH);
+        names[albumCount] = album["name"] | "";
+        albumCount++;
+    }
+
+    uiManager.updateAlbums(names, albumCount);
+}
+
+void onPlaylistsCompact(CompactReader& reader) {
+    if (playlistTable.ready()) return;
+
+    const char* names[LIST_MAX_ITEMS];
+    playlistCount = readCompactList(reader, playlistIds, names);
+    uiManager.updatePlaylists(names, playlistCount);
+}
+
+void onAlbumsCompact(CompactReader& reader) {
+    if (albumTable.ready()) return;
+
+    const char* names[LIST_MAX_ITEMS];
+    albumCount = readCompactList(reader, albumIds, names);
+    uiManager.updateAlbums(names, albumCount);
+}
+
+// Entries are decoded one at a time straight into the ID list and the name arena
+size_t readCompactList(CompactReader& reader, char ids[][LIST_ID_LENGTH], const char** names) {
+    unsigned long startUs = micros();
+    char name[COMPACT_TEXT_SIZE];
+    size_t count = 0;
+    size_t used = 0;
+
+    while (count < LIST_MAX_ITEMS && reader.nextEntry(ids[count], LIST_ID_LENGTH, name, sizeof(name))) {
+        size_t length = strlen(name) + 1;
+        if (used + length > sizeof(listNames)) break;
+
+        memcpy(listNames + used, name, length);
+        names[count++] = listNames + used;
+        used += length;
     }
+
+    Serial.printf("Compact list: %u entries, %u bytes of names, decoded in %lu us%s\n",
+                  (unsigned)count, (unsigned)used, micros() - startUs,
+                  reader.failed() ? " (corrupt)" : "");
+    return count;
+}
+
+void onPlaylistTableChunk(const uint8_t* chunk, size_t length) {
+    if (playlistTable.addChunk(chunk, length)) {
+        uiManager.setPlaylistTable(&playlistTable);
+    }
+}
+
+void onAlbumTableChunk(const uint8_t* chunk, size_t length) {
+    if (albumTable.addChunk(chunk, length)) {
+        uiManager.setAlbumTable(&albumTable);
+    }
+}
+
+void onOtaOffer(const uint8_t* payload, size_t length) {
+    otaUpdater.onOffer(payload, length);
+}
+
+void onOtaData(const uint8_t* payload, size_t length) {
+    otaUpdater.onData(payload, length);
+}
+
+void onListSelect(UIScreen screen, uint16_t index) {
+    // Selected by touch or by the button release already marked in handleEncoder
+    latencyTracer.markInput(lv_input_last_touch_us());
+
+    char id[LIST_ID_LENGTH];
+    if (screen == SCREEN_PLAYLISTS && playlistTable.idAt(index, id, sizeof(id))) {
+        Serial.printf("Playlist selected: %s\n", id);
+        mqttClient.changePlaylist(id);
+        uiManager.showScreen(SCREEN_NOW_PLAYING);
+    } else if (screen == SCREEN_ALBUMS && albumTable.idAt(index, id, sizeof(id))) {
+        Serial.printf("Album selected: %s\n", id);
+        mqttClient.changeAlbum(id);
+        uiManager.showScreen(SCREEN_NOW_PLAYING);
+    } else if (screen == SCREEN_PLAYLISTS && index < playlistCount) {
+        Serial.printf("Playlist selected: %s\n", playlistIds[index]);
+        mqttClient.changePlaylist(playlistIds[index]);
+        uiManager.showScreen(SCREEN_NOW_PLAYING);
+    } else if (screen == SCREEN_ALBUMS && index < albumCount) {
+        Serial.printf("Album selected: %s\n", albumIds[index]);
+        mqttClient.changeAlbum(albumIds[index]);
+        uiManager.showScreen(SCREEN_NOW_PLAYING);
+    }
+}
+
+void onSeek(int positionMs) {
+    Serial.printf("Seek to %d ms\n", positionMs);
+    latencyTracer.markInput(lv_input_last_touch_us());
+    mqttClient.seek(positionMs);
+}
+
+void onSwipe(int direction) {
+    cycleScreen(direction);
 }
@@ -0,0 +1,157 @@
+#include "command_journal.h"
+
+CommandJournal::CommandJournal()
+    : _count(0),
+      _bootId(0),
+      _sequence(0),
+      _coalesced(0),
+      _dropped(0) {
+}
+
+void CommandJournal::begin() {
+    // Ids restart every boot; the random prefix keeps them from repeating
+    _bootId = esp_random();
+}
+
+CommandJournal::Group CommandJournal::groupOf(const char* command) {
+    if (strcmp(command, "set_volume") == 0 || strcmp(command, "volume_up") == 0 ||
+        strcmp(command, "volume_down") == 0) {
+        return GROUP_VOLUME;
+    }
+    if (strcmp(command, "play") == 0 || strcmp(command, "pause") == 0) return GROUP_PLAYBACK;
+    if (strcmp(command, "seek") == 0) return GROUP_SEEK;
+    if (strcmp(command, "change_playlist") == 0 || strcmp(command, "change_album") == 0) return GROUP_CONTEXT;
+    if (strcmp(command, "next") == 0 || strcmp(command, "previous") == 0) return GROUP_SKIP;
+    if (strcmp(command, "get_playlists") == 0) return GROUP_PLAYLISTS;
+    if (strcmp(command, "get_albums") == 0) return GROUP_ALBUMS;
+    return GROUP_NONE;
+}
+
+int CommandJournal::volumeDelta(const Entry& entry) {
+    int step = entry.parameter[0] ? atoi(entry.parameter) : ENCODER_VOLUME_STEP;
+    return strcmp(entry.command, "volume_down") == 0 ? -step : step;
+}
+
+void CommandJournal::push(const char* command, const char* parameter) {
+    Group group = groupOf(command);
+
+    switch (group) {
+        case GROUP_VOLUME:
+            if (mergeVolume(command, parameter)) return;
+            break;
+
+        case GROUP_CONTEXT:
+            // Skips and seeks queued before a context change no longer mean anything
+            removeGroup(GROUP_SKIP);
+            removeGroup(GROUP_SEEK);
+            removeGroup(GROUP_CONTEXT);
+            break;
+
+        case GROUP_SKIP:
+            // Position within the track being skipped does not matter
+            removeGroup(GROUP_SEEK);
+            break;
+
+        case GROUP_PLAYBACK:
+        case GROUP_SEEK:
+        case GROUP_PLAYLISTS:
+        case GROUP_ALBUMS:
+            removeGroup(group);
+            break;
+
+        default:
+            break;
+    }
+
+    append(command, parameter);
+}
+
+// Fold a volume command into the queued one: an absolute target replaces it,
+// a relative step adjusts it. Returns true when nothing more needs appending.
+bool CommandJournal::mergeVolume(const char* command, const char* parameter) {
+    size_t index = _count;
+    for (size_t i = 0; i < _count; i++) {
+        if (groupOf(_entries[i].command) == GROUP_VOLUME) {
+            index = i;
+            break;
+        }
+    }
+    if (index == _count) return false;
+
+    if (strcmp(command, "set_volume") == 0) {
+        removeAt(index);
+        _coalesced++;
+        return false;
+    }
+
+    Entry incoming = {};
+    strlcpy(incoming.command, command, sizeof(incoming.command));
+    strlcpy(incoming.parameter, parameter ? parameter : "", sizeof(incoming.parameter));
+    int delta = volumeDelta(incoming);
+
+    Entry queued = _entries[index];
+    removeAt(index);
+    _coalesced++;
+
+    char merged[12];
+    if (strcmp(queued.command, "set_volume") == 0) {
+        snprintf(merged, sizeof(merged), "%d", constrain(atoi(queued.parameter) + delta, 0, 100));
+        append("set_volume", merged);
+    } else {
+        int net = volumeDelta(queued) + delta;
+        if (net == 0) return true;
+        snprintf(merged, sizeof(merged), "%d", net > 0 ? net : -net);
+        append(net > 0 ? "volume_up" : "volume_down", merged);
+    }
+    return true;
+}
+
+void CommandJournal::append(const char* command, const char* parameter) {
+    // Keep the newest intent when full
+    if (_count == COMMAND_JOURNAL_SIZE) {
+        removeAt(0);
+        _dropped++;
+    }
+
+    Entry& entry = _entries[_count++];
+    strlcpy(entry.command, command, sizeof(entry.command));
+    strlcpy(entry.parameter, parameter ? parameter : "", sizeof(entry.parameter));
+    snprintf(entry.commandId, sizeof(entry.commandId), "%08lx-%lu",
+             (unsigned long)_bootId, (unsigned long)_sequence++);
+    entry.queuedMs = millis();
+}
+
+const CommandJournal::Entry* CommandJournal::peek() const {
+    return _count > 0 ? &_entries[0] : nullptr;
+}
+
+void CommandJournal::pop() {
+    if (_count > 0) removeAt(0);
+}
+
+void CommandJournal::expire(unsigned long nowMs) {
+    while (_count > 0 && nowMs - _entries[0].queuedMs > COMMAND_JOURNAL_MAX_AGE_MS) {
+        Serial.printf("Journal: dropping stale %s\n", _entries[0].command);
+        removeAt(0);
+        _dropped++;
+    }
+}
+
+void CommandJournal::removeAt(size_t index) {
+    for (size_t i = index + 1; i < _count; i++) {
+        _entries[i - 1] = _entries[i];
+    }
+    _count--;
+}
+
+void CommandJournal::removeGroup(Group group) {
+    size_t i = 0;
+    while (i < _count) {
+        if (groupOf(_entries[i].command) == group) {
+            removeAt(i);
+            _coalesced++;
+        } else {
+            i++;
+        }
+    }
+}
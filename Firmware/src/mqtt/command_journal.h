@@ -0,0 +1,71 @@
+#ifndef COMMAND_JOURNAL_H
+#define COMMAND_JOURNAL_H
+
+#include <Arduino.h>
+#include "config.h"
+
+/**
+ * Bounded list of commands waiting to be published, oldest first.
+ * Pushing a command removes the entries it makes obsolete (an older volume
+ * target, an earlier play/pause, skips within a context that was replaced), so
+ * what survives an outage is the user's latest intent. Every entry carries a
+ * commandId, unique per boot, that the backend uses to ignore replays.
+ */
+class CommandJournal {
+public:
+    struct Entry {
+        char command[20];
+        char parameter[COMMAND_PARAM_LENGTH];
+        char commandId[20];
+        unsigned long queuedMs;
+    };
+
+    CommandJournal();
+
+    // Seed the commandId prefix for this boot
+    void begin();
+
+    // Queue a command, coalescing it with the entries it supersedes
+    void push(const char* command, const char* parameter);
+
+    // Oldest entry, nullptr when empty
+    const Entry* peek() const;
+    void pop();
+
+    // Forget entries older than COMMAND_JOURNAL_MAX_AGE_MS
+    void expire(unsigned long nowMs);
+
+    size_t size() const { return _count; }
+    bool empty() const { return _count == 0; }
+    unsigned long coalesced() const { return _coalesced; }
+    unsigned long dropped() const { return _dropped; }
+
+private:
+    enum Group : uint8_t {
+        GROUP_NONE,
+        GROUP_VOLUME,
+        GROUP_PLAYBACK,
+        GROUP_SEEK,
+        GROUP_CONTEXT,
+        GROUP_SKIP,
+        GROUP_PLAYLISTS,
+        GROUP_ALBUMS
+    };
+
+    static Group groupOf(const char* command);
+    static int volumeDelta(const Entry& entry);
+
+    void removeAt(size_t index);
+    void removeGroup(Group group);
+    void append(const char* command, const char* parameter);
+    bool mergeVolume(const char* command, const char* parameter);
+
+    Entry _entries[COMMAND_JOURNAL_SIZE];
+    size_t _count;
+    uint32_t _bootId;
+    uint32_t _sequence;
+    unsigned long _coalesced;
+    unsigned long _dropped;
+};
+
+#endif // COMMAND_JOURNAL_H
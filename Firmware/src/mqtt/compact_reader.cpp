@@ -0,0 +1,170 @@
+#include "compact_reader.h"
+#include <string.h>
+
+// Words common in track, playlist and album names; byte for byte CompactCodec.Dictionary
+const char COMPACT_DICTIONARY[] =
+    "Original Motion Picture Soundtrack (Deluxe Edition) (Remastered) - Remastered 20"
+    " (Live) Live at (feat. feat. (Radio Edit) - Radio Edit (Acoustic Version) Instrumental"
+    " Remix (Extended Mix) Greatest Hits The Best of Essentials Collection Anniversary Edition"
+    " Expanded Edition Special Edition - Single Vol. Part Symphony No. Concerto in Orchestra"
+    " Sessions Daily Mix Discover Weekly Release Radar Liked Songs This Is On Repeat Top 50 -"
+    " Global Top Hits Chill Vibes Lo-Fi Beats Peaceful Piano Deep Focus Workout Running Sleep"
+    " Party Rock Classics Hip Hop Jazz Classical Love Songs Summer Christmas Radio Playlist"
+    " Album Music Songs Mix the and The & of ";
+
+const size_t COMPACT_DICTIONARY_SIZE = sizeof(COMPACT_DICTIONARY) - 1;
+
+CompactReader::CompactReader()
+    : _input(nullptr),
+      _inputLength(0),
+      _inputPos(0),
+      _kind(0),
+      _compressed(false),
+      _failed(true),
+      _rawLength(0),
+      _produced(0),
+      _windowPos(0),
+      _bits(0),
+      _bitCount(0),
+      _matchDistance(0),
+      _matchLeft(0) {
+}
+
+bool CompactReader::begin(const uint8_t* payload, size_t length) {
+    _failed = true;
+    if (!payload || length < COMPACT_HEADER_SIZE) return false;
+    if (payload[0] != COMPACT_FORMAT || payload[2] != COMPACT_DICTIONARY_VERSION) return false;
+
+    _kind = payload[1];
+    _compressed = (payload[3] & 0x01) != 0;
+    _rawLength = (uint16_t)(payload[4] | (payload[5] << 8));
+    _input = payload + COMPACT_HEADER_SIZE;
+    _inputLength = length - COMPACT_HEADER_SIZE;
+    _inputPos = 0;
+    _produced = 0;
+    _failed = false;
+
+    // Matches may reach back into the dictionary as if it had just been decoded
+    memcpy(_window, COMPACT_DICTIONARY, COMPACT_DICTIONARY_SIZE);
+    _windowPos = COMPACT_DICTIONARY_SIZE;
+    _bits = 0;
+    _bitCount = 0;
+    _matchLeft = 0;
+    return true;
+}
+
+bool CompactReader::nextEntry(char* id, size_t idSize, char* name, size_t nameSize) {
+    if (_failed || _produced == _rawLength) return false;
+    return readString(id, idSize) && readString(name, nameSize);
+}
+
+bool CompactReader::readStatus(CompactStatus& status) {
+    if (_kind != COMPACT_KIND_STATUS) return false;
+
+    if (!readVarint(status.progressMs) || !readVarint(status.durationMs)) return false;
+    int volume = readByte();
+    int flags = readByte();
+    if (volume < 0 || flags < 0 || !readVarint(status.backendUs)) return false;
+    status.volumePercent = volume;
+    status.isPlaying = (flags & 0x01) != 0;
+
+    return readString(status.track, sizeof(status.track)) &&
+           readString(status.artist, sizeof(status.artist)) &&
+           readString(status.album, sizeof(status.album)) &&
+           readString(status.correlationId, sizeof(status.correlationId)) &&
+           readString(status.artPreview, sizeof(status.artPreview));
+}
+
+// One raw byte, -1 past the end of the records or on a corrupt body
+int CompactReader::readByte() {
+    if (_failed) return -1;
+    if (_produced == _rawLength) {
+        _failed = true;
+        return -1;
+    }
+
+    if (!_compressed) {
+        if (_inputPos == _inputLength) {
+            _failed = true;
+            return -1;
+        }
+        _produced++;
+        return _input[_inputPos++];
+    }
+
+    const uint32_t mask = (1UL << COMPACT_WINDOW_BITS) - 1;
+    if (_matchLeft == 0) {
+        uint32_t literal;
+        if (!readBits(1, literal)) return -1;
+
+        if (literal) {
+            uint32_t value;
+            if (!readBits(8, value)) return -1;
+            output(value);
+            return value;
+        }
+
+        uint32_t value;
+        if (!readBits(COMPACT_WINDOW_BITS + COMPACT_LENGTH_BITS, value)) return -1;
+        uint32_t distance = (value >> COMPACT_LENGTH_BITS) + 1;
+        if (distance > _windowPos) {
+            _failed = true;
+            return -1;
+        }
+        _matchDistance = distance;
+        _matchLeft = (value & ((1UL << COMPACT_LENGTH_BITS) - 1)) + COMPACT_MIN_MATCH;
+    }
+
+    uint8_t byte = _window[(_windowPos - _matchDistance) & mask];
+    _matchLeft--;
+    output(byte);
+    return byte;
+}
+
+bool CompactReader::readBits(uint8_t count, uint32_t& value) {
+    while (_bitCount < count) {
+        if (_inputPos == _inputLength) {
+            _failed = true;
+            return false;
+        }
+        _bits = (_bits << 8) | _input[_inputPos++];
+        _bitCount += 8;
+    }
+
+    value = (_bits >> (_bitCount - count)) & ((1UL << count) - 1);
+    _bitCount -= count;
+    _bits &= (1UL << _bitCount) - 1;
+    return true;
+}
+
+bool CompactReader::readVarint(uint32_t& value) {
+    value = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        int byte = readByte();
+        if (byte < 0) return false;
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    _failed = true;
+    return false;
+}
+
+// Reads the whole field even when only the start fits, so the next one lines up
+bool CompactReader::readString(char* buffer, size_t size) {
+    int length = readByte();
+    if (length < 0) return false;
+
+    size_t kept = 0;
+    for (int i = 0; i < length; i++) {
+        int byte = readByte();
+        if (byte < 0) return false;
+        if (kept + 1 < size) buffer[kept++] = (char)byte;
+    }
+    if (size > 0) buffer[kept] = '\0';
+    return true;
+}
+
+void CompactReader::output(uint8_t byte) {
+    _window[_windowPos++ & ((1UL << COMPACT_WINDOW_BITS) - 1)] = byte;
+    _produced++;
+}
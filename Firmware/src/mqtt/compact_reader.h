@@ -0,0 +1,102 @@
+#ifndef COMPACT_READER_H
+#define COMPACT_READER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================
+// Compact payload format (little-endian)
+// ============================================
+// header:  u8 format, u8 kind, u8 dictionary version, u8 flags, u16 raw length
+// body:    the raw records, LZSS-compressed when flags bit 0 is set
+//
+// The LZSS is the one firmware patches use (see patch_applier.h) with an
+// 11-bit window and 6-bit lengths, except that the window starts out holding
+// COMPACT_DICTIONARY, so even the first name can refer back to common words.
+// Raw records:
+//   list     u8 id length, id, u8 name length, name; repeated
+//   status   varint progressMs, varint durationMs, u8 volumePercent,
+//            u8 flags (bit 0 playing), varint backendUs, then u8 length and
+//            bytes of track, artist, album, correlation id and art preview
+// Written by CompactCodec in the backend, which has the same dictionary;
+// change both and bump COMPACT_DICTIONARY_VERSION together.
+
+#define COMPACT_FORMAT 1
+#define COMPACT_DICTIONARY_VERSION 1
+#define COMPACT_HEADER_SIZE 6
+#define COMPACT_WINDOW_BITS 11
+#define COMPACT_LENGTH_BITS 6
+#define COMPACT_MIN_MATCH 3
+#define COMPACT_TEXT_SIZE 256       // Longest field plus terminator
+
+#define COMPACT_KIND_PLAYLISTS 1
+#define COMPACT_KIND_ALBUMS 2
+#define COMPACT_KIND_STATUS 3
+
+extern const char COMPACT_DICTIONARY[];
+extern const size_t COMPACT_DICTIONARY_SIZE;
+
+struct CompactStatus {
+    uint32_t progressMs;
+    uint32_t durationMs;
+    uint8_t volumePercent;
+    bool isPlaying;
+    uint32_t backendUs;             // 0 when not answering a traced command
+    char track[COMPACT_TEXT_SIZE];
+    char artist[COMPACT_TEXT_SIZE];
+    char album[COMPACT_TEXT_SIZE];
+    char correlationId[64];
+    char artPreview[COMPACT_TEXT_SIZE];
+};
+
+/**
+ * Decodes a compact payload record by record as it is read, so a list takes
+ * the window and whatever the caller keeps of each entry however long it is.
+ * The payload must stay valid until the last read. Plain C++ without Arduino
+ * dependencies so it builds on the host.
+ */
+class CompactReader {
+public:
+    CompactReader();
+
+    // Check the header and start on the records; false if this build cannot read it
+    bool begin(const uint8_t* payload, size_t length);
+
+    uint8_t kind() const { return _kind; }
+    bool compressed() const { return _compressed; }
+    size_t rawLength() const { return _rawLength; }
+
+    // Next list entry, truncated to the buffers; false after the last one or on error
+    bool nextEntry(char* id, size_t idSize, char* name, size_t nameSize);
+
+    bool readStatus(CompactStatus& status);
+
+    // The records ended early or a match pointed outside the window
+    bool failed() const { return _failed; }
+
+private:
+    int readByte();
+    bool readBits(uint8_t count, uint32_t& value);
+    bool readVarint(uint32_t& value);
+    bool readString(char* buffer, size_t size);
+    void output(uint8_t byte);
+
+    const uint8_t* _input;
+    size_t _inputLength;
+    size_t _inputPos;
+    uint8_t _kind;
+    bool _compressed;
+    bool _failed;
+    uint16_t _rawLength;
+    uint16_t _produced;
+
+    // LZSS
+    uint8_t _window[1 << COMPACT_WINDOW_BITS];
+    uint32_t _windowPos;
+    uint32_t _bits;
+    uint8_t _bitCount;
+    uint16_t _matchDistance;
+    uint8_t _matchLeft;
+};
+
+#endif // COMPACT_READER_H
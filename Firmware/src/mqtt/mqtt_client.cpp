@@ -1,94 +1,321 @@
 #include "mqtt_client.h"
+#include "mqtt_tls_certs.h"
 
 MQTTClient* MQTTClient::_instance = nullptr;
 
+// Topics the compact encoding covers, by the names the backend knows them by
+static const struct {
+    const char* name;
+    const char* json;
+    const char* compact;
+} COMPACT_TOPICS[] = {
+    { "status", MQTT_TOPIC_STATUS, MQTT_TOPIC_STATUS MQTT_COMPACT_SUFFIX },
+    { "playlists", MQTT_TOPIC_PLAYLISTS, MQTT_TOPIC_PLAYLISTS MQTT_COMPACT_SUFFIX },
+    { "albums", MQTT_TOPIC_ALBUMS, MQTT_TOPIC_ALBUMS MQTT_COMPACT_SUFFIX },
+};
+#define COMPACT_TOPIC_COUNT (sizeof(COMPACT_TOPICS) / sizeof(COMPACT_TOPICS[0]))
+
 MQTTClient::MQTTClient()
-    : _mqttClient(_wifiClient),
+    : _mqttClient(MQTT_USE_TLS ? static_cast<Client&>(_tlsClient) : static_cast<Client&>(_wifiClient)),
       _statusCallback(nullptr),
+      _artPreviewCallback(nullptr),
       _imageCallback(nullptr),
       _playlistsCallback(nullptr),
       _albumsCallback(nullptr),
-      _lastReconnectAttempt(0) {
+      _playlistsCompactCallback(nullptr),
+      _albumsCompactCallback(nullptr),
+      _playlistTableCallback(nullptr),
+      _albumTableCallback(nullptr),
+      _otaOfferCallback(nullptr),
+      _otaDataCallback(nullptr),
+      _tracer(nullptr),
+      _lastReconnectAttempt(0),
+      _reconnectDelay(MQTT_RECONNECT_MIN_DELAY),
+      _reconnectWait(0),
+      _compactTopics(0),
+      _subscribed(false),
+      _probingSession(false),
+      _probeSentMs(0),
+      _rttPending(false),
+      _rttSentUs(0),
+      _rttUs(0),
+      _reconnects(0),
+      _state(MQTT_DISCONNECTED),
+      _connectResult(false) {
+    _clientId[0] = '\0';
+    _sessionTopic[0] = '\0';
+    _otaTopic[0] = '\0';
+    _encodingTopic[0] = '\0';
     _instance = this;
 }
 
 bool MQTTClient::begin() {
-    _mqttClient.setServer(MQTT_BROKER, MQTT_PORT);
+    // Client ID from the full MAC address: stable across reboots so the broker can keep
+    // our session, and unique so two dials never take over each other's session
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    snprintf(_clientId, sizeof(_clientId), "%s-%02X%02X%02X%02X%02X%02X",
+             MQTT_CLIENT_ID_PREFIX, mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    snprintf(_sessionTopic, sizeof(_sessionTopic), "%s%s", MQTT_TOPIC_SESSION_PREFIX, _clientId);
+    snprintf(_otaTopic, sizeof(_otaTopic), "%s%s/", MQTT_TOPIC_OTA_PREFIX, _clientId);
+    snprintf(_encodingTopic, sizeof(_encodingTopic), "%s%s/", MQTT_TOPIC_ENCODING_PREFIX, _clientId);
+
+    if (MQTT_USE_TLS && !_tlsClient.begin(MQTT_TLS_CA_CERT, MQTT_TLS_PIN_SHA256)) {
+        Serial.println("MQTT TLS setup failed, connects will fail");
+    }
+
+    _mqttClient.setServer(MQTT_BROKER, MQTT_USE_TLS ? MQTT_TLS_PORT : MQTT_PORT);
     _mqttClient.setCallback(messageCallback);
     _mqttClient.setBufferSize(MQTT_MAX_PACKET_SIZE);
     _mqttClient.setKeepAlive(MQTT_KEEPALIVE);
 
-    return reconnect();
+    _journal.begin();
+
+    return startConnect();
 }
 
 void MQTTClient::loop() {
-    if (!_mqttClient.connected()) {
-        unsigned long now = millis();
-        if (now - _lastReconnectAttempt > MQTT_RECONNECT_DELAY) {
-            _lastReconnectAttempt = now;
-            if (reconnect()) {
-                _lastReconnectAttempt = 0;
+    unsigned long now = millis();
+
+    switch (_state) {
+        case MQTT_CONNECTED:
+            if (!_mqttClient.connected()) {
+                Serial.println("MQTT connection lost, queuing commands");
+                _state = MQTT_DISCONNECTED;
+                scheduleReconnect(now);
+                break;
             }
-        }
-    } else {
-        _mqttClient.loop();
+            _mqttClient.loop();
+            if (_probingSession && now - _probeSentMs > MQTT_SESSION_PROBE_MS) {
+                Serial.println("MQTT session was not kept, resubscribing");
+                _probingSession = false;
+                subscribe();
+            }
+            flushJournal();
+            publishTraceReports();
+            break;
+
+        case MQTT_DISCONNECTED:
+            _journal.expire(now);
+            if (WiFi.status() == WL_CONNECTED && now - _lastReconnectAttempt >= _reconnectWait) {
+                startConnect();
+            }
+            break;
+
+        case MQTT_CONNECTING:
+            // The connect task owns _mqttClient until it reports back
+            break;
+
+        case MQTT_CONNECT_DONE:
+            onConnectDone();
+            break;
     }
 }
 
 bool MQTTClient::isConnected() {
-    return _mqttClient.connected();
+    return _state == MQTT_CONNECTED;
 }
 
-bool MQTTClient::reconnect() {
-    Serial.print("Connecting to MQTT broker...");
+// PubSubClient::connect blocks for the TCP handshake and CONNACK, several seconds
+// when the broker is unreachable, so it runs in a short-lived task on the other core
+bool MQTTClient::startConnect() {
+    _lastReconnectAttempt = millis();
 
-    // Create unique client ID using MAC address to avoid conflicts with backend
-    uint8_t mac[6];
-    WiFi.macAddress(mac);
-    char uniqueClientId[40];
-    snprintf(uniqueClientId, sizeof(uniqueClientId), "%s-%02X%02X%02X",
-             MQTT_CLIENT_ID_PREFIX, mac[3], mac[4], mac[5]);
+    Serial.print("Connecting to MQTT broker... Client ID: ");
+    Serial.println(_clientId);
 
-    Serial.print(" Client ID: ");
-    Serial.println(uniqueClientId);
+    _state = MQTT_CONNECTING;
+    if (xTaskCreatePinnedToCore(connectTask, "mqtt_connect", MQTT_CONNECT_TASK_STACK,
+                                this, 1, nullptr, 0) != pdPASS) {
+        Serial.println("Failed to start MQTT connect task");
+        _state = MQTT_DISCONNECTED;
+        scheduleReconnect(millis());
+        return false;
+    }
+    return true;
+}
 
-    bool connected = false;
-    if (strlen(MQTT_USERNAME) > 0) {
-        connected = _mqttClient.connect(uniqueClientId, MQTT_USERNAME, MQTT_PASSWORD);
-    } else {
-        connected = _mqttClient.connect(uniqueClientId);
+void MQTTClient::connectTask(void* arg) {
+    MQTTClient* self = static_cast<MQTTClient*>(arg);
+
+    bool hasCredentials = strlen(MQTT_USERNAME) > 0;
+    bool connected = self->_mqttClient.connect(self->_clientId,
+                                               hasCredentials ? MQTT_USERNAME : nullptr,
+                                               hasCredentials ? MQTT_PASSWORD : nullptr,
+                                               nullptr, 0, false, nullptr, MQTT_CLEAN_SESSION);
+
+    self->_connectResult = connected;
+    self->_state = MQTT_CONNECT_DONE;
+    vTaskDelete(nullptr);
+}
+
+void MQTTClient::onConnectDone() {
+    if (!_connectResult) {
+        _state = MQTT_DISCONNECTED;
+        scheduleReconnect(millis());
+        Serial.printf("MQTT connect failed, rc=%d, retrying in %lu ms\n",
+                      _mqttClient.state(), _reconnectWait);
+        return;
+    }
+
+    Serial.println("MQTT connected!");
+    if (MQTT_USE_TLS) {
+        Serial.printf("TLS handshake %lu ms (%s); average cold %lu ms, resumed %lu ms\n",
+                      _tlsClient.handshakeMs(), _tlsClient.resumed() ? "resumed" : "full",
+                      _tlsClient.averageHandshakeMs(false), _tlsClient.averageHandshakeMs(true));
     }
+    _reconnectDelay = MQTT_RECONNECT_MIN_DELAY;
+    if (_subscribed) _reconnects++;
 
-    if (connected) {
-        Serial.println(" Connected!");
+    // Subscribing again makes the broker resend every retained message, which is
+    // what floods it when a whole fleet comes back after a restart. Subscribe once
+    // per boot and afterwards only when the probe shows the session is gone.
+    if (MQTT_CLEAN_SESSION || !_subscribed) {
         subscribe();
-        return true;
     } else {
-        Serial.print(" Failed, rc=");
-        Serial.println(_mqttClient.state());
-        return false;
+        probeSession();
     }
+    _state = MQTT_CONNECTED;
+
+    if (!_journal.empty()) {
+        Serial.printf("Replaying %u queued commands (%lu coalesced, %lu dropped)\n",
+                      (unsigned)_journal.size(), _journal.coalesced(), _journal.dropped());
+    }
+}
+
+// Waits grow exponentially up to MQTT_RECONNECT_MAX_DELAY; the actual wait is
+// picked at random from the upper half of the current delay
+void MQTTClient::scheduleReconnect(unsigned long now) {
+    _lastReconnectAttempt = now;
+    _reconnectWait = _reconnectDelay / 2 + esp_random() % (_reconnectDelay / 2 + 1);
+    _reconnectDelay = _reconnectDelay * 2 > MQTT_RECONNECT_MAX_DELAY
+        ? MQTT_RECONNECT_MAX_DELAY
+        : _reconnectDelay * 2;
 }
 
 void MQTTClient::subscribe() {
-    _mqttClient.subscribe(MQTT_TOPIC_STATUS);
-    _mqttClient.subscribe(MQTT_TOPIC_IMAGE);
-    _mqttClient.subscribe(MQTT_TOPIC_PLAYLISTS);
-    _mqttClient.subscribe(MQTT_TOPIC_ALBUMS);
+    // QoS 1 so the broker queues what changes while we are offline
+    for (size_t i = 0; i < COMPACT_TOPIC_COUNT; i++) {
+        bool compact = _compactTopics & (1 << i);
+        _mqttClient.subscribe(compact ? COMPACT_TOPICS[i].compact : COMPACT_TOPICS[i].json, 1);
+    }
+    _mqttClient.subscribe(MQTT_TOPIC_IMAGE, 1);
+    _mqttClient.subscribe(MQTT_TOPIC_PLAYLIST_TABLE, 1);
+    _mqttClient.subscribe(MQTT_TOPIC_ALBUM_TABLE, 1);
+    _mqttClient.subscribe(_sessionTopic);
+    if (OTA_ENABLE) {
+        char otaFilter[72];
+        snprintf(otaFilter, sizeof(otaFilter), "%s+", _otaTopic);
+        _mqttClient.subscribe(otaFilter, 1);
+    }
+    if (MQTT_COMPACT_ENABLE) {
+        requestCompact();
+    }
+    _subscribed = true;
 
     Serial.println("Subscribed to all topics");
 }
 
+// Our own session topic only reaches us if the broker still has our subscriptions
+void MQTTClient::probeSession() {
+    _probingSession = true;
+    _probeSentMs = millis();
+    _mqttClient.publish(_sessionTopic, "probe");
+}
+
+// Retained, so a backend that starts after us still finds it. The backend that owns
+// this dial answers on our accept topic with the topics it will send compact.
+void MQTTClient::requestCompact() {
+    char topic[80];
+    snprintf(topic, sizeof(topic), "%saccept", _encodingTopic);
+    _mqttClient.subscribe(topic, 1);
+
+    StaticJsonDocument<192> doc;
+    doc["format"] = COMPACT_FORMAT;
+    doc["dictionary"] = COMPACT_DICTIONARY_VERSION;
+    JsonArray topics = doc.createNestedArray("topics");
+    for (size_t i = 0; i < COMPACT_TOPIC_COUNT; i++) {
+        topics.add(COMPACT_TOPICS[i].name);
+    }
+
+    char payload[128];
+    size_t length = serializeJson(doc, payload);
+    snprintf(topic, sizeof(topic), "%srequest", _encodingTopic);
+    _mqttClient.publish(topic, (const uint8_t*)payload, (unsigned int)length, true);
+}
+
+// Switch each topic between its JSON and compact form; the new one is subscribed
+// before the old one is dropped so no update falls in between
+void MQTTClient::useCompact(uint8_t topics) {
+    if (topics == _compactTopics) return;
+
+    for (size_t i = 0; i < COMPACT_TOPIC_COUNT; i++) {
+        uint8_t bit = 1 << i;
+        if (!((topics ^ _compactTopics) & bit)) continue;
+
+        bool compact = topics & bit;
+        _mqttClient.subscribe(compact ? COMPACT_TOPICS[i].compact : COMPACT_TOPICS[i].json, 1);
+        _mqttClient.unsubscribe(compact ? COMPACT_TOPICS[i].json : COMPACT_TOPICS[i].compact);
+        Serial.printf("MQTT %s now %s\n", COMPACT_TOPICS[i].name, compact ? "compact" : "JSON");
+    }
+    _compactTopics = topics;
+}
+
+void MQTTClient::measureRtt() {
+    if (_state != MQTT_CONNECTED) return;
+
+    // A ping lost with the session is given up after the probe timeout
+    if (_rttPending && micros() - _rttSentUs < MQTT_SESSION_PROBE_MS * 1000UL) return;
+
+    _rttPending = true;
+    _rttSentUs = micros();
+    _mqttClient.publish(_sessionTopic, "ping");
+}
+
+void MQTTClient::publishTraceReports() {
+    if (!_tracer) return;
+
+    char report[256];
+    while (_tracer->takeReport(report, sizeof(report))) {
+        _mqttClient.publish(MQTT_TOPIC_TRACE, report);
+    }
+}
+
 void MQTTClient::messageCallback(char* topic, uint8_t* payload, unsigned int length) {
     if (_instance) {
-        if (strcmp(topic, MQTT_TOPIC_STATUS) == 0) {
+        if (strcmp(topic, _instance->_sessionTopic) == 0) {
+            if (_instance->_probingSession) {
+                Serial.println("MQTT session resumed");
+                _instance->_probingSession = false;
+            }
+            if (_instance->_rttPending && length == 4 && memcmp(payload, "ping", 4) == 0) {
+                _instance->_rttPending = false;
+                _instance->_rttUs = micros() - _instance->_rttSentUs;
+            }
+        } else if (strncmp(topic, _instance->_otaTopic, strlen(_instance->_otaTopic)) == 0) {
+            _instance->handleOtaMessage(topic + strlen(_instance->_otaTopic), payload, length);
+        } else if (strncmp(topic, _instance->_encodingTopic, strlen(_instance->_encodingTopic)) == 0) {
+            if (strcmp(topic + strlen(_instance->_encodingTopic), "accept") == 0) {
+                _instance->handleEncodingAccept(payload, length);
+            }
+        } else if (strcmp(topic, MQTT_TOPIC_STATUS) == 0) {
             _instance->handleStatusMessage(payload, length);
+        } else if (strcmp(topic, MQTT_TOPIC_STATUS MQTT_COMPACT_SUFFIX) == 0) {
+            _instance->handleCompactMessage(COMPACT_KIND_STATUS, payload, length);
+        } else if (strcmp(topic, MQTT_TOPIC_PLAYLISTS MQTT_COMPACT_SUFFIX) == 0) {
+            _instance->handleCompactMessage(COMPACT_KIND_PLAYLISTS, payload, length);
+        } else if (strcmp(topic, MQTT_TOPIC_ALBUMS MQTT_COMPACT_SUFFIX) == 0) {
+            _instance->handleCompactMessage(COMPACT_KIND_ALBUMS, payload, length);
         } else if (strcmp(topic, MQTT_TOPIC_IMAGE) == 0) {
             _instance->handleImageMessage(payload, length);
         } else if (strcmp(topic, MQTT_TOPIC_PLAYLISTS) == 0) {
             _instance->handlePlaylistsMessage(payload, length);
         } else if (strcmp(topic, MQTT_TOPIC_ALBUMS) == 0) {
             _instance->handleAlbumsMessage(payload, length);
+        } else if (strcmp(topic, MQTT_TOPIC_PLAYLIST_TABLE) == 0) {
+            if (_instance->_playlistTableCallback) _instance->_playlistTableCallback(payload, length);
+        } else if (strcmp(topic, MQTT_TOPIC_ALBUM_TABLE) == 0) {
+            if (_instance->_albumTableCallback) _instance->_albumTableCallback(payload, length);
         }
     }
 }
@@ -96,7 +323,10 @@ void MQTTClient::messageCallback(char* topic, uint8_t* payload, unsigned int len
 void MQTTClient::handleStatusMessage(uint8_t* payload, unsigned int length) {
     if (!_statusCallback) return;
 
-    StaticJsonDocument<1024> doc;
+    unsigned long receivedUs = micros();
+
+    // Room for the names, the cover URL and the art preview
+    StaticJsonDocument<1536> doc;
     DeserializationError error = deserializeJson(doc, payload, length);
 
     if (error) {
@@ -113,7 +343,69 @@ void MQTTClient::handleStatusMessage(uint8_t* payload, unsigned int length) {
     int volumePercent = doc["volumePercent"] | 0;
     bool isPlaying = doc["isPlaying"] | false;
 
+    deliverStatus(trackName, artistName, albumName, progressMs, durationMs, volumePercent, isPlaying,
+                  doc["correlationId"].as<const char*>(), doc["backendUs"].as<long>(),
+                  doc["artPreview"].as<const char*>(), receivedUs);
+}
+
+void MQTTClient::handleCompactMessage(uint8_t kind, uint8_t* payload, unsigned int length) {
+    unsigned long receivedUs = micros();
+
+    if (!_compactReader.begin(payload, length) || _compactReader.kind() != kind) {
+        Serial.println("Ignoring compact payload of another format or dictionary");
+        return;
+    }
+
+    if (kind == COMPACT_KIND_PLAYLISTS) {
+        if (_playlistsCompactCallback) _playlistsCompactCallback(_compactReader);
+    } else if (kind == COMPACT_KIND_ALBUMS) {
+        if (_albumsCompactCallback) _albumsCompactCallback(_compactReader);
+    } else if (_statusCallback) {
+        // Too large for the stack next to the callbacks
+        static CompactStatus status;
+        if (!_compactReader.readStatus(status)) {
+            Serial.println("Compact status is corrupt");
+            return;
+        }
+        deliverStatus(status.track, status.artist, status.album, status.progressMs, status.durationMs,
+                      status.volumePercent, status.isPlaying,
+                      status.correlationId[0] ? status.correlationId : nullptr, status.backendUs,
+                      status.artPreview[0] ? status.artPreview : nullptr, receivedUs);
+    }
+}
+
+// An empty or unreadable accept, or one for another format, means JSON for everything
+void MQTTClient::handleEncodingAccept(uint8_t* payload, unsigned int length) {
+    uint8_t topics = 0;
+
+    StaticJsonDocument<256> doc;
+    if (!deserializeJson(doc, payload, length) &&
+        (doc["format"] | 0) == COMPACT_FORMAT && (doc["dictionary"] | 0) == COMPACT_DICTIONARY_VERSION) {
+        for (JsonVariant topic : doc["topics"].as<JsonArray>()) {
+            for (size_t i = 0; i < COMPACT_TOPIC_COUNT; i++) {
+                if (strcmp(topic | "", COMPACT_TOPICS[i].name) == 0) topics |= 1 << i;
+            }
+        }
+    }
+
+    useCompact(topics);
+}
+
+void MQTTClient::deliverStatus(const char* trackName, const char* artistName, const char* albumName,
+                               int progressMs, int durationMs, int volumePercent, bool isPlaying,
+                               const char* correlationId, long backendUs, const char* artPreview,
+                               unsigned long receivedUs) {
+    // Status published in response to one of our traced commands
+    if (_tracer && correlationId) {
+        _tracer->onStatus(correlationId, backendUs, receivedUs);
+    }
+
     _statusCallback(trackName, artistName, albumName, progressMs, durationMs, volumePercent, isPlaying);
+
+    // After the status, so a track change is known before its cover
+    if (_artPreviewCallback && artPreview) {
+        _artPreviewCallback(artPreview);
+    }
 }
 
 void MQTTClient::handleImageMessage(uint8_t* payload, unsigned int length) {
@@ -154,23 +446,87 @@ void MQTTClient::handleAlbumsMessage(uint8_t* payload, unsigned int length) {
     _albumsCallback(albums);
 }
 
+void MQTTClient::handleOtaMessage(const char* topic, uint8_t* payload, unsigned int length) {
+    if (strcmp(topic, "offer") == 0) {
+        if (_otaOfferCallback) _otaOfferCallback(payload, length);
+    } else if (strcmp(topic, "data") == 0) {
+        if (_otaDataCallback) _otaDataCallback(payload, length);
+    }
+}
+
+// Not journaled: the updater repeats what it still needs after a reconnect
+bool MQTTClient::sendOtaRequest(const char* json) {
+    if (_state != MQTT_CONNECTED) return false;
+    return _mqttClient.publish(MQTT_TOPIC_OTA_REQUEST, (const uint8_t*)json, (unsigned int)strlen(json), false);
+}
+
+// Fire and forget like the trace reports; the watchdog keeps a record until it went out
+bool MQTTClient::sendStallReport(const char* json) {
+    if (_state != MQTT_CONNECTED) return false;
+    return _mqttClient.publish(MQTT_TOPIC_STALL, (const uint8_t*)json, (unsigned int)strlen(json), false);
+}
+
+bool MQTTClient::sendCoreDump(const uint8_t* chunk, size_t length) {
+    if (_state != MQTT_CONNECTED) return false;
+
+    char topic[80];
+    snprintf(topic, sizeof(topic), "%s%s", MQTT_TOPIC_COREDUMP_PREFIX, _clientId);
+    return _mqttClient.publish(topic, chunk, (unsigned int)length, false);
+}
+
+// Every command goes through the journal so nothing is lost while the broker is
+// unreachable; when connected it is published right away
 void MQTTClient::sendCommand(const char* command, const char* parameter) {
+    _journal.push(command, parameter);
+
+    if (_state == MQTT_CONNECTED) {
+        flushJournal();
+    } else {
+        Serial.printf("Offline, queued %s (%u pending)\n", command, (unsigned)_journal.size());
+    }
+}
+
+void MQTTClient::flushJournal() {
+    // A few per call so a long replay does not hold up the UI
+    for (int i = 0; i < COMMAND_REPLAY_BURST; i++) {
+        const CommandJournal::Entry* entry = _journal.peek();
+        if (!entry) return;
+
+        // Keep it for the next attempt; the connection is most likely gone
+        if (!publishCommand(*entry)) return;
+        _journal.pop();
+    }
+}
+
+bool MQTTClient::publishCommand(const CommandJournal::Entry& entry) {
     StaticJsonDocument<256> doc;
-    doc["command"] = command;
-    if (parameter) {
-        doc["parameter"] = parameter;
+    doc["command"] = (const char*)entry.command;
+    doc["deviceId"] = (const char*)_clientId;
+    if (entry.parameter[0]) {
+        doc["parameter"] = (const char*)entry.parameter;
+    }
+    doc["commandId"] = (const char*)entry.commandId;
+    if (_tracer) {
+        const char* correlationId = _tracer->startCommand(entry.command);
+        if (correlationId) {
+            doc["correlationId"] = correlationId;
+        }
     }
 
     char buffer[256];
     size_t length = serializeJson(doc, buffer);
 
-    if (_mqttClient.publish(MQTT_TOPIC_COMMAND, buffer, length)) {
+    // publish(topic, char*, size_t) would resolve to the (topic, payload, retained)
+    // overload and leave the last command retained on the broker
+    if (_mqttClient.publish(MQTT_TOPIC_COMMAND, (const uint8_t*)buffer, (unsigned int)length, false)) {
         Serial.print("Command sent: ");
-        Serial.println(command);
-    } else {
-        Serial.print("Failed to send command: ");
-        Serial.println(command);
+        Serial.println(entry.command);
+        return true;
     }
+
+    Serial.print("Failed to send command: ");
+    Serial.println(entry.command);
+    return false;
 }
 
 void MQTTClient::play() {
@@ -203,6 +559,12 @@ void MQTTClient::setVolume(int volume) {
     sendCommand("set_volume", volumeStr);
 }
 
+void MQTTClient::seek(int positionMs) {
+    char positionStr[12];
+    snprintf(positionStr, sizeof(positionStr), "%d", positionMs);
+    sendCommand("seek", positionStr);
+}
+
 void MQTTClient::changePlaylist(const char* playlistId) {
     sendCommand("change_playlist", playlistId);
 }
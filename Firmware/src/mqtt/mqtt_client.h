@@ -5,14 +5,22 @@
 #include <WiFi.h>
 #include <ArduinoJson.h>
 #include "config.h"
+#include "trace/latency_tracer.h"
+#include "command_journal.h"
+#include "compact_reader.h"
+#include "tls_client.h"
 
 // Callback types
 typedef void (*StatusCallback)(const char* trackName, const char* artistName,
                                const char* albumName, int progressMs, int durationMs,
                                int volumePercent, bool isPlaying);
+typedef void (*ArtPreviewCallback)(const char* preview);
 typedef void (*ImageCallback)(uint8_t* imageData, size_t length);
 typedef void (*PlaylistsCallback)(JsonArray playlists);
 typedef void (*AlbumsCallback)(JsonArray albums);
+typedef void (*CompactListCallback)(CompactReader& reader);
+typedef void (*TableChunkCallback)(const uint8_t* chunk, size_t length);
+typedef void (*OtaCallback)(const uint8_t* payload, size_t length);
 
 class MQTTClient {
 public:
@@ -23,8 +31,9 @@ public:
     void loop();
     bool isConnected();
 
-    // Command publishing
+    // Command publishing; queued in the journal while offline
     void sendCommand(const char* command, const char* parameter = nullptr);
+    size_t pendingCommands() const { return _journal.size(); }
     void play();
     void pause();
     void nextTrack();
@@ -32,6 +41,7 @@ public:
     void volumeUp();
     void volumeDown();
     void setVolume(int volume);
+    void seek(int positionMs);
     void changePlaylist(const char* playlistId);
     void changeAlbum(const char* albumId);
     void getPlaylists();
@@ -39,31 +49,113 @@ public:
 
     // Callbacks
     void onStatus(StatusCallback callback) { _statusCallback = callback; }
+    void onArtPreview(ArtPreviewCallback callback) { _artPreviewCallback = callback; }
     void onImage(ImageCallback callback) { _imageCallback = callback; }
     void onPlaylists(PlaylistsCallback callback) { _playlistsCallback = callback; }
     void onAlbums(AlbumsCallback callback) { _albumsCallback = callback; }
+    void onPlaylistsCompact(CompactListCallback callback) { _playlistsCompactCallback = callback; }
+    void onAlbumsCompact(CompactListCallback callback) { _albumsCompactCallback = callback; }
+    void onPlaylistTable(TableChunkCallback callback) { _playlistTableCallback = callback; }
+    void onAlbumTable(TableChunkCallback callback) { _albumTableCallback = callback; }
+    void onOtaOffer(OtaCallback callback) { _otaOfferCallback = callback; }
+    void onOtaData(OtaCallback callback) { _otaDataCallback = callback; }
+
+    // Firmware update announcements, requests and results
+    bool sendOtaRequest(const char* json);
+
+    // Stall and panic reports, and core dump chunks on our core dump topic
+    bool sendStallReport(const char* json);
+    bool sendCoreDump(const uint8_t* chunk, size_t length);
+    const char* clientId() const { return _clientId; }
+
+    // Attach correlation ids to commands and publish trace reports
+    void setTracer(LatencyTracer* tracer) { _tracer = tracer; }
+
+    // Round trip through the broker, measured on our session topic
+    void measureRtt();
+    uint32_t rttUs() const { return _rttUs; }
+    uint32_t reconnects() const { return _reconnects; }
 
 private:
+    enum ConnectionState : uint8_t {
+        MQTT_DISCONNECTED,
+        MQTT_CONNECTING,     // Connect task owns _mqttClient; do not touch it
+        MQTT_CONNECT_DONE,   // Connect task finished, result in _connectResult
+        MQTT_CONNECTED
+    };
+
     WiFiClient _wifiClient;
+    TlsClient _tlsClient;     // Used instead of _wifiClient with MQTT_USE_TLS
     PubSubClient _mqttClient;
 
     StatusCallback _statusCallback;
+    ArtPreviewCallback _artPreviewCallback;
     ImageCallback _imageCallback;
     PlaylistsCallback _playlistsCallback;
     AlbumsCallback _albumsCallback;
+    CompactListCallback _playlistsCompactCallback;
+    CompactListCallback _albumsCompactCallback;
+    TableChunkCallback _playlistTableCallback;
+    TableChunkCallback _albumTableCallback;
+    OtaCallback _otaOfferCallback;
+    OtaCallback _otaDataCallback;
+    LatencyTracer* _tracer;
 
     unsigned long _lastReconnectAttempt;
+    unsigned long _reconnectDelay;  // Backoff, doubled after every failure
+    unsigned long _reconnectWait;   // Jittered wait before the next attempt
+    char _clientId[40];  // Also identifies this dial's command queue on the backend
+    char _sessionTopic[64];
+    char _otaTopic[64];  // Prefix of our offer and data topics
+    char _encodingTopic[64];  // Prefix of our encoding request and accept topics
+
+    // Status and list topics the backend sends us compact, one bit per entry of COMPACT_TOPICS
+    uint8_t _compactTopics;
+    CompactReader _compactReader;
+
+    // Subscriptions live in the broker session; only redo them when it was lost
+    bool _subscribed;
+    bool _probingSession;
+    unsigned long _probeSentMs;
+
+    // Broker round trip and connections after the first
+    bool _rttPending;
+    unsigned long _rttSentUs;
+    uint32_t _rttUs;
+    uint32_t _reconnects;
+
+    volatile ConnectionState _state;
+    volatile bool _connectResult;
+    CommandJournal _journal;
 
     // Connection helpers
-    bool reconnect();
+    bool startConnect();
+    static void connectTask(void* arg);
+    void onConnectDone();
+    void scheduleReconnect(unsigned long now);
     void subscribe();
+    void probeSession();
+    void requestCompact();
+    void useCompact(uint8_t topics);
+    void publishTraceReports();
+
+    // Publish queued commands, a few per call
+    void flushJournal();
+    bool publishCommand(const CommandJournal::Entry& entry);
 
     // Message handling
     static void messageCallback(char* topic, uint8_t* payload, unsigned int length);
     void handleStatusMessage(uint8_t* payload, unsigned int length);
+    void handleCompactMessage(uint8_t kind, uint8_t* payload, unsigned int length);
+    void handleEncodingAccept(uint8_t* payload, unsigned int length);
+    void deliverStatus(const char* trackName, const char* artistName, const char* albumName,
+                       int progressMs, int durationMs, int volumePercent, bool isPlaying,
+                       const char* correlationId, long backendUs, const char* artPreview,
+                       unsigned long receivedUs);
     void handleImageMessage(uint8_t* payload, unsigned int length);
     void handlePlaylistsMessage(uint8_t* payload, unsigned int length);
     void handleAlbumsMessage(uint8_t* payload, unsigned int length);
+    void handleOtaMessage(const char* topic, uint8_t* payload, unsigned int length);
 
     // Static instance for callback
     static MQTTClient* _instance;
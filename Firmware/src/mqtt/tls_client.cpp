@@ -0,0 +1,392 @@
+#include "tls_client.h"
+#include <esp_attr.h>
+#include <mbedtls/error.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/pk.h>
+#include <mbedtls/sha256.h>
+
+// AES-GCM and SHA-256 run on the hardware accelerators, ECDHE on P-256 uses the
+// bignum unit; ChaCha20 and CBC suites would fall back to software
+static const int kCiphersuites[] = {
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+    0
+};
+
+static const mbedtls_ecp_group_id kCurves[] = {
+    MBEDTLS_ECP_DP_SECP256R1,
+    MBEDTLS_ECP_DP_NONE
+};
+
+// Serialized session for the last broker. RTC memory survives software resets
+// and deep sleep but not a power cycle, hence the magic and checksum.
+struct SessionCache {
+    uint32_t magic;
+    uint32_t endpoint;  // Hash of host and port the session belongs to
+    uint32_t length;
+    uint32_t checksum;
+    uint8_t data[MQTT_TLS_SESSION_CACHE_SIZE];
+};
+
+RTC_NOINIT_ATTR static SessionCache rtcSession;
+static const uint32_t kSessionMagic = 0x544c5331;
+
+static uint32_t fnv1a(const uint8_t* data, size_t length, uint32_t hash = 2166136261u) {
+    for (size_t i = 0; i < length; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t endpointHash(const char* host, uint16_t port) {
+    uint32_t hash = fnv1a((const uint8_t*)host, strlen(host));
+    return fnv1a((const uint8_t*)&port, sizeof(port), hash);
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+TlsClient::TlsClient()
+    : _hasPin(false),
+      _ready(false),
+      _sslActive(false),
+      _connected(false),
+      _certSeen(false),
+      _pinMismatch(false),
+      _peeked(-1),
+      _handshakeMs(0),
+      _resumed(false),
+      _coldCount(0),
+      _coldTotalMs(0),
+      _resumedCount(0),
+      _resumedTotalMs(0) {
+    mbedtls_ssl_config_init(&_conf);
+    mbedtls_entropy_init(&_entropy);
+    mbedtls_ctr_drbg_init(&_drbg);
+    mbedtls_x509_crt_init(&_ca);
+}
+
+TlsClient::~TlsClient() {
+    stop();
+    mbedtls_x509_crt_free(&_ca);
+    mbedtls_ctr_drbg_free(&_drbg);
+    mbedtls_entropy_free(&_entropy);
+    mbedtls_ssl_config_free(&_conf);
+}
+
+bool TlsClient::begin(const char* caCertPem, const char* pinSha256Hex) {
+    static const char personalization[] = "spotidial-mqtt";
+    int ret = mbedtls_ctr_drbg_seed(&_drbg, mbedtls_entropy_func, &_entropy,
+                                    (const unsigned char*)personalization, sizeof(personalization) - 1);
+    if (ret != 0) {
+        logError("RNG seed", ret);
+        return false;
+    }
+
+    // PEM input must include the terminating NUL in its length
+    ret = mbedtls_x509_crt_parse(&_ca, (const unsigned char*)caCertPem, strlen(caCertPem) + 1);
+    if (ret != 0) {
+        logError("CA certificate (run mosquitto/make-certs.sh)", ret);
+        return false;
+    }
+
+    ret = mbedtls_ssl_config_defaults(&_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                      MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret != 0) {
+        logError("config", ret);
+        return false;
+    }
+
+    mbedtls_ssl_conf_authmode(&_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_ca_chain(&_conf, &_ca, nullptr);
+    mbedtls_ssl_conf_verify(&_conf, verifyCallback, this);
+    mbedtls_ssl_conf_rng(&_conf, mbedtls_ctr_drbg_random, &_drbg);
+    mbedtls_ssl_conf_ciphersuites(&_conf, kCiphersuites);
+    mbedtls_ssl_conf_curves(&_conf, kCurves);
+    mbedtls_ssl_conf_min_version(&_conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
+    mbedtls_ssl_conf_session_tickets(&_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+
+    _hasPin = pinSha256Hex && strlen(pinSha256Hex) == 2 * sizeof(_pin);
+    for (size_t i = 0; _hasPin && i < sizeof(_pin); i++) {
+        int high = hexValue(pinSha256Hex[2 * i]);
+        int low = hexValue(pinSha256Hex[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            Serial.println("TLS: ignoring malformed MQTT_TLS_PIN_SHA256");
+            _hasPin = false;
+            break;
+        }
+        _pin[i] = (uint8_t)(high << 4 | low);
+    }
+
+    _ready = true;
+    return true;
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port) {
+    // The broker certificate then needs the address as its CN
+    return connect(ip.toString().c_str(), port);
+}
+
+int TlsClient::connect(const char* host, uint16_t port) {
+    if (!_ready) {
+        Serial.println("TLS: not configured");
+        return 0;
+    }
+
+    stop();
+    if (!_tcp.connect(host, port)) return 0;
+
+    mbedtls_ssl_init(&_ssl);
+    _sslActive = true;
+
+    int ret = mbedtls_ssl_setup(&_ssl, &_conf);
+    if (ret == 0) ret = mbedtls_ssl_set_hostname(&_ssl, host);
+    if (ret != 0) {
+        logError("setup", ret);
+        stop();
+        return 0;
+    }
+    mbedtls_ssl_set_bio(&_ssl, this, sendCallback, recvCallback, nullptr);
+
+    if (MQTT_TLS_SESSION_RESUME) {
+        restoreSession(host, port);
+    }
+
+    _certSeen = false;
+    _pinMismatch = false;
+    unsigned long started = millis();
+
+    while ((ret = mbedtls_ssl_handshake(&_ssl)) != 0) {
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            logError(_pinMismatch ? "handshake (public key pin mismatch)" : "handshake", ret);
+            forgetSession();
+            stop();
+            return 0;
+        }
+        if (millis() - started > MQTT_TLS_HANDSHAKE_TIMEOUT_MS) {
+            Serial.println("TLS: handshake timed out");
+            stop();
+            return 0;
+        }
+        delay(1);
+    }
+
+    // The certificate is only sent, and verified, in a full handshake
+    _handshakeMs = millis() - started;
+    _resumed = !_certSeen;
+    if (_resumed) {
+        _resumedCount++;
+        _resumedTotalMs += _handshakeMs;
+    } else {
+        _coldCount++;
+        _coldTotalMs += _handshakeMs;
+    }
+
+    // The broker may have issued a fresh ticket either way
+    if (MQTT_TLS_SESSION_RESUME) {
+        saveSession(host, port);
+    }
+
+    _connected = true;
+    return 1;
+}
+
+size_t TlsClient::write(uint8_t b) {
+    return write(&b, 1);
+}
+
+size_t TlsClient::write(const uint8_t* buf, size_t size) {
+    if (!_connected) return 0;
+
+    size_t sent = 0;
+    unsigned long started = millis();
+    while (sent < size) {
+        int ret = mbedtls_ssl_write(&_ssl, buf + sent, size - sent);
+        if (ret > 0) {
+            sent += ret;
+            continue;
+        }
+        if (ret != MBEDTLS_ERR_SSL_WANT_WRITE && ret != MBEDTLS_ERR_SSL_WANT_READ) {
+            logError("write", ret);
+            stop();
+            break;
+        }
+        if (millis() - started > MQTT_TLS_HANDSHAKE_TIMEOUT_MS) break;
+        delay(1);
+    }
+    return sent;
+}
+
+int TlsClient::available() {
+    if (!_connected) return 0;
+
+    int pending = _peeked >= 0 ? 1 : 0;
+    if (mbedtls_ssl_get_bytes_avail(&_ssl) == 0) {
+        // A zero-length read pulls in the next record if one has arrived
+        int ret = mbedtls_ssl_read(&_ssl, nullptr, 0);
+        if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            if (ret != MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) logError("read", ret);
+            stop();
+            return pending;
+        }
+    }
+    return pending + (int)mbedtls_ssl_get_bytes_avail(&_ssl);
+}
+
+int TlsClient::read() {
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+}
+
+int TlsClient::read(uint8_t* buf, size_t size) {
+    if (size == 0) return 0;
+
+    size_t offset = 0;
+    if (_peeked >= 0) {
+        buf[0] = (uint8_t)_peeked;
+        _peeked = -1;
+        offset = 1;
+    }
+    if (offset == size || !_connected) return offset > 0 ? (int)offset : -1;
+
+    int ret = mbedtls_ssl_read(&_ssl, buf + offset, size - offset);
+    if (ret > 0) return (int)offset + ret;
+
+    if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+        // 0 or close notify: the broker closed the connection
+        if (ret < 0 && ret != MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) logError("read", ret);
+        stop();
+    }
+    return offset > 0 ? (int)offset : -1;
+}
+
+int TlsClient::peek() {
+    if (_peeked < 0) {
+        uint8_t b;
+        if (read(&b, 1) == 1) _peeked = b;
+    }
+    return _peeked;
+}
+
+void TlsClient::flush() {
+    // Writes go out record by record; nothing is buffered here
+}
+
+void TlsClient::stop() {
+    if (_sslActive) {
+        if (_connected) mbedtls_ssl_close_notify(&_ssl);
+        mbedtls_ssl_free(&_ssl);
+        _sslActive = false;
+    }
+    _connected = false;
+    _peeked = -1;
+    _tcp.stop();
+}
+
+uint8_t TlsClient::connected() {
+    if (_connected && !_tcp.connected() && available() == 0) {
+        stop();
+    }
+    return _connected;
+}
+
+unsigned long TlsClient::averageHandshakeMs(bool resumed) const {
+    if (resumed) return _resumedCount > 0 ? _resumedTotalMs / _resumedCount : 0;
+    return _coldCount > 0 ? _coldTotalMs / _coldCount : 0;
+}
+
+void TlsClient::forgetSession() {
+    rtcSession.magic = 0;
+}
+
+void TlsClient::restoreSession(const char* host, uint16_t port) {
+    if (rtcSession.magic != kSessionMagic ||
+        rtcSession.endpoint != endpointHash(host, port) ||
+        rtcSession.length > sizeof(rtcSession.data) ||
+        rtcSession.checksum != fnv1a(rtcSession.data, rtcSession.length)) {
+        return;
+    }
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    if (mbedtls_ssl_session_load(&session, rtcSession.data, rtcSession.length) == 0) {
+        mbedtls_ssl_set_session(&_ssl, &session);
+    } else {
+        forgetSession();
+    }
+    mbedtls_ssl_session_free(&session);
+}
+
+void TlsClient::saveSession(const char* host, uint16_t port) {
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+
+    size_t length = 0;
+    if (mbedtls_ssl_get_session(&_ssl, &session) == 0 &&
+        mbedtls_ssl_session_save(&session, rtcSession.data, sizeof(rtcSession.data), &length) == 0) {
+        rtcSession.endpoint = endpointHash(host, port);
+        rtcSession.length = length;
+        rtcSession.checksum = fnv1a(rtcSession.data, length);
+        rtcSession.magic = kSessionMagic;
+    } else {
+        // Too large for the cache (long certificate chain) or nothing to resume
+        forgetSession();
+    }
+    mbedtls_ssl_session_free(&session);
+}
+
+int TlsClient::sendCallback(void* ctx, const unsigned char* buf, size_t len) {
+    TlsClient* self = static_cast<TlsClient*>(ctx);
+    if (!self->_tcp.connected()) return MBEDTLS_ERR_NET_CONN_RESET;
+
+    size_t written = self->_tcp.write(buf, len);
+    return written > 0 ? (int)written : MBEDTLS_ERR_SSL_WANT_WRITE;
+}
+
+int TlsClient::recvCallback(void* ctx, unsigned char* buf, size_t len) {
+    TlsClient* self = static_cast<TlsClient*>(ctx);
+
+    int available = self->_tcp.available();
+    if (available <= 0) {
+        return self->_tcp.connected() ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_CONN_RESET;
+    }
+
+    int read = self->_tcp.read(buf, len < (size_t)available ? len : (size_t)available);
+    return read > 0 ? read : MBEDTLS_ERR_SSL_WANT_READ;
+}
+
+// Called for every certificate in the chain, only during a full handshake
+int TlsClient::verifyCallback(void* ctx, mbedtls_x509_crt* crt, int depth, uint32_t* flags) {
+    TlsClient* self = static_cast<TlsClient*>(ctx);
+    self->_certSeen = true;
+
+    if (depth != 0 || !self->_hasPin) return 0;
+
+    // Pin the SubjectPublicKeyInfo, which survives certificate renewal with the same key.
+    // mbedtls writes the DER at the end of the buffer.
+    unsigned char der[600];
+    int length = mbedtls_pk_write_pubkey_der(&crt->pk, der, sizeof(der));
+    if (length <= 0) {
+        *flags |= MBEDTLS_X509_BADCERT_OTHER;
+        return 0;
+    }
+
+    unsigned char hash[32];
+    mbedtls_sha256_ret(der + sizeof(der) - length, length, hash, 0);
+    if (memcmp(hash, self->_pin, sizeof(hash)) != 0) {
+        self->_pinMismatch = true;
+        *flags |= MBEDTLS_X509_BADCERT_NOT_TRUSTED;
+    }
+    return 0;
+}
+
+void TlsClient::logError(const char* what, int ret) {
+    char message[96];
+    mbedtls_strerror(ret, message, sizeof(message));
+    Serial.printf("TLS: %s failed: -0x%04x %s\n", what, (unsigned)-ret, message);
+}
@@ -0,0 +1,85 @@
+#ifndef TLS_CLIENT_H
+#define TLS_CLIENT_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <WiFi.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/x509_crt.h>
+#include "config.h"
+
+/**
+ * TLS transport for PubSubClient, built directly on mbedtls so the handshake
+ * can be tuned:
+ * - the broker must chain to the given CA and can additionally be pinned to
+ *   the SHA-256 of its public key
+ * - only ECDHE with AES-GCM is offered, which runs on the S3's AES, SHA and
+ *   bignum accelerators
+ * - the last session (ticket) is kept in RTC memory, so reconnects, also after
+ *   a software reset or deep sleep, use the abbreviated handshake
+ */
+class TlsClient : public Client {
+public:
+    TlsClient();
+    ~TlsClient();
+
+    // Parse the CA and seed the RNG. pinSha256Hex may be empty to trust the CA alone.
+    bool begin(const char* caCertPem, const char* pinSha256Hex);
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char* host, uint16_t port) override;
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buf, size_t size) override;
+    int peek() override;
+    void flush() override;
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override { return connected(); }
+
+    // Timing of the last successful handshake and running averages
+    unsigned long handshakeMs() const { return _handshakeMs; }
+    bool resumed() const { return _resumed; }
+    unsigned long averageHandshakeMs(bool resumed) const;
+
+    // Drop the cached session, e.g. after the broker rejected it
+    void forgetSession();
+
+private:
+    static int sendCallback(void* ctx, const unsigned char* buf, size_t len);
+    static int recvCallback(void* ctx, unsigned char* buf, size_t len);
+    static int verifyCallback(void* ctx, mbedtls_x509_crt* crt, int depth, uint32_t* flags);
+
+    void restoreSession(const char* host, uint16_t port);
+    void saveSession(const char* host, uint16_t port);
+    void logError(const char* what, int ret);
+
+    WiFiClient _tcp;
+    mbedtls_ssl_context _ssl;
+    mbedtls_ssl_config _conf;
+    mbedtls_entropy_context _entropy;
+    mbedtls_ctr_drbg_context _drbg;
+    mbedtls_x509_crt _ca;
+
+    uint8_t _pin[32];
+    bool _hasPin;
+    bool _ready;        // begin() succeeded
+    bool _sslActive;    // _ssl is set up and must be freed
+    bool _connected;
+    bool _certSeen;     // Verify callback ran, so this was a full handshake
+    bool _pinMismatch;
+    int _peeked;
+
+    unsigned long _handshakeMs;
+    bool _resumed;
+    unsigned long _coldCount;
+    unsigned long _coldTotalMs;
+    unsigned long _resumedCount;
+    unsigned long _resumedTotalMs;
+};
+
+#endif // TLS_CLIENT_H
@@ -0,0 +1,415 @@
+#include "ota_updater.h"
+#include <esp_ota_ops.h>
+#include <new>
+
+static uint32_t readLE32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Keep the bootloader from cancelling a rollback before we have checked the
+// new image ourselves; the Arduino core marks the app valid at boot otherwise
+extern "C" bool verifyRollbackLater() {
+    return true;
+}
+
+bool PartitionPatchIO::readBase(uint32_t offset, uint8_t* buffer, size_t length) {
+    return esp_partition_read(base, offset, buffer, length) == ESP_OK;
+}
+
+// The applier writes whole sectors from sector boundaries, the last one of a
+// block possibly short, so every write starts by erasing its sector
+bool PartitionPatchIO::writeTarget(uint32_t offset, const uint8_t* data, size_t length) {
+    unsigned long start = micros();
+    bool ok = esp_partition_erase_range(target, offset, PATCH_SECTOR_SIZE) == ESP_OK &&
+              esp_partition_write(target, offset, data, length) == ESP_OK;
+    flashUs += micros() - start;
+    return ok;
+}
+
+OtaUpdater::OtaUpdater()
+    : _mqtt(nullptr),
+      _announced(false),
+      _rolledBack(0),
+      _trial(false),
+      _trialPatch(0),
+      _watchdog(false),
+      _connectedAt(0),
+      _firstConnectMs(0),
+      _applier(nullptr),
+      _patchId(0),
+      _full(false),
+      _patchSize(0),
+      _imageSize(0),
+      _expected(0),
+      _windowEnd(0),
+      _savedBlock(0),
+      _received(0),
+      _retries(0),
+      _lastChunkMs(0),
+      _startMs(0),
+      _restartAt(0) {
+    _imageSha[0] = '\0';
+    memset(&_patchHeader, 0, sizeof(_patchHeader));
+}
+
+void OtaUpdater::begin() {
+    if (!OTA_ENABLE) return;
+
+    // The backend knows images by this digest; hashing the slot takes ~100 ms
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    uint8_t sha[32];
+    if (esp_partition_get_sha256(running, sha) == ESP_OK) {
+        for (int i = 0; i < 32; i++) {
+            snprintf(_imageSha + i * 2, 3, "%02x", sha[i]);
+        }
+    }
+
+    _prefs.begin("ota", false);
+
+    TrialState trial;
+    if (_prefs.getBytes("trial", &trial, sizeof(trial)) != sizeof(trial)) return;
+
+    // The bootloader already went back, or the new image never started
+    if (running->address != trial.target) {
+        Serial.printf("OTA: update %08lx was rolled back\n", (unsigned long)trial.patchId);
+        _rolledBack = trial.patchId;
+        _prefs.remove("trial");
+        return;
+    }
+
+    if (++trial.boots > OTA_TRIAL_BOOTS) {
+        Serial.printf("OTA: update %08lx not verified after %u boots, rolling back\n",
+                      (unsigned long)trial.patchId, OTA_TRIAL_BOOTS);
+        const esp_partition_t* previous = esp_ota_get_next_update_partition(nullptr);
+        if (previous && esp_ota_set_boot_partition(previous) == ESP_OK) {
+            ESP.restart();
+        }
+        Serial.println("OTA: previous image is not bootable, keeping this one");
+        _prefs.remove("trial");
+        return;
+    }
+
+    _prefs.putBytes("trial", &trial, sizeof(trial));
+    _trial = true;
+    _trialPatch = trial.patchId;
+    Serial.printf("OTA: running update %08lx on trial, boot %u of %u\n",
+                  (unsigned long)trial.patchId, trial.boots, OTA_TRIAL_BOOTS);
+}
+
+void OtaUpdater::poll() {
+    if (!OTA_ENABLE || !_mqtt) return;
+
+    // A hang on trial resets the dial and counts as a failed boot. Armed from
+    // the first loop, as setup may sit in the WiFi portal for minutes
+    if (_trial && !_watchdog) {
+        _watchdog = true;
+        enableLoopWDT();
+    }
+
+    unsigned long now = millis();
+    if (_restartAt && (long)(now - _restartAt) >= 0) {
+        Serial.println("OTA: restarting into the new image");
+        ESP.restart();
+    }
+
+    if (!_mqtt->isConnected()) {
+        _announced = false;
+        _connectedAt = 0;
+        return;
+    }
+
+    if (!_firstConnectMs) _firstConnectMs = now;
+    if (!_connectedAt) _connectedAt = now;
+
+    // Every connect: the backend answers with an offer, or repeats the one in progress
+    if (!_announced) {
+        _announced = true;
+        sendHello();
+    }
+
+    if (_trial && now - _connectedAt >= OTA_VERIFY_AFTER_MS) {
+        confirm();
+    }
+
+    if (_applier && now - _lastChunkMs > OTA_CHUNK_TIMEOUT_MS) {
+        retry("timed out");
+    }
+}
+
+void OtaUpdater::sendHello() {
+    StaticJsonDocument<384> doc;
+    doc["type"] = "hello";
+    doc["clientId"] = _mqtt->clientId();
+    doc["version"] = APP_VERSION;
+    doc["image"] = (const char*)_imageSha;
+
+    char patch[12];
+    if (_rolledBack) {
+        snprintf(patch, sizeof(patch), "%08lx", (unsigned long)_rolledBack);
+        doc["rolledBack"] = (const char*)patch;
+    }
+
+    char buffer[384];
+    serializeJson(doc, buffer, sizeof(buffer));
+    _mqtt->sendOtaRequest(buffer);
+}
+
+void OtaUpdater::onOffer(const uint8_t* payload, size_t length) {
+    // No new update until the one on trial is kept
+    if (!OTA_ENABLE || _trial || _restartAt) return;
+
+    StaticJsonDocument<512> doc;
+    if (deserializeJson(doc, payload, length)) {
+        Serial.println("OTA: bad offer");
+        return;
+    }
+
+    uint32_t patchId = strtoul(doc["patch"] | "0", nullptr, 16);
+    const char* base = doc["base"] | "";
+    const char* target = doc["target"] | "";
+    bool full = doc["full"] | false;
+
+    // Offered again after a reconnect: carry on from where we are
+    if (_applier && patchId == _patchId) {
+        requestWindow();
+        return;
+    }
+    if (_applier) stop();
+
+    if (strcmp(target, _imageSha) == 0) return;
+    if (!full && strcmp(base, _imageSha) != 0) {
+        Serial.printf("OTA: patch %08lx is for another image\n", (unsigned long)patchId);
+        return;
+    }
+
+    _patchId = patchId;
+    _full = full;
+    _patchSize = doc["size"] | 0;
+    _imageSize = doc["imageSize"] | 0;
+    _io.base = esp_ota_get_running_partition();
+    _io.target = esp_ota_get_next_update_partition(nullptr);
+    _io.flashUs = 0;
+    _received = 0;
+    _retries = 0;
+    _startMs = millis();
+
+    if (!_io.target || _imageSize == 0 || _imageSize > _io.target->size || _patchSize < PATCH_HEADER_SIZE) {
+        publishResult(false, "image does not fit", 0);
+        return;
+    }
+
+    _applier = new (std::nothrow) PatchApplier();
+    if (!_applier) {
+        publishResult(false, "out of memory", 0);
+        return;
+    }
+
+    ResumeState resume;
+    if (_prefs.getBytes("resume", &resume, sizeof(resume)) == sizeof(resume) && resume.patchId == patchId) {
+        _patchHeader = resume.header;
+        _applier->begin(resume.header, &_io, resume.checkpoint);
+        _expected = resume.checkpoint.offset;
+        _savedBlock = resume.checkpoint.block;
+        Serial.printf("OTA: resuming %08lx at block %lu of %lu\n", (unsigned long)patchId,
+                      (unsigned long)_savedBlock, (unsigned long)_applier->blockCount());
+    } else {
+        _expected = 0;
+        _savedBlock = 0;
+    }
+
+    Serial.printf("OTA: %s update %08lx, %lu byte patch for a %lu byte image\n",
+                  full ? "full" : "delta", (unsigned long)patchId,
+                  (unsigned long)_patchSize, (unsigned long)_imageSize);
+    requestWindow();
+}
+
+// Chunks: u32 patch id, u32 offset, u32 CRC-32 of the data, data (little-endian)
+void OtaUpdater::onData(const uint8_t* payload, size_t length) {
+    if (!_applier || length < 12) return;
+
+    // Late and repeated chunks are dropped; the window is requested again on a gap
+    if (readLE32(payload) != _patchId || readLE32(payload + 4) != _expected) return;
+
+    const uint8_t* data = payload + 12;
+    size_t size = length - 12;
+    if (size == 0 || size > _patchSize - _expected || patchCrc32(0, data, size) != readLE32(payload + 8)) {
+        retry("bad chunk");
+        return;
+    }
+
+    _received += size;
+    _retries = 0;
+    _lastChunkMs = millis();
+
+    size_t used = 0;
+    if (_expected < PATCH_HEADER_SIZE) {
+        used = min(size, (size_t)(PATCH_HEADER_SIZE - _expected));
+        memcpy(_header + _expected, data, used);
+        _expected += used;
+        if (_expected == PATCH_HEADER_SIZE && !acceptHeader()) return;
+    }
+
+    PatchApplier::Result result = PatchApplier::PATCH_MORE;
+    if (used < size) {
+        result = _applier->feed(data + used, size - used);
+        _expected += size - used;
+    }
+
+    if (result == PatchApplier::PATCH_ERROR) {
+        fail(_applier->error(), false);
+        return;
+    }
+    if (_applier->checkpoint().block != _savedBlock) {
+        saveCheckpoint();
+    }
+
+    if (result == PatchApplier::PATCH_DONE) {
+        finish();
+    } else if (_expected >= _patchSize) {
+        fail("patch ends early", false);
+    } else if (_expected >= _windowEnd) {
+        requestWindow();
+    }
+}
+
+bool OtaUpdater::acceptHeader() {
+    PatchHeader header;
+    if (!PatchApplier::parseHeader(_header, sizeof(_header), header) ||
+        header.targetSize != _imageSize || (header.baseSize == 0) != _full ||
+        header.baseSize > _io.base->size) {
+        fail("bad patch header", false);
+        return false;
+    }
+
+    PatchCheckpoint start = {0, PATCH_HEADER_SIZE, 0};
+    _patchHeader = header;
+    _applier->begin(header, &_io, start);
+    return true;
+}
+
+void OtaUpdater::requestWindow() {
+    _windowEnd = min(_expected + (uint32_t)OTA_WINDOW_BYTES, _patchSize);
+    _lastChunkMs = millis();
+
+    char patch[12];
+    snprintf(patch, sizeof(patch), "%08lx", (unsigned long)_patchId);
+
+    StaticJsonDocument<192> doc;
+    doc["type"] = "get";
+    doc["clientId"] = _mqtt->clientId();
+    doc["patch"] = (const char*)patch;
+    doc["offset"] = _expected;
+    doc["length"] = _windowEnd - _expected;
+
+    char buffer[192];
+    serializeJson(doc, buffer, sizeof(buffer));
+    _mqtt->sendOtaRequest(buffer);
+}
+
+void OtaUpdater::retry(const char* reason) {
+    if (++_retries > OTA_MAX_RETRIES) {
+        fail(reason, true);
+        return;
+    }
+
+    Serial.printf("OTA: %s at %lu, asking again\n", reason, (unsigned long)_expected);
+    requestWindow();
+}
+
+void OtaUpdater::saveCheckpoint() {
+    ResumeState resume;
+    resume.patchId = _patchId;
+    resume.header = _patchHeader;
+    resume.checkpoint = _applier->checkpoint();
+    _prefs.putBytes("resume", &resume, sizeof(resume));
+    _savedBlock = resume.checkpoint.block;
+
+    Serial.printf("OTA: block %lu of %lu written\n",
+                  (unsigned long)_savedBlock, (unsigned long)_applier->blockCount());
+}
+
+// esp_ota_set_boot_partition checks the new image's own digest before
+// switching, on top of the CRC the applier already checked
+void OtaUpdater::finish() {
+    unsigned long activateStart = millis();
+    esp_err_t err = esp_ota_set_boot_partition(_io.target);
+    unsigned long activateMs = millis() - activateStart;
+
+    if (err != ESP_OK) {
+        fail(esp_err_to_name(err), false);
+        return;
+    }
+
+    TrialState trial;
+    trial.patchId = _patchId;
+    trial.target = _io.target->address;
+    trial.boots = 0;
+    _prefs.putBytes("trial", &trial, sizeof(trial));
+    _prefs.remove("resume");
+
+    Serial.printf("OTA: %08lx written in %lu ms (flash %lu ms), restarting\n", (unsigned long)_patchId,
+                  millis() - _startMs, (unsigned long)(_io.flashUs / 1000));
+    publishResult(true, nullptr, activateMs);
+    stop();
+    _restartAt = millis() + OTA_RESTART_DELAY_MS;
+}
+
+void OtaUpdater::fail(const char* error, bool keepProgress) {
+    Serial.printf("OTA: update %08lx failed: %s\n", (unsigned long)_patchId, error ? error : "unknown");
+    if (!keepProgress) _prefs.remove("resume");
+
+    publishResult(false, error, 0);
+    stop();
+}
+
+void OtaUpdater::stop() {
+    delete _applier;
+    _applier = nullptr;
+}
+
+void OtaUpdater::confirm() {
+    esp_ota_mark_app_valid_cancel_rollback();
+    _prefs.remove("trial");
+    _trial = false;
+    _watchdog = false;
+    disableLoopWDT();
+
+    Serial.printf("OTA: update %08lx verified\n", (unsigned long)_trialPatch);
+
+    char patch[12];
+    snprintf(patch, sizeof(patch), "%08lx", (unsigned long)_trialPatch);
+
+    // From boot to the broker: the part of the restart the backend cannot see
+    StaticJsonDocument<192> doc;
+    doc["type"] = "confirmed";
+    doc["clientId"] = _mqtt->clientId();
+    doc["patch"] = (const char*)patch;
+    doc["connectMs"] = _firstConnectMs;
+
+    char buffer[192];
+    serializeJson(doc, buffer, sizeof(buffer));
+    _mqtt->sendOtaRequest(buffer);
+}
+
+void OtaUpdater::publishResult(bool ok, const char* error, unsigned long activateMs) {
+    char patch[12];
+    snprintf(patch, sizeof(patch), "%08lx", (unsigned long)_patchId);
+
+    StaticJsonDocument<384> doc;
+    doc["type"] = "result";
+    doc["clientId"] = _mqtt->clientId();
+    doc["patch"] = (const char*)patch;
+    doc["ok"] = ok;
+    doc["full"] = _full;
+    if (error) doc["error"] = error;
+    doc["bytes"] = _received;
+    doc["patchSize"] = _patchSize;
+    doc["imageSize"] = _imageSize;
+    doc["flashMs"] = (unsigned long)(_io.flashUs / 1000);
+    doc["totalMs"] = millis() - _startMs;
+    doc["activateMs"] = activateMs;
+
+    char buffer[384];
+    serializeJson(doc, buffer, sizeof(buffer));
+    _mqtt->sendOtaRequest(buffer);
+}
@@ -0,0 +1,106 @@
+#ifndef OTA_UPDATER_H
+#define OTA_UPDATER_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <esp_partition.h>
+#include "config.h"
+#include "mqtt/mqtt_client.h"
+#include "patch_applier.h"
+
+// Flash side of a patch: reads the running slot, erases and writes the other
+class PartitionPatchIO : public PatchIO {
+public:
+    PartitionPatchIO() : base(nullptr), target(nullptr), flashUs(0) {}
+
+    bool readBase(uint32_t offset, uint8_t* buffer, size_t length) override;
+    bool writeTarget(uint32_t offset, const uint8_t* data, size_t length) override;
+
+    const esp_partition_t* base;
+    const esp_partition_t* target;
+    uint64_t flashUs;  // Time spent erasing and writing
+};
+
+/**
+ * Firmware updates over MQTT. Announces the running image when connected,
+ * fetches an offered patch window by window, applies it into the inactive
+ * slot and boots it on trial. Progress is kept in NVS at every completed
+ * block so an update survives reconnects and reboots.
+ */
+class OtaUpdater {
+public:
+    OtaUpdater();
+
+    void setClient(MQTTClient* mqtt) { _mqtt = mqtt; }
+
+    // Count a trial boot or roll back; call first thing in setup
+    void begin();
+
+    // Announce, time out requests and confirm a trial image; call once per loop
+    void poll();
+
+    // Messages on our OTA topics
+    void onOffer(const uint8_t* payload, size_t length);
+    void onData(const uint8_t* payload, size_t length);
+
+    bool isUpdating() const { return _applier != nullptr; }
+
+private:
+    // Kept in NVS while an update is in progress
+    struct ResumeState {
+        uint32_t patchId;
+        PatchHeader header;
+        PatchCheckpoint checkpoint;
+    };
+
+    // Kept in NVS while a new image is on trial
+    struct TrialState {
+        uint32_t patchId;
+        uint32_t target;   // Flash address of the new image's slot
+        uint8_t boots;
+    };
+
+    void sendHello();
+    void requestWindow();
+    void retry(const char* reason);
+    bool acceptHeader();
+    void saveCheckpoint();
+    void finish();
+    void fail(const char* error, bool keepProgress);
+    void stop();
+    void confirm();
+    void publishResult(bool ok, const char* error, unsigned long activateMs);
+
+    MQTTClient* _mqtt;
+    Preferences _prefs;
+    char _imageSha[65];
+
+    // Announcements and the trial
+    bool _announced;
+    uint32_t _rolledBack;        // Patch whose image did not survive its trial
+    bool _trial;
+    uint32_t _trialPatch;
+    bool _watchdog;
+    unsigned long _connectedAt;
+    unsigned long _firstConnectMs;
+
+    // Transfer
+    PatchApplier* _applier;
+    PartitionPatchIO _io;
+    uint32_t _patchId;
+    bool _full;
+    uint32_t _patchSize;
+    uint32_t _imageSize;
+    uint8_t _header[PATCH_HEADER_SIZE];
+    PatchHeader _patchHeader;
+    uint32_t _expected;          // Next patch offset we accept
+    uint32_t _windowEnd;
+    uint32_t _savedBlock;
+    uint32_t _received;          // Including chunks sent again
+    uint8_t _retries;
+    unsigned long _lastChunkMs;
+    unsigned long _startMs;
+    unsigned long _restartAt;
+};
+
+#endif // OTA_UPDATER_H
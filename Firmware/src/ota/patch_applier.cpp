@@ -0,0 +1,316 @@
+#include "patch_applier.h"
+#include <string.h>
+
+#define OP_COPY 0
+#define OP_ADD_BYTES 1
+#define OP_INSERT_BYTES 2
+
+static uint32_t readLE32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint32_t patchCrc32(uint32_t crc, const uint8_t* data, size_t length) {
+    static uint32_t table[256];
+    static bool tableReady = false;
+
+    if (!tableReady) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320UL ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        tableReady = true;
+    }
+
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+PatchApplier::PatchApplier()
+    : _io(nullptr),
+      _blockCount(0),
+      _result(PATCH_ERROR),
+      _error(nullptr),
+      _offset(0),
+      _block(0),
+      _blockStart(0),
+      _blockLength(0),
+      _blockCrcExpected(0),
+      _compressedLeft(0),
+      _blockHeaderFill(0),
+      _inBlock(false),
+      _windowPos(0),
+      _bits(0),
+      _bitCount(0),
+      _opState(OP_CODE),
+      _op(0),
+      _varint(0),
+      _varintShift(0),
+      _opLength(0),
+      _baseCursor(0),
+      _baseStart(0),
+      _baseFill(0),
+      _outFill(0),
+      _produced(0),
+      _crc(0),
+      _blockCrc(0) {
+    memset(&_header, 0, sizeof(_header));
+    memset(&_checkpoint, 0, sizeof(_checkpoint));
+}
+
+bool PatchApplier::parseHeader(const uint8_t* data, size_t length, PatchHeader& header) {
+    if (length < PATCH_HEADER_SIZE || memcmp(data, "SDP1", 4) != 0) return false;
+
+    header.windowBits = data[4];
+    header.lengthBits = data[5];
+    header.blockSize = readLE32(data + 8);
+    header.baseSize = readLE32(data + 12);
+    header.targetSize = readLE32(data + 16);
+    header.targetCrc = readLE32(data + 20);
+
+    return header.windowBits >= 8 && header.windowBits <= PATCH_MAX_WINDOW_BITS &&
+           header.lengthBits >= 3 && header.lengthBits <= PATCH_MAX_LENGTH_BITS &&
+           header.blockSize > 0 && header.blockSize % PATCH_SECTOR_SIZE == 0 &&
+           header.targetSize > 0;
+}
+
+void PatchApplier::begin(const PatchHeader& header, PatchIO* io, const PatchCheckpoint& checkpoint) {
+    _header = header;
+    _io = io;
+    _checkpoint = checkpoint;
+    _blockCount = (header.targetSize + header.blockSize - 1) / header.blockSize;
+    _error = nullptr;
+
+    _offset = checkpoint.offset;
+    _block = checkpoint.block;
+    _blockStart = _block * header.blockSize;
+    _crc = checkpoint.crc;
+    _produced = 0;
+    _outFill = 0;
+    _baseFill = 0;
+    _blockHeaderFill = 0;
+    _inBlock = false;
+    _result = _block < _blockCount ? PATCH_MORE : PATCH_ERROR;
+    if (_result == PATCH_ERROR) _error = "checkpoint past the last block";
+}
+
+PatchApplier::Result PatchApplier::feed(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length && _result == PATCH_MORE; i++) {
+        uint8_t byte = data[i];
+        _offset++;
+
+        if (!_inBlock) {
+            _blockHeader[_blockHeaderFill++] = byte;
+            if (_blockHeaderFill == PATCH_BLOCK_HEADER_SIZE && !startBlock()) break;
+            continue;
+        }
+
+        _compressedLeft--;
+        if (!decodeByte(byte)) break;
+        if (_compressedLeft == 0 && !finishBlock()) break;
+    }
+
+    return _result;
+}
+
+bool PatchApplier::startBlock() {
+    _blockHeaderFill = 0;
+    _compressedLeft = readLE32(_blockHeader);
+    _blockCrcExpected = readLE32(_blockHeader + 4);
+
+    _blockStart = _block * _header.blockSize;
+    _blockLength = _header.targetSize - _blockStart;
+    if (_blockLength > _header.blockSize) _blockLength = _header.blockSize;
+
+    if (_compressedLeft == 0) return fail("empty block");
+
+    _windowPos = 0;
+    _bits = 0;
+    _bitCount = 0;
+    _opState = OP_CODE;
+    _baseCursor = _blockStart;
+    _produced = 0;
+    _outFill = 0;
+    _blockCrc = 0;
+    _inBlock = true;
+    return true;
+}
+
+bool PatchApplier::finishBlock() {
+    // Anything left over is padding to the byte boundary
+    if (_produced != _blockLength || _opState != OP_CODE || _bitCount >= 8) {
+        return fail("block ends early or runs over");
+    }
+    if (!flushOutput()) return false;
+    if (_blockCrc != _blockCrcExpected) return fail("block CRC mismatch");
+
+    _inBlock = false;
+    _block++;
+    _checkpoint.block = _block;
+    _checkpoint.offset = _offset;
+    _checkpoint.crc = _crc;
+
+    if (_block == _blockCount) {
+        if (_crc != _header.targetCrc) return fail("image CRC mismatch");
+        _result = PATCH_DONE;
+    }
+    return true;
+}
+
+bool PatchApplier::decodeByte(uint8_t byte) {
+    const uint8_t w = _header.windowBits;
+    const uint8_t l = _header.lengthBits;
+    const uint8_t referenceBits = 1 + w + l;
+    const uint32_t mask = (1UL << w) - 1;
+
+    _bits = (_bits << 8) | byte;
+    _bitCount += 8;
+
+    while (_bitCount > 0) {
+        bool literal = (_bits >> (_bitCount - 1)) & 1;
+
+        if (literal) {
+            if (_bitCount < 9) break;
+            uint8_t value = (_bits >> (_bitCount - 9)) & 0xFF;
+            _bitCount -= 9;
+            _bits &= (1UL << _bitCount) - 1;
+
+            _window[_windowPos++ & mask] = value;
+            if (!opByte(value)) return false;
+        } else {
+            if (_bitCount < referenceBits) break;
+            uint32_t value = (_bits >> (_bitCount - referenceBits)) & ((1UL << (w + l)) - 1);
+            _bitCount -= referenceBits;
+            _bits &= (1UL << _bitCount) - 1;
+
+            uint32_t distance = (value >> l) + 1;
+            uint32_t count = (value & ((1UL << l) - 1)) + PATCH_MIN_MATCH;
+            if (distance > _windowPos) return fail("reference before block start");
+
+            for (uint32_t k = 0; k < count; k++) {
+                uint8_t copied = _window[(_windowPos - distance) & mask];
+                _window[_windowPos++ & mask] = copied;
+                if (!opByte(copied)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool PatchApplier::opByte(uint8_t byte) {
+    switch (_opState) {
+        case OP_CODE:
+            if (byte > OP_INSERT_BYTES) return fail("unknown op");
+            _op = byte;
+            _varint = 0;
+            _varintShift = 0;
+            _opState = OP_LENGTH;
+            return true;
+
+        case OP_LENGTH:
+        case OP_DELTA:
+            if (_varintShift > 28) return fail("varint too long");
+            _varint |= (uint32_t)(byte & 0x7F) << _varintShift;
+            _varintShift += 7;
+            if (byte & 0x80) return true;
+
+            if (_opState == OP_LENGTH) {
+                _opLength = _varint;
+                _varint = 0;
+                _varintShift = 0;
+                if (_op == OP_INSERT_BYTES) {
+                    _opState = _opLength ? OP_INSERT : OP_CODE;
+                } else {
+                    _opState = OP_DELTA;
+                }
+                return true;
+            }
+
+            // Zigzag: the base cursor moves either way
+            _baseCursor += (uint32_t)((_varint >> 1) ^ (0 - (_varint & 1)));
+            if (_baseCursor > _header.baseSize || _opLength > _header.baseSize - _baseCursor) {
+                return fail("base range out of bounds");
+            }
+
+            _opState = OP_CODE;
+            if (_op == OP_COPY) return copyBase(_opLength);
+            if (_opLength) _opState = OP_ADD;
+            return true;
+
+        case OP_ADD: {
+            if ((_baseCursor < _baseStart || _baseCursor >= _baseStart + _baseFill) && !fillBase()) {
+                return false;
+            }
+            uint8_t value = _base[_baseCursor - _baseStart] + byte;
+            _baseCursor++;
+            if (--_opLength == 0) _opState = OP_CODE;
+            return output(value);
+        }
+
+        case OP_INSERT:
+            if (--_opLength == 0) _opState = OP_CODE;
+            return output(byte);
+    }
+    return fail("bad op state");
+}
+
+// Read the base image into the buffer from the cursor on
+bool PatchApplier::fillBase() {
+    uint32_t fill = _header.baseSize - _baseCursor;
+    if (fill > PATCH_BASE_BUFFER) fill = PATCH_BASE_BUFFER;
+    if (fill == 0 || !_io->readBase(_baseCursor, _base, fill)) return fail("base read failed");
+
+    _baseStart = _baseCursor;
+    _baseFill = fill;
+    return true;
+}
+
+// Copy length base bytes to the output; a COPY of nothing may sit at the end of the base
+bool PatchApplier::copyBase(uint32_t length) {
+    while (length > 0) {
+        if ((_baseCursor < _baseStart || _baseCursor >= _baseStart + _baseFill) && !fillBase()) {
+            return false;
+        }
+
+        uint32_t available = _baseStart + _baseFill - _baseCursor;
+        uint32_t take = length < available ? length : available;
+        for (uint32_t k = 0; k < take; k++) {
+            if (!output(_base[_baseCursor - _baseStart + k])) return false;
+        }
+        _baseCursor += take;
+        length -= take;
+    }
+
+    return true;
+}
+
+bool PatchApplier::output(uint8_t byte) {
+    if (_produced >= _blockLength) return fail("block runs over");
+
+    _out[_outFill++] = byte;
+    _produced++;
+    return _outFill < PATCH_SECTOR_SIZE || flushOutput();
+}
+
+bool PatchApplier::flushOutput() {
+    if (_outFill == 0) return true;
+
+    uint32_t offset = _blockStart + _produced - _outFill;
+    if (!_io->writeTarget(offset, _out, _outFill)) return fail("flash write failed");
+
+    _crc = patchCrc32(_crc, _out, _outFill);
+    _blockCrc = patchCrc32(_blockCrc, _out, _outFill);
+    _outFill = 0;
+    return true;
+}
+
+bool PatchApplier::fail(const char* message) {
+    _error = message;
+    _result = PATCH_ERROR;
+    return false;
+}
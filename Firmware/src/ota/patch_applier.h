@@ -0,0 +1,151 @@
+#ifndef PATCH_APPLIER_H
+#define PATCH_APPLIER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================
+// Firmware patch format (little-endian)
+// ============================================
+// header:  "SDP1", u8 windowBits, u8 lengthBits, u16 reserved,
+//          u32 blockSize, u32 baseSize, u32 targetSize, u32 targetCrc
+// blocks:  u32 compressedLength, u32 blockCrc, compressed ops
+//
+// Each block produces blockSize bytes of the new image (the last one the
+// rest) and is decodable on its own, so an interrupted update resumes at the
+// start of a block. Blocks are LZSS-compressed: a 1 bit is followed by a
+// literal byte, a 0 bit by windowBits of distance - 1 and lengthBits of
+// length - 3, all MSB first. The decoded ops are
+//   0 COPY   varint length, svarint delta   base bytes at cursor + delta
+//   1 ADD    varint length, svarint delta, length bytes added to the base bytes
+//   2 INSERT varint length, length bytes
+// The base cursor starts each block at the block's offset in the new image
+// and advances past every COPY and ADD.
+
+#define PATCH_HEADER_SIZE 24
+#define PATCH_BLOCK_HEADER_SIZE 8
+#define PATCH_MAX_WINDOW_BITS 12
+#define PATCH_MAX_LENGTH_BITS 8
+#define PATCH_MIN_MATCH 3
+#define PATCH_SECTOR_SIZE 4096      // Blocks are multiples of this; writes start on sector boundaries
+#define PATCH_BASE_BUFFER 256
+
+// CRC-32 (IEEE); pass 0 to start and the previous result to continue
+uint32_t patchCrc32(uint32_t crc, const uint8_t* data, size_t length);
+
+struct PatchHeader {
+    uint8_t windowBits;
+    uint8_t lengthBits;
+    uint32_t blockSize;
+    uint32_t baseSize;    // 0 for a full image
+    uint32_t targetSize;
+    uint32_t targetCrc;
+};
+
+// Where to pick up an interrupted patch: the first block not yet written
+struct PatchCheckpoint {
+    uint32_t block;
+    uint32_t offset;  // Patch offset of that block's header
+    uint32_t crc;     // CRC of the new image up to that block
+};
+
+// Reads the running image and writes the new one; flash partitions on the
+// device, plain buffers on the host
+class PatchIO {
+public:
+    virtual ~PatchIO() {}
+    virtual bool readBase(uint32_t offset, uint8_t* buffer, size_t length) = 0;
+    virtual bool writeTarget(uint32_t offset, const uint8_t* data, size_t length) = 0;
+};
+
+/**
+ * Streams a patch into a new image with fixed memory: the LZSS window, one
+ * sector of output and a small base read buffer. Plain C++ without Arduino
+ * dependencies so it builds on the host.
+ */
+class PatchApplier {
+public:
+    enum Result : uint8_t {
+        PATCH_MORE,   // Consumed everything, waiting for more
+        PATCH_DONE,   // Last block written and the image CRC matches
+        PATCH_ERROR
+    };
+
+    PatchApplier();
+
+    static bool parseHeader(const uint8_t* data, size_t length, PatchHeader& header);
+
+    // Start at a checkpoint; feed patch bytes from checkpoint.offset on
+    void begin(const PatchHeader& header, PatchIO* io, const PatchCheckpoint& checkpoint);
+
+    Result feed(const uint8_t* data, size_t length);
+
+    // Latest block boundary, updated as blocks complete
+    const PatchCheckpoint& checkpoint() const { return _checkpoint; }
+    uint32_t blockCount() const { return _blockCount; }
+    uint32_t written() const { return _blockStart + _produced; }
+    const char* error() const { return _error; }
+
+private:
+    enum OpState : uint8_t {
+        OP_CODE,
+        OP_LENGTH,
+        OP_DELTA,
+        OP_ADD,
+        OP_INSERT
+    };
+
+    bool startBlock();
+    bool finishBlock();
+    bool decodeByte(uint8_t byte);
+    bool opByte(uint8_t byte);
+    bool fillBase();
+    bool copyBase(uint32_t length);
+    bool output(uint8_t byte);
+    bool flushOutput();
+    bool fail(const char* message);
+
+    PatchHeader _header;
+    PatchIO* _io;
+    PatchCheckpoint _checkpoint;
+    uint32_t _blockCount;
+    Result _result;
+    const char* _error;
+
+    // Block framing
+    uint32_t _offset;          // Patch offset of the next byte fed
+    uint32_t _block;
+    uint32_t _blockStart;      // Offset of the block in the new image
+    uint32_t _blockLength;
+    uint32_t _blockCrcExpected;
+    uint32_t _compressedLeft;
+    uint8_t _blockHeader[PATCH_BLOCK_HEADER_SIZE];
+    uint8_t _blockHeaderFill;
+    bool _inBlock;
+
+    // LZSS
+    uint8_t _window[1 << PATCH_MAX_WINDOW_BITS];
+    uint32_t _windowPos;
+    uint32_t _bits;
+    uint8_t _bitCount;
+
+    // Ops
+    OpState _opState;
+    uint8_t _op;
+    uint32_t _varint;
+    uint8_t _varintShift;
+    uint32_t _opLength;
+    uint32_t _baseCursor;
+    uint8_t _base[PATCH_BASE_BUFFER];
+    uint32_t _baseStart;       // Base offset of _base[0]
+    uint32_t _baseFill;
+
+    // Output
+    uint8_t _out[PATCH_SECTOR_SIZE];
+    uint32_t _outFill;
+    uint32_t _produced;        // Bytes of the current block
+    uint32_t _crc;             // Whole image so far
+    uint32_t _blockCrc;
+};
+
+#endif // PATCH_APPLIER_H
@@ -0,0 +1,144 @@
+#include "power_manager.h"
+#include <WiFi.h>
+#include <esp_wifi.h>
+
+static const char* wakeSourceName(WakeSource source) {
+    switch (source) {
+        case WAKE_ENCODER: return "encoder";
+        case WAKE_BUTTON:  return "button";
+        case WAKE_TOUCH:   return "touch";
+        case WAKE_MQTT:    return "mqtt";
+    }
+    return "?";
+}
+
+PowerManager::PowerManager()
+    : _ui(nullptr),
+      _state(POWER_ACTIVE),
+      _playing(false),
+      _lastActivity(0),
+      _stateSince(0),
+      _wakeStartUs(0),
+      _wakeSource(WAKE_ENCODER),
+      _wakePending(false) {
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+void PowerManager::begin() {
+    M5Dial.Display.setBrightness(POWER_BRIGHTNESS_ACTIVE);
+    _lastActivity = millis();
+    _stateSince = millis();
+}
+
+void PowerManager::configureWiFi() {
+    // The listen interval goes out with the association request, so it has to
+    // be in the station config before WiFiManager connects. It only matters in
+    // max modem sleep, where the radio wakes every listen interval beacons
+    WiFi.mode(WIFI_STA);
+
+    wifi_config_t config;
+    if (esp_wifi_get_config(WIFI_IF_STA, &config) == ESP_OK) {
+        config.sta.listen_interval = POWER_WIFI_LISTEN_INTERVAL;
+        esp_wifi_set_config(WIFI_IF_STA, &config);
+    }
+}
+
+bool PowerManager::activity(WakeSource source, unsigned long eventUs) {
+    _lastActivity = millis();
+    if (_state == POWER_ACTIVE) return false;
+
+    bool wasBlank = _state == POWER_BLANK;
+    if (wasBlank) {
+        _wakeStartUs = eventUs;
+        _wakeSource = source;
+        _wakePending = true;
+    }
+
+    enter(POWER_ACTIVE);
+    return wasBlank;
+}
+
+void PowerManager::update() {
+    // The UI pass that just ran was the first one with rendering back on
+    if (_wakePending) {
+        _wakePending = false;
+        uint32_t elapsedUs = micros() - _wakeStartUs;
+        _stats.wakes++;
+        _stats.lastWakeUs = elapsedUs;
+        if (elapsedUs > _stats.maxWakeUs) _stats.maxWakeUs = elapsedUs;
+
+        Serial.printf("Woke on %s: interactive in %lu us\n",
+                      wakeSourceName(_wakeSource), (unsigned long)elapsedUs);
+    }
+
+    if (!POWER_ENABLE) return;
+
+    unsigned long idleMs = millis() - _lastActivity;
+
+    if (_state == POWER_ACTIVE && idleMs > POWER_DIM_AFTER_MS) {
+        enter(POWER_DIM);
+    } else if (_state == POWER_DIM && !_playing && idleMs > POWER_BLANK_AFTER_MS) {
+        enter(POWER_BLANK);
+    }
+}
+
+void PowerManager::enter(PowerState state) {
+    unsigned long now = millis();
+    PowerState previous = _state;
+
+    _stats.residencyMs[previous] += now - _stateSince;
+    _stateSince = now;
+    _state = state;
+
+    switch (state) {
+        case POWER_ACTIVE:
+            if (previous == POWER_BLANK) {
+                // Speed up first so the frame goes out at full SPI speed, and
+                // put it on the panel before the backlight comes on
+                setCpuFrequencyMhz(POWER_CPU_MHZ_ACTIVE);
+                M5Dial.Display.wakeup();
+                bool restored = _ui && _ui->resume();
+                WiFi.setSleep(WIFI_PS_MIN_MODEM);
+
+                Serial.printf("Power: wake, %s in %lu us\n",
+                              restored ? "last frame restored" : "no cached frame",
+                              (unsigned long)(micros() - _wakeStartUs));
+            }
+            M5Dial.Display.setBrightness(POWER_BRIGHTNESS_ACTIVE);
+            break;
+
+        case POWER_DIM:
+            M5Dial.Display.setBrightness(POWER_BRIGHTNESS_DIM);
+            break;
+
+        case POWER_BLANK:
+            if (_ui) _ui->suspend();
+            M5Dial.Display.setBrightness(0);
+            M5Dial.Display.sleep();
+            WiFi.setSleep(WIFI_PS_MAX_MODEM);
+            setCpuFrequencyMhz(POWER_CPU_MHZ_BLANK);
+            break;
+
+        default:
+            break;
+    }
+
+    Serial.printf("Power: %s -> %s\n", stateName(previous), stateName(state));
+}
+
+const PowerStats& PowerManager::stats() {
+    // Count the time in the current state up to now
+    unsigned long now = millis();
+    _stats.residencyMs[_state] += now - _stateSince;
+    _stateSince = now;
+    return _stats;
+}
+
+const char* PowerManager::stateName(PowerState state) {
+    switch (state) {
+        case POWER_ACTIVE: return "active";
+        case POWER_DIM:    return "dim";
+        case POWER_BLANK:  return "blank";
+        default:           return "?";
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "ui/ui_manager.h"
+
+enum PowerState : uint8_t {
+    POWER_ACTIVE,  // Full brightness, rendering, WiFi awake
+    POWER_DIM,     // Backlight lowered, otherwise active
+    POWER_BLANK,   // Backlight and panel off, rendering suspended, CPU slowed, WiFi in modem sleep
+    POWER_STATE_COUNT
+};
+
+enum WakeSource : uint8_t {
+    WAKE_ENCODER,
+    WAKE_BUTTON,
+    WAKE_TOUCH,
+    WAKE_MQTT
+};
+
+// Time spent in each state and how fast the dial came back from blank
+struct PowerStats {
+    uint64_t residencyMs[POWER_STATE_COUNT];
+    uint32_t wakes;
+    uint32_t lastWakeUs;  // Wake event to first UI pass with the frame back on the panel
+    uint32_t maxWakeUs;
+};
+
+/**
+ * Idle state machine. The dial dims after POWER_DIM_AFTER_MS without input and
+ * blanks after POWER_BLANK_AFTER_MS while playback is paused. Input or a
+ * relevant status change brings it back to active.
+ */
+class PowerManager {
+public:
+    PowerManager();
+
+    void setUI(UIManager* ui) { _ui = ui; }
+    void begin();
+
+    // Set the modem sleep listen interval; call before WiFi connects
+    void configureWiFi();
+
+    // Input or traffic worth waking for. Returns true if the dial was blank,
+    // in which case the input only wakes it and should not act
+    bool activity(WakeSource source, unsigned long eventUs);
+
+    void setPlaying(bool playing) { _playing = playing; }
+
+    // Idle transitions and wake timing; call once per loop after the UI update
+    void update();
+
+    PowerState state() { return _state; }
+    const PowerStats& stats();
+    static const char* stateName(PowerState state);
+
+private:
+    void enter(PowerState state);
+
+    UIManager* _ui;
+    PowerState _state;
+    bool _playing;
+    unsigned long _lastActivity;
+    unsigned long _stateSince;
+
+    unsigned long _wakeStartUs;
+    WakeSource _wakeSource;
+    bool _wakePending;
+
+    PowerStats _stats;
+};
+
+#endif // POWER_MANAGER_H
@@ -0,0 +1,112 @@
+#include "latency_tracer.h"
+#include <WiFi.h>
+#include "lv_display.h"
+
+LatencyTracer::LatencyTracer()
+    : _counter(0),
+      _next(0),
+      _pendingInputUs(0) {
+    memset(_traces, 0, sizeof(_traces));
+    strlcpy(_prefix, "dial", sizeof(_prefix));
+}
+
+void LatencyTracer::begin() {
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    snprintf(_prefix, sizeof(_prefix), "%02x%02x%02x", mac[3], mac[4], mac[5]);
+}
+
+void LatencyTracer::markInput(unsigned long us) {
+    // Keep the most recent input; several callers may report the same gesture
+    if (_pendingInputUs == 0 || (long)(us - _pendingInputUs) > 0) {
+        _pendingInputUs = us;
+    }
+}
+
+const char* LatencyTracer::startCommand(const char* command) {
+    if (!TRACE_ENABLE) return nullptr;
+
+    unsigned long now = micros();
+
+    // Slots are reused round-robin; an unfinished trace in the way is dropped
+    Trace& trace = _traces[_next];
+    _next = (_next + 1) % TRACE_SLOTS;
+
+    trace.state = TRACE_WAIT_STATUS;
+    snprintf(trace.id, sizeof(trace.id), "%s-%u", _prefix, (unsigned)_counter++);
+    strlcpy(trace.command, command, sizeof(trace.command));
+
+    bool inputFresh = _pendingInputUs != 0 &&
+                      now - _pendingInputUs < (unsigned long)TRACE_INPUT_MAX_AGE_MS * 1000UL;
+    trace.inputUs = inputFresh ? _pendingInputUs : now;
+    trace.publishUs = now;
+    trace.statusUs = 0;
+    trace.renderUs = 0;
+    trace.backendUs = 0;
+    _pendingInputUs = 0;
+
+    return trace.id;
+}
+
+void LatencyTracer::onStatus(const char* correlationId, long backendUs, unsigned long receivedUs) {
+    for (int i = 0; i < TRACE_SLOTS; i++) {
+        Trace& trace = _traces[i];
+        if (trace.state == TRACE_WAIT_STATUS && strcmp(trace.id, correlationId) == 0) {
+            trace.state = TRACE_WAIT_RENDER;
+            trace.statusUs = receivedUs;
+            trace.backendUs = backendUs;
+            trace.flushCount = lv_display_flush_count();
+            return;
+        }
+    }
+}
+
+void LatencyTracer::poll() {
+    unsigned long now = micros();
+    uint32_t flushCount = lv_display_flush_count();
+
+    for (int i = 0; i < TRACE_SLOTS; i++) {
+        Trace& trace = _traces[i];
+
+        if (trace.state == TRACE_WAIT_STATUS &&
+            now - trace.publishUs > (unsigned long)TRACE_STATUS_TIMEOUT_MS * 1000UL) {
+            Serial.printf("Trace %s (%s): no status\n", trace.id, trace.command);
+            trace.state = TRACE_FREE;
+        } else if (trace.state == TRACE_WAIT_RENDER) {
+            if (flushCount != trace.flushCount) {
+                trace.renderUs = now;
+                trace.state = TRACE_DONE;
+            } else if (now - trace.statusUs > (unsigned long)TRACE_RENDER_TIMEOUT_MS * 1000UL) {
+                // Nothing visible changed; count the status arrival as the render
+                trace.renderUs = trace.statusUs;
+                trace.state = TRACE_DONE;
+            }
+        }
+    }
+}
+
+bool LatencyTracer::takeReport(char* buffer, size_t size) {
+    for (int i = 0; i < TRACE_SLOTS; i++) {
+        Trace& trace = _traces[i];
+        if (trace.state != TRACE_DONE) continue;
+
+        unsigned long inputToPublish = trace.publishUs - trace.inputUs;
+        unsigned long publishToStatus = trace.statusUs - trace.publishUs;
+        unsigned long statusToRender = trace.renderUs - trace.statusUs;
+
+        Serial.printf("Trace %s (%s): input %lu us, round trip %lu us (backend %ld us), render %lu us\n",
+                      trace.id, trace.command, inputToPublish, publishToStatus,
+                      trace.backendUs, statusToRender);
+
+        snprintf(buffer, size,
+                 "{\"correlationId\":\"%s\",\"command\":\"%s\",\"inputToPublishUs\":%lu,"
+                 "\"publishToStatusUs\":%lu,\"statusToRenderUs\":%lu,\"backendUs\":%ld}",
+                 trace.id, trace.command, inputToPublish, publishToStatus,
+                 statusToRender, trace.backendUs);
+
+        trace.state = TRACE_FREE;
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,61 @@
+#ifndef LATENCY_TRACER_H
+#define LATENCY_TRACER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+/**
+ * Follows a command from the user input that caused it, through the backend,
+ * to the first frame flushed after the matching status arrived.
+ * All times are micros() on the device clock.
+ */
+class LatencyTracer {
+public:
+    LatencyTracer();
+
+    // Derive the correlation id prefix from the MAC (call after WiFi is up)
+    void begin();
+
+    // Record a user input that is about to produce a command
+    void markInput(unsigned long us);
+
+    // A command is being published; returns its correlation id (nullptr when disabled)
+    const char* startCommand(const char* command);
+
+    // A status carrying a correlation id arrived
+    void onStatus(const char* correlationId, long backendUs, unsigned long receivedUs);
+
+    // Detect the first flush after each status and expire stale traces
+    void poll();
+
+    // Copy the next finished trace as JSON into buffer; false when none is ready
+    bool takeReport(char* buffer, size_t size);
+
+private:
+    enum TraceState : uint8_t {
+        TRACE_FREE,
+        TRACE_WAIT_STATUS,
+        TRACE_WAIT_RENDER,
+        TRACE_DONE
+    };
+
+    struct Trace {
+        TraceState state;
+        char id[16];
+        char command[20];
+        unsigned long inputUs;
+        unsigned long publishUs;
+        unsigned long statusUs;
+        unsigned long renderUs;
+        long backendUs;
+        uint32_t flushCount;
+    };
+
+    Trace _traces[TRACE_SLOTS];
+    char _prefix[8];
+    uint16_t _counter;
+    uint8_t _next;
+    unsigned long _pendingInputUs;
+};
+
+#endif // LATENCY_TRACER_H
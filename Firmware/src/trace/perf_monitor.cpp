@@ -0,0 +1,142 @@
+#include "perf_monitor.h"
+#include <WiFi.h>
+#include <esp_heap_caps.h>
+#include "lv_display.h"
+
+// Milliseconds with one decimal, without pulling in float printf
+static void formatMs(uint32_t us, char* buffer, size_t size) {
+    snprintf(buffer, size, "%lu.%lu", (unsigned long)(us / 1000), (unsigned long)(us / 100 % 10));
+}
+
+PerfMonitor::PerfMonitor()
+    : _ui(nullptr),
+      _mqtt(nullptr),
+      _active(false),
+      _windowStart(0),
+      _loopCount(0),
+      _flushUs(0) {
+    memset(_loopHistogram, 0, sizeof(_loopHistogram));
+    memset(&_render, 0, sizeof(_render));
+}
+
+void PerfMonitor::recordLoop(unsigned long loopUs) {
+    if (!_active) return;
+
+    uint32_t bucket = loopUs / PERF_LOOP_BUCKET_US;
+    if (bucket >= PERF_LOOP_BUCKETS) bucket = PERF_LOOP_BUCKETS - 1;
+    if (_loopHistogram[bucket] < UINT16_MAX) _loopHistogram[bucket]++;
+    _loopCount++;
+}
+
+void PerfMonitor::poll() {
+    if (!PERF_HUD_ENABLE || !_ui) return;
+
+    bool visible = _ui->getCurrentScreen() == SCREEN_SETTINGS && !_ui->isSuspended();
+    if (!visible) {
+        _active = false;
+        return;
+    }
+
+    if (!_active) {
+        start();
+        return;
+    }
+
+    unsigned long now = millis();
+    if (now - _windowStart >= PERF_HUD_INTERVAL_MS) {
+        refresh(now);
+    }
+}
+
+// Begin a window from the current counters so the first figures only cover
+// the time the page has been open
+void PerfMonitor::start() {
+    _active = true;
+    _windowStart = millis();
+    _loopCount = 0;
+    memset(_loopHistogram, 0, sizeof(_loopHistogram));
+    _render = _ui->getRenderStats();
+    _flushUs = lv_display_flush_us();
+
+    if (_mqtt) _mqtt->measureRtt();
+}
+
+void PerfMonitor::refresh(unsigned long now) {
+    unsigned long windowMs = now - _windowStart;
+
+    const RenderStats& render = _ui->getRenderStats();
+    uint32_t frames = render.frames - _render.frames;
+    uint64_t renderUs = render.totalUs - _render.totalUs;
+    uint64_t flushUs = lv_display_flush_us() - _flushUs;
+
+    char draw[12], flush[12], p50[12], p95[12], p99[12], rtt[16];
+    formatMs(frames ? renderUs / frames : 0, draw, sizeof(draw));
+    formatMs(frames ? flushUs / frames : 0, flush, sizeof(flush));
+    formatMs(loopPercentileUs(50), p50, sizeof(p50));
+    formatMs(loopPercentileUs(95), p95, sizeof(p95));
+    formatMs(loopPercentileUs(99), p99, sizeof(p99));
+
+    if (_mqtt && _mqtt->rttUs() > 0) {
+        formatMs(_mqtt->rttUs(), rtt, sizeof(rtt));
+    } else {
+        strlcpy(rtt, "-", sizeof(rtt));
+    }
+
+    lv_mem_monitor_t lvgl;
+    lv_mem_monitor(&lvgl);
+
+    // Frame cache: screen switches served from a cached frame
+    uint32_t switches = 0, cached = 0;
+    for (int i = 0; i < SCREEN_COUNT; i++) {
+        switches += _ui->getSwitchStats((UIScreen)i).switches;
+        cached += _ui->getSwitchStats((UIScreen)i).cachedSwitches;
+    }
+
+    // Album art: track change to first colour and to the full cover, last track
+    const ArtStats& art = _ui->getArtStats();
+    char preview[12] = "-", cover[12] = "-";
+    if (art.previews > 0) formatMs(art.lastPreviewUs, preview, sizeof(preview));
+    if (art.covers > 0) formatMs(art.lastCoverUs, cover, sizeof(cover));
+
+    char text[352];
+    snprintf(text, sizeof(text),
+             "%lu fps, draw %s ms\n"
+             "flush %s ms\n"
+             "loop %s / %s / %s ms\n"
+             "heap %luk, max %luk\n"
+             "psram %luk, max %luk\n"
+             "lvgl %u%% used, %u%% frag\n"
+             "wifi %d dBm\n"
+             "mqtt %s ms, %lu reconn\n"
+             "frame cache %lu%%\n"
+             "art %s / %s ms",
+             (unsigned long)(frames * 1000UL / (windowMs ? windowMs : 1)), draw,
+             flush,
+             p50, p95, p99,
+             (unsigned long)(heap_caps_get_free_size(MALLOC_CAP_INTERNAL) / 1024),
+             (unsigned long)(heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL) / 1024),
+             (unsigned long)(heap_caps_get_free_size(MALLOC_CAP_SPIRAM) / 1024),
+             (unsigned long)(heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM) / 1024),
+             lvgl.used_pct, lvgl.frag_pct,
+             WiFi.isConnected() ? WiFi.RSSI() : 0,
+             rtt, (unsigned long)(_mqtt ? _mqtt->reconnects() : 0),
+             (unsigned long)(switches ? cached * 100 / switches : 0),
+             preview, cover);
+
+    _ui->updateDiagnostics(text);
+
+    // The redraw of the new text falls into the next window
+    start();
+}
+
+uint32_t PerfMonitor::loopPercentileUs(uint8_t percent) {
+    if (_loopCount == 0) return 0;
+
+    uint32_t target = (_loopCount * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (int i = 0; i < PERF_LOOP_BUCKETS; i++) {
+        seen += _loopHistogram[i];
+        if (seen >= target) return (i + 1) * PERF_LOOP_BUCKET_US;
+    }
+    return PERF_LOOP_BUCKETS * PERF_LOOP_BUCKET_US;
+}
@@ -0,0 +1,46 @@
+#ifndef PERF_MONITOR_H
+#define PERF_MONITOR_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "mqtt/mqtt_client.h"
+#include "ui/ui_manager.h"
+
+/**
+ * Live diagnostics for the Settings screen. While the screen is shown it
+ * samples loop times and, every PERF_HUD_INTERVAL_MS, turns the counters
+ * gathered since the last refresh into the text of the diagnostics label.
+ * Otherwise it does nothing.
+ */
+class PerfMonitor {
+public:
+    PerfMonitor();
+
+    void setSources(UIManager* ui, MQTTClient* mqtt) { _ui = ui; _mqtt = mqtt; }
+
+    // Time from the start of the loop to its delay
+    void recordLoop(unsigned long loopUs);
+
+    // Refresh the page when due; call once per loop
+    void poll();
+
+private:
+    void start();
+    void refresh(unsigned long now);
+    uint32_t loopPercentileUs(uint8_t percent);
+
+    UIManager* _ui;
+    MQTTClient* _mqtt;
+    bool _active;
+    unsigned long _windowStart;
+
+    // Loop times in PERF_LOOP_BUCKET_US buckets for the current window
+    uint16_t _loopHistogram[PERF_LOOP_BUCKETS];
+    uint32_t _loopCount;
+
+    // Counters at the start of the window
+    RenderStats _render;
+    uint64_t _flushUs;
+};
+
+#endif // PERF_MONITOR_H
@@ -0,0 +1,352 @@
+#include "stall_watchdog.h"
+#include <esp_debug_helpers.h>
+#include <esp_flash.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <freertos/xtensa_context.h>
+#include <soc/soc_memory_layout.h>
+#if CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH
+#include <esp_core_dump.h>
+#endif
+
+const char* const STALL_STEP_NAMES[STALL_STEP_COUNT] = {
+    "none", "input", "wifi", "mqtt", "encoder", "ui", "power", "ota", "trace", "stalls"
+};
+
+// The running step survives a panic or watchdog reset, not a power cycle
+#define STALL_RTC_MAGIC 0x57A11D06
+static RTC_NOINIT_ATTR uint32_t rtcMagic;
+static RTC_NOINIT_ATTR uint32_t rtcStep;
+static RTC_NOINIT_ATTR uint32_t rtcStepStartMs;
+
+StallWatchdog* StallWatchdog::_instance = nullptr;
+
+// Return addresses carry the caller's window size in the top bits; report the
+// call instruction as the panic handler does
+static inline uint32_t IRAM_ATTR callSite(uint32_t pc) {
+    if (pc & 0x80000000) pc = (pc & 0x3fffffff) | 0x40000000;
+    return pc - 3;
+}
+
+static const char* resetReasonName(uint8_t reason) {
+    switch (reason) {
+        case ESP_RST_PANIC: return "panic";
+        case ESP_RST_INT_WDT: return "interrupt_wdt";
+        case ESP_RST_TASK_WDT: return "task_wdt";
+        case ESP_RST_WDT: return "wdt";
+        default: return "reset";
+    }
+}
+
+StallWatchdog::StallWatchdog()
+    : _mqtt(nullptr),
+      _timer(nullptr),
+      _loopTask(nullptr),
+      _step(STALL_STEP_NONE),
+      _stepStartUs(0),
+      _sampled(false),
+      _sampleDepth(0),
+      _sampleBlocked(false),
+      _pendingCount(0),
+      _next(0),
+      _sent(0),
+      _dumpSeq(0),
+      _dumpAddress(0),
+      _dumpSize(0),
+      _dumpOffset(0) {
+    _elfSha[0] = '\0';
+    memset(_sample, 0, sizeof(_sample));
+    memset(_lastRecordMs, 0, sizeof(_lastRecordMs));
+    memset(_suppressed, 0, sizeof(_suppressed));
+}
+
+void StallWatchdog::begin() {
+    if (!STALL_ENABLE) return;
+
+    // The backend finds the symbols by this digest
+    esp_ota_get_app_elf_sha256(_elfSha, sizeof(_elfSha));
+
+    _prefs.begin("stalls", false);
+    _next = _prefs.getUInt("next", 0);
+    _sent = _prefs.getUInt("sent", 0);
+    if (_next - _sent > STALL_RING_SIZE) _sent = _next - STALL_RING_SIZE;
+
+    recordReset();
+
+    if (_next != _sent || _dumpSize) {
+        Serial.printf("Stalls: %lu records and a %lu byte core dump to upload\n",
+                      (unsigned long)(_next - _sent), (unsigned long)_dumpSize);
+    }
+
+    // Started from setup, so the interrupt runs on the loop task's core and
+    // preempts the loop task itself when it is busy
+    _loopTask = xTaskGetCurrentTaskHandle();
+    _instance = this;
+    _timer = timerBegin(STALL_TIMER, 80, true);  // 1 MHz
+    timerAttachInterrupt(_timer, onTimer, true);
+    timerAlarmWrite(_timer, (uint64_t)STALL_CHECK_MS * 1000ULL, true);
+    timerAlarmEnable(_timer);
+}
+
+void StallWatchdog::recordReset() {
+    esp_reset_reason_t reason = esp_reset_reason();
+    bool crashed = reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT ||
+                   reason == ESP_RST_TASK_WDT || reason == ESP_RST_WDT;
+    bool hasDump = false;
+
+#if CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH
+    size_t address = 0;
+    size_t size = 0;
+    if (esp_core_dump_image_get(&address, &size) == ESP_OK && size > 0) {
+        hasDump = true;
+        _dumpAddress = address;
+        _dumpSize = size;
+        _dumpSeq = _prefs.getUInt("dump", _next);
+    }
+#endif
+
+    if (crashed && rtcMagic == STALL_RTC_MAGIC) {
+        Record record;
+        memset(&record, 0, sizeof(record));
+        record.kind = STALL_KIND_PANIC;
+        record.step = rtcStep < STALL_STEP_COUNT ? (uint8_t)rtcStep : (uint8_t)STALL_STEP_NONE;
+        record.reason = reason;
+        record.uptimeMs = rtcStepStartMs;
+
+#if CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH && CONFIG_ESP_COREDUMP_DATA_FORMAT_ELF
+        esp_core_dump_summary_t summary;
+        if (hasDump && esp_core_dump_get_summary(&summary) == ESP_OK) {
+            strlcpy(record.task, summary.exc_task, sizeof(record.task));
+            uint32_t depth = summary.exc_bt_info.depth;
+            if (depth > STALL_BACKTRACE_DEPTH) depth = STALL_BACKTRACE_DEPTH;
+            for (uint32_t i = 0; i < depth; i++) {
+                record.backtrace[i] = summary.exc_bt_info.bt[i];
+            }
+            record.depth = depth;
+            if (!depth) {
+                record.backtrace[0] = summary.exc_pc;
+                record.depth = 1;
+            }
+        }
+#endif
+
+        Serial.printf("Stalls: %s reset during step %s\n",
+                      resetReasonName(reason), STALL_STEP_NAMES[record.step]);
+        store(record);
+        if (hasDump) {
+            _dumpSeq = record.seq;
+            _prefs.putUInt("dump", _dumpSeq);
+        }
+    }
+
+    rtcMagic = STALL_RTC_MAGIC;
+    rtcStep = STALL_STEP_NONE;
+    rtcStepStartMs = 0;
+}
+
+void StallWatchdog::step(StallStep next) {
+    if (!STALL_ENABLE) return;
+
+    uint32_t now = micros();
+
+    // The interrupt leaves a step alone once it is NONE
+    uint8_t previous = _step;
+    _step = STALL_STEP_NONE;
+    if (previous != STALL_STEP_NONE) {
+        uint32_t elapsedUs = now - _stepStartUs;
+        if (elapsedUs >= (uint32_t)STALL_THRESHOLD_MS * 1000UL) finishStep(previous, now);
+    }
+
+    _sampled = false;
+    _stepStartUs = now;
+    rtcStep = next;
+    rtcStepStartMs = millis();
+    _step = next;
+}
+
+void StallWatchdog::finishStep(uint8_t step, uint32_t nowUs) {
+    uint32_t durationMs = (nowUs - _stepStartUs) / 1000UL;
+    bool sampled = _sampled;
+
+    Serial.printf("Stall: %s took %lu ms%s\n", STALL_STEP_NAMES[step], (unsigned long)durationMs,
+                  sampled && _sampleBlocked ? " (waiting)" : "");
+
+    unsigned long now = millis();
+    if ((_lastRecordMs[step] && now - _lastRecordMs[step] < STALL_RECORD_INTERVAL_MS) ||
+        _pendingCount == sizeof(_pending) / sizeof(_pending[0])) {
+        if (_suppressed[step] < UINT16_MAX) _suppressed[step]++;
+        return;
+    }
+    _lastRecordMs[step] = now ? now : 1;
+
+    Record& record = _pending[_pendingCount++];
+    memset(&record, 0, sizeof(record));
+    record.kind = STALL_KIND_STALL;
+    record.step = step;
+    record.durationMs = durationMs;
+    record.uptimeMs = now - durationMs;
+    record.suppressed = _suppressed[step];
+    _suppressed[step] = 0;
+
+    // No backtrace when the step ended before the timer came round
+    if (sampled) {
+        record.depth = _sampleDepth;
+        record.blocked = _sampleBlocked;
+        memcpy(record.backtrace, _sample, _sampleDepth * sizeof(uint32_t));
+    }
+}
+
+void IRAM_ATTR StallWatchdog::onTimer() {
+    StallWatchdog* self = _instance;
+    if (!self || self->_step == STALL_STEP_NONE || self->_sampled) return;
+    if ((uint32_t)micros() - self->_stepStartUs < (uint32_t)STALL_THRESHOLD_MS * 1000UL) return;
+
+    self->sample();
+    self->_sampled = true;
+}
+
+void IRAM_ATTR StallWatchdog::sample() {
+    esp_backtrace_frame_t frame;
+    bool blocked = xTaskGetCurrentTaskHandle() != _loopTask;
+
+    if (!blocked) {
+        // Busy: the loop task is what we interrupted. The first frames are
+        // this handler and the interrupt dispatch; the backend drops them
+        esp_backtrace_get_start(&frame.pc, &frame.sp, &frame.next_pc);
+    } else {
+        // Waiting: walk from the context it saved when it was switched out,
+        // as the core dump does. pxTopOfStack is the first member of a TCB
+        const uint32_t* top = *(const uint32_t* const*)_loopTask;
+        const XtExcFrame* exc = (const XtExcFrame*)top;
+        if (exc->exit) {
+            frame.pc = exc->pc;
+            frame.sp = exc->a1;
+            frame.next_pc = exc->a0;
+        } else {
+            const XtSolFrame* sol = (const XtSolFrame*)top;
+            frame.pc = sol->pc;
+            frame.sp = sol->a1;
+            frame.next_pc = sol->a0;
+        }
+        if (!esp_stack_ptr_is_sane(frame.sp)) {
+            _sampleDepth = 0;
+            _sampleBlocked = true;
+            return;
+        }
+    }
+
+    uint8_t depth = 0;
+    _sample[depth++] = callSite(frame.pc);
+    while (depth < STALL_BACKTRACE_DEPTH && frame.next_pc != 0) {
+        if (!esp_backtrace_get_next_frame(&frame)) break;
+        _sample[depth++] = callSite(frame.pc);
+    }
+    _sampleDepth = depth;
+    _sampleBlocked = blocked;
+}
+
+void StallWatchdog::store(Record& record) {
+    char key[8];
+    record.seq = _next;
+    snprintf(key, sizeof(key), "r%lu", (unsigned long)(_next % STALL_RING_SIZE));
+    _prefs.putBytes(key, &record, sizeof(record));
+    _prefs.putUInt("next", ++_next);
+
+    // Overwrote the oldest record that was not uploaded yet
+    if (_next - _sent > STALL_RING_SIZE) {
+        _sent = _next - STALL_RING_SIZE;
+        _prefs.putUInt("sent", _sent);
+    }
+}
+
+void StallWatchdog::poll() {
+    if (!STALL_ENABLE) return;
+
+    for (uint8_t i = 0; i < _pendingCount; i++) {
+        store(_pending[i]);
+    }
+    _pendingCount = 0;
+
+    if (!_mqtt || !_mqtt->isConnected()) {
+        _dumpOffset = 0;  // The backend starts over at offset 0
+        return;
+    }
+
+    // One message per loop; records first, they are small and say most
+    if (_sent != _next) {
+        if (upload(_sent)) _prefs.putUInt("sent", ++_sent);
+        return;
+    }
+
+    if (_dumpSize) uploadCoreDump();
+}
+
+bool StallWatchdog::upload(uint32_t seq) {
+    char key[8];
+    Record record;
+    snprintf(key, sizeof(key), "r%lu", (unsigned long)(seq % STALL_RING_SIZE));
+
+    // Lost or overwritten: nothing to send, move on
+    if (_prefs.getBytes(key, &record, sizeof(record)) != sizeof(record) || record.seq != seq) {
+        return true;
+    }
+
+    StaticJsonDocument<768> doc;
+    doc["deviceId"] = _mqtt->clientId();
+    doc["version"] = APP_VERSION;
+    doc["elf"] = (const char*)_elfSha;
+    doc["seq"] = record.seq;
+    doc["kind"] = record.kind == STALL_KIND_PANIC ? "panic" : "stall";
+    doc["step"] = STALL_STEP_NAMES[record.step < STALL_STEP_COUNT ? record.step : (uint8_t)STALL_STEP_NONE];
+    doc["durationMs"] = record.durationMs;
+    doc["uptimeMs"] = record.uptimeMs;
+    doc["blocked"] = record.blocked != 0;
+    doc["suppressed"] = record.suppressed;
+    if (record.kind == STALL_KIND_PANIC) {
+        doc["reason"] = resetReasonName(record.reason);
+        record.task[sizeof(record.task) - 1] = '\0';
+        if (record.task[0]) doc["task"] = (const char*)record.task;
+    }
+
+    JsonArray backtrace = doc.createNestedArray("backtrace");
+    uint8_t depth = record.depth < STALL_BACKTRACE_DEPTH ? record.depth : STALL_BACKTRACE_DEPTH;
+    for (uint8_t i = 0; i < depth; i++) {
+        backtrace.add(record.backtrace[i]);
+    }
+
+    char buffer[768];
+    serializeJson(doc, buffer, sizeof(buffer));
+    return _mqtt->sendStallReport(buffer);
+}
+
+// Chunks carry the record seq of the panic, their offset and the dump size
+// (u32, little-endian). The dump is erased once the last chunk went out
+void StallWatchdog::uploadCoreDump() {
+    uint8_t chunk[12 + STALL_COREDUMP_CHUNK_BYTES];
+    uint32_t length = _dumpSize - _dumpOffset;
+    if (length > STALL_COREDUMP_CHUNK_BYTES) length = STALL_COREDUMP_CHUNK_BYTES;
+
+    memcpy(chunk, &_dumpSeq, 4);
+    memcpy(chunk + 4, &_dumpOffset, 4);
+    memcpy(chunk + 8, &_dumpSize, 4);
+    if (esp_flash_read(nullptr, chunk + 12, _dumpAddress + _dumpOffset, length) != ESP_OK) {
+        Serial.println("Stalls: cannot read the core dump, dropping it");
+        length = _dumpSize - _dumpOffset;
+    } else if (!_mqtt->sendCoreDump(chunk, 12 + length)) {
+        return;
+    }
+
+    _dumpOffset += length;
+    if (_dumpOffset < _dumpSize) return;
+
+    // Without its header the dump is gone for esp_core_dump_image_get; one
+    // sector instead of the whole partition keeps this short
+    const esp_partition_t* partition = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_COREDUMP, nullptr);
+    if (partition) esp_partition_erase_range(partition, 0, SPI_FLASH_SEC_SIZE);
+
+    Serial.printf("Stalls: core dump of %lu bytes uploaded\n", (unsigned long)_dumpSize);
+    _prefs.remove("dump");
+    _dumpSize = 0;
+    _dumpOffset = 0;
+}
@@ -0,0 +1,119 @@
+#ifndef STALL_WATCHDOG_H
+#define STALL_WATCHDOG_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "config.h"
+#include "mqtt/mqtt_client.h"
+
+// Subsystem steps of loop(); names are in STALL_STEP_NAMES
+enum StallStep : uint8_t {
+    STALL_STEP_NONE,      // Between loops, or before the first
+    STALL_STEP_INPUT,     // Dial button
+    STALL_STEP_WIFI,      // WiFiManager portal
+    STALL_STEP_MQTT,      // MQTT loop and the message callbacks it runs
+    STALL_STEP_ENCODER,   // Encoder and touch handling, commands
+    STALL_STEP_UI,        // LVGL timers, rendering and flushing
+    STALL_STEP_POWER,
+    STALL_STEP_OTA,
+    STALL_STEP_TRACE,     // Latency tracer and diagnostics page
+    STALL_STEP_STALLS,    // Our own NVS writes and uploads
+    STALL_STEP_COUNT
+};
+
+/**
+ * Catches loop() steps that hold up the dial. Each step is marked before it
+ * runs; a hardware timer interrupt on the loop core notices a step running
+ * past STALL_THRESHOLD_MS and takes a backtrace of the loop task, whether it
+ * is busy (walked from the interrupt) or waiting (walked from the context it
+ * saved). When the step ends the stall is recorded with its duration.
+ *
+ * Records go to a ring in NVS and are uploaded one per loop while connected,
+ * so stalls before a reconnect or a reset are not lost. After a panic or
+ * watchdog reset the step that was running, the panic backtrace from the core
+ * dump and the dump itself are uploaded too. The backend symbolizes the
+ * addresses with the ELF file whose SHA-256 we report.
+ */
+class StallWatchdog {
+public:
+    StallWatchdog();
+
+    void setClient(MQTTClient* mqtt) { _mqtt = mqtt; }
+
+    // Record a reset, load the ring and start the timer; call from setup
+    void begin();
+
+    // The loop is about to run this step; the previous one ended
+    void step(StallStep next);
+
+    // End of the loop's work, before its delay
+    void endLoop() { step(STALL_STEP_NONE); }
+
+    // Write finished stalls to NVS and upload; call once per loop
+    void poll();
+
+private:
+    enum RecordKind : uint8_t {
+        STALL_KIND_STALL = 1,
+        STALL_KIND_PANIC = 2
+    };
+
+    // Stored in NVS as is
+    struct Record {
+        uint32_t seq;
+        uint8_t kind;
+        uint8_t step;
+        uint8_t depth;
+        uint8_t blocked;       // The loop task was waiting, not running, when sampled
+        uint8_t reason;        // esp_reset_reason_t of a panic record
+        char task[16];         // Task that panicked, from the core dump
+        uint32_t durationMs;
+        uint32_t uptimeMs;     // When the step started
+        uint16_t suppressed;   // Stalls of this step not recorded since the last record
+        uint32_t backtrace[STALL_BACKTRACE_DEPTH];
+    };
+
+    static void onTimer();
+    void sample();
+    void finishStep(uint8_t step, uint32_t nowUs);
+    void recordReset();
+    void store(Record& record);
+    bool upload(uint32_t seq);
+    void uploadCoreDump();
+
+    static StallWatchdog* _instance;
+
+    MQTTClient* _mqtt;
+    Preferences _prefs;
+    hw_timer_t* _timer;
+    TaskHandle_t _loopTask;
+    char _elfSha[65];
+
+    // Shared with the timer interrupt
+    volatile uint8_t _step;
+    volatile uint32_t _stepStartUs;
+    volatile bool _sampled;
+    volatile uint8_t _sampleDepth;
+    volatile bool _sampleBlocked;
+    uint32_t _sample[STALL_BACKTRACE_DEPTH];
+
+    // Finished stalls waiting for poll() to store them
+    Record _pending[2];
+    uint8_t _pendingCount;
+    uint32_t _lastRecordMs[STALL_STEP_COUNT];
+    uint16_t _suppressed[STALL_STEP_COUNT];
+
+    // Ring in NVS: records _sent.._next-1 are still to be uploaded
+    uint32_t _next;
+    uint32_t _sent;
+
+    // Core dump left by a panic, uploaded after the records
+    uint32_t _dumpSeq;
+    uint32_t _dumpAddress;
+    uint32_t _dumpSize;
+    uint32_t _dumpOffset;
+};
+
+extern const char* const STALL_STEP_NAMES[STALL_STEP_COUNT];
+
+#endif // STALL_WATCHDOG_H
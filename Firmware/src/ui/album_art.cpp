@@ -0,0 +1,168 @@
+#include "album_art.h"
+#include <M5Dial.h>
+#include <esp_heap_caps.h>
+
+static int8_t base64Value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+static inline uint16_t toRgb565(uint8_t r, uint8_t g, uint8_t b) {
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+
+AlbumArt::AlbumArt()
+    : _previewPixels(nullptr),
+      _coverPixels(nullptr),
+      _coverHash(0),
+      _coverDecodeUs(0) {
+    memset(&_previewImage, 0, sizeof(_previewImage));
+    memset(&_coverImage, 0, sizeof(_coverImage));
+    _previewText[0] = '\0';
+}
+
+AlbumArt::~AlbumArt() {
+    heap_caps_free(_previewPixels);
+    heap_caps_free(_coverPixels);
+}
+
+bool AlbumArt::setPreview(const char* base64) {
+    if (!base64 || strncmp(base64, _previewText, sizeof(_previewText)) == 0) return false;
+
+    uint8_t rgb[ART_PREVIEW_MAX_BYTES];
+    uint8_t width, height;
+    if (!decodePreview(base64, rgb, width, height)) {
+        Serial.println("Album art: ignoring malformed preview");
+        return false;
+    }
+    if (!allocate(_previewPixels, _previewImage)) return false;
+
+    scalePreview(rgb, width, height, _previewPixels, ART_SIZE);
+    strlcpy(_previewText, base64, sizeof(_previewText));
+    return true;
+}
+
+bool AlbumArt::setCover(const uint8_t* data, size_t length) {
+    if (!data || length == 0) return false;
+
+    // FNV-1a; the backend sends the same cover again for every track of an album
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    if (hash == _coverHash) return false;
+    if (!allocate(_coverPixels, _coverImage)) return false;
+
+    unsigned long startUs = micros();
+
+    // Decode straight into the cover buffer, scaled from the backend's size to the widget's
+    M5Canvas canvas;
+    canvas.setColorDepth(16);
+    canvas.setBuffer(_coverPixels, ART_SIZE, ART_SIZE, 16);
+    canvas.fillSprite(TFT_BLACK);
+    float scale = (float)ART_SIZE / ART_SOURCE_SIZE;
+    bool ok = canvas.drawJpg(data, length, 0, 0, ART_SIZE, ART_SIZE, 0, 0, scale, scale);
+
+    // Sprites hold RGB565 byte-swapped for the panel; LVGL wants it native (LV_COLOR_16_SWAP 0)
+    for (size_t i = 0; i < (size_t)ART_SIZE * ART_SIZE; i++) {
+        _coverPixels[i] = __builtin_bswap16(_coverPixels[i]);
+    }
+
+    _coverDecodeUs = micros() - startUs;
+    if (!ok) {
+        Serial.printf("Album art: failed to decode %lu byte cover\n", (unsigned long)length);
+        _coverHash = 0;
+        return false;
+    }
+
+    _coverHash = hash;
+    return true;
+}
+
+bool AlbumArt::decodePreview(const char* base64, uint8_t* rgb, uint8_t& width, uint8_t& height) {
+    uint8_t bytes[ART_PREVIEW_MAX_BYTES];
+    size_t count = 0;
+    uint32_t bits = 0;
+    int pending = 0;
+
+    for (const char* c = base64; *c && *c != '='; c++) {
+        int8_t value = base64Value(*c);
+        if (value < 0) return false;
+
+        bits = (bits << 6) | value;
+        pending += 6;
+        if (pending >= 8) {
+            pending -= 8;
+            if (count == sizeof(bytes)) return false;
+            bytes[count++] = (bits >> pending) & 0xFF;
+        }
+    }
+
+    if (count < 2) return false;
+    width = bytes[0];
+    height = bytes[1];
+    if (width == 0 || height == 0 || width > ART_PREVIEW_MAX_GRID || height > ART_PREVIEW_MAX_GRID) return false;
+    if (count != 2 + (size_t)width * height * 3) return false;
+
+    memcpy(rgb, bytes + 2, count - 2);
+    return true;
+}
+
+void AlbumArt::scalePreview(const uint8_t* rgb, uint8_t width, uint8_t height,
+                            uint16_t* pixels, uint16_t size) {
+    for (uint16_t y = 0; y < size; y++) {
+        // Pixel centres mapped onto cell centres, in 1/256ths of a cell
+        int fy = ((2 * y + 1) * height * 128) / size - 128;
+        fy = constrain(fy, 0, (height - 1) * 256);
+        int y0 = fy >> 8;
+        int y1 = min(y0 + 1, height - 1);
+        int wy = fy & 0xFF;
+
+        for (uint16_t x = 0; x < size; x++) {
+            int fx = ((2 * x + 1) * width * 128) / size - 128;
+            fx = constrain(fx, 0, (width - 1) * 256);
+            int x0 = fx >> 8;
+            int x1 = min(x0 + 1, width - 1);
+            int wx = fx & 0xFF;
+
+            const uint8_t* c00 = rgb + (y0 * width + x0) * 3;
+            const uint8_t* c01 = rgb + (y0 * width + x1) * 3;
+            const uint8_t* c10 = rgb + (y1 * width + x0) * 3;
+            const uint8_t* c11 = rgb + (y1 * width + x1) * 3;
+
+            uint8_t out[3];
+            for (int i = 0; i < 3; i++) {
+                int top = c00[i] * (256 - wx) + c01[i] * wx;
+                int bottom = c10[i] * (256 - wx) + c11[i] * wx;
+                out[i] = (top * (256 - wy) + bottom * wy) >> 16;
+            }
+            pixels[y * size + x] = toRgb565(out[0], out[1], out[2]);
+        }
+    }
+}
+
+bool AlbumArt::allocate(uint16_t*& pixels, lv_img_dsc_t& image) {
+    if (pixels) return true;
+
+    size_t size = (size_t)ART_SIZE * ART_SIZE * sizeof(uint16_t);
+    pixels = (uint16_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!pixels) {
+        pixels = (uint16_t*)heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+    if (!pixels) {
+        Serial.printf("Album art: failed to allocate %lu bytes\n", (unsigned long)size);
+        return false;
+    }
+
+    image.header.cf = LV_IMG_CF_TRUE_COLOR;
+    image.header.always_zero = 0;
+    image.header.w = ART_SIZE;
+    image.header.h = ART_SIZE;
+    image.data_size = size;
+    image.data = (const uint8_t*)pixels;
+    return true;
+}
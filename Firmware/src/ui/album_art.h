@@ -0,0 +1,60 @@
+#ifndef ALBUM_ART_H
+#define ALBUM_ART_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include "config.h"
+
+// Longest base64 preview: width and height, then RGB per cell
+#define ART_PREVIEW_MAX_BYTES (2 + ART_PREVIEW_MAX_GRID * ART_PREVIEW_MAX_GRID * 3)
+#define ART_PREVIEW_MAX_CHARS ((ART_PREVIEW_MAX_BYTES + 2) / 3 * 4)
+
+/**
+ * Pixels for the album art widget. The colour preview that comes with the
+ * status (see ImageProcessingService.CreatePreview in the backend) is scaled
+ * up bilinearly into one buffer and the full cover is decoded into another,
+ * so the preview stays on screen while the cover fades in over it. Both are
+ * ART_SIZE square RGB565 images in PSRAM, allocated on first use.
+ */
+class AlbumArt {
+public:
+    AlbumArt();
+    ~AlbumArt();
+
+    // Draw a base64 preview; false if it is malformed or the one already drawn
+    bool setPreview(const char* base64);
+
+    // Decode a JPEG cover; false on error or if it is the one already decoded
+    bool setCover(const uint8_t* data, size_t length);
+    bool hasCover() const { return _coverHash != 0; }
+
+    const lv_img_dsc_t* preview() const { return &_previewImage; }
+    const lv_img_dsc_t* cover() const { return &_coverImage; }
+
+    // Decoding time of the last cover
+    unsigned long coverDecodeUs() const { return _coverDecodeUs; }
+
+    // The cover was taken off screen; decode the next one even if it is the same
+    void clearCover() { _coverHash = 0; }
+
+    // Grid of up to ART_PREVIEW_MAX_GRID cells per side from the base64 text
+    static bool decodePreview(const char* base64, uint8_t* rgb, uint8_t& width, uint8_t& height);
+
+    // Bilinear upscale of the grid to size x size RGB565 pixels
+    static void scalePreview(const uint8_t* rgb, uint8_t width, uint8_t height,
+                             uint16_t* pixels, uint16_t size);
+
+private:
+    bool allocate(uint16_t*& pixels, lv_img_dsc_t& image);
+
+    uint16_t* _previewPixels;
+    uint16_t* _coverPixels;
+    lv_img_dsc_t _previewImage;
+    lv_img_dsc_t _coverImage;
+
+    char _previewText[ART_PREVIEW_MAX_CHARS + 1];
+    uint32_t _coverHash;
+    unsigned long _coverDecodeUs;
+};
+
+#endif // ALBUM_ART_H
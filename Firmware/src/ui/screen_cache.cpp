@@ -0,0 +1,82 @@
+#include "screen_cache.h"
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include "lv_display.h"
+
+ScreenCache::ScreenCache() : _enabled(false) {
+    for (size_t i = 0; i < SCREEN_CACHE_SLOTS; i++) {
+        _entries[i].pixels = nullptr;
+        _entries[i].capacity = 0;
+        _entries[i].valid = false;
+    }
+}
+
+bool ScreenCache::begin() {
+    if (!SCREEN_CACHE_ENABLE) {
+        _enabled = false;
+        return false;
+    }
+
+    // Frames are ~115KB each, far too large for internal RAM
+    _enabled = heap_caps_get_free_size(MALLOC_CAP_SPIRAM) > 0;
+    if (!_enabled) {
+        Serial.println("Screen cache disabled: no PSRAM available");
+    }
+    return _enabled;
+}
+
+bool ScreenCache::capture(size_t slot, lv_obj_t* screen) {
+    if (!_enabled || slot >= SCREEN_CACHE_SLOTS || !screen) return false;
+
+    Entry& entry = _entries[slot];
+    uint32_t needed = lv_snapshot_buf_size_needed(screen, LV_IMG_CF_TRUE_COLOR);
+
+    // Buffers are allocated once per slot and reused for every capture
+    if (entry.capacity < needed) {
+        heap_caps_free(entry.pixels);
+        entry.pixels = (lv_color_t*)heap_caps_malloc(needed, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        entry.capacity = entry.pixels ? needed : 0;
+        if (!entry.pixels) {
+            Serial.printf("Screen cache: failed to allocate %lu bytes\n", (unsigned long)needed);
+            entry.valid = false;
+            return false;
+        }
+    }
+
+    lv_img_dsc_t dsc;
+    if (lv_snapshot_take_to_buf(screen, LV_IMG_CF_TRUE_COLOR, &dsc,
+                                entry.pixels, entry.capacity) != LV_RES_OK) {
+        entry.valid = false;
+        return false;
+    }
+
+    // The snapshot covers the object plus its extra draw area
+    lv_coord_t ext = _lv_obj_get_ext_draw_size(screen);
+    lv_obj_get_coords(screen, &entry.area);
+    lv_area_increase(&entry.area, ext, ext);
+    entry.area.x2 = entry.area.x1 + dsc.header.w - 1;
+    entry.area.y2 = entry.area.y1 + dsc.header.h - 1;
+    entry.valid = true;
+
+    return true;
+}
+
+bool ScreenCache::blit(size_t slot) {
+    if (!has(slot)) return false;
+
+    lv_display_blit(&_entries[slot].area, _entries[slot].pixels);
+    return true;
+}
+
+bool ScreenCache::has(size_t slot) {
+    return _enabled && slot < SCREEN_CACHE_SLOTS && _entries[slot].valid;
+}
+
+void ScreenCache::invalidate(size_t slot) {
+    if (slot < SCREEN_CACHE_SLOTS) {
+        heap_caps_free(_entries[slot].pixels);
+        _entries[slot].pixels = nullptr;
+        _entries[slot].capacity = 0;
+        _entries[slot].valid = false;
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef SCREEN_CACHE_H
+#define SCREEN_CACHE_H
+
+#include <lvgl.h>
+#include "config.h"
+
+// Maximum number of screens that can be cached
+#define SCREEN_CACHE_SLOTS 8
+
+/**
+ * Keeps the last rendered frame of each screen in PSRAM so a screen switch
+ * can put pixels on the panel immediately, before LVGL has redrawn anything.
+ */
+class ScreenCache {
+public:
+    ScreenCache();
+
+    // Initialization (disables itself when no PSRAM is available)
+    bool begin();
+    bool isEnabled() { return _enabled; }
+
+    // Render the given screen object into its slot
+    bool capture(size_t slot, lv_obj_t* screen);
+
+    // Push the cached frame of a slot to the panel
+    bool blit(size_t slot);
+
+    bool has(size_t slot);
+
+    // Drop a slot's frame and free its buffer
+    void invalidate(size_t slot);
+
+private:
+    struct Entry {
+        lv_color_t* pixels;
+        uint32_t capacity;
+        lv_area_t area;
+        bool valid;
+    };
+
+    Entry _entries[SCREEN_CACHE_SLOTS];
+    bool _enabled;
+};
+
+#endif // SCREEN_CACHE_H
@@ -0,0 +1,110 @@
+#include "ui_layout.h"
+
+LayoutBuilder::LayoutBuilder() : _initialized(false) {
+}
+
+void LayoutBuilder::begin() {
+    if (_initialized) return;
+
+    for (int i = 0; i < STYLE_COUNT; i++) {
+        lv_style_init(&_styles[i]);
+    }
+
+    lv_style_set_bg_color(&_styles[STYLE_SCREEN], lv_color_black());
+
+    lv_style_set_text_font(&_styles[STYLE_TEXT], &lv_font_montserrat_14);
+
+    lv_style_set_text_font(&_styles[STYLE_PRIMARY_TEXT], &lv_font_montserrat_14);
+    lv_style_set_text_color(&_styles[STYLE_PRIMARY_TEXT], lv_color_white());
+
+    lv_style_set_text_font(&_styles[STYLE_SECONDARY_TEXT], &lv_font_montserrat_14);
+    lv_style_set_text_color(&_styles[STYLE_SECONDARY_TEXT], lv_color_make(180, 180, 180));
+
+    lv_style_set_text_font(&_styles[STYLE_MUTED_TEXT], &lv_font_montserrat_14);
+    lv_style_set_text_color(&_styles[STYLE_MUTED_TEXT], lv_color_make(128, 128, 128));
+
+    lv_style_set_bg_color(&_styles[STYLE_OVERLAY], lv_color_make(40, 40, 40));
+    lv_style_set_bg_opa(&_styles[STYLE_OVERLAY], LV_OPA_90);
+    lv_style_set_radius(&_styles[STYLE_OVERLAY], 10);
+
+    lv_style_set_text_align(&_styles[STYLE_CENTER_TEXT], LV_TEXT_ALIGN_CENTER);
+
+    _initialized = true;
+}
+
+lv_obj_t* LayoutBuilder::build(const ScreenLayout& layout, lv_obj_t* parent, lv_obj_t** bindings) {
+    lv_obj_t* screen = lv_obj_create(parent);
+    lv_obj_set_size(screen, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    lv_obj_add_style(screen, &_styles[STYLE_SCREEN], 0);
+
+    // Screens never scroll, so drags on them become swipe gestures
+    lv_obj_clear_flag(screen, LV_OBJ_FLAG_SCROLLABLE);
+
+    for (size_t i = 0; i < layout.count; i++) {
+        const WidgetLayout& widget = layout.widgets[i];
+        lv_obj_t* obj = createWidget(widget, screen);
+
+        if (widget.binding != BIND_NONE) {
+            bindings[widget.binding] = obj;
+        }
+    }
+
+    return screen;
+}
+
+void LayoutBuilder::unbind(const ScreenLayout& layout, lv_obj_t** bindings) {
+    for (size_t i = 0; i < layout.count; i++) {
+        if (layout.widgets[i].binding != BIND_NONE) {
+            bindings[layout.widgets[i].binding] = nullptr;
+        }
+    }
+}
+
+lv_obj_t* LayoutBuilder::createWidget(const WidgetLayout& widget, lv_obj_t* parent) {
+    lv_obj_t* obj = nullptr;
+
+    switch (widget.type) {
+        case WIDGET_LABEL:
+            obj = lv_label_create(parent);
+            lv_label_set_text_static(obj, widget.text ? widget.text : "");
+            if (widget.flags & WIDGET_FLAG_SCROLL_TEXT) {
+                lv_label_set_long_mode(obj, LV_LABEL_LONG_SCROLL_CIRCULAR);
+            }
+            if (widget.flags & WIDGET_FLAG_CENTER_TEXT) {
+                lv_obj_add_style(obj, &_styles[STYLE_CENTER_TEXT], 0);
+            }
+            break;
+        case WIDGET_IMAGE:
+            obj = lv_img_create(parent);
+            break;
+        case WIDGET_BAR:
+            obj = lv_bar_create(parent);
+            lv_bar_set_value(obj, 0, LV_ANIM_OFF);
+            break;
+        case WIDGET_ROLLER:
+            obj = lv_roller_create(parent);
+            lv_roller_set_options(obj, widget.text ? widget.text : "", LV_ROLLER_MODE_NORMAL);
+            break;
+        case WIDGET_SPINNER:
+            obj = lv_spinner_create(parent, 1000, 60);
+            break;
+    }
+
+    if (widget.width > 0 && widget.height > 0) {
+        lv_obj_set_size(obj, widget.width, widget.height);
+    } else if (widget.width > 0) {
+        lv_obj_set_width(obj, widget.width);
+    }
+
+    if (widget.flags & WIDGET_FLAG_TOUCHABLE) {
+        lv_obj_add_flag(obj, LV_OBJ_FLAG_CLICKABLE);
+        lv_obj_set_ext_click_area(obj, 15);
+    }
+
+    if (widget.style != STYLE_NONE) {
+        lv_obj_add_style(obj, &_styles[widget.style], 0);
+    }
+
+    lv_obj_align(obj, widget.align, widget.x, widget.y);
+    return obj;
+}
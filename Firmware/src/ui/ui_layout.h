@@ -0,0 +1,104 @@
+#ifndef UI_LAYOUT_H
+#define UI_LAYOUT_H
+
+#include <lvgl.h>
+#include "config.h"
+
+// UI Screens
+enum UIScreen {
+    SCREEN_SPLASH,
+    SCREEN_NOW_PLAYING,
+    SCREEN_PLAYLISTS,
+    SCREEN_ALBUMS,
+    SCREEN_SETTINGS,
+    SCREEN_COUNT  // Number of screens, not a screen
+};
+
+// Widget kinds the layout builder knows how to create
+enum WidgetType : uint8_t {
+    WIDGET_LABEL,
+    WIDGET_IMAGE,
+    WIDGET_BAR,
+    WIDGET_ROLLER,
+    WIDGET_SPINNER
+};
+
+// Shared styles, created once and referenced by every screen
+enum StyleId : uint8_t {
+    STYLE_NONE,
+    STYLE_SCREEN,
+    STYLE_TEXT,
+    STYLE_PRIMARY_TEXT,
+    STYLE_SECONDARY_TEXT,
+    STYLE_MUTED_TEXT,
+    STYLE_OVERLAY,
+    STYLE_CENTER_TEXT,     // Added on top of a widget's style by WIDGET_FLAG_CENTER_TEXT
+    STYLE_COUNT
+};
+
+// Model fields a widget can be bound to
+enum BindingId : uint8_t {
+    BIND_NONE,
+    BIND_TRACK_NAME,
+    BIND_ARTIST_NAME,
+    BIND_ALBUM_ART,
+    BIND_PROGRESS,
+    BIND_PROGRESS_TEXT,
+    BIND_PLAY_STATE,
+    BIND_PLAYLISTS,
+    BIND_ALBUMS,
+    BIND_DIAGNOSTICS,
+    BIND_COUNT
+};
+
+// Widget flags
+#define WIDGET_FLAG_SCROLL_TEXT 0x01  // Circular scrolling for long labels
+#define WIDGET_FLAG_TOUCHABLE 0x02    // Clickable, with a larger touch area
+#define WIDGET_FLAG_CENTER_TEXT 0x04  // Center every line of a multi-line label
+
+// One widget in a screen layout. A width or height of 0 keeps LVGL's default.
+struct WidgetLayout {
+    WidgetType type;
+    lv_align_t align;
+    lv_coord_t x;
+    lv_coord_t y;
+    lv_coord_t width;
+    lv_coord_t height;
+    StyleId style;
+    BindingId binding;
+    const char* text;
+    uint8_t flags;
+};
+
+struct ScreenLayout {
+    const WidgetLayout* widgets;
+    size_t count;
+};
+
+/**
+ * Instantiates screen layouts and owns the styles they share.
+ */
+class LayoutBuilder {
+public:
+    LayoutBuilder();
+
+    // Create the shared styles (call once after lv_init)
+    void begin();
+
+    // Create a full-screen container with all widgets of the layout.
+    // Bound widgets are written to bindings[BIND_*].
+    lv_obj_t* build(const ScreenLayout& layout, lv_obj_t* parent, lv_obj_t** bindings);
+
+    // Clear the bindings owned by a layout after its screen was deleted
+    void unbind(const ScreenLayout& layout, lv_obj_t** bindings);
+
+    lv_style_t* style(StyleId id) { return &_styles[id]; }
+
+private:
+    lv_style_t _styles[STYLE_COUNT];
+    bool _initialized;
+
+    lv_obj_t* createWidget(const WidgetLayout& widget, lv_obj_t* parent);
+};
+
+#endif // UI_LAYOUT_H
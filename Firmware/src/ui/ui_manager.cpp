@@ -1,241 +1,367 @@
 #include "ui_manager.h"
+#include "ui_screens.h"
+#include "lv_display.h"
+#include "lv_input.h"
+
+// ListWindow::first before the roller was filled from the table
+#define LIST_WINDOW_NONE 0xFFFF
 
 UIManager::UIManager()
     : _currentScreen(SCREEN_SPLASH),
       _screen(nullptr),
-      _splashScreen(nullptr),
-      _nowPlayingScreen(nullptr),
-      _playlistsScreen(nullptr),
-      _albumsScreen(nullptr),
-      _settingsScreen(nullptr),
-      _volumeOverlay(nullptr),
-      _volumeOverlayTime(0) {
+      _suspended(false),
+      _overlay(nullptr),
+      _overlayTime(0),
+      _jumpStartUs(0),
+      _jumpDecodeUs(0),
+      _jumpFlushCount(0),
+      _jumpRow(0),
+      _jumpPending(false),
+      _coverImage(nullptr),
+      _artStartUs(0),
+      _artPreviewFlushCount(0),
+      _artCoverFlushCount(0),
+      _artTiming(false),
+      _artPreviewPending(false),
+      _artCoverWaiting(false),
+      _artCoverPending(false),
+      _durationMs(0),
+      _listSelectCallback(nullptr),
+      _seekCallback(nullptr),
+      _swipeCallback(nullptr),
+      _touchStartUs(0),
+      _touchFlushCount(0),
+      _touchPending(false),
+      _switchStartUs(0),
+      _switchFlushCount(0),
+      _switchPending(false),
+      _lastEvictionCheck(0),
+      _lastFlushCount(0),
+      _lastFlushMs(0),
+      _captureFlushCount(0),
+      _lastCaptureMs(0),
+      _captured(false) {
+    memset(_screens, 0, sizeof(_screens));
+    memset(_bound, 0, sizeof(_bound));
+    memset(_lastVisited, 0, sizeof(_lastVisited));
+    memset(_switchStats, 0, sizeof(_switchStats));
+    memset(&_renderStats, 0, sizeof(_renderStats));
+    memset(&_artStats, 0, sizeof(_artStats));
+    for (ListWindow& list : _listWindows) {
+        list.table = nullptr;
+        list.selected = 0;
+        list.first = LIST_WINDOW_NONE;
+    }
 }
 
 bool UIManager::begin() {
-    // Create all screens
-    createSplashScreen();
-    createNowPlayingScreen();
-    createPlaylistsScreen();
-    createAlbumsScreen();
-    createSettingsScreen();
+    unsigned long startUs = micros();
+
+    _layoutBuilder.begin();
+    _screenCache.begin();
+
+    // Swipes on any screen bubble up to the active LVGL screen
+    lv_obj_add_event_cb(lv_scr_act(), gestureEventHandler, LV_EVENT_GESTURE, this);
+
+    // Splash and Now Playing are needed right away, the rest are built on first use
+    buildScreen(SCREEN_SPLASH);
+    buildScreen(SCREEN_NOW_PLAYING);
 
     // Show splash screen initially
     showScreen(SCREEN_SPLASH);
 
+    Serial.printf("UI ready in %lu us\n", micros() - startUs);
     return true;
 }
 
 void UIManager::update() {
-    // Handle volume overlay timeout
-    if (_volumeOverlay && lv_obj_has_flag(_volumeOverlay, LV_OBJ_FLAG_HIDDEN) == false) {
-        if (millis() - _volumeOverlayTime > 2000) {
-            hideVolumeOverlay();
+    if (_suspended) return;
+
+    // Handle overlay timeout
+    if (_overlay && lv_obj_has_flag(_overlay, LV_OBJ_FLAG_HIDDEN) == false) {
+        if (millis() - _overlayTime > 2000) {
+            hideOverlay();
         }
     }
 
+    uint32_t flushCount = lv_display_flush_count();
+    unsigned long renderStartUs = micros();
     lv_timer_handler();
+
+    if (lv_display_flush_count() != flushCount) {
+        _renderStats.frames++;
+        _renderStats.totalUs += micros() - renderStartUs;
+    }
+
+    // First flush after an uncached switch is the first pixel of the new screen
+    if (_switchPending && lv_display_flush_count() != _switchFlushCount) {
+        _switchPending = false;
+        recordSwitch(_currentScreen, micros() - _switchStartUs, false);
+    }
+
+    if (_touchPending && lv_display_flush_count() != _touchFlushCount) {
+        finishTouchResponse();
+    }
+
+    if (_jumpPending && lv_display_flush_count() != _jumpFlushCount) {
+        _jumpPending = false;
+        Serial.printf("Jump to row %u: rows decoded in %lu us, on screen in %lu us\n",
+                      _jumpRow, _jumpDecodeUs, micros() - _jumpStartUs);
+    }
+
+    if (_artPreviewPending && lv_display_flush_count() != _artPreviewFlushCount) {
+        _artPreviewPending = false;
+        recordArt(false, micros() - _artStartUs);
+    }
+
+    if (_artCoverPending && lv_display_flush_count() != _artCoverFlushCount) {
+        _artCoverPending = false;
+        recordArt(true, micros() - _artStartUs);
+    }
+
+    if (millis() - _lastEvictionCheck > 1000) {
+        _lastEvictionCheck = millis();
+        evictIdleScreens();
+    }
+
+    captureIdleScreen();
+}
+
+void UIManager::suspend() {
+    if (_suspended) return;
+
+    // The overlay is not part of the screen's frame; drop it so both agree on wake
+    hideOverlay();
+
+    lv_obj_t* obj = getScreenObject(_currentScreen);
+    if (obj) {
+        _screenCache.capture(_currentScreen, obj);
+    }
+    _suspended = true;
+}
+
+bool UIManager::resume() {
+    if (!_suspended) return false;
+
+    _suspended = false;
+    _lastVisited[_currentScreen] = millis();
+    return _screenCache.blit(_currentScreen);
 }
 
 void UIManager::showScreen(UIScreen screen) {
+    UIScreen previous = _currentScreen;
+    _switchStartUs = micros();
+
+    // Put the cached frame on the panel before touching the object tree
+    bool cached = _screenCache.blit(screen);
+    if (cached) {
+        recordSwitch(screen, micros() - _switchStartUs, true);
+        if (_touchPending) finishTouchResponse();
+    }
+
+    // The new screen is captured once it has been drawn and the panel is idle
+    if (previous != screen) {
+        _captured = false;
+        _captureFlushCount = lv_display_flush_count();
+    }
+
     _currentScreen = screen;
+    _lastVisited[screen] = millis();
+    buildScreen(screen);
+
+    // Hide all screens except the selected one
+    for (int i = 0; i < SCREEN_COUNT; i++) {
+        lv_obj_t* obj = getScreenObject((UIScreen)i);
+        if (!obj) continue;
+
+        if (i == screen) {
+            lv_obj_clear_flag(obj, LV_OBJ_FLAG_HIDDEN);
+        } else {
+            lv_obj_add_flag(obj, LV_OBJ_FLAG_HIDDEN);
+        }
+    }
+
+    // Give the encoder to the screen's list, if it has one
+    lv_obj_t* focus = getFocusTarget(screen);
+    if (focus) {
+        lv_group_focus_obj(focus);
+        lv_group_set_editing(lv_input_group(), true);
+    }
+
+    // Without a cached frame the first pixel arrives with LVGL's next flush
+    if (!cached) {
+        _switchFlushCount = lv_display_flush_count();
+        _switchPending = true;
+    }
+}
+
+lv_obj_t* UIManager::getScreenObject(UIScreen screen) {
+    return screen < SCREEN_COUNT ? _screens[screen] : nullptr;
+}
+
+void UIManager::buildScreen(UIScreen screen) {
+    if (screen >= SCREEN_COUNT || _screens[screen]) return;
+
+    lv_mem_monitor_t before, after;
+    lv_mem_monitor(&before);
+    unsigned long startUs = micros();
+
+    lv_obj_t* obj = _layoutBuilder.build(SCREEN_LAYOUTS[screen], lv_scr_act(), _bound);
+    _screens[screen] = obj;
 
-    // Hide all screens
-    if (_splashScreen) lv_obj_add_flag(_splashScreen, LV_OBJ_FLAG_HIDDEN);
-    if (_nowPlayingScreen) lv_obj_add_flag(_nowPlayingScreen, LV_OBJ_FLAG_HIDDEN);
-    if (_playlistsScreen) lv_obj_add_flag(_playlistsScreen, LV_OBJ_FLAG_HIDDEN);
-    if (_albumsScreen) lv_obj_add_flag(_albumsScreen, LV_OBJ_FLAG_HIDDEN);
-    if (_settingsScreen) lv_obj_add_flag(_settingsScreen, LV_OBJ_FLAG_HIDDEN);
-
-    // Show selected screen
-    switch (screen) {
-        case SCREEN_SPLASH:
-            if (_splashScreen) lv_obj_clear_flag(_splashScreen, LV_OBJ_FLAG_HIDDEN);
-            break;
-        case SCREEN_NOW_PLAYING:
-            if (_nowPlayingScreen) lv_obj_clear_flag(_nowPlayingScreen, LV_OBJ_FLAG_HIDDEN);
-            break;
-        case SCREEN_PLAYLISTS:
-            if (_playlistsScreen) lv_obj_clear_flag(_playlistsScreen, LV_OBJ_FLAG_HIDDEN);
-            break;
-        case SCREEN_ALBUMS:
-            if (_albumsScreen) lv_obj_clear_flag(_albumsScreen, LV_OBJ_FLAG_HIDDEN);
-            break;
-        case SCREEN_SETTINGS:
-            if (_settingsScreen) lv_obj_clear_flag(_settingsScreen, LV_OBJ_FLAG_HIDDEN);
-            break;
-    }
-}
-
-void UIManager::createSplashScreen() {
-    _splashScreen = lv_obj_create(lv_scr_act());
-    lv_obj_set_size(_splashScreen, DISPLAY_WIDTH, DISPLAY_HEIGHT);
-    lv_obj_set_style_bg_color(_splashScreen, lv_color_black(), 0);
-
-    // App name label
-    lv_obj_t* nameLabel = lv_label_create(_splashScreen);
-    lv_label_set_text(nameLabel, APP_NAME);
-    lv_obj_set_style_text_font(nameLabel, &lv_font_montserrat_14, 0);
-    lv_obj_set_style_text_color(nameLabel, lv_color_white(), 0);
-    lv_obj_align(nameLabel, LV_ALIGN_CENTER, 0, -20);
-
-    // Version label
-    lv_obj_t* versionLabel = lv_label_create(_splashScreen);
-    lv_label_set_text(versionLabel, "v" APP_VERSION);
-    lv_obj_set_style_text_font(versionLabel, &lv_font_montserrat_14, 0);
-    lv_obj_set_style_text_color(versionLabel, lv_color_make(128, 128, 128), 0);
-    lv_obj_align(versionLabel, LV_ALIGN_CENTER, 0, 10);
-
-    // Loading spinner
-    lv_obj_t* spinner = lv_spinner_create(_splashScreen, 1000, 60);
-    lv_obj_set_size(spinner, 40, 40);
-    lv_obj_align(spinner, LV_ALIGN_CENTER, 0, 50);
-}
-
-void UIManager::createNowPlayingScreen() {
-    _nowPlayingScreen = lv_obj_create(lv_scr_act());
-    lv_obj_set_size(_nowPlayingScreen, DISPLAY_WIDTH, DISPLAY_HEIGHT);
-    lv_obj_set_style_bg_color(_nowPlayingScreen, lv_color_black(), 0);
-
-    // Album art (centered, circular)
-    _albumArtImage = lv_img_create(_nowPlayingScreen);
-    lv_obj_set_size(_albumArtImage, 120, 120);
-    lv_obj_align(_albumArtImage, LV_ALIGN_CENTER, 0, -40);
-
-    // Track name
-    _trackLabel = lv_label_create(_nowPlayingScreen);
-    lv_label_set_text(_trackLabel, "No track");
-    lv_obj_set_style_text_font(_trackLabel, &lv_font_montserrat_14, 0);
-    lv_obj_set_style_text_color(_trackLabel, lv_color_white(), 0);
-    lv_obj_align(_trackLabel, LV_ALIGN_CENTER, 0, 50);
-    lv_label_set_long_mode(_trackLabel, LV_LABEL_LONG_SCROLL_CIRCULAR);
-    lv_obj_set_width(_trackLabel, DISPLAY_WIDTH - 20);
-
-    // Artist name
-    _artistLabel = lv_label_create(_nowPlayingScreen);
-    lv_label_set_text(_artistLabel, "No artist");
-    lv_obj_set_style_text_font(_artistLabel, &lv_font_montserrat_14, 0);
-    lv_obj_set_style_text_color(_artistLabel, lv_color_make(180, 180, 180), 0);
-    lv_obj_align(_artistLabel, LV_ALIGN_CENTER, 0, 70);
-    lv_label_set_long_mode(_artistLabel, LV_LABEL_LONG_SCROLL_CIRCULAR);
-    lv_obj_set_width(_artistLabel, DISPLAY_WIDTH - 20);
-
-    // Progress bar
-    _progressBar = lv_bar_create(_nowPlayingScreen);
-    lv_obj_set_size(_progressBar, DISPLAY_WIDTH - 40, 4);
-    lv_obj_align(_progressBar, LV_ALIGN_BOTTOM_MID, 0, -30);
-    lv_bar_set_value(_progressBar, 0, LV_ANIM_OFF);
-
-    // Progress label (time)
-    _progressLabel = lv_label_create(_nowPlayingScreen);
-    lv_label_set_text(_progressLabel, "0:00 / 0:00");
-    lv_obj_set_style_text_font(_progressLabel, &lv_font_montserrat_14, 0);
-    lv_obj_set_style_text_color(_progressLabel, lv_color_make(128, 128, 128), 0);
-    lv_obj_align(_progressLabel, LV_ALIGN_BOTTOM_MID, 0, -10);
-
-    // Play/Pause icon
-    _playPauseIcon = lv_label_create(_nowPlayingScreen);
-    lv_label_set_text(_playPauseIcon, LV_SYMBOL_PLAY);
-    lv_obj_set_style_text_font(_playPauseIcon, &lv_font_montserrat_14, 0);
-    lv_obj_align(_playPauseIcon, LV_ALIGN_TOP_MID, 0, 10);
-}
-
-void UIManager::createPlaylistsScreen() {
-    _playlistsScreen = lv_obj_create(lv_scr_act());
-    lv_obj_set_size(_playlistsScreen, DISPLAY_WIDTH, DISPLAY_HEIGHT);
-    lv_obj_set_style_bg_color(_playlistsScreen, lv_color_black(), 0);
-
-    // Title
-    lv_obj_t* titleLabel = lv_label_create(_playlistsScreen);
-    lv_label_set_text(titleLabel, "Playlists");
-    lv_obj_set_style_text_font(titleLabel, &lv_font_montserrat_14, 0);
-    lv_obj_align(titleLabel, LV_ALIGN_TOP_MID, 0, 10);
-
-    // Roller for playlist list
-    _listRoller = lv_roller_create(_playlistsScreen);
-    lv_obj_set_size(_listRoller, DISPLAY_WIDTH - 40, 150);
-    lv_obj_align(_listRoller, LV_ALIGN_CENTER, 0, 20);
-    lv_roller_set_options(_listRoller, "Loading...", LV_ROLLER_MODE_NORMAL);
-}
-
-void UIManager::createAlbumsScreen() {
-    _albumsScreen = lv_obj_create(lv_scr_act());
-    lv_obj_set_size(_albumsScreen, DISPLAY_WIDTH, DISPLAY_HEIGHT);
-    lv_obj_set_style_bg_color(_albumsScreen, lv_color_black(), 0);
-
-    // Similar to playlists screen
-    lv_obj_t* titleLabel = lv_label_create(_albumsScreen);
-    lv_label_set_text(titleLabel, "Albums");
-    lv_obj_set_style_text_font(titleLabel, &lv_font_montserrat_14, 0);
-    lv_obj_align(titleLabel, LV_ALIGN_TOP_MID, 0, 10);
-}
-
-void UIManager::createSettingsScreen() {
-    _settingsScreen = lv_obj_create(lv_scr_act());
-    lv_obj_set_size(_settingsScreen, DISPLAY_WIDTH, DISPLAY_HEIGHT);
-    lv_obj_set_style_bg_color(_settingsScreen, lv_color_black(), 0);
-
-    lv_obj_t* titleLabel = lv_label_create(_settingsScreen);
-    lv_label_set_text(titleLabel, "Settings");
-    lv_obj_set_style_text_font(titleLabel, &lv_font_montserrat_14, 0);
-    lv_obj_align(titleLabel, LV_ALIGN_TOP_MID, 0, 10);
+    // Keep overlays such as the volume popup above rebuilt screens
+    lv_obj_add_flag(obj, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_move_background(obj);
+    attachInput(screen);
+
+    // A rebuilt list starts from "Loading..."; refill it from its table
+    BindingId binding = listBinding(screen);
+    ListWindow* list = listWindow(binding);
+    if (list && list->table) {
+        list->first = LIST_WINDOW_NONE;
+        selectListRow(binding, list->selected);
+    }
+
+    lv_mem_monitor(&after);
+    Serial.printf("Screen %d built: %u widgets, %lu bytes LVGL memory, %lu us\n",
+                  screen, (unsigned)SCREEN_LAYOUTS[screen].count,
+                  (unsigned long)(before.free_size - after.free_size), micros() - startUs);
+}
+
+void UIManager::destroyScreen(UIScreen screen) {
+    lv_obj_t* obj = getScreenObject(screen);
+    if (!obj) return;
+
+    lv_obj_del(obj);
+    _screens[screen] = nullptr;
+    _screenCache.invalidate(screen);
+    _layoutBuilder.unbind(SCREEN_LAYOUTS[screen], _bound);
+
+    Serial.printf("Screen %d destroyed after %lu ms idle\n", screen, millis() - _lastVisited[screen]);
+}
+
+void UIManager::evictIdleScreens() {
+    unsigned long now = millis();
+
+    for (int i = 0; i < SCREEN_COUNT; i++) {
+        UIScreen screen = (UIScreen)i;
+
+        // Now Playing holds the live playback state and is never rebuilt
+        if (screen == _currentScreen || screen == SCREEN_NOW_PLAYING) continue;
+        if (!getScreenObject(screen)) continue;
+
+        if (now - _lastVisited[screen] > SCREEN_EVICT_AFTER_MS) {
+            destroyScreen(screen);
+        }
+    }
+}
+
+// Snapshots are taken here rather than on a switch, so their render is not
+// part of the switch's latency; Now Playing redraws every second, hence the cap
+void UIManager::captureIdleScreen() {
+    uint32_t flushCount = lv_display_flush_count();
+    unsigned long now = millis();
+    if (flushCount != _lastFlushCount) {
+        _lastFlushCount = flushCount;
+        _lastFlushMs = now;
+        return;
+    }
+
+    if (flushCount == _captureFlushCount || now - _lastFlushMs < SCREEN_CACHE_SETTLE_MS) return;
+    if (_captured && now - _lastCaptureMs < SCREEN_CACHE_REFRESH_MS) return;
+
+    lv_obj_t* obj = getScreenObject(_currentScreen);
+    if (obj && _screenCache.capture(_currentScreen, obj)) {
+        _captured = true;
+    }
+    _captureFlushCount = flushCount;
+    _lastCaptureMs = now;
+}
+
+void UIManager::recordSwitch(UIScreen screen, unsigned long elapsedUs, bool cached) {
+    ScreenSwitchStats& stats = _switchStats[screen];
+    stats.switches++;
+    if (cached) stats.cachedSwitches++;
+    stats.lastUs = elapsedUs;
+    stats.maxUs = max(stats.maxUs, (uint32_t)elapsedUs);
+    stats.totalUs += elapsedUs;
+
+    Serial.printf("Screen %d first pixel in %lu us (%s, avg %lu us, max %lu us)\n",
+                  screen, elapsedUs, cached ? "cached" : "live",
+                  (unsigned long)(stats.totalUs / stats.switches), (unsigned long)stats.maxUs);
 }
 
 void UIManager::updateNowPlaying(const char* trackName, const char* artistName,
                                  const char* albumName, int progressMs, int durationMs,
                                  int volumePercent, bool isPlaying) {
-    if (_trackLabel) {
-        lv_label_set_text(_trackLabel, trackName);
+    if (_bound[BIND_TRACK_NAME]) {
+        lv_label_set_text(_bound[BIND_TRACK_NAME], trackName);
     }
 
-    if (_artistLabel) {
-        lv_label_set_text(_artistLabel, artistName);
+    if (_bound[BIND_ARTIST_NAME]) {
+        lv_label_set_text(_bound[BIND_ARTIST_NAME], artistName);
     }
 
-    if (_progressBar && durationMs > 0) {
+    _durationMs = durationMs;
+
+    if (_bound[BIND_PROGRESS] && durationMs > 0) {
         int percent = (progressMs * 100) / durationMs;
-        lv_bar_set_value(_progressBar, percent, LV_ANIM_OFF);
+        lv_bar_set_value(_bound[BIND_PROGRESS], percent, LV_ANIM_OFF);
     }
 
-    if (_progressLabel) {
+    if (_bound[BIND_PROGRESS_TEXT]) {
         char buffer[32];
         char currentTime[16], totalTime[16];
         formatTime(progressMs, currentTime, sizeof(currentTime));
         formatTime(durationMs, totalTime, sizeof(totalTime));
         snprintf(buffer, sizeof(buffer), "%s / %s", currentTime, totalTime);
-        lv_label_set_text(_progressLabel, buffer);
+        lv_label_set_text(_bound[BIND_PROGRESS_TEXT], buffer);
     }
 
-    if (_playPauseIcon) {
-        lv_label_set_text(_playPauseIcon, isPlaying ? LV_SYMBOL_PAUSE : LV_SYMBOL_PLAY);
+    if (_bound[BIND_PLAY_STATE]) {
+        lv_label_set_text_static(_bound[BIND_PLAY_STATE], isPlaying ? LV_SYMBOL_PAUSE : LV_SYMBOL_PLAY);
     }
 }
 
-void UIManager::showVolumeOverlay(int volume) {
-    if (!_volumeOverlay) {
-        // Create volume overlay
-        _volumeOverlay = lv_obj_create(lv_scr_act());
-        lv_obj_set_size(_volumeOverlay, 100, 100);
-        lv_obj_align(_volumeOverlay, LV_ALIGN_CENTER, 0, 0);
-        lv_obj_set_style_bg_color(_volumeOverlay, lv_color_make(40, 40, 40), 0);
-        lv_obj_set_style_bg_opa(_volumeOverlay, LV_OPA_90, 0);
-        lv_obj_set_style_radius(_volumeOverlay, 10, 0);
-
-        _volumeLabel = lv_label_create(_volumeOverlay);
-        lv_obj_set_style_text_font(_volumeLabel, &lv_font_montserrat_14, 0);
-        lv_obj_align(_volumeLabel, LV_ALIGN_CENTER, 0, 0);
+void UIManager::updateDiagnostics(const char* text) {
+    if (_bound[BIND_DIAGNOSTICS]) {
+        lv_label_set_text(_bound[BIND_DIAGNOSTICS], text);
     }
+}
 
+void UIManager::showVolumeOverlay(int volume) {
     char buffer[16];
     snprintf(buffer, sizeof(buffer), "%d%%", volume);
-    lv_label_set_text(_volumeLabel, buffer);
-    lv_obj_clear_flag(_volumeOverlay, LV_OBJ_FLAG_HIDDEN);
-    _volumeOverlayTime = millis();
+    showOverlay(buffer);
+}
+
+void UIManager::showSeekOverlay(int positionMs) {
+    char buffer[16];
+    formatTime(positionMs, buffer, sizeof(buffer));
+    showOverlay(buffer);
+}
+
+void UIManager::showOverlay(const char* text) {
+    if (!_overlay) {
+        // Create the overlay, shared by the volume, seek position and list jump letter
+        _overlay = lv_obj_create(lv_scr_act());
+        lv_obj_set_size(_overlay, 100, 100);
+        lv_obj_align(_overlay, LV_ALIGN_CENTER, 0, 0);
+        lv_obj_add_style(_overlay, _layoutBuilder.style(STYLE_OVERLAY), 0);
+
+        _overlayLabel = lv_label_create(_overlay);
+        lv_obj_add_style(_overlayLabel, _layoutBuilder.style(STYLE_TEXT), 0);
+        lv_obj_align(_overlayLabel, LV_ALIGN_CENTER, 0, 0);
+    }
+
+    lv_label_set_text(_overlayLabel, text);
+    lv_obj_clear_flag(_overlay, LV_OBJ_FLAG_HIDDEN);
+    _overlayTime = millis();
 }
 
-void UIManager::hideVolumeOverlay() {
-    if (_volumeOverlay) {
-        lv_obj_add_flag(_volumeOverlay, LV_OBJ_FLAG_HIDDEN);
+void UIManager::hideOverlay() {
+    if (_overlay) {
+        lv_obj_add_flag(_overlay, LV_OBJ_FLAG_HIDDEN);
     }
 }
 
@@ -247,23 +373,376 @@ void UIManager::formatTime(int milliseconds, char* buffer, size_t bufferSize) {
 }
 
 void UIManager::onEncoderChange(int delta) {
-    // Handle encoder rotation based on current screen
-    // To be implemented based on UI requirements
+    BindingId binding = listBinding(_currentScreen);
+    ListWindow* list = listWindow(binding);
+
+    // Table-backed lists move their window; the rest consume rotation
+    // natively through the LVGL encoder group
+    if (list && list->table) {
+        int row = constrain((int)list->selected + delta, 0, max((int)list->table->count() - 1, 0));
+        selectListRow(binding, row);
+    } else {
+        lv_input_encoder_feed(delta);
+    }
+}
+
+void UIManager::onEncoderJump(int direction) {
+    BindingId binding = listBinding(_currentScreen);
+    ListWindow* list = listWindow(binding);
+
+    // Short JSON lists have no letter index; page through them instead
+    if (!list || !list->table || list->table->count() == 0) {
+        lv_input_encoder_feed(direction * LIST_WINDOW_ROWS);
+        return;
+    }
+
+    _jumpStartUs = micros();
+    uint16_t row = list->table->jump(list->selected, direction);
+    selectListRow(binding, row);
+    _jumpDecodeUs = micros() - _jumpStartUs;
+    _jumpRow = row;
+    _jumpFlushCount = lv_display_flush_count();
+    _jumpPending = true;
+
+    char letter[2] = { NameTable::bucketLabel(list->table->bucketOf(row)), '\0' };
+    showOverlay(letter);
 }
 
 void UIManager::onEncoderClick() {
-    // Handle encoder click based on current screen
-    // To be implemented based on UI requirements
+    lv_input_encoder_click();
+}
+
+void UIManager::startArtTiming() {
+    _artStartUs = micros();
+    _artTiming = true;
+    _artPreviewPending = false;
+    _artCoverWaiting = false;
+    _artCoverPending = false;
+}
+
+void UIManager::updateArtPreview(const char* preview) {
+    lv_obj_t* art = _bound[BIND_ALBUM_ART];
+
+    // Unchanged means the new track shares the cover; nothing new to draw or time
+    if (!art || !_albumArt.setPreview(preview)) {
+        _artTiming = false;
+        return;
+    }
+
+    hideCover();
+    lv_img_cache_invalidate_src(_albumArt.preview());
+    lv_img_set_src(art, _albumArt.preview());
+    lv_obj_invalidate(art);
+
+    if (_artTiming && artVisible()) {
+        _artPreviewFlushCount = lv_display_flush_count();
+        _artPreviewPending = true;
+        _artCoverWaiting = true;
+    }
+    _artTiming = false;
 }
 
 void UIManager::updateAlbumArt(uint8_t* imageData, size_t length) {
-    // To be implemented - decode and display album art
+    lv_obj_t* art = _bound[BIND_ALBUM_ART];
+    if (!art) return;
+
+    if (!_coverImage) {
+        _coverImage = lv_img_create(art);
+        lv_obj_set_size(_coverImage, ART_SIZE, ART_SIZE);
+        lv_obj_center(_coverImage);
+        lv_obj_set_style_img_opa(_coverImage, LV_OPA_TRANSP, 0);
+    }
+
+    // Rendering only happens in update(), so the buffer can be rewritten in place
+    if (!_albumArt.setCover(imageData, length)) {
+        if (!_albumArt.hasCover()) hideCover();
+        return;
+    }
+
+    lv_img_cache_invalidate_src(_albumArt.cover());
+    lv_img_set_src(_coverImage, _albumArt.cover());
+    lv_obj_invalidate(_coverImage);
+
+    lv_anim_del(_coverImage, coverFadeAnim);
+    lv_anim_t anim;
+    lv_anim_init(&anim);
+    lv_anim_set_var(&anim, _coverImage);
+    lv_anim_set_exec_cb(&anim, coverFadeAnim);
+    lv_anim_set_values(&anim, LV_OPA_TRANSP, LV_OPA_COVER);
+    lv_anim_set_time(&anim, ART_CROSSFADE_MS);
+    lv_anim_start(&anim);
+
+    if (_artCoverWaiting && artVisible()) {
+        _artCoverFlushCount = lv_display_flush_count();
+        _artCoverPending = true;
+    }
+    _artCoverWaiting = false;
+}
+
+bool UIManager::artVisible() {
+    return !_suspended && _currentScreen == SCREEN_NOW_PLAYING;
+}
+
+void UIManager::hideCover() {
+    if (_coverImage) {
+        lv_anim_del(_coverImage, coverFadeAnim);
+        lv_obj_set_style_img_opa(_coverImage, LV_OPA_TRANSP, 0);
+    }
+    _albumArt.clearCover();
+    _artCoverWaiting = false;
+    _artCoverPending = false;
+}
+
+void UIManager::coverFadeAnim(void* obj, int32_t value) {
+    lv_obj_set_style_img_opa((lv_obj_t*)obj, (lv_opa_t)value, 0);
+}
+
+void UIManager::recordArt(bool cover, unsigned long elapsedUs) {
+    if (cover) {
+        _artStats.covers++;
+        _artStats.lastCoverUs = elapsedUs;
+        _artStats.totalCoverUs += elapsedUs;
+        Serial.printf("Album art: full cover in %lu us (decoded in %lu us)\n",
+                      elapsedUs, _albumArt.coverDecodeUs());
+    } else {
+        _artStats.previews++;
+        _artStats.lastPreviewUs = elapsedUs;
+        _artStats.totalPreviewUs += elapsedUs;
+        Serial.printf("Album art: first colour in %lu us\n", elapsedUs);
+    }
 }
 
 void UIManager::updatePlaylists(const char** playlists, size_t count) {
-    // To be implemented
+    setListOptions(BIND_PLAYLISTS, playlists, count);
 }
 
 void UIManager::updateAlbums(const char** albums, size_t count) {
-    // To be implemented
+    setListOptions(BIND_ALBUMS, albums, count);
+}
+
+void UIManager::setPlaylistTable(const NameTable* table) {
+    setListTable(BIND_PLAYLISTS, table);
+}
+
+void UIManager::setAlbumTable(const NameTable* table) {
+    setListTable(BIND_ALBUMS, table);
+}
+
+UIManager::ListWindow* UIManager::listWindow(BindingId binding) {
+    if (binding == BIND_PLAYLISTS) return &_listWindows[0];
+    if (binding == BIND_ALBUMS) return &_listWindows[1];
+    return nullptr;
+}
+
+BindingId UIManager::listBinding(UIScreen screen) {
+    if (screen == SCREEN_PLAYLISTS) return BIND_PLAYLISTS;
+    if (screen == SCREEN_ALBUMS) return BIND_ALBUMS;
+    return BIND_NONE;
+}
+
+void UIManager::setListTable(BindingId binding, const NameTable* table) {
+    ListWindow* list = listWindow(binding);
+    if (!list) return;
+
+    // Same position after a library update, as far as the list still reaches
+    list->table = table;
+    list->first = LIST_WINDOW_NONE;
+    selectListRow(binding, list->selected);
+}
+
+void UIManager::selectListRow(BindingId binding, uint16_t row) {
+    ListWindow* list = listWindow(binding);
+    lv_obj_t* roller = _bound[binding];
+    if (!list || !list->table) return;
+
+    uint16_t count = list->table->count();
+    list->selected = count > 0 ? min<uint16_t>(row, count - 1) : 0;
+    if (!roller) return;
+
+    if (count == 0) {
+        lv_roller_set_options(roller, "Empty", LV_ROLLER_MODE_NORMAL);
+        list->first = LIST_WINDOW_NONE;
+        return;
+    }
+
+    // Keep two rows of context on either side before moving the window
+    const uint16_t margin = 2;
+    uint16_t rows = min<uint16_t>(count, LIST_WINDOW_ROWS);
+    bool inWindow = list->first != LIST_WINDOW_NONE &&
+                    list->selected >= list->first && list->selected < list->first + rows &&
+                    (list->selected >= list->first + margin || list->first == 0) &&
+                    (list->selected + margin < list->first + rows || list->first + rows == count);
+
+    if (!inWindow) {
+        uint16_t first = list->selected > rows / 2 ? list->selected - rows / 2 : 0;
+        list->first = min<uint16_t>(first, count - rows);
+
+        // Decode just the window, starting from the nearest restart point
+        char* options = (char*)lv_mem_alloc(rows * NAME_TABLE_NAME_LENGTH);
+        if (!options) return;
+
+        NameTable::Cursor cursor;
+        char* p = options;
+        bool ok = list->table->seek(cursor, list->first);
+        for (uint16_t i = 0; ok && i < rows; i++) {
+            // Roller options are newline-separated
+            if (i > 0) *p++ = '\n';
+            for (const char* c = cursor.name; *c; c++) {
+                *p++ = *c == '\n' ? ' ' : *c;
+            }
+            ok = i + 1 == rows || list->table->next(cursor);
+        }
+        *p = '\0';
+
+        lv_roller_set_options(roller, options, LV_ROLLER_MODE_NORMAL);
+        lv_mem_free(options);
+        lv_roller_set_selected(roller, list->selected - list->first, LV_ANIM_OFF);
+    } else {
+        lv_roller_set_selected(roller, list->selected - list->first, LV_ANIM_ON);
+    }
+}
+
+void UIManager::setListOptions(BindingId binding, const char** items, size_t count) {
+    lv_obj_t* roller = _bound[binding];
+    if (!roller) return;
+
+    if (count == 0) {
+        lv_roller_set_options(roller, "Empty", LV_ROLLER_MODE_NORMAL);
+        return;
+    }
+
+    // Roller options are a single newline-separated string
+    size_t length = 0;
+    for (size_t i = 0; i < count; i++) {
+        length += strlen(items[i]) + 1;
+    }
+
+    char* options = (char*)lv_mem_alloc(length);
+    if (!options) return;
+
+    char* p = options;
+    for (size_t i = 0; i < count; i++) {
+        size_t itemLength = strlen(items[i]);
+        memcpy(p, items[i], itemLength);
+        p += itemLength;
+        *p++ = (i + 1 < count) ? '\n' : '\0';
+    }
+
+    lv_roller_set_options(roller, options, LV_ROLLER_MODE_NORMAL);
+    lv_mem_free(options);
+}
+
+void UIManager::attachInput(UIScreen screen) {
+    const ScreenLayout& layout = SCREEN_LAYOUTS[screen];
+
+    for (size_t i = 0; i < layout.count; i++) {
+        const WidgetLayout& widget = layout.widgets[i];
+        if (widget.binding == BIND_NONE || !_bound[widget.binding]) continue;
+
+        lv_obj_t* obj = _bound[widget.binding];
+
+        if (widget.type == WIDGET_ROLLER) {
+            lv_group_add_obj(lv_input_group(), obj);
+            lv_obj_add_event_cb(obj, listEventHandler, LV_EVENT_CLICKED, this);
+            lv_obj_add_event_cb(obj, listScrollEventHandler, LV_EVENT_VALUE_CHANGED, this);
+        } else if (widget.binding == BIND_PROGRESS) {
+            lv_obj_add_event_cb(obj, seekEventHandler, LV_EVENT_CLICKED, this);
+        }
+    }
+}
+
+lv_obj_t* UIManager::getFocusTarget(UIScreen screen) {
+    const ScreenLayout& layout = SCREEN_LAYOUTS[screen];
+
+    for (size_t i = 0; i < layout.count; i++) {
+        if (layout.widgets[i].type == WIDGET_ROLLER && layout.widgets[i].binding != BIND_NONE) {
+            return _bound[layout.widgets[i].binding];
+        }
+    }
+    return nullptr;
+}
+
+void UIManager::startTouchResponse() {
+    // Encoder selections raise the same events but have no touch to measure from
+    lv_indev_t* indev = lv_indev_get_act();
+    if (!indev || lv_indev_get_type(indev) != LV_INDEV_TYPE_POINTER) return;
+
+    _touchStartUs = lv_input_last_touch_us();
+    _touchFlushCount = lv_display_flush_count();
+    _touchPending = true;
+}
+
+void UIManager::finishTouchResponse() {
+    _touchPending = false;
+    Serial.printf("Touch response in %lu us\n", micros() - _touchStartUs);
+}
+
+void UIManager::listEventHandler(lv_event_t* e) {
+    UIManager* ui = (UIManager*)lv_event_get_user_data(e);
+    lv_obj_t* roller = lv_event_get_target(e);
+
+    // Releasing the encoder leaves edit mode; stay in it so rotation keeps scrolling
+    lv_group_set_editing(lv_input_group(), true);
+
+    if (ui->_listSelectCallback) {
+        // Table-backed lists report the row in the table, not in the window
+        uint16_t index = lv_roller_get_selected(roller);
+        ListWindow* list = ui->listWindow(ui->listBinding(ui->_currentScreen));
+        if (list && list->table && list->first != LIST_WINDOW_NONE) {
+            index = list->first + index;
+        }
+
+        ui->startTouchResponse();
+        ui->_listSelectCallback(ui->_currentScreen, index);
+    }
+}
+
+void UIManager::listScrollEventHandler(lv_event_t* e) {
+    UIManager* ui = (UIManager*)lv_event_get_user_data(e);
+    lv_obj_t* roller = lv_event_get_target(e);
+    BindingId binding = ui->listBinding(ui->_currentScreen);
+    ListWindow* list = ui->listWindow(binding);
+
+    // Dragged by touch: follow the selection with the window
+    if (list && list->table && list->first != LIST_WINDOW_NONE && ui->_bound[binding] == roller) {
+        ui->selectListRow(binding, list->first + lv_roller_get_selected(roller));
+    }
+}
+
+void UIManager::seekEventHandler(lv_event_t* e) {
+    UIManager* ui = (UIManager*)lv_event_get_user_data(e);
+    lv_obj_t* bar = lv_event_get_target(e);
+    if (ui->_durationMs <= 0) return;
+
+    lv_point_t point;
+    lv_area_t coords;
+    lv_indev_get_point(lv_indev_get_act(), &point);
+    lv_obj_get_coords(bar, &coords);
+
+    int32_t width = lv_area_get_width(&coords);
+    int32_t x = constrain(point.x - coords.x1, 0, width);
+    int percent = (x * 100) / width;
+
+    // Move the bar right away, the next status update confirms the position
+    lv_bar_set_value(bar, percent, LV_ANIM_OFF);
+    ui->startTouchResponse();
+
+    if (ui->_seekCallback) {
+        ui->_seekCallback((int)(((int64_t)ui->_durationMs * x) / width));
+    }
+}
+
+void UIManager::gestureEventHandler(lv_event_t* e) {
+    UIManager* ui = (UIManager*)lv_event_get_user_data(e);
+    lv_dir_t dir = lv_indev_get_gesture_dir(lv_indev_get_act());
+
+    if (!ui->_swipeCallback) return;
+
+    if (dir == LV_DIR_LEFT) {
+        ui->startTouchResponse();
+        ui->_swipeCallback(1);
+    } else if (dir == LV_DIR_RIGHT) {
+        ui->startTouchResponse();
+        ui->_swipeCallback(-1);
+    }
 }
@@ -4,14 +4,39 @@
 #include <M5Dial.h>
 #include <lvgl.h>
 #include "config.h"
+#include "album_art.h"
+#include "screen_cache.h"
+#include "ui_layout.h"
+#include "library/name_table.h"
+
+// Callback types
+typedef void (*ListSelectCallback)(UIScreen screen, uint16_t index);
+typedef void (*SeekCallback)(int positionMs);
+typedef void (*SwipeCallback)(int direction);
+
+// Switch-to-first-pixel latency for one screen
+struct ScreenSwitchStats {
+    uint32_t switches;
+    uint32_t cachedSwitches;
+    uint32_t lastUs;
+    uint32_t maxUs;
+    uint64_t totalUs;
+};
+
+// LVGL passes that drew something, and how long they took including the flush
+struct RenderStats {
+    uint32_t frames;
+    uint64_t totalUs;
+};
 
-// UI Screens
-enum UIScreen {
-    SCREEN_SPLASH,
-    SCREEN_NOW_PLAYING,
-    SCREEN_PLAYLISTS,
-    SCREEN_ALBUMS,
-    SCREEN_SETTINGS
+// Track change to the first pixel of its cover: the colour preview, then the full image
+struct ArtStats {
+    uint32_t previews;
+    uint32_t covers;
+    uint32_t lastPreviewUs;
+    uint32_t lastCoverUs;
+    uint64_t totalPreviewUs;
+    uint64_t totalCoverUs;
 };
 
 class UIManager {
@@ -22,66 +47,159 @@ public:
     bool begin();
     void update();
 
+    // Stop rendering while the backlight is off. The current frame is kept
+    // in the screen cache; resume puts it back on the panel, false if there was none
+    void suspend();
+    bool resume();
+    bool isSuspended() { return _suspended; }
+
     // Screen management
     void showScreen(UIScreen screen);
     UIScreen getCurrentScreen() { return _currentScreen; }
+    const ScreenSwitchStats& getSwitchStats(UIScreen screen) { return _switchStats[screen]; }
+    const RenderStats& getRenderStats() { return _renderStats; }
 
     // Now Playing screen updates
     void updateNowPlaying(const char* trackName, const char* artistName,
                          const char* albumName, int progressMs, int durationMs,
                          int volumePercent, bool isPlaying);
+
+    // Album art: the preview from the status is drawn at once, the full cover
+    // fades in over it. A track change starts the clock for both
+    void startArtTiming();
+    void updateArtPreview(const char* preview);
     void updateAlbumArt(uint8_t* imageData, size_t length);
+    const ArtStats& getArtStats() { return _artStats; }
 
     // Playlist/Album list updates
     void updatePlaylists(const char** playlists, size_t count);
     void updateAlbums(const char** albums, size_t count);
 
+    // Lists backed by a name table; only the rows around the selection are decoded
+    void setPlaylistTable(const NameTable* table);
+    void setAlbumTable(const NameTable* table);
+
     // Encoder handling
     void onEncoderChange(int delta);
     void onEncoderClick();
+    void onEncoderJump(int direction);  // Press-and-turn: next/previous letter
+
+    // Diagnostics text on the Settings screen
+    void updateDiagnostics(const char* text);
 
-    // Volume control
+    // Volume and seek feedback
     void showVolumeOverlay(int volume);
-    void hideVolumeOverlay();
+    void showSeekOverlay(int positionMs);
+    void hideOverlay();
+
+    // Callbacks
+    void onListSelect(ListSelectCallback callback) { _listSelectCallback = callback; }
+    void onSeek(SeekCallback callback) { _seekCallback = callback; }
+    void onSwipe(SwipeCallback callback) { _swipeCallback = callback; }
 
 private:
     UIScreen _currentScreen;
     lv_obj_t* _screen;
-
-    // Screen objects
-    lv_obj_t* _splashScreen;
-    lv_obj_t* _nowPlayingScreen;
-    lv_obj_t* _playlistsScreen;
-    lv_obj_t* _albumsScreen;
-    lv_obj_t* _settingsScreen;
-
-    // Now Playing widgets
-    lv_obj_t* _trackLabel;
-    lv_obj_t* _artistLabel;
-    lv_obj_t* _albumLabel;
-    lv_obj_t* _progressBar;
-    lv_obj_t* _progressLabel;
-    lv_obj_t* _albumArtImage;
-    lv_obj_t* _playPauseIcon;
-    lv_obj_t* _volumeArc;
-
-    // Volume overlay
-    lv_obj_t* _volumeOverlay;
-    lv_obj_t* _volumeLabel;
-    unsigned long _volumeOverlayTime;
-
-    // List widgets
-    lv_obj_t* _listRoller;
-
-    // Screen creation
-    void createSplashScreen();
-    void createNowPlayingScreen();
-    void createPlaylistsScreen();
-    void createAlbumsScreen();
-    void createSettingsScreen();
+    bool _suspended;
+
+    // Screen objects, built from SCREEN_LAYOUTS
+    LayoutBuilder _layoutBuilder;
+    lv_obj_t* _screens[SCREEN_COUNT];
+
+    // Widgets bound to model fields
+    lv_obj_t* _bound[BIND_COUNT];
+
+    // Volume and jump letter overlay
+    lv_obj_t* _overlay;
+    lv_obj_t* _overlayLabel;
+    unsigned long _overlayTime;
+
+    // Table-backed lists: the roller holds a window of LIST_WINDOW_ROWS rows
+    struct ListWindow {
+        const NameTable* table;
+        uint16_t selected;  // Row in the table
+        uint16_t first;     // Row shown as the roller's first option, LIST_WINDOW_NONE if not built
+    };
+    ListWindow _listWindows[2];
+
+    // Time to jump: rows decoded, then first pixel with the next flush
+    unsigned long _jumpStartUs;
+    unsigned long _jumpDecodeUs;
+    uint32_t _jumpFlushCount;
+    uint16_t _jumpRow;
+    bool _jumpPending;
+
+    // Album art: the cover image is a child of the bound preview image
+    AlbumArt _albumArt;
+    lv_obj_t* _coverImage;
+    ArtStats _artStats;
+    unsigned long _artStartUs;
+    uint32_t _artPreviewFlushCount;
+    uint32_t _artCoverFlushCount;
+    bool _artTiming;          // Track changed, its preview not seen yet
+    bool _artPreviewPending;  // New preview drawn, waiting for the flush
+    bool _artCoverWaiting;    // Waiting for the full cover of that preview
+    bool _artCoverPending;    // Cover decoded, waiting for the flush
+
+    // Playback state needed to turn a tap into a seek position
+    int _durationMs;
+
+    ListSelectCallback _listSelectCallback;
+    SeekCallback _seekCallback;
+    SwipeCallback _swipeCallback;
+
+    // Touch-to-response latency
+    unsigned long _touchStartUs;
+    uint32_t _touchFlushCount;
+    bool _touchPending;
+
+    // Screen switching
+    ScreenCache _screenCache;
+    unsigned long _lastVisited[SCREEN_COUNT];
+    ScreenSwitchStats _switchStats[SCREEN_COUNT];
+    unsigned long _switchStartUs;
+    uint32_t _switchFlushCount;
+    bool _switchPending;
+    unsigned long _lastEvictionCheck;
+
+    // Snapshots of the shown screen, taken while the panel is idle
+    uint32_t _lastFlushCount;
+    unsigned long _lastFlushMs;
+    uint32_t _captureFlushCount;  // Flushes when the shown screen was last captured
+    unsigned long _lastCaptureMs;
+    bool _captured;               // Captured since it was switched to
+    RenderStats _renderStats;
+
+    // Screen lifecycle
+    lv_obj_t* getScreenObject(UIScreen screen);
+    void buildScreen(UIScreen screen);
+    void destroyScreen(UIScreen screen);
+    void evictIdleScreens();
+    void captureIdleScreen();
+    void recordSwitch(UIScreen screen, unsigned long elapsedUs, bool cached);
+    void recordArt(bool cover, unsigned long elapsedUs);
+    bool artVisible();
+    void hideCover();
+    static void coverFadeAnim(void* obj, int32_t value);
+
+    // Input
+    void attachInput(UIScreen screen);
+    lv_obj_t* getFocusTarget(UIScreen screen);
+    void setListOptions(BindingId binding, const char** items, size_t count);
+    ListWindow* listWindow(BindingId binding);
+    BindingId listBinding(UIScreen screen);
+    void setListTable(BindingId binding, const NameTable* table);
+    void selectListRow(BindingId binding, uint16_t row);
+    void startTouchResponse();
+    void finishTouchResponse();
+    static void listEventHandler(lv_event_t* e);
+    static void listScrollEventHandler(lv_event_t* e);
+    static void seekEventHandler(lv_event_t* e);
+    static void gestureEventHandler(lv_event_t* e);
 
     // Helper functions
     void formatTime(int milliseconds, char* buffer, size_t bufferSize);
+    void showOverlay(const char* text);
 };
 
 #endif // UI_MANAGER_H
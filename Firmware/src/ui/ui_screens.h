@@ -0,0 +1,55 @@
+#ifndef UI_SCREENS_H
+#define UI_SCREENS_H
+
+#include "ui_layout.h"
+
+// ============================================
+// Screen layouts
+// ============================================
+// To add a screen: add it to UIScreen, describe its widgets below and
+// register the table in SCREEN_LAYOUTS (same order as UIScreen).
+
+static constexpr WidgetLayout SPLASH_LAYOUT[] = {
+    // type           align            x    y    w   h   style                 binding    text
+    { WIDGET_LABEL,   LV_ALIGN_CENTER, 0, -20,  0,  0, STYLE_PRIMARY_TEXT, BIND_NONE, APP_NAME,        0 },
+    { WIDGET_LABEL,   LV_ALIGN_CENTER, 0,  10,  0,  0, STYLE_MUTED_TEXT,   BIND_NONE, "v" APP_VERSION, 0 },
+    { WIDGET_SPINNER, LV_ALIGN_CENTER, 0,  50, 40, 40, STYLE_NONE,         BIND_NONE, nullptr,         0 },
+};
+
+static constexpr WidgetLayout NOW_PLAYING_LAYOUT[] = {
+    { WIDGET_IMAGE, LV_ALIGN_CENTER,     0, -40, ART_SIZE,          ART_SIZE, STYLE_NONE,           BIND_ALBUM_ART,     nullptr,        0 },
+    { WIDGET_LABEL, LV_ALIGN_CENTER,     0,  50, DISPLAY_WIDTH - 20,  0, STYLE_PRIMARY_TEXT,   BIND_TRACK_NAME,    "No track",     WIDGET_FLAG_SCROLL_TEXT },
+    { WIDGET_LABEL, LV_ALIGN_CENTER,     0,  70, DISPLAY_WIDTH - 20,  0, STYLE_SECONDARY_TEXT, BIND_ARTIST_NAME,   "No artist",    WIDGET_FLAG_SCROLL_TEXT },
+    { WIDGET_BAR,   LV_ALIGN_BOTTOM_MID, 0, -30, DISPLAY_WIDTH - 40,  4, STYLE_NONE,           BIND_PROGRESS,      nullptr,        WIDGET_FLAG_TOUCHABLE },
+    { WIDGET_LABEL, LV_ALIGN_BOTTOM_MID, 0, -10, 0,                   0, STYLE_MUTED_TEXT,     BIND_PROGRESS_TEXT, "0:00 / 0:00",  0 },
+    { WIDGET_LABEL, LV_ALIGN_TOP_MID,    0,  10, 0,                   0, STYLE_TEXT,           BIND_PLAY_STATE,    LV_SYMBOL_PLAY, 0 },
+};
+
+static constexpr WidgetLayout PLAYLISTS_LAYOUT[] = {
+    { WIDGET_LABEL,  LV_ALIGN_TOP_MID, 0, 10, 0,                    0, STYLE_TEXT, BIND_NONE,      "Playlists",  0 },
+    { WIDGET_ROLLER, LV_ALIGN_CENTER,  0, 20, DISPLAY_WIDTH - 40, 150, STYLE_NONE, BIND_PLAYLISTS, "Loading...", 0 },
+};
+
+static constexpr WidgetLayout ALBUMS_LAYOUT[] = {
+    { WIDGET_LABEL,  LV_ALIGN_TOP_MID, 0, 10, 0,                    0, STYLE_TEXT, BIND_NONE,   "Albums",     0 },
+    { WIDGET_ROLLER, LV_ALIGN_CENTER,  0, 20, DISPLAY_WIDTH - 40, 150, STYLE_NONE, BIND_ALBUMS, "Loading...", 0 },
+};
+
+static constexpr WidgetLayout SETTINGS_LAYOUT[] = {
+    { WIDGET_LABEL, LV_ALIGN_TOP_MID, 0, 10, 0, 0, STYLE_TEXT,       BIND_NONE,        "Settings",     0 },
+    { WIDGET_LABEL, LV_ALIGN_CENTER,  0, 12, 0, 0, STYLE_MUTED_TEXT, BIND_DIAGNOSTICS, "Measuring...", WIDGET_FLAG_CENTER_TEXT },
+};
+
+#define LAYOUT(table) { table, sizeof(table) / sizeof(table[0]) }
+
+static constexpr ScreenLayout SCREEN_LAYOUTS[SCREEN_COUNT] = {
+    LAYOUT(SPLASH_LAYOUT),
+    LAYOUT(NOW_PLAYING_LAYOUT),
+    LAYOUT(PLAYLISTS_LAYOUT),
+    LAYOUT(ALBUMS_LAYOUT),
+    LAYOUT(SETTINGS_LAYOUT),
+};
+
+#undef LAYOUT
+
+#endif // UI_SCREENS_H
@@ -0,0 +1,306 @@
+// Host build of the dial's decoding paths for status and list payloads, JSON
+// with ArduinoJson and compact with compact_reader.cpp, run on payloads the
+// CLIClient's compact-benchmark captured from the backend.
+//
+//   compact_bench [--rounds N] <directory>
+//
+// The directory holds status, playlists and albums as <name>.json and, where
+// the backend sent one, <name>.compact. Prints one tab-separated line per
+// payload: name, encoding, bytes, entries, decode time in us (average over
+// the rounds), stack, heap and static bytes, and for compact payloads whether
+// they decode to the same fields as the JSON one (or its first entries).
+//
+// Memory is measured the way the dial would see it. Stack is the high-water
+// mark of a painted thread stack, heap what the JSON document allocates, and
+// static the buffers the firmware keeps outside the stack for each path.
+
+#include <ArduinoJson.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "mqtt/compact_reader.h"
+
+#define BENCH_STACK_SIZE (256 * 1024)
+#define BENCH_STACK_PAINT 0xA5
+#define BENCH_JSON_LIST_DOCUMENT 8192     // DynamicJsonDocument in handlePlaylistsMessage
+#define BENCH_JSON_STATUS_DOCUMENT 1536   // StaticJsonDocument in handleStatusMessage
+
+// ============================================
+// Heap
+// ============================================
+
+static size_t heapInUse = 0;
+static size_t heapPeak = 0;
+
+// Allocator for the JSON document, otherwise ArduinoJson's default; sizes go in a header
+struct TrackingAllocator {
+    void* allocate(size_t size) {
+        size_t* block = (size_t*)malloc(size + sizeof(size_t));
+        if (!block) return nullptr;
+        *block = size;
+        heapInUse += size;
+        if (heapInUse > heapPeak) heapPeak = heapInUse;
+        return block + 1;
+    }
+
+    void deallocate(void* pointer) {
+        if (!pointer) return;
+        size_t* block = (size_t*)pointer - 1;
+        heapInUse -= *block;
+        free(block);
+    }
+
+    void* reallocate(void* pointer, size_t size) {
+        void* moved = allocate(size);
+        if (moved && pointer) {
+            size_t old = *((size_t*)pointer - 1);
+            memcpy(moved, pointer, old < size ? old : size);
+        }
+        deallocate(pointer);
+        return moved;
+    }
+};
+
+typedef BasicJsonDocument<TrackingAllocator> TrackedJsonDocument;
+
+// ============================================
+// What the dial keeps of a payload
+// ============================================
+
+struct Decoded {
+    std::vector<std::string> fields;
+    size_t entries = 0;
+    bool ok = false;
+};
+
+static char listIds[LIST_MAX_ITEMS][LIST_ID_LENGTH];
+static const char* listNamePointers[LIST_MAX_ITEMS];
+
+// Outside the stack on the dial: MQTTClient::_compactReader, the static status
+// in handleCompactMessage and the name arena in main.cpp
+static CompactReader compactReader;
+static CompactStatus compactStatus;
+static char listNames[LIST_NAME_ARENA_BYTES];
+
+static void copyField(char* destination, const char* source, size_t size) {
+    size_t length = strnlen(source, size - 1);
+    memcpy(destination, source, length);
+    destination[length] = '\0';
+}
+
+static void keepList(size_t count, Decoded* out) {
+    if (!out) return;
+    for (size_t i = 0; i < count; i++) {
+        out->fields.push_back(listIds[i]);
+        out->fields.push_back(listNamePointers[i]);
+    }
+    out->entries = count;
+}
+
+// handlePlaylistsMessage and onPlaylistsUpdate
+static void decodeJsonList(const uint8_t* payload, size_t length, Decoded* out) {
+    TrackedJsonDocument doc(BENCH_JSON_LIST_DOCUMENT);
+    if (deserializeJson(doc, payload, length)) return;
+
+    size_t count = 0;
+    for (JsonVariant entry : doc.as<JsonArray>()) {
+        if (count >= LIST_MAX_ITEMS) break;
+        copyField(listIds[count], entry["id"] | "", LIST_ID_LENGTH);
+        listNamePointers[count] = entry["name"] | "";
+        count++;
+    }
+
+    keepList(count, out);
+    if (out) out->ok = true;
+}
+
+// readCompactList
+static void decodeCompactList(const uint8_t* payload, size_t length, Decoded* out) {
+    if (!compactReader.begin(payload, length)) return;
+
+    char name[COMPACT_TEXT_SIZE];
+    size_t count = 0;
+    size_t used = 0;
+    while (count < LIST_MAX_ITEMS &&
+           compactReader.nextEntry(listIds[count], LIST_ID_LENGTH, name, sizeof(name))) {
+        size_t nameLength = strlen(name) + 1;
+        if (used + nameLength > sizeof(listNames)) break;
+
+        memcpy(listNames + used, name, nameLength);
+        listNamePointers[count++] = listNames + used;
+        used += nameLength;
+    }
+
+    keepList(count, out);
+    if (out) out->ok = !compactReader.failed();
+}
+
+static void keepStatus(const char* track, const char* artist, const char* album, long progressMs,
+                       long durationMs, int volumePercent, bool isPlaying, const char* correlationId,
+                       long backendUs, const char* artPreview, Decoded* out) {
+    if (!out) return;
+    out->fields = {track, artist, album, std::to_string(progressMs), std::to_string(durationMs),
+                   std::to_string(volumePercent), isPlaying ? "playing" : "paused",
+                   correlationId ? correlationId : "", std::to_string(backendUs),
+                   artPreview ? artPreview : ""};
+    out->entries = 1;
+    out->ok = true;
+}
+
+// handleStatusMessage
+static void decodeJsonStatus(const uint8_t* payload, size_t length, Decoded* out) {
+    StaticJsonDocument<BENCH_JSON_STATUS_DOCUMENT> doc;
+    if (deserializeJson(doc, payload, length)) return;
+
+    keepStatus(doc["trackName"] | "Unknown", doc["artistName"] | "Unknown", doc["albumName"] | "Unknown",
+               doc["progressMs"] | 0, doc["durationMs"] | 0, doc["volumePercent"] | 0,
+               doc["isPlaying"] | false, doc["correlationId"].as<const char*>(),
+               doc["backendUs"].as<long>(), doc["artPreview"].as<const char*>(), out);
+}
+
+// handleCompactMessage
+static void decodeCompactStatus(const uint8_t* payload, size_t length, Decoded* out) {
+    if (!compactReader.begin(payload, length) || !compactReader.readStatus(compactStatus)) return;
+
+    keepStatus(compactStatus.track, compactStatus.artist, compactStatus.album, compactStatus.progressMs,
+               compactStatus.durationMs, compactStatus.volumePercent, compactStatus.isPlaying,
+               compactStatus.correlationId[0] ? compactStatus.correlationId : nullptr,
+               compactStatus.backendUs, compactStatus.artPreview[0] ? compactStatus.artPreview : nullptr,
+               out);
+}
+
+typedef void (*DecodeFunction)(const uint8_t* payload, size_t length, Decoded* out);
+
+// ============================================
+// Stack
+// ============================================
+
+struct StackRun {
+    DecodeFunction decode;
+    const std::vector<uint8_t>* payload;
+};
+
+static void* runDecode(void* arg) {
+    StackRun* run = (StackRun*)arg;
+    if (run->decode) run->decode(run->payload->data(), run->payload->size(), nullptr);
+    return nullptr;
+}
+
+// Bytes of a painted stack that a run touched; the stack grows down
+static size_t stackUsed(DecodeFunction decode, const std::vector<uint8_t>& payload) {
+    uint8_t* stack = (uint8_t*)aligned_alloc(4096, BENCH_STACK_SIZE);
+    memset(stack, BENCH_STACK_PAINT, BENCH_STACK_SIZE);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, BENCH_STACK_SIZE);
+
+    StackRun run = {decode, &payload};
+    pthread_t thread;
+    pthread_create(&thread, &attr, runDecode, &run);
+    pthread_join(thread, nullptr);
+    pthread_attr_destroy(&attr);
+
+    size_t untouched = 0;
+    while (untouched < BENCH_STACK_SIZE && stack[untouched] == BENCH_STACK_PAINT) untouched++;
+    free(stack);
+    return BENCH_STACK_SIZE - untouched;
+}
+
+// ============================================
+// Bench
+// ============================================
+
+static bool readFile(const std::string& path, std::vector<uint8_t>& data) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    uint8_t buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + read);
+    }
+    fclose(file);
+    return true;
+}
+
+static void bench(const char* name, const char* encoding, DecodeFunction decode,
+                  const std::vector<uint8_t>& payload, size_t staticBytes, int rounds,
+                  const Decoded* reference, Decoded& decoded) {
+    decode(payload.data(), payload.size(), &decoded);
+
+    auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        decode(payload.data(), payload.size(), nullptr);
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count() / rounds;
+
+    // Thread start-up touches the stack too
+    size_t stack = stackUsed(decode, payload);
+    size_t startup = stackUsed(nullptr, payload);
+    stack = stack > startup ? stack - startup : 0;
+
+    heapPeak = heapInUse = 0;
+    decode(payload.data(), payload.size(), nullptr);
+
+    // Compact lists are cut to fit a table chunk, so they match the start of the JSON one
+    const char* same = "-";
+    if (reference && reference->ok) {
+        same = decoded.ok && decoded.fields.size() <= reference->fields.size() &&
+               std::equal(decoded.fields.begin(), decoded.fields.end(), reference->fields.begin()) ? "yes" : "no";
+    }
+
+    printf("%s\t%s\t%zu\t%zu\t%.2f\t%zu\t%zu\t%zu\t%s\n", name, encoding, payload.size(),
+           decoded.ok ? decoded.entries : 0, us, stack, heapPeak, staticBytes, same);
+}
+
+int main(int argc, char** argv) {
+    int rounds = 1000;
+    const char* directory = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else {
+            directory = argv[i];
+        }
+    }
+    if (!directory || rounds < 1) {
+        fprintf(stderr, "usage: %s [--rounds N] <directory>\n", argv[0]);
+        return 2;
+    }
+
+    struct Kind {
+        const char* name;
+        DecodeFunction json;
+        DecodeFunction compact;
+        size_t compactStatic;
+    };
+    const Kind kinds[] = {
+        {"status", decodeJsonStatus, decodeCompactStatus, sizeof(CompactReader) + sizeof(CompactStatus)},
+        {"playlists", decodeJsonList, decodeCompactList, sizeof(CompactReader) + sizeof(listNames)},
+        {"albums", decodeJsonList, decodeCompactList, sizeof(CompactReader) + sizeof(listNames)},
+    };
+
+    printf("# name\tencoding\tbytes\tentries\tdecode_us\tstack\theap\tstatic\tsame\n");
+    for (const Kind& kind : kinds) {
+        std::string base = std::string(directory) + "/" + kind.name;
+        std::vector<uint8_t> json;
+        std::vector<uint8_t> compact;
+        if (!readFile(base + ".json", json)) continue;
+
+        Decoded fromJson;
+        bench(kind.name, "json", kind.json, json, 0, rounds, nullptr, fromJson);
+
+        if (readFile(base + ".compact", compact)) {
+            Decoded fromCompact;
+            bench(kind.name, "compact", kind.compact, compact, kind.compactStatic, rounds, &fromJson, fromCompact);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,219 @@
+// Host test of the encoder acceleration in src/input/encoder_accel.cpp. Feeds
+// synthetic detent traces through EncoderAccel and AccelAxis the way the dial
+// does (each detent timestamped, each poll scaled by the axis) and checks the
+// steps that come out.
+//
+//   encoder_accel_test
+//
+// Prints one line per check and exits non-zero if any failed. The curves are
+// fixed here rather than taken from config.h, so tuning the dial does not
+// change what is being checked.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include "input/encoder_accel.h"
+
+#define TEST_IDLE_RESET_US 150000UL
+
+// Gain 1 up to 8 detents/s, 4 at 30 and above: 16 + 48 * (v - 8)^2 / 484 in 1/16 steps
+static const AccelCurve testCurve = {8, 30, 4};
+
+static int failures = 0;
+
+static void check(const char* name, bool ok) {
+    printf("%s\t%s\n", ok ? "ok" : "FAIL", name);
+    if (!ok) failures++;
+}
+
+static void checkSteps(const char* name, const std::vector<int>& steps, const std::vector<int>& expected) {
+    bool ok = steps == expected;
+    check(name, ok);
+    if (ok) return;
+
+    printf("\tgot     ");
+    for (int step : steps) printf(" %d", step);
+    printf("\n\texpected");
+    for (int step : expected) printf(" %d", step);
+    printf("\n");
+}
+
+// One detent of a trace: when it was seen and which way
+struct Detent {
+    uint32_t timeUs;
+    int direction;
+};
+
+// Steps per detent, one poll per detent
+static std::vector<int> run(EncoderAccel& accel, AccelAxis& axis, const std::vector<Detent>& trace) {
+    std::vector<int> steps;
+    for (const Detent& detent : trace) {
+        accel.addDetent(detent.timeUs, detent.direction);
+        steps.push_back(axis.steps(detent.direction, accel.velocity()));
+    }
+    return steps;
+}
+
+// count detents one way, intervalUs apart, starting at startUs
+static std::vector<Detent> turn(uint32_t startUs, uint32_t intervalUs, int count, int direction) {
+    std::vector<Detent> trace;
+    for (int i = 0; i < count; i++) {
+        trace.push_back({startUs + intervalUs * i, direction});
+    }
+    return trace;
+}
+
+static std::vector<int> repeat(int step, int count) {
+    return std::vector<int>(count, step);
+}
+
+static std::vector<int> join(std::vector<int> first, const std::vector<int>& second) {
+    first.insert(first.end(), second.begin(), second.end());
+    return first;
+}
+
+static int sum(const std::vector<int>& steps) {
+    int total = 0;
+    for (int step : steps) total += step;
+    return total;
+}
+
+// ============================================
+// Curve
+// ============================================
+
+static void testGain() {
+    check("gain is 1:1 at rest", EncoderAccel::gainX16(0, testCurve) == 16);
+    check("gain is 1:1 up to the slow speed", EncoderAccel::gainX16(8, testCurve) == 16);
+    check("gain is quadratic between slow and fast", EncoderAccel::gainX16(19, testCurve) == 28);
+    check("gain reaches the maximum at the fast speed", EncoderAccel::gainX16(30, testCurve) == 64);
+    check("gain stays at the maximum above the fast speed", EncoderAccel::gainX16(UINT16_MAX, testCurve) == 64);
+
+    const AccelCurve flat = {20, 20, 4};
+    check("a curve without a ramp stays 1:1", EncoderAccel::gainX16(1000, flat) == 16);
+
+    const AccelCurve noGain = {8, 30, 0};
+    check("a maximum gain below 1 is 1:1", EncoderAccel::gainX16(1000, noGain) == 16);
+}
+
+// ============================================
+// Carry
+// ============================================
+
+static void testCarry() {
+    // 1.75 steps per detent: the fraction carries over, nothing is lost
+    AccelAxis axis(testCurve);
+    std::vector<int> steps;
+    for (int i = 0; i < 4; i++) steps.push_back(axis.steps(1, 19));
+    checkSteps("fractional gain is carried", steps, {1, 2, 2, 2});
+
+    // Left with 0.75 of a step; turning back does not spend it
+    axis.reset();
+    axis.steps(1, 19);
+    checkSteps("carry is dropped when the direction changes", {axis.steps(-1, 19), axis.steps(-1, 19)}, {-1, -2});
+
+    axis.reset();
+    axis.steps(1, 19);
+    axis.reset();
+    checkSteps("reset drops the carry", {axis.steps(1, 0)}, {1});
+
+    check("no detents is no steps", axis.steps(0, UINT16_MAX) == 0);
+    check("detents in one poll are scaled together", AccelAxis(testCurve).steps(3, 30) == 12);
+}
+
+// ============================================
+// Traces
+// ============================================
+
+static void testSlowTurn() {
+    // 8 detents per second, at the edge of the curve
+    EncoderAccel accel(TEST_IDLE_RESET_US);
+    AccelAxis axis(testCurve);
+    checkSteps("slow turn is one step per detent", run(accel, axis, turn(1000000, 125000, 12, 1)), repeat(1, 12));
+
+    // Slower than the idle reset, every detent starts from rest
+    EncoderAccel idle(TEST_IDLE_RESET_US);
+    AccelAxis idleAxis(testCurve);
+    checkSteps("detents past the idle reset are one step", run(idle, idleAxis, turn(1000000, 400000, 5, -1)), repeat(-1, 5));
+    check("velocity is 0 after an idle gap", idle.velocity() == 0);
+}
+
+static void testFastSpin() {
+    // 100 detents per second: the first detent is from rest, the next already
+    // averages to 50 per second, past the fast speed
+    EncoderAccel accel(TEST_IDLE_RESET_US);
+    AccelAxis axis(testCurve);
+    std::vector<int> steps = run(accel, axis, turn(1000000, 10000, 20, 1));
+    checkSteps("fast spin reaches the maximum gain", steps, join({1}, repeat(4, 19)));
+    check("fast spin moves 77 steps for 20 detents", sum(steps) == 77);
+    check("velocity converges on the turn speed", accel.velocity() >= 99 && accel.velocity() <= 100);
+
+    // Detents in the same microsecond count as the fastest possible turn
+    EncoderAccel burst(TEST_IDLE_RESET_US);
+    AccelAxis burstAxis(testCurve);
+    checkSteps("simultaneous detents do not divide by zero",
+               run(burst, burstAxis, {{5000, 1}, {5000, 1}, {5000, 1}}), {1, 4, 4});
+}
+
+static void testReversal() {
+    // Spinning fast one way, then back: the first detent back is from rest
+    // and the carry from the other direction is dropped
+    EncoderAccel accel(TEST_IDLE_RESET_US);
+    AccelAxis axis(testCurve);
+    std::vector<Detent> trace = turn(1000000, 10000, 10, 1);
+    std::vector<Detent> back = turn(1100000, 10000, 5, -1);
+    trace.insert(trace.end(), back.begin(), back.end());
+
+    std::vector<int> steps = run(accel, axis, trace);
+    checkSteps("reversal starts again from rest", steps,
+               join(join({1}, repeat(4, 9)), join({-1}, repeat(-4, 4))));
+
+    // Wobbling back and forth never accelerates
+    EncoderAccel wobble(TEST_IDLE_RESET_US);
+    AccelAxis wobbleAxis(testCurve);
+    checkSteps("alternating detents stay 1:1",
+               run(wobble, wobbleAxis, {{0, 1}, {5000, -1}, {10000, 1}, {15000, -1}}), {1, -1, 1, -1});
+}
+
+static void testPauseAndTurn() {
+    // Fast spin, let go, then a fresh turn the same way: the pause resets the
+    // speed so the first detent after it is a single step
+    EncoderAccel accel(TEST_IDLE_RESET_US);
+    AccelAxis axis(testCurve);
+    std::vector<int> spin = run(accel, axis, turn(1000000, 10000, 6, 1));
+    check("spin before the pause is fast", spin.back() == 4);
+
+    std::vector<int> fresh = run(accel, axis, turn(1050000 + 500000, 125000, 4, 1));
+    checkSteps("turn after a pause starts from rest", fresh, repeat(1, 4));
+
+    // Just inside the idle reset the turn carries on, at the speed of the gap
+    EncoderAccel held(TEST_IDLE_RESET_US);
+    held.addDetent(0, 1);
+    held.addDetent(TEST_IDLE_RESET_US, 1);
+    check("a gap at the idle reset keeps the turn going", held.velocity() == 3);
+}
+
+static void testTimerWrap() {
+    // micros() wraps after about 71 minutes; the spin crosses it
+    EncoderAccel accel(TEST_IDLE_RESET_US);
+    AccelAxis axis(testCurve);
+    checkSteps("fast spin across the timer wrap", run(accel, axis, turn(UINT32_MAX - 25000, 10000, 6, 1)),
+               join({1}, repeat(4, 5)));
+}
+
+int main() {
+    testGain();
+    testCarry();
+    testSlowTurn();
+    testFastSpin();
+    testReversal();
+    testPauseAndTurn();
+    testTimerWrap();
+
+    if (failures) {
+        printf("%d failed\n", failures);
+        return 1;
+    }
+    printf("all passed\n");
+    return 0;
+}
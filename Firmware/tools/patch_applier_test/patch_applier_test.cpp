@@ -0,0 +1,592 @@
+// Host test of the OTA patch applier in src/ota/patch_applier.cpp. Builds
+// patches in the backend's format (see patch_applier.h and FirmwareDiff.cs),
+// feeds them through a buffer-backed PatchIO in random chunk sizes, reboots
+// at random points and resumes from the last checkpoint, and checks that the
+// new image comes out byte for byte and that corrupted patches are rejected.
+//
+//   patch_applier_test [--seeds N]
+//
+// Prints one line per check and exits non-zero if any failed. Build it with
+// the sanitizers to catch reads past a buffer on bad input:
+//
+//   make test CXXFLAGS="-O1 -g -fsanitize=address,undefined"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "ota/patch_applier.h"
+
+#define TEST_BLOCK_SIZE (2 * PATCH_SECTOR_SIZE)
+#define TEST_WINDOW_BITS 12   // FirmwareDiff.WindowBits
+#define TEST_LENGTH_BITS 8    // FirmwareDiff.LengthBits
+#define TEST_MIN_COPY 12      // FirmwareDiff.MinCopy
+#define TEST_MAX_CHUNK 2048   // Larger than an OTA data message
+#define TEST_MATCH_CHAIN 64
+
+#define OP_COPY 0
+#define OP_ADD_BYTES 1
+#define OP_INSERT_BYTES 2
+
+typedef std::vector<uint8_t> Bytes;
+
+static int failures = 0;
+static int seeds = 20;
+
+static void check(const char* name, bool ok) {
+    printf("%s\t%s\n", ok ? "ok" : "FAIL", name);
+    if (!ok) failures++;
+}
+
+// xorshift32, so every run sees the same chunks and reboots
+struct Random {
+    uint32_t state;
+
+    explicit Random(uint32_t seed) : state(seed ? seed : 1) {}
+
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    uint32_t below(uint32_t limit) { return next() % limit; }
+};
+
+// ============================================
+// Writing patches
+// ============================================
+
+static void putLE32(Bytes& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out.push_back((uint8_t)(value >> (8 * i)));
+}
+
+static void putVarint(Bytes& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+/**
+ * Ops of one block, written together with the bytes the applier should make
+ * of them, so a test states the ops and the expected image follows.
+ */
+class BlockOps {
+public:
+    BlockOps(const Bytes& base, uint32_t blockStart) : _base(base), _cursor(blockStart) {}
+
+    // Base bytes at cursor + delta
+    void copy(uint32_t length, int32_t delta) {
+        op(OP_COPY, length, delta);
+        for (uint32_t i = 0; i < length; i++) produced.push_back(_base[_cursor + i]);
+        _cursor += length;
+    }
+
+    // Base bytes at cursor + delta, each plus a byte of differences
+    void add(int32_t delta, const Bytes& differences) {
+        op(OP_ADD_BYTES, (uint32_t)differences.size(), delta);
+        ops.insert(ops.end(), differences.begin(), differences.end());
+        for (uint8_t difference : differences) produced.push_back((uint8_t)(_base[_cursor++] + difference));
+    }
+
+    void insert(const uint8_t* data, size_t length) {
+        ops.push_back(OP_INSERT_BYTES);
+        putVarint(ops, (uint32_t)length);
+        ops.insert(ops.end(), data, data + length);
+        produced.insert(produced.end(), data, data + length);
+    }
+
+    uint32_t cursor() const { return _cursor; }
+
+    Bytes ops;
+    Bytes produced;
+
+private:
+    void op(uint8_t code, uint32_t length, int32_t delta) {
+        ops.push_back(code);
+        putVarint(ops, length);
+        putVarint(ops, ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31));
+        _cursor += delta;
+    }
+
+    const Bytes& _base;
+    uint32_t _cursor;
+};
+
+// LZSS as in Lzss.cs: 1 + literal, or 0 + distance - 1 + length - 3, MSB first
+static Bytes compress(const Bytes& data, int windowBits, int lengthBits) {
+    const uint32_t window = 1UL << windowBits;
+    const uint32_t maxMatch = (1UL << lengthBits) - 1 + PATCH_MIN_MATCH;
+
+    Bytes out;
+    uint64_t bits = 0;
+    int bitCount = 0;
+    auto put = [&](uint32_t value, int count) {
+        bits = (bits << count) | value;
+        bitCount += count;
+        while (bitCount >= 8) {
+            bitCount -= 8;
+            out.push_back((uint8_t)(bits >> bitCount));
+        }
+        bits &= (1ULL << bitCount) - 1;
+    };
+
+    std::unordered_map<uint32_t, int64_t> head;
+    std::vector<int64_t> previous(data.size(), -1);
+    auto key = [&](size_t pos) { return data[pos] | (data[pos + 1] << 8) | (data[pos + 2] << 16); };
+    auto index = [&](size_t pos) {
+        if (pos + PATCH_MIN_MATCH > data.size()) return;
+        auto found = head.find(key(pos));
+        previous[pos] = found != head.end() ? found->second : -1;
+        head[key(pos)] = (int64_t)pos;
+    };
+
+    size_t pos = 0;
+    while (pos < data.size()) {
+        uint32_t bestLength = 0;
+        uint32_t bestDistance = 0;
+
+        if (pos + PATCH_MIN_MATCH <= data.size()) {
+            auto found = head.find(key(pos));
+            int64_t candidate = found != head.end() ? found->second : -1;
+            for (int chain = 0; candidate >= 0 && chain < TEST_MATCH_CHAIN; chain++) {
+                uint32_t distance = (uint32_t)(pos - candidate);
+                if (distance > window) break;
+
+                uint32_t length = 0;
+                while (length < maxMatch && pos + length < data.size() &&
+                       data[candidate + length] == data[pos + length]) {
+                    length++;
+                }
+                if (length > bestLength) {
+                    bestLength = length;
+                    bestDistance = distance;
+                }
+                candidate = previous[candidate];
+            }
+        }
+
+        if (bestLength >= PATCH_MIN_MATCH) {
+            put(0, 1);
+            put(bestDistance - 1, windowBits);
+            put(bestLength - PATCH_MIN_MATCH, lengthBits);
+        } else {
+            bestLength = 1;
+            put(1, 1);
+            put(data[pos], 8);
+        }
+
+        for (uint32_t i = 0; i < bestLength; i++) index(pos + i);
+        pos += bestLength;
+    }
+
+    if (bitCount > 0) put(0, 8 - bitCount);
+    return out;
+}
+
+struct Patch {
+    Bytes bytes;
+    Bytes target;   // What applying it should produce
+};
+
+static Patch writePatch(const Bytes& base, const std::vector<BlockOps>& blocks, uint32_t blockSize,
+                        int windowBits = TEST_WINDOW_BITS, int lengthBits = TEST_LENGTH_BITS) {
+    Patch patch;
+    for (const BlockOps& block : blocks) {
+        patch.target.insert(patch.target.end(), block.produced.begin(), block.produced.end());
+    }
+
+    patch.bytes.insert(patch.bytes.end(), {'S', 'D', 'P', '1', (uint8_t)windowBits, (uint8_t)lengthBits, 0, 0});
+    putLE32(patch.bytes, blockSize);
+    putLE32(patch.bytes, (uint32_t)base.size());
+    putLE32(patch.bytes, (uint32_t)patch.target.size());
+    putLE32(patch.bytes, patchCrc32(0, patch.target.data(), patch.target.size()));
+
+    for (const BlockOps& block : blocks) {
+        Bytes compressed = compress(block.ops, windowBits, lengthBits);
+        putLE32(patch.bytes, (uint32_t)compressed.size());
+        putLE32(patch.bytes, patchCrc32(0, block.produced.data(), block.produced.size()));
+        patch.bytes.insert(patch.bytes.end(), compressed.begin(), compressed.end());
+    }
+    return patch;
+}
+
+// The matching FirmwareDiff does, shortened: an exact match at the base cursor
+// or at the last base position with the same 8 bytes becomes a COPY, stretched
+// into an ADD while more bytes agree than not
+static Patch diff(const Bytes& base, const Bytes& target, uint32_t blockSize) {
+    std::unordered_map<uint64_t, uint32_t> seeds;
+    for (uint32_t i = 0; i + 8 <= base.size(); i++) {
+        uint64_t seed;
+        memcpy(&seed, &base[i], 8);
+        seeds[seed] = i;
+    }
+
+    auto matchLength = [&](uint32_t basePos, uint32_t pos, uint32_t end) {
+        uint32_t length = 0;
+        while (basePos + length < base.size() && pos + length < end && base[basePos + length] == target[pos + length]) {
+            length++;
+        }
+        return length;
+    };
+
+    std::vector<BlockOps> blocks;
+    for (uint32_t start = 0; start < target.size(); start += blockSize) {
+        uint32_t end = start + blockSize < target.size() ? start + blockSize : (uint32_t)target.size();
+        BlockOps block(base, start);
+        uint32_t literalStart = start;
+        uint32_t pos = start;
+
+        while (pos < end) {
+            uint32_t matchPos = block.cursor();
+            uint32_t length = matchLength(matchPos, pos, end);
+            if (pos + 8 <= target.size()) {
+                uint64_t seed;
+                memcpy(&seed, &target[pos], 8);
+                auto found = seeds.find(seed);
+                if (found != seeds.end() && matchLength(found->second, pos, end) > length) {
+                    matchPos = found->second;
+                    length = matchLength(matchPos, pos, end);
+                }
+            }
+            if (length < TEST_MIN_COPY) {
+                pos++;
+                continue;
+            }
+
+            if (pos > literalStart) block.insert(&target[literalStart], pos - literalStart);
+            block.copy(length, (int32_t)(matchPos - block.cursor()));
+            pos += length;
+
+            int score = 0, bestScore = 0;
+            uint32_t addLength = 0;
+            for (uint32_t i = 0; pos + i < end && block.cursor() + i < base.size(); i++) {
+                score += target[pos + i] == base[block.cursor() + i] ? 1 : -1;
+                if (score > bestScore) {
+                    bestScore = score;
+                    addLength = i + 1;
+                } else if (score < bestScore - 16) {
+                    break;
+                }
+            }
+            if (addLength > 0) {
+                Bytes differences;
+                for (uint32_t i = 0; i < addLength; i++) {
+                    differences.push_back((uint8_t)(target[pos + i] - base[block.cursor() + i]));
+                }
+                block.add(0, differences);
+                pos += addLength;
+            }
+            literalStart = pos;
+        }
+
+        if (end > literalStart) block.insert(&target[literalStart], end - literalStart);
+        blocks.push_back(block);
+    }
+
+    return writePatch(base, blocks, blockSize);
+}
+
+// ============================================
+// Applying patches
+// ============================================
+
+// Flash partitions as buffers; writes must start on a sector, like erases
+class BufferIO : public PatchIO {
+public:
+    BufferIO(const Bytes& base, uint32_t targetSize) : base(base), target(targetSize, 0xFF) {}
+
+    bool readBase(uint32_t offset, uint8_t* buffer, size_t length) override {
+        if (failReads || offset > base.size() || length > base.size() - offset) return false;
+        memcpy(buffer, &base[offset], length);
+        return true;
+    }
+
+    bool writeTarget(uint32_t offset, const uint8_t* data, size_t length) override {
+        if (offset % PATCH_SECTOR_SIZE != 0) misaligned = true;
+        if (offset > target.size() || length > target.size() - offset) return false;
+        memcpy(&target[offset], data, length);
+        return true;
+    }
+
+    Bytes base;
+    Bytes target;
+    bool failReads = false;
+    bool misaligned = false;
+};
+
+struct Applied {
+    PatchApplier::Result result = PatchApplier::PATCH_ERROR;
+    Bytes target;
+    int reboots = 0;
+    bool misaligned = false;
+    const char* error = nullptr;
+};
+
+// Feed the patch in random chunks; with rebootEvery, lose the applier about
+// that often between chunks and resume from its checkpoint with a new one
+static Applied apply(const Bytes& patch, const Bytes& base, uint32_t seed, uint32_t rebootEvery,
+                     bool failReads = false) {
+    Applied applied;
+    PatchHeader header;
+    if (!PatchApplier::parseHeader(patch.data(), patch.size(), header)) {
+        applied.error = "bad header";
+        return applied;
+    }
+
+    Random random(seed);
+    BufferIO io(base, header.targetSize);
+    io.failReads = failReads;
+    PatchCheckpoint checkpoint = {0, PATCH_HEADER_SIZE, 0};
+    std::unique_ptr<PatchApplier> applier(new PatchApplier());
+    applier->begin(header, &io, checkpoint);
+    size_t position = checkpoint.offset;
+
+    while (position < patch.size()) {
+        if (rebootEvery && random.below(rebootEvery) == 0) {
+            // What was written past the checkpoint is left half done
+            checkpoint = applier->checkpoint();
+            for (size_t i = (size_t)checkpoint.block * header.blockSize; i < io.target.size(); i++) {
+                io.target[i] = (uint8_t)random.next();
+            }
+            applier.reset(new PatchApplier());
+            applier->begin(header, &io, checkpoint);
+            position = checkpoint.offset;
+            applied.reboots++;
+        }
+
+        size_t chunk = random.below(8) == 0 ? 1 : 1 + random.below(TEST_MAX_CHUNK);
+        if (chunk > patch.size() - position) chunk = patch.size() - position;
+        applied.result = applier->feed(&patch[position], chunk);
+        position += chunk;
+        if (applied.result != PatchApplier::PATCH_MORE) break;
+    }
+
+    applied.target = io.target;
+    applied.misaligned = io.misaligned;
+    applied.error = applier->error();
+    return applied;
+}
+
+// Every seed, with and without reboots, produces the image exactly
+static void checkApplies(const char* name, const Patch& patch, const Bytes& base) {
+    bool ok = true;
+    int reboots = 0;
+    for (int seed = 1; seed <= seeds && ok; seed++) {
+        for (uint32_t rebootEvery : {0u, 3u, 20u}) {
+            Applied applied = apply(patch.bytes, base, (uint32_t)seed, rebootEvery);
+            reboots += applied.reboots;
+            if (applied.result != PatchApplier::PATCH_DONE || applied.target != patch.target || applied.misaligned) {
+                printf("\tseed %d, reboot every %u: %s\n", seed, rebootEvery,
+                       applied.error ? applied.error : "wrong image");
+                ok = false;
+                break;
+            }
+        }
+    }
+    check(name, ok && reboots > 0);
+}
+
+// ============================================
+// Images
+// ============================================
+
+// Something like code: instruction words, some of them addresses into the image
+static Bytes firmwareImage(uint32_t size, uint32_t seed) {
+    Random random(seed);
+    Bytes image;
+    while (image.size() < size) {
+        uint32_t word = random.below(4) == 0 ? 0x42000000 + random.below(size) : random.below(64) * 0x01010101;
+        for (int i = 0; i < 4 && image.size() < size; i++) image.push_back((uint8_t)(word >> (8 * i)));
+    }
+    return image;
+}
+
+// The same program rebuilt: code inserted and removed, addresses after it shifted
+static Bytes rebuilt(const Bytes& base) {
+    Bytes target(base.begin(), base.begin() + 20000);
+    Bytes inserted = firmwareImage(300, 7);
+    target.insert(target.end(), inserted.begin(), inserted.end());
+    target.insert(target.end(), base.begin() + 20000, base.begin() + 50000);
+    target.insert(target.end(), base.begin() + 51000, base.end());
+
+    for (size_t i = 20300; i + 4 <= target.size(); i += 4) {
+        if (target[i + 3] == 0x42) target[i] += 0x2C;
+    }
+
+    Bytes tail = firmwareImage(5000, 9);
+    target.insert(target.end(), tail.begin(), tail.end());
+    return target;
+}
+
+// ============================================
+// Tests
+// ============================================
+
+static void testHeader() {
+    Bytes base = firmwareImage(PATCH_SECTOR_SIZE, 1);
+    Patch patch = diff(base, base, TEST_BLOCK_SIZE);
+    PatchHeader header;
+
+    check("header parses", PatchApplier::parseHeader(patch.bytes.data(), patch.bytes.size(), header) &&
+                                header.baseSize == base.size() && header.targetSize == base.size());
+    check("short header is rejected", !PatchApplier::parseHeader(patch.bytes.data(), PATCH_HEADER_SIZE - 1, header));
+
+    Bytes magic = patch.bytes;
+    magic[3] = '2';
+    check("other magic is rejected", !PatchApplier::parseHeader(magic.data(), magic.size(), header));
+
+    Bytes window = patch.bytes;
+    window[4] = PATCH_MAX_WINDOW_BITS + 1;
+    check("window too large for the dial is rejected", !PatchApplier::parseHeader(window.data(), window.size(), header));
+
+    Bytes blockSize = patch.bytes;
+    blockSize[8] = 0x10;
+    check("block not a multiple of a sector is rejected",
+          !PatchApplier::parseHeader(blockSize.data(), blockSize.size(), header));
+}
+
+static void testFullImage() {
+    Bytes target = firmwareImage(3 * TEST_BLOCK_SIZE + 1234, 2);
+    Bytes empty;
+    checkApplies("full image in random chunks with reboots", diff(empty, target, TEST_BLOCK_SIZE), empty);
+
+    // A narrower window and shorter matches than the backend uses
+    std::vector<BlockOps> blocks;
+    for (uint32_t start = 0; start < target.size(); start += TEST_BLOCK_SIZE) {
+        BlockOps block(empty, start);
+        uint32_t length = target.size() - start < TEST_BLOCK_SIZE ? target.size() - start : TEST_BLOCK_SIZE;
+        block.insert(&target[start], length);
+        blocks.push_back(block);
+    }
+    checkApplies("full image with a 512 byte window", writePatch(empty, blocks, TEST_BLOCK_SIZE, 9, 4), empty);
+}
+
+static void testDelta() {
+    Bytes base = firmwareImage(96 * 1024, 3);
+    Bytes target = rebuilt(base);
+    Patch patch = diff(base, target, TEST_BLOCK_SIZE);
+
+    check("diff reproduces the rebuilt image", patch.target == target);
+    check("delta patch is smaller than the image", patch.bytes.size() < target.size() / 4);
+    checkApplies("delta in random chunks with reboots", patch, base);
+
+    Patch single = diff(base, target, 64 * PATCH_SECTOR_SIZE);
+    checkApplies("delta as one large block", single, base);
+}
+
+static void testOps() {
+    const uint32_t blockSize = 4 * PATCH_SECTOR_SIZE;
+    Bytes base = firmwareImage(10000, 4);
+    BlockOps block(base, 0);
+    uint8_t text[] = "inserted";
+
+    // Nothing to copy at the very end of the base, then back to the start
+    block.copy(0, (int32_t)base.size());
+    block.insert(text, 0);
+    block.add((int32_t)-base.size() + 100, Bytes());
+    block.copy(1000, 0);
+    block.insert(text, sizeof(text));
+
+    // Longer than the base read buffer, so ADD and COPY refill it
+    Bytes differences(3 * PATCH_BASE_BUFFER + 17);
+    for (size_t i = 0; i < differences.size(); i++) differences[i] = (uint8_t)(i * 7);
+    block.add(-500, differences);
+    block.copy(PATCH_BASE_BUFFER * 2 + 1, 2000);
+
+    // Up to the last base byte, then an empty COPY right at the end
+    block.copy((uint32_t)base.size() - block.cursor() - 10, 0);
+    block.add(0, Bytes(10, 1));
+    block.copy(0, 0);
+
+    Bytes fill(blockSize - block.produced.size(), 0x5A);
+    block.insert(fill.data(), fill.size());
+
+    Patch patch = writePatch(base, {block}, blockSize);
+    checkApplies("empty ops, backward deltas and ops past the base buffer", patch, base);
+
+    BlockOps past(base, 0);
+    past.copy(0, (int32_t)base.size());
+    past.insert(fill.data(), PATCH_SECTOR_SIZE);
+    checkApplies("empty COPY at the end of the base", writePatch(base, {past}, PATCH_SECTOR_SIZE), base);
+}
+
+static void testRejects() {
+    Bytes base = firmwareImage(96 * 1024, 3);
+    Patch patch = diff(base, rebuilt(base), TEST_BLOCK_SIZE);
+
+    // A flipped byte must never produce a wrong image; the rare flip in the
+    // padding of a block's last byte may still apply
+    Random random(5);
+    int rejected = 0;
+    bool wrongImage = false;
+    const int flips = 400;
+    for (int i = 0; i < flips; i++) {
+        Bytes corrupted = patch.bytes;
+        size_t position = PATCH_HEADER_SIZE + random.below((uint32_t)corrupted.size() - PATCH_HEADER_SIZE);
+        corrupted[position] ^= (uint8_t)(1 + random.below(255));
+
+        Applied applied = apply(corrupted, base, (uint32_t)i + 1, 0);
+        if (applied.result != PatchApplier::PATCH_DONE) {
+            rejected++;
+        } else if (applied.target != patch.target) {
+            wrongImage = true;
+        }
+    }
+    printf("\t%d of %d corrupted patches rejected\n", rejected, flips);
+    check("corrupted patches never apply a wrong image", !wrongImage && rejected > flips * 9 / 10);
+
+    Bytes truncated(patch.bytes.begin(), patch.bytes.end() - 1);
+    check("truncated patch waits for more", apply(truncated, base, 1, 0).result == PatchApplier::PATCH_MORE);
+
+    Bytes otherBase = base;
+    for (size_t i = 0; i < otherBase.size(); i += 997) otherBase[i] ^= 0x80;
+    Applied mismatch = apply(patch.bytes, otherBase, 1, 0);
+    check("patch for another base is rejected", mismatch.result == PatchApplier::PATCH_ERROR &&
+                                                    strcmp(mismatch.error, "block CRC mismatch") == 0);
+
+    check("base read failure is rejected", apply(patch.bytes, base, 1, 0, true).result == PatchApplier::PATCH_ERROR);
+
+    BlockOps outside(base, 0);
+    outside.insert((const uint8_t*)"x", 1);
+    Bytes ops = outside.ops;
+    ops.push_back(OP_COPY);
+    putVarint(ops, 2);
+    putVarint(ops, ((uint32_t)base.size() - 1) << 1);
+    outside.ops = ops;
+    Applied bounds = apply(writePatch(base, {outside}, TEST_BLOCK_SIZE).bytes, base, 1, 0);
+    check("COPY past the end of the base is rejected", bounds.result == PatchApplier::PATCH_ERROR &&
+                                                           strcmp(bounds.error, "base range out of bounds") == 0);
+}
+
+int main(int argc, char** argv) {
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seeds") == 0 && i + 1 < argc) {
+            seeds = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--seeds N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    testHeader();
+    testFullImage();
+    testDelta();
+    testOps();
+    testRejects();
+
+    if (failures) {
+        printf("%d failed\n", failures);
+        return 1;
+    }
+    printf("all passed\n");
+    return 0;
+}
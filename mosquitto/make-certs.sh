@@ -0,0 +1,76 @@
+#!/bin/sh
+# Self-signed CA and broker certificate for mosquitto-tls.conf, the broker password
+# file, and the firmware header with the CA and the broker's public key pin.
+#
+# Usage: mosquitto/make-certs.sh <broker host or IP> [mqtt user] [mqtt password]
+#
+# The CA is created once and reused; the broker key is regenerated on every run,
+# so reflash the dials afterwards (or leave MQTT_TLS_PIN_SHA256 empty).
+set -e
+
+HOST=${1:?usage: $0 <broker host or IP> [mqtt user] [mqtt password]}
+MQTT_USER=${2:-mqtttest}
+MQTT_PASS=${3:-mqtttest}
+
+DIR=$(cd "$(dirname "$0")" && pwd)
+CERTS="$DIR/config/certs"
+HEADER="$DIR/../Firmware/include/mqtt_tls_certs.h"
+
+mkdir -p "$CERTS"
+cd "$CERTS"
+
+# P-256 keys: ECDSA verification and ECDHE both run on the ESP32-S3 bignum accelerator
+if [ ! -f ca.key ]; then
+    openssl ecparam -name prime256v1 -genkey -noout -out ca.key
+    openssl req -x509 -new -key ca.key -sha256 -days 3650 -subj "/CN=SpotiDial MQTT CA" -out ca.crt
+fi
+
+# mbedtls matches the host name against the CN, browsers and OpenSSL against the SAN
+case "$HOST" in
+    *[!0-9.]*) SAN="DNS:$HOST" ;;
+    *) SAN="IP:$HOST" ;;
+esac
+
+openssl ecparam -name prime256v1 -genkey -noout -out server.key
+openssl req -new -key server.key -subj "/CN=$HOST" -out server.csr
+printf "subjectAltName=%s\nextendedKeyUsage=serverAuth\n" "$SAN" > server.ext
+openssl x509 -req -in server.csr -CA ca.crt -CAkey ca.key -CAcreateserial \
+    -sha256 -days 825 -extfile server.ext -out server.crt
+rm -f server.csr server.ext
+
+# The broker runs as its own user inside the container
+chmod 644 server.key
+
+PIN=$(openssl x509 -in server.crt -pubkey -noout | openssl pkey -pubin -outform der | openssl dgst -sha256 -hex | sed 's/^.* //')
+
+if command -v mosquitto_passwd >/dev/null 2>&1; then
+    mosquitto_passwd -b -c "$DIR/config/passwd" "$MQTT_USER" "$MQTT_PASS"
+else
+    docker run --rm -v "$DIR/config:/mosquitto/config" eclipse-mosquitto:2 \
+        mosquitto_passwd -b -c /mosquitto/config/passwd "$MQTT_USER" "$MQTT_PASS"
+fi
+
+cat > "$HEADER" <<HEADER_EOF
+#ifndef MQTT_TLS_CERTS_H
+#define MQTT_TLS_CERTS_H
+
+// Trust anchors for MQTT over TLS (MQTT_USE_TLS in config.h).
+// Generated by mosquitto/make-certs.sh for $HOST.
+
+// CA that signed the broker certificate (mosquitto/config/certs/ca.crt)
+static const char MQTT_TLS_CA_CERT[] = R"PEM(
+$(cat ca.crt)
+)PEM";
+
+// SHA-256 of the broker's public key (SubjectPublicKeyInfo) as hex.
+// Empty trusts any certificate the CA signed for MQTT_BROKER.
+#define MQTT_TLS_PIN_SHA256 "$PIN"
+
+#endif // MQTT_TLS_CERTS_H
+HEADER_EOF
+
+echo "Broker certificate for $HOST in $CERTS"
+echo "Public key pin: $PIN"
+echo "Firmware header: $HEADER"
+echo "Start the broker with MOSQUITTO_CONFIG=mosquitto-tls.conf and set MQTT_USE_TLS true in config.h"
+echo "Set MQTT_USERNAME=$MQTT_USER and its password in .env for the backend"